@@ -0,0 +1,1025 @@
+/*
+ * This file is part of ABCDK.
+ *
+ * MIT License
+ *
+ */
+#include "comm.h"
+
+/** 读缓存默认大小。*/
+#define ABCDK_COMM_RBUF_SIZE (64 * 1024)
+
+/** 写队列默认高水位。*/
+#define ABCDK_COMM_WQ_HIGH (1024 * 1024)
+
+/** 写队列中缓存块的默认大小。*/
+#define ABCDK_COMM_CHUNK_SIZE (16 * 1024)
+
+/** 一次writev的最大缓存块数量。*/
+#define ABCDK_COMM_IOV_MAX 64
+
+/** 一次调度的最大事件数量。*/
+#define ABCDK_COMM_DISPATCH_MAX 16
+
+/** 文件区间一次发送的最大长度。*/
+#define ABCDK_COMM_FILE_STEP (1024 * 1024)
+
+/** 文件区间经管道转发时，一次转发的最大长度(管道默认容量)。*/
+#define ABCDK_COMM_PIPE_STEP (64 * 1024)
+
+/**
+ * 写队列的元素。
+*/
+typedef struct _abcdk_comm_wq_item
+{
+    /** 缓存。NULL(0) 文件区间。*/
+    abcdk_buffer_t *buf;
+
+    /** 文件句柄(复制的)。*/
+    int fd;
+
+    /** 文件偏移量。< 0 从当前位置读取(管道、磁带等不支持定位的句柄)。*/
+    off_t offset;
+
+    /** 剩余长度。*/
+    size_t remain;
+
+    /** 是否读到文件末尾为止。!0 是，0 否。*/
+    int to_eof;
+
+    /** 是否经管道转发(源句柄不支持sendfile)。!0 是，0 否。*/
+    int splice;
+
+} abcdk_comm_wq_item;
+
+/**
+ * 通讯环境。
+*/
+struct _abcdk_comm
+{
+    /** 多路复用器。*/
+    abcdk_mux_t *mux;
+
+    /** 读缓存大小。*/
+    size_t rbuf_size;
+
+    /** 写队列的高水位。*/
+    size_t wq_high;
+
+    /** 写队列的低水位。*/
+    size_t wq_low;
+};
+
+/**
+ * 通讯节点。
+*/
+struct _abcdk_comm_node
+{
+    /** 环境。*/
+    abcdk_comm_t *ctx;
+
+    /** 句柄。-1 已关闭。*/
+    int fd;
+
+    /** 是否为监听节点。!0 是，0 否。*/
+    int listen;
+
+    /** 引用计数。*/
+    volatile int refcount;
+
+    /** 回调函数。*/
+    abcdk_comm_callback cb;
+
+    /** 环境指针。*/
+    void *opaque;
+
+    /** 互斥量，保护写队列和状态。*/
+    abcdk_mutex_t mutex;
+
+    /** 读缓存，仅读事件的处理线程访问。*/
+    abcdk_buffer_t *rbuf;
+
+    /** 写队列(环形)。*/
+    abcdk_comm_wq_item *wq_list;
+
+    /** 写队列容量。*/
+    size_t wq_max;
+
+    /** 写队列的队头。*/
+    size_t wq_head;
+
+    /** 写队列中的缓存数量。*/
+    size_t wq_count;
+
+    /** 写队列中缓存的数据长度(不包括文件区间)。*/
+    size_t wq_bytes;
+
+    /** 队尾缓存是否可以追加数据(非投递的缓存)。!0 是，0 否。*/
+    int wq_tail_own;
+
+    /** 备用的缓存块，重复使用。*/
+    abcdk_buffer_t *wq_spare;
+
+    /** 转发文件区间的管道。-1 未创建。*/
+    int pipe_fds[2];
+
+    /** 管道中待发送的数据长度。*/
+    size_t pipe_bytes;
+
+    /** 等待可读的源句柄(复制的)，关联在多路复用器中。-1 未等待。*/
+    int src_fd;
+
+    /** 是否已经注册输出事件。!0 是，0 否。*/
+    int wait_output;
+
+    /** 是否暂停读取(写队列超过高水位)。!0 是，0 否。*/
+    int paused;
+
+    /** 是否在写队列发送完后关闭。!0 是，0 否。*/
+    int closing;
+
+    /** 是否已关闭。!0 是，0 否。*/
+    int closed;
+};
+
+void abcdk_comm_free(abcdk_comm_t **ctx)
+{
+    abcdk_comm_t *ctx_p;
+
+    if (!ctx || !*ctx)
+        return;
+
+    ctx_p = *ctx;
+
+    abcdk_mux_free(&ctx_p->mux);
+
+    /*free.*/
+    abcdk_heap_free(ctx_p);
+
+    /*Set to NULL(0).*/
+    *ctx = NULL;
+}
+
+abcdk_comm_t *abcdk_comm_alloc(const abcdk_comm_param *param)
+{
+    abcdk_comm_t *ctx = NULL;
+
+    ctx = abcdk_heap_alloc(sizeof(abcdk_comm_t));
+    if (!ctx)
+        goto final_error;
+
+    ctx->mux = abcdk_mux_alloc2(param ? &param->mux : NULL);
+    if (!ctx->mux)
+        goto final_error;
+
+    ctx->rbuf_size = ((param && param->rbuf_size > 0) ? param->rbuf_size : ABCDK_COMM_RBUF_SIZE);
+    ctx->wq_high = ((param && param->wq_high > 0) ? param->wq_high : ABCDK_COMM_WQ_HIGH);
+    ctx->wq_low = ((param && param->wq_low > 0) ? param->wq_low : ctx->wq_high / 4);
+    ctx->wq_low = ABCDK_MIN(ctx->wq_low, ctx->wq_high);
+
+    return ctx;
+
+final_error:
+
+    abcdk_comm_free(&ctx);
+
+    return NULL;
+}
+
+abcdk_mux_t *abcdk_comm_mux(abcdk_comm_t *ctx)
+{
+    assert(ctx != NULL);
+
+    return ctx->mux;
+}
+
+static void _abcdk_comm_wq_clear(abcdk_comm_node_t *node)
+{
+    abcdk_comm_wq_item *item;
+
+    for (size_t i = 0; i < node->wq_count; i++)
+    {
+        item = &node->wq_list[(node->wq_head + i) % node->wq_max];
+
+        if (item->buf)
+            abcdk_buffer_free(&item->buf);
+        else
+            abcdk_closep(&item->fd);
+    }
+
+    node->wq_head = node->wq_count = node->wq_bytes = 0;
+    node->wq_tail_own = 0;
+
+    abcdk_buffer_free(&node->wq_spare);
+
+    abcdk_closep(&node->pipe_fds[0]);
+    abcdk_closep(&node->pipe_fds[1]);
+    node->pipe_bytes = 0;
+}
+
+static void _abcdk_comm_node_free(abcdk_comm_node_t **node)
+{
+    abcdk_comm_node_t *node_p;
+
+    if (!node || !*node)
+        return;
+
+    node_p = *node;
+
+    _abcdk_comm_wq_clear(node_p);
+    abcdk_heap_free(node_p->wq_list);
+    abcdk_buffer_free(&node_p->rbuf);
+    abcdk_closep(&node_p->fd);
+    abcdk_mutex_destroy(&node_p->mutex);
+
+    /*free.*/
+    abcdk_heap_free(node_p);
+
+    /*Set to NULL(0).*/
+    *node = NULL;
+}
+
+abcdk_comm_node_t *abcdk_comm_refer(abcdk_comm_node_t *node)
+{
+    assert(node != NULL);
+
+    abcdk_atomic_fetch_and_add(&node->refcount, 1);
+
+    return node;
+}
+
+void abcdk_comm_unref(abcdk_comm_node_t **node)
+{
+    abcdk_comm_node_t *node_p;
+
+    if (!node || !*node)
+        return;
+
+    node_p = *node;
+    *node = NULL;
+
+    if (abcdk_atomic_fetch_and_add(&node_p->refcount, -1) != 1)
+        return;
+
+    _abcdk_comm_node_free(&node_p);
+}
+
+static abcdk_comm_node_t *_abcdk_comm_node_attach(abcdk_comm_t *ctx, int fd, int listen, const abcdk_comm_callback *cb, void *opaque, time_t timeout)
+{
+    abcdk_comm_node_t *node = NULL;
+    epoll_data_t data;
+
+    assert(ctx != NULL && fd >= 0 && cb != NULL);
+
+    node = abcdk_heap_alloc(sizeof(abcdk_comm_node_t));
+    if (!node)
+        return NULL;
+
+    node->ctx = ctx;
+    node->fd = -1;
+    node->listen = listen;
+    node->refcount = 1;
+    node->cb = *cb;
+    node->opaque = opaque;
+    node->pipe_fds[0] = node->pipe_fds[1] = -1;
+    node->src_fd = -1;
+    abcdk_mutex_init2(&node->mutex, 0);
+
+    if (!listen)
+    {
+        node->rbuf = abcdk_buffer_alloc2(ctx->rbuf_size);
+        if (!node->rbuf)
+            goto final_error;
+    }
+
+    data.ptr = node;
+    if (abcdk_mux_attach(ctx->mux, fd, &data, timeout) != 0)
+        goto final_error;
+
+    /*关联成功后，句柄由节点管理。*/
+    node->fd = fd;
+
+    abcdk_mux_mark(ctx->mux, fd, ABCDK_EPOLL_INPUT, 0);
+
+    return node;
+
+final_error:
+
+    _abcdk_comm_node_free(&node);
+
+    return NULL;
+}
+
+abcdk_comm_node_t *abcdk_comm_listen(abcdk_comm_t *ctx, int fd, const abcdk_comm_callback *cb, void *opaque)
+{
+    return _abcdk_comm_node_attach(ctx, fd, 1, cb, opaque, 0);
+}
+
+abcdk_comm_node_t *abcdk_comm_attach(abcdk_comm_t *ctx, int fd, const abcdk_comm_callback *cb, void *opaque, time_t timeout)
+{
+    return _abcdk_comm_node_attach(ctx, fd, 0, cb, opaque, timeout);
+}
+
+int abcdk_comm_fd(abcdk_comm_node_t *node)
+{
+    assert(node != NULL);
+
+    return node->fd;
+}
+
+static int _abcdk_comm_wq_push(abcdk_comm_node_t *node, const abcdk_comm_wq_item *item, int own)
+{
+    abcdk_comm_wq_item *list_new = NULL;
+    size_t max_new;
+
+    /*队列满了，翻倍扩容，保持原有顺序。*/
+    if (node->wq_count >= node->wq_max)
+    {
+        max_new = ABCDK_MAX(node->wq_max * 2, (size_t)8);
+
+        list_new = abcdk_heap_alloc(max_new * sizeof(abcdk_comm_wq_item));
+        if (!list_new)
+            ABCDK_ERRNO_AND_RETURN1(ENOMEM, -1);
+
+        for (size_t i = 0; i < node->wq_count; i++)
+            list_new[i] = node->wq_list[(node->wq_head + i) % node->wq_max];
+
+        abcdk_heap_free(node->wq_list);
+
+        node->wq_list = list_new;
+        node->wq_max = max_new;
+        node->wq_head = 0;
+    }
+
+    node->wq_list[(node->wq_head + node->wq_count) % node->wq_max] = *item;
+    node->wq_count += 1;
+    if (item->buf)
+        node->wq_bytes += item->buf->wsize - item->buf->rsize;
+    node->wq_tail_own = own;
+
+    return 0;
+}
+
+static void _abcdk_comm_wq_pop(abcdk_comm_node_t *node)
+{
+    abcdk_comm_wq_item item = node->wq_list[node->wq_head];
+    abcdk_buffer_t *buf = item.buf;
+
+    memset(&node->wq_list[node->wq_head], 0, sizeof(abcdk_comm_wq_item));
+    node->wq_head = (node->wq_head + 1) % node->wq_max;
+    node->wq_count -= 1;
+
+    if (!buf)
+    {
+        abcdk_closep(&item.fd);
+        return;
+    }
+
+    /*保留一个标准大小的缓存块，重复使用。*/
+    if (!node->wq_spare && buf->size == ABCDK_COMM_CHUNK_SIZE && buf->alloc)
+    {
+        buf->rsize = buf->wsize = 0;
+        node->wq_spare = buf;
+    }
+    else
+    {
+        abcdk_buffer_free(&buf);
+    }
+}
+
+static ssize_t _abcdk_comm_wq_append(abcdk_comm_node_t *node, const void *data, size_t size)
+{
+    abcdk_comm_wq_item item = {0};
+    abcdk_buffer_t *tail = NULL;
+    size_t remain = size;
+    ssize_t chk;
+
+    while (remain > 0)
+    {
+        tail = (node->wq_count > 0 ? node->wq_list[(node->wq_head + node->wq_count - 1) % node->wq_max].buf : NULL);
+
+        /*优先追加到队尾的缓存块，合并小的数据块。*/
+        if (tail && node->wq_tail_own && tail->wsize < tail->size)
+        {
+            chk = abcdk_buffer_write(tail, ABCDK_PTR2VPTR(data, size - remain), remain);
+            if (chk <= 0)
+                break;
+
+            remain -= chk;
+            node->wq_bytes += chk;
+            continue;
+        }
+
+        if (node->wq_spare && remain <= ABCDK_COMM_CHUNK_SIZE)
+        {
+            tail = node->wq_spare;
+            node->wq_spare = NULL;
+        }
+        else
+        {
+            tail = abcdk_buffer_alloc2(ABCDK_MAX(remain, (size_t)ABCDK_COMM_CHUNK_SIZE));
+            if (!tail)
+                break;
+        }
+
+        item.buf = tail;
+        if (_abcdk_comm_wq_push(node, &item, 1) != 0)
+        {
+            abcdk_buffer_free(&tail);
+            break;
+        }
+    }
+
+    if (remain == size)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, -1);
+
+    return size - remain;
+}
+
+static void _abcdk_comm_want_output(abcdk_comm_node_t *node)
+{
+    if (node->wq_count <= 0)
+        return;
+
+    /*超过高水位，暂停读取。*/
+    if (node->wq_bytes >= node->ctx->wq_high)
+        node->paused = 1;
+
+    if (node->wait_output)
+        return;
+
+    node->wait_output = 1;
+    abcdk_mux_mark(node->ctx->mux, node->fd, ABCDK_EPOLL_OUTPUT, 0);
+}
+
+ssize_t abcdk_comm_write(abcdk_comm_node_t *node, const void *data, size_t size)
+{
+    ssize_t wsize = 0;
+    ssize_t chk;
+
+    assert(node != NULL && data != NULL && size > 0);
+    assert(!node->listen);
+
+    abcdk_mutex_lock(&node->mutex, 1);
+
+    if (node->closed || node->closing)
+        ABCDK_ERRNO_AND_GOTO1(EPIPE, final_error);
+
+    /*写队列为空时直接发送，减少一次复制。*/
+    if (node->wq_count <= 0 && !node->wait_output)
+    {
+        wsize = send(node->fd, data, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (wsize < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                abcdk_mux_mark(node->ctx->mux, node->fd, ABCDK_EPOLL_ERROR, 0);
+                goto final_error;
+            }
+
+            wsize = 0;
+        }
+    }
+
+    /*未发送的部分加入写队列。*/
+    if (wsize < size)
+    {
+        chk = _abcdk_comm_wq_append(node, ABCDK_PTR2VPTR(data, wsize), size - wsize);
+        if (chk < 0 && wsize <= 0)
+            goto final_error;
+        if (chk > 0)
+            wsize += chk;
+
+        _abcdk_comm_want_output(node);
+    }
+
+    abcdk_mutex_unlock(&node->mutex);
+
+    return wsize;
+
+final_error:
+
+    abcdk_mutex_unlock(&node->mutex);
+
+    return -1;
+}
+
+int abcdk_comm_post(abcdk_comm_node_t *node, abcdk_buffer_t *buf)
+{
+    abcdk_comm_wq_item item = {0};
+    int chk = -1;
+
+    assert(node != NULL && buf != NULL);
+    assert(!node->listen);
+
+    abcdk_mutex_lock(&node->mutex, 1);
+
+    if (node->closed || node->closing)
+        ABCDK_ERRNO_AND_GOTO1(EPIPE, final);
+
+    /*没有数据，直接释放。*/
+    if (buf->wsize <= buf->rsize)
+    {
+        abcdk_buffer_free(&buf);
+        chk = 0;
+        goto final;
+    }
+
+    /*投递的缓存可能被共享，不能追加数据。*/
+    item.buf = buf;
+    chk = _abcdk_comm_wq_push(node, &item, 0);
+    if (chk == 0)
+        _abcdk_comm_want_output(node);
+
+final:
+
+    abcdk_mutex_unlock(&node->mutex);
+
+    return chk;
+}
+
+int abcdk_comm_sendfile(abcdk_comm_node_t *node, int fd, off_t offset, size_t size)
+{
+    abcdk_comm_wq_item item = {0};
+    int chk = -1;
+
+    assert(node != NULL && fd >= 0);
+    assert(!node->listen);
+
+    item.fd = -1;
+
+    abcdk_mutex_lock(&node->mutex, 1);
+
+    if (node->closed || node->closing)
+        ABCDK_ERRNO_AND_GOTO1(EPIPE, final);
+
+    /*复制句柄，调用者可以立即关闭自己的句柄。*/
+    item.fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (item.fd < 0)
+        goto final;
+
+    /*
+     * 不支持定位的源句柄(管道等)设为非阻塞，没有数据时不会阻塞调度线程(持有节点锁)。
+     * 复制的句柄与调用者的句柄共享文件描述，非阻塞标志对调用者的句柄同样生效。
+    */
+    if (lseek(item.fd, 0, SEEK_CUR) < 0 && abcdk_fflag_add(item.fd, O_NONBLOCK) != 0)
+    {
+        abcdk_closep(&item.fd);
+        goto final;
+    }
+
+    item.offset = offset;
+    item.remain = size;
+    item.to_eof = (size <= 0);
+
+    chk = _abcdk_comm_wq_push(node, &item, 0);
+    if (chk == 0)
+        _abcdk_comm_want_output(node);
+    else
+        abcdk_closep(&item.fd);
+
+final:
+
+    abcdk_mutex_unlock(&node->mutex);
+
+    return chk;
+}
+
+size_t abcdk_comm_pending(abcdk_comm_node_t *node)
+{
+    size_t bytes;
+
+    assert(node != NULL);
+
+    abcdk_mutex_lock(&node->mutex, 1);
+    bytes = node->wq_bytes;
+    abcdk_mutex_unlock(&node->mutex);
+
+    return bytes;
+}
+
+void abcdk_comm_close(abcdk_comm_node_t *node)
+{
+    assert(node != NULL);
+
+    abcdk_mutex_lock(&node->mutex, 1);
+
+    if (!node->closed && !node->closing)
+    {
+        node->closing = 1;
+
+        /*写队列为空时立即关闭，否则发送完后关闭。*/
+        if (node->wq_count <= 0)
+            abcdk_mux_mark(node->ctx->mux, node->fd, ABCDK_EPOLL_ERROR, 0);
+    }
+
+    abcdk_mutex_unlock(&node->mutex);
+}
+
+static void _abcdk_comm_process_accept(abcdk_comm_node_t *node)
+{
+    int fd;
+
+    /*接收到EAGAIN为止。*/
+    while (1)
+    {
+        fd = abcdk_accept(node->fd, NULL);
+        if (fd < 0)
+            break;
+
+        if (node->cb.accept_cb)
+            node->cb.accept_cb(node, fd, node->opaque);
+        else
+            abcdk_closep(&fd);
+    }
+
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR || errno == ECONNABORTED)
+        abcdk_mux_mark(node->ctx->mux, node->fd, ABCDK_EPOLL_INPUT, ABCDK_EPOLL_INPUT);
+    else
+        abcdk_mux_mark(node->ctx->mux, node->fd, ABCDK_EPOLL_ERROR, ABCDK_EPOLL_INPUT);
+}
+
+static void _abcdk_comm_process_input(abcdk_comm_node_t *node)
+{
+    abcdk_buffer_t *rbuf = node->rbuf;
+    uint32_t want = ABCDK_EPOLL_ERROR;
+    ssize_t rsize;
+    int paused;
+
+    /*读取到EAGAIN为止。*/
+    while (1)
+    {
+        /*读缓存满了，并且没有数据被读取，无法继续。*/
+        if (rbuf->wsize >= rbuf->size)
+            break;
+
+        rsize = abcdk_buffer_import_atmost(rbuf, node->fd, rbuf->size - rbuf->wsize);
+        if (rsize <= 0)
+        {
+            if (rsize < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+                want = ABCDK_EPOLL_INPUT;
+
+            break;
+        }
+
+        if (node->cb.read_cb)
+            node->cb.read_cb(node, rbuf, node->opaque);
+        else
+            rbuf->rsize = rbuf->wsize;
+
+        /*移除已读取的数据，未读取的数据保留到下一次。*/
+        if (rbuf->rsize > 0)
+            abcdk_buffer_drain(rbuf);
+
+        abcdk_mutex_lock(&node->mutex, 1);
+        paused = node->paused;
+        abcdk_mutex_unlock(&node->mutex);
+
+        /*写队列超过高水位，暂停读取，由写事件恢复。*/
+        if (paused)
+        {
+            want = 0;
+            break;
+        }
+    }
+
+    abcdk_mux_mark(node->ctx->mux, node->fd, want, ABCDK_EPOLL_INPUT);
+}
+
+/*
+ * 发送文件区间。
+ *
+ * @return 1 继续发送，0 等待套接字可写，2 等待源句柄可读，-1 出错。
+*/
+static int _abcdk_comm_send_file(abcdk_comm_node_t *node, abcdk_comm_wq_item *item)
+{
+    off_t *off = (item->offset >= 0 ? &item->offset : NULL);
+    ssize_t wsize;
+
+    if (!item->splice)
+    {
+        wsize = sendfile(node->fd, item->fd, off, (item->to_eof ? ABCDK_COMM_FILE_STEP : ABCDK_MIN(item->remain, (size_t)ABCDK_COMM_FILE_STEP)));
+        if (wsize > 0)
+        {
+            if (!item->to_eof)
+                item->remain -= wsize;
+            if (!item->to_eof && item->remain <= 0)
+                _abcdk_comm_wq_pop(node);
+
+            return 1;
+        }
+
+        /*读到文件末尾。*/
+        if (wsize == 0)
+        {
+            if (!item->to_eof)
+                ABCDK_ERRNO_AND_RETURN1(EIO, -1);
+
+            _abcdk_comm_wq_pop(node);
+            return 1;
+        }
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+            return 0;
+
+        /*源句柄不支持sendfile(管道、字符设备等)，改为经管道转发。*/
+        if (errno != EINVAL && errno != ENOSYS)
+            return -1;
+
+        item->splice = 1;
+    }
+
+    if (node->pipe_fds[0] < 0)
+    {
+        if (pipe2(node->pipe_fds, O_NONBLOCK | O_CLOEXEC) != 0)
+            return -1;
+    }
+
+    /*先把管道中的数据发送出去。*/
+    if (node->pipe_bytes > 0)
+    {
+        wsize = splice(node->pipe_fds[0], NULL, node->fd, NULL, node->pipe_bytes, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (wsize > 0)
+        {
+            node->pipe_bytes -= wsize;
+            return 1;
+        }
+
+        if (wsize < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+            return 0;
+
+        return -1;
+    }
+
+    /*管道为空，并且源数据已经全部转发。*/
+    if (!item->to_eof && item->remain <= 0)
+    {
+        _abcdk_comm_wq_pop(node);
+        return 1;
+    }
+
+    wsize = splice(item->fd, off, node->pipe_fds[1], NULL, (item->to_eof ? ABCDK_COMM_PIPE_STEP : ABCDK_MIN(item->remain, (size_t)ABCDK_COMM_PIPE_STEP)), SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (wsize > 0)
+    {
+        node->pipe_bytes += wsize;
+        if (!item->to_eof)
+            item->remain -= wsize;
+
+        return 1;
+    }
+
+    /*读到文件末尾。*/
+    if (wsize == 0)
+    {
+        if (!item->to_eof)
+            ABCDK_ERRNO_AND_RETURN1(EIO, -1);
+
+        item->to_eof = 0;
+        item->remain = 0;
+        return 1;
+    }
+
+    /*管道是空的，源句柄暂时没有数据。*/
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+        return 2;
+
+    if (errno == EINTR)
+        return 1;
+
+    return -1;
+}
+
+static int _abcdk_comm_source_wait(abcdk_comm_node_t *node, abcdk_comm_wq_item *item)
+{
+    epoll_data_t data;
+
+    /*再复制一个句柄关联到多路复用器，文件区间出队时关闭自己的句柄不影响关联。*/
+    node->src_fd = fcntl(item->fd, F_DUPFD_CLOEXEC, 0);
+    if (node->src_fd < 0)
+        return -1;
+
+    /*关联数据的最低位是1，与通讯节点的事件区分开。*/
+    data.u64 = (uint64_t)(uintptr_t)node | 1;
+    if (abcdk_mux_attach(node->ctx->mux, node->src_fd, &data, 0) != 0)
+    {
+        abcdk_closep(&node->src_fd);
+        return -1;
+    }
+
+    /*关联期间持有引用，处理源句柄的事件时节点不会被释放。*/
+    abcdk_comm_refer(node);
+
+    abcdk_mux_mark(node->ctx->mux, node->src_fd, ABCDK_EPOLL_INPUT, 0);
+
+    return 0;
+}
+
+static int _abcdk_comm_source_detach(abcdk_comm_node_t *node, uint32_t events)
+{
+    abcdk_mux_t *mux = node->ctx->mux;
+
+    if (events)
+        abcdk_mux_unref(mux, node->src_fd, events);
+
+    /*事件还在处理中，由事件的处理线程分离。*/
+    if (abcdk_mux_detach(mux, node->src_fd) != 0)
+        return -1;
+
+    abcdk_closep(&node->src_fd);
+
+    return 0;
+}
+
+static void _abcdk_comm_process_output(abcdk_comm_node_t *node)
+{
+    struct iovec iov[ABCDK_COMM_IOV_MAX];
+    abcdk_comm_wq_item *item;
+    uint32_t want = 0;
+    int resume = 0;
+    int count;
+    ssize_t wsize;
+    int chk;
+
+    abcdk_mutex_lock(&node->mutex, 1);
+
+    /*发送到队列为空或EAGAIN为止。*/
+    while (node->wq_count > 0)
+    {
+        /*文件区间，不经过用户空间。*/
+        if (!node->wq_list[node->wq_head].buf)
+        {
+            chk = _abcdk_comm_send_file(node, &node->wq_list[node->wq_head]);
+            if (chk == 1)
+                continue;
+
+            /*源句柄暂时没有数据，套接字仍然可写，等待源句柄可读后再注册输出事件。*/
+            if (chk == 2 && _abcdk_comm_source_wait(node, &node->wq_list[node->wq_head]) == 0)
+                want = 0;
+            else
+                want = (chk >= 0 ? ABCDK_EPOLL_OUTPUT : ABCDK_EPOLL_ERROR);
+
+            break;
+        }
+
+        /*合并连续的缓存块，遇到文件区间为止。*/
+        for (count = 0; count < node->wq_count && count < ABCDK_COMM_IOV_MAX; count++)
+        {
+            item = &node->wq_list[(node->wq_head + count) % node->wq_max];
+            if (!item->buf)
+                break;
+
+            iov[count].iov_base = ABCDK_PTR2VPTR(item->buf->data, item->buf->rsize);
+            iov[count].iov_len = item->buf->wsize - item->buf->rsize;
+        }
+
+        wsize = writev(node->fd, iov, count);
+        if (wsize < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                want = ABCDK_EPOLL_OUTPUT;
+            else
+                want = ABCDK_EPOLL_ERROR;
+
+            break;
+        }
+
+        node->wq_bytes -= wsize;
+
+        /*移除已发送的缓存块(包括空的)。*/
+        while (node->wq_count > 0)
+        {
+            item = &node->wq_list[node->wq_head];
+            if (!item->buf)
+                break;
+
+            if (wsize < item->buf->wsize - item->buf->rsize)
+            {
+                item->buf->rsize += wsize;
+                break;
+            }
+
+            wsize -= item->buf->wsize - item->buf->rsize;
+            _abcdk_comm_wq_pop(node);
+        }
+    }
+
+    if (node->wq_count <= 0)
+    {
+        node->wait_output = 0;
+
+        /*发送完后关闭。*/
+        if (node->closing)
+            want = ABCDK_EPOLL_ERROR;
+    }
+
+    /*降到低水位以下，恢复读取。*/
+    if (node->paused && node->wq_bytes <= node->ctx->wq_low)
+    {
+        node->paused = 0;
+        resume = 1;
+    }
+
+    abcdk_mux_mark(node->ctx->mux, node->fd, want, ABCDK_EPOLL_OUTPUT);
+
+    abcdk_mutex_unlock(&node->mutex);
+
+    if (resume)
+    {
+        abcdk_mux_mark(node->ctx->mux, node->fd, ABCDK_EPOLL_INPUT, 0);
+
+        if (node->cb.writable_cb)
+            node->cb.writable_cb(node, node->opaque);
+    }
+}
+
+static void _abcdk_comm_process_source(abcdk_comm_node_t *node, uint32_t events)
+{
+    abcdk_mutex_lock(&node->mutex, 1);
+
+    /*源句柄可读或出错(写端关闭)，停止等待，恢复发送。*/
+    _abcdk_comm_source_detach(node, events);
+
+    /*节点已关闭时，写队列已清空。*/
+    if (!node->closed)
+        abcdk_mux_mark(node->ctx->mux, node->fd, ABCDK_EPOLL_OUTPUT, 0);
+
+    abcdk_mutex_unlock(&node->mutex);
+
+    /*释放关联源句柄时的引用。*/
+    abcdk_comm_unref(&node);
+}
+
+static void _abcdk_comm_process_error(abcdk_comm_node_t *node, uint32_t events)
+{
+    abcdk_comm_node_t *src_ref = NULL;
+    abcdk_mux_t *mux = node->ctx->mux;
+    int fd = node->fd;
+
+    /*出错事件只在其它事件全部处理完后才会分派，这里不会有其它回调并发执行。*/
+    if (node->cb.close_cb)
+        node->cb.close_cb(node, node->opaque);
+
+    abcdk_mux_unref(mux, fd, events);
+    abcdk_mux_detach(mux, fd);
+
+    abcdk_mutex_lock(&node->mutex, 1);
+
+    node->closed = 1;
+    _abcdk_comm_wq_clear(node);
+    abcdk_closep(&node->fd);
+
+    /*正在等待源句柄，分离成功后释放关联源句柄时的引用。*/
+    if (node->src_fd >= 0 && _abcdk_comm_source_detach(node, 0) == 0)
+        src_ref = node;
+
+    abcdk_mutex_unlock(&node->mutex);
+
+    abcdk_comm_unref(&src_ref);
+
+    /*释放关联时的引用。*/
+    abcdk_comm_unref(&node);
+}
+
+int abcdk_comm_dispatch(abcdk_comm_t *ctx, time_t timeout)
+{
+    abcdk_epoll_event events[ABCDK_COMM_DISPATCH_MAX];
+    abcdk_comm_node_t *node;
+    int count;
+
+    assert(ctx != NULL);
+
+    count = abcdk_mux_wait_batch(ctx->mux, events, ABCDK_COMM_DISPATCH_MAX, timeout);
+
+    for (int i = 0; i < count; i++)
+    {
+        /*源句柄的事件(关联数据的最低位是1)。*/
+        if (events[i].data.u64 & 1)
+        {
+            _abcdk_comm_process_source((abcdk_comm_node_t *)(uintptr_t)(events[i].data.u64 & ~(uint64_t)1), events[i].events);
+            continue;
+        }
+
+        node = (abcdk_comm_node_t *)events[i].data.ptr;
+
+        if (events[i].events & ABCDK_EPOLL_ERROR)
+        {
+            _abcdk_comm_process_error(node, events[i].events);
+            continue;
+        }
+
+        if (events[i].events & ABCDK_EPOLL_INPUT)
+        {
+            if (node->listen)
+                _abcdk_comm_process_accept(node);
+            else
+                _abcdk_comm_process_input(node);
+        }
+
+        if (events[i].events & ABCDK_EPOLL_OUTPUT)
+            _abcdk_comm_process_output(node);
+
+        abcdk_mux_unref(ctx->mux, node->fd, events[i].events);
+    }
+
+    return count;
+}
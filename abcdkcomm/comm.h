@@ -0,0 +1,210 @@
+/*
+ * This file is part of ABCDK.
+ *
+ * MIT License
+ *
+ */
+#ifndef ABCDKCOMM_COMM_H
+#define ABCDKCOMM_COMM_H
+
+#include "abcdkutil/buffer.h"
+#include "abcdkutil/socket.h"
+#include "abcdkcomm/mux.h"
+
+__BEGIN_DECLS
+
+/** 通讯环境。*/
+typedef struct _abcdk_comm abcdk_comm_t;
+
+/** 通讯节点(监听或连接)。*/
+typedef struct _abcdk_comm_node abcdk_comm_node_t;
+
+/**
+ * 通讯节点的回调函数。
+ *
+ * @note 同一个节点的读回调不会并发执行，读回调与写回调可能在不同的线程中并发执行。
+ * @note 关闭回调执行时，其它回调已经全部返回，并且不会再被调用。
+*/
+typedef struct _abcdk_comm_callback
+{
+    /**
+     * 新连接通知(仅监听节点)。
+     *
+     * 需要调用abcdk_comm_attach关联新连接，或者关闭句柄。NULL(0) 直接关闭新连接。
+    */
+    void (*accept_cb)(abcdk_comm_node_t *node, int fd, void *opaque);
+
+    /**
+     * 数据到达通知。
+     *
+     * 数据在读缓存中，使用abcdk_buffer_read等接口读取，未读取的数据保留到下一次通知。
+     *
+     * @note 读缓存满了并且没有数据被读取时，连接被关闭。
+    */
+    void (*read_cb)(abcdk_comm_node_t *node, abcdk_buffer_t *rbuf, void *opaque);
+
+    /**
+     * 可写通知。
+     *
+     * 写队列超过高水位后暂停读取，降到低水位以下时恢复读取，并发出此通知。
+    */
+    void (*writable_cb)(abcdk_comm_node_t *node, void *opaque);
+
+    /**
+     * 关闭通知(出错、超时、对端关闭或主动关闭)。
+     *
+     * 回调返回后句柄被关闭，节点被释放(如果没有其它引用)。
+    */
+    void (*close_cb)(abcdk_comm_node_t *node, void *opaque);
+
+} abcdk_comm_callback;
+
+/**
+ * 通讯环境参数。
+ *
+ * @note 未填写(0)的参数使用默认值。
+*/
+typedef struct _abcdk_comm_param
+{
+    /** 多路复用器参数。*/
+    abcdk_mux_param mux;
+
+    /** 读缓存大小(每个连接)。默认：64K。*/
+    size_t rbuf_size;
+
+    /** 写队列的高水位(字节)。默认：1M。*/
+    size_t wq_high;
+
+    /** 写队列的低水位(字节)。默认：高水位的1/4。*/
+    size_t wq_low;
+
+} abcdk_comm_param;
+
+/**
+ * 销毁通讯环境。
+ *
+ * @warning 所有节点关闭后，并且没有线程在调度时才能销毁。
+*/
+void abcdk_comm_free(abcdk_comm_t **ctx);
+
+/**
+ * 创建通讯环境。
+ *
+ * @param param 参数，NULL(0) 全部使用默认值。
+ *
+ * @return !NULL(0) 成功(环境指针)，NULL(0) 失败。
+*/
+abcdk_comm_t *abcdk_comm_alloc(const abcdk_comm_param *param);
+
+/**
+ * 获取多路复用器。
+ *
+ * @note 仅用于获取统计信息等，不要关联其它句柄。
+*/
+abcdk_mux_t *abcdk_comm_mux(abcdk_comm_t *ctx);
+
+/**
+ * 关联监听句柄。
+ *
+ * @param fd 已经监听的句柄。关联成功后，句柄由节点管理。
+ *
+ * @return !NULL(0) 成功(节点指针)，NULL(0) 失败。
+*/
+abcdk_comm_node_t *abcdk_comm_listen(abcdk_comm_t *ctx, int fd, const abcdk_comm_callback *cb, void *opaque);
+
+/**
+ * 关联连接句柄。
+ *
+ * @param fd 已经连接的句柄。关联成功后，句柄由节点管理。
+ * @param timeout 超时(毫秒)，<=0 忽略。
+ *
+ * @return !NULL(0) 成功(节点指针)，NULL(0) 失败。
+*/
+abcdk_comm_node_t *abcdk_comm_attach(abcdk_comm_t *ctx, int fd, const abcdk_comm_callback *cb, void *opaque, time_t timeout);
+
+/**
+ * 节点引用。
+ *
+ * 节点在关闭后释放，在回调函数之外使用节点，需要先增加引用。
+*/
+abcdk_comm_node_t *abcdk_comm_refer(abcdk_comm_node_t *node);
+
+/**
+ * 节点引用释放。
+*/
+void abcdk_comm_unref(abcdk_comm_node_t **node);
+
+/**
+ * 获取节点的句柄。
+ *
+ * @return >= 0 句柄，-1 已关闭。
+*/
+int abcdk_comm_fd(abcdk_comm_node_t *node);
+
+/**
+ * 写数据。
+ *
+ * 写队列为空时直接发送，未发送的部分复制到写队列，由调度线程发送(writev)。
+ *
+ * @return > 0 成功(写入的长度)，-1 失败(已关闭或内存不足)。
+*/
+ssize_t abcdk_comm_write(abcdk_comm_node_t *node, const void *data, size_t size);
+
+/**
+ * 投递缓存。
+ *
+ * 未读取的数据(rsize ~ wsize)加入写队列，不复制。
+ *
+ * @param buf 缓存。成功后由写队列管理，失败后调用者管理。
+ *
+ * @return 0 成功，-1 失败(已关闭或内存不足)。
+*/
+int abcdk_comm_post(abcdk_comm_node_t *node, abcdk_buffer_t *buf);
+
+/**
+ * 投递文件区间。
+ *
+ * 与缓存按顺序加入写队列，由调度线程使用sendfile发送，不经过用户空间。
+ * 源句柄不支持sendfile时(管道、磁带等字符设备)，经内部管道使用splice转发。
+ *
+ * @note 文件区间不计入写队列的水位。
+ * @note 不支持定位的源句柄，从当前位置读取，并且被设为非阻塞。复制的句柄与调用者的句柄共享
+ * 文件描述(包括读写位置和O_NONBLOCK标志)，调用者的句柄也会变为非阻塞。
+ * @note 源句柄暂时没有数据时，停止等待套接字可写，源句柄可读(或写端关闭)后再继续发送，
+ * 期间源句柄的一个复制句柄关联在多路复用器中。
+ * @note 字符设备(如磁带)的驱动可能忽略O_NONBLOCK，读取仍可能阻塞调度线程。
+ *
+ * @param fd 文件句柄。句柄被复制，调用者可以立即关闭。
+ * @param offset 偏移量。< 0 从当前位置读取。
+ * @param size 长度。0 读到文件末尾为止。
+ *
+ * @return 0 成功，-1 失败(已关闭或内存不足)。
+*/
+int abcdk_comm_sendfile(abcdk_comm_node_t *node, int fd, off_t offset, size_t size);
+
+/**
+ * 获取写队列中缓存的数据长度(不包括文件区间)。
+*/
+size_t abcdk_comm_pending(abcdk_comm_node_t *node);
+
+/**
+ * 关闭连接。
+ *
+ * 写队列中的数据发送完后关闭。
+*/
+void abcdk_comm_close(abcdk_comm_node_t *node);
+
+/**
+ * 调度。
+ *
+ * 等待事件，并执行相应的回调函数。可以在多个线程中同时调用。
+ *
+ * @param timeout 超时(毫秒)。>= 0 有事件或时间过期，< 0 直到有事件或出错。
+ *
+ * @return > 0 成功(处理的事件数量)，<= 0 失败(或超时)。
+*/
+int abcdk_comm_dispatch(abcdk_comm_t *ctx, time_t timeout);
+
+__END_DECLS
+
+#endif //ABCDKCOMM_COMM_H
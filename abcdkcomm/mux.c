@@ -6,35 +6,166 @@
  */
 #include "mux.h"
 
+/** 缓存行长度。*/
+#define ABCDK_MUX_CACHELINE 64
+
+/** 节点表的最小容量。*/
+#define ABCDK_MUX_NODE_MIN 64
+
+/** 看门狗时间轮的槽位数量。*/
+#define ABCDK_MUX_WHEEL_SLOTS 256
+
+/** 看门狗默认刻度(毫秒)。*/
+#define ABCDK_MUX_WHEEL_TICK 100
+
+/** IO等待一次获取事件的默认数量。*/
+#define ABCDK_MUX_WAIT_MAX 20
+
+/** IO_URING提交队列的最小长度。*/
+#define ABCDK_MUX_URING_ENTRIES 256
+
+/** IO_URING已注册标志。*/
+#define ABCDK_MUX_URING_ARMED 0x80000000
+
 /**
- * 多路复用器。
+ * 分片的统计计数器。
+ * 
+ * 只在分片的临界区内更新(原子写入)，读取时不加锁(原子读取)。
+ * 单独占用缓存行，读取时不干扰分片的其它字段。
 */
-typedef struct _abcdk_mux
+typedef struct _abcdk_mux_counter
+{
+    uint64_t queue_count;
+    uint64_t queue_size;
+    uint64_t queue_peak;
+    uint64_t queue_overflow;
+    uint64_t event_input;
+    uint64_t event_inoob;
+    uint64_t event_output;
+    uint64_t event_error;
+    uint64_t wait_calls;
+    uint64_t wait_events;
+    uint64_t leader_handoffs;
+    uint64_t lock_acquires;
+    uint64_t lock_contended;
+    uint64_t lock_wait_ns;
+    uint64_t watchdog_timeouts;
+    uint64_t latency_hist[ABCDK_MUX_STAT_HIST_BUCKETS];
+
+} __attribute__((aligned(ABCDK_MUX_CACHELINE))) abcdk_mux_counter;
+
+/**
+ * 事件队列的元素。
+*/
+typedef struct _abcdk_mux_queue_item
+{
+    /** 事件。*/
+    abcdk_epoll_event event;
+
+    /** 就绪时间(纳秒)。*/
+    uint64_t ready;
+
+} abcdk_mux_queue_item;
+
+/**
+ * 多路复用器的分片。
+*/
+typedef struct _abcdk_mux_shard
 {
     /** epoll句柄。 >= 0 有效。*/
     int efd;
 
+    /** IO_URING环境。!NULL(0) 有效，代替epoll句柄。*/
+    abcdk_uring_t *uring;
+
+    /** WAIT主线程是否阻塞在IO等待中(仅单分片)。!0 是，0 否。*/
+    volatile int wait_blocking;
+
+    /** 多路复用器中等待事件的线程数量(仅多分片)。NULL(0) 无效。*/
+    volatile int *wait_idle;
+
     /** 互斥量。*/
     abcdk_mutex_t mutex;
 
-    /** 节点表。*/
-    abcdk_map_t node_map;
+    /**
+     * 节点表。
+     * 
+     * 按句柄直接索引(fd / shards)，缓存行对齐，按需增长。
+    */
+    struct _abcdk_mux_node *node_table;
+
+    /** 节点表容量。*/
+    size_t node_max;
 
-    /** 事件池。*/
+    /**
+     * 事件池。
+     * 
+     * 满了自动扩容，不丢弃事件。
+    */
     abcdk_pool_t event_pool;
 
     /** WAIT主线程ID。*/
     volatile pthread_t wait_leader;
 
-    /** 看门狗活动时间(毫秒)。*/
-    time_t watchdog_active;
+    /** IO等待的事件数组，仅WAIT主线程访问。*/
+    abcdk_epoll_event *wait_events;
+
+    /** IO等待一次获取事件的最大数量。*/
+    int wait_max;
+
+    /**
+     * 看门狗时间轮。
+     * 
+     * 每个槽位是一个节点链表的表头(句柄)，-1 空。节点按(活动时间+超时)散列到槽位，
+     * 活动时间更新时不移动节点，到期检查时再重新散列(惰性)。
+    */
+    int wheel_slots[ABCDK_MUX_WHEEL_SLOTS];
+
+    /** 时间轮刻度(毫秒)。*/
+    time_t wheel_tick;
 
-    /** 看门狗活动间隔(毫秒)。*/
-    time_t watchdog_intvl;
+    /** 时间轮已处理的刻度。*/
+    uint64_t wheel_cursor;
+
+    /** 时间轮中的节点数量。*/
+    size_t wheel_count;
+
+    /** 统计计数器。*/
+    abcdk_mux_counter counter;
+
+} abcdk_mux_shard;
+
+/**
+ * 多路复用器。
+*/
+typedef struct _abcdk_mux
+{
+    /** 分片数量。*/
+    size_t shards;
+
+    /** 分片表。*/
+    abcdk_mux_shard **shard_list;
+
+    /**
+     * 上级EPOLL句柄(仅多分片)。
+     * 
+     * 包括每个分片的IO句柄(边沿触发)和唤醒句柄，空闲的线程在这里等待任意分片的事件。-1 无效。
+    */
+    int efd;
+
+    /**
+     * 唤醒句柄(eventfd)。-1 无效。
+     * 
+     * 多分片时注册到上级EPOLL句柄中，单分片时注册到分片的IO句柄中。
+    */
+    int kick;
+
+    /** 线程序号(用于分配线程所属的分片)。*/
+    volatile int thread_seq;
+
+    /** 等待事件的线程数量(仅多分片)。*/
+    volatile int wait_idle;
 
-    /** 广播事件。*/
-    uint32_t broadcast_want;
-    
 } abcdk_mux_t;
 
 /**
@@ -49,7 +180,16 @@ typedef struct _abcdk_mux_node
     epoll_data_t data;
 
     /** 状态。!0 正常，0 异常。 */
-    int stable;
+    uint8_t stable;
+
+    /** 是否第一次注册。!0 是，0 否。*/
+    uint8_t mark_first;
+
+    /** 是否第一次添加。!0 是，0 否。*/
+    uint8_t add_first;
+
+    /** IO_URING注册序号，用于识别过期的完成事件。分离后保留。*/
+    uint32_t uring_seq;
 
     /** 注册事件。*/
     uint32_t event_mark;
@@ -60,20 +200,143 @@ typedef struct _abcdk_mux_node
     /** 引用计数。*/
     int refcount;
 
+    /** 时间轮槽位。-1 不在时间轮中。*/
+    int wheel_slot;
+
+    /** 时间轮链表的前一个节点(句柄)。-1 无。*/
+    int wheel_prev;
+
+    /** 时间轮链表的后一个节点(句柄)。-1 无。*/
+    int wheel_next;
+
+    /** IO_URING已注册的事件(包括ABCDK_MUX_URING_ARMED标志)。0 未注册。*/
+    uint32_t uring_armed;
+
     /** 活动时间(毫秒)。*/
     time_t active;
 
     /** 超时(毫秒)。*/
     time_t timeout;
 
-    /** 是否第一次注册。!0 是，0 否。*/
-    int mark_first;
-    
-    /** 是否第一次添加。!0 是，0 否。*/
-    int add_first;
+} __attribute__((aligned(ABCDK_MUX_CACHELINE))) abcdk_mux_node;
+
+/** 当前线程最近一次使用的多路复用器。*/
+static __thread abcdk_mux_t *_abcdk_mux_thread_ctx = NULL;
 
-}abcdk_mux_node;
+/** 当前线程在多路复用器中所属的分片。*/
+static __thread size_t _abcdk_mux_thread_home = 0;
 
+/** 计数器增加(仅在临界区内调用)。*/
+#define ABCDK_MUX_COUNTER_ADD(shard, field, n) \
+    __atomic_store_n(&(shard)->counter.field, (shard)->counter.field + (n), __ATOMIC_RELAXED)
+
+/** 计数器赋值(仅在临界区内调用)。*/
+#define ABCDK_MUX_COUNTER_SET(shard, field, v) \
+    __atomic_store_n(&(shard)->counter.field, (v), __ATOMIC_RELAXED)
+
+/** 计数器读取(不需要加锁)。*/
+#define ABCDK_MUX_COUNTER_GET(shard, field) \
+    __atomic_load_n(&(shard)->counter.field, __ATOMIC_RELAXED)
+
+static void _abcdk_mux_shard_lock(abcdk_mux_shard *shard)
+{
+    uint64_t begin;
+
+    /*没有竞争时不读取时钟。*/
+    if (abcdk_mutex_lock(&shard->mutex, 0) != 0)
+    {
+        begin = abcdk_time_clock2kind_with(CLOCK_MONOTONIC, 9);
+        abcdk_mutex_lock(&shard->mutex, 1);
+
+        ABCDK_MUX_COUNTER_ADD(shard, lock_contended, 1);
+        ABCDK_MUX_COUNTER_ADD(shard, lock_wait_ns, abcdk_time_clock2kind_with(CLOCK_MONOTONIC, 9) - begin);
+    }
+
+    ABCDK_MUX_COUNTER_ADD(shard, lock_acquires, 1);
+}
+
+static void _abcdk_mux_shard_free(abcdk_mux_shard **shard)
+{
+    abcdk_mux_shard *shard_p;
+
+    if(!shard || !*shard)
+        return;
+
+    shard_p = *shard;
+
+    abcdk_closep(&shard_p->efd);
+    abcdk_uring_free(&shard_p->uring);
+    abcdk_pool_destroy(&shard_p->event_pool);
+    abcdk_heap_free(shard_p->node_table);
+    abcdk_heap_free(shard_p->wait_events);
+    abcdk_mutex_destroy(&shard_p->mutex);
+
+    /*free.*/
+    abcdk_heap_free(shard_p);
+
+    /*Set to NULL(0).*/
+    *shard = NULL;
+}
+
+static abcdk_mux_shard *_abcdk_mux_shard_alloc(time_t tick, int wait_max, size_t queue_size, int backend)
+{
+    int efd = -1;
+    abcdk_uring_t *uring = NULL;
+    abcdk_mux_shard *shard = NULL;
+
+    if (backend == ABCDK_MUX_BACKEND_URING)
+    {
+        uring = abcdk_uring_alloc(ABCDK_MAX(4 * wait_max, ABCDK_MUX_URING_ENTRIES));
+        if (!uring)
+            syslog(LOG_INFO, "mux: io_uring is not available(errno=%d), fall back to epoll.", errno);
+    }
+
+    if (!uring)
+    {
+        efd = abcdk_epoll_create();
+        if (efd < 0)
+            goto final_error;
+    }
+
+    shard = abcdk_heap_alloc(sizeof(abcdk_mux_shard));
+    if(!shard)
+        goto final_error;
+
+    shard->wait_events = abcdk_heap_alloc(wait_max * sizeof(abcdk_epoll_event));
+    if (!shard->wait_events)
+        goto final_error;
+
+    shard->efd = efd;
+    shard->uring = uring;
+    shard->wait_blocking = 0;
+    shard->wait_idle = NULL;
+    shard->wait_max = wait_max;
+    if (abcdk_pool_init(&shard->event_pool, sizeof(abcdk_mux_queue_item), queue_size) != 0)
+        goto final_error;
+    shard->counter.queue_size = shard->event_pool.table->numbers;
+    abcdk_mutex_init2(&shard->mutex,0);
+    shard->wheel_tick = tick;
+    shard->wheel_cursor = abcdk_time_clock2kind_with(CLOCK_MONOTONIC,3) / tick;
+    shard->wheel_count = 0;
+    for (size_t i = 0; i < ABCDK_MUX_WHEEL_SLOTS; i++)
+        shard->wheel_slots[i] = -1;
+    shard->wait_leader = 0;
+
+    return shard;
+
+final_error:
+
+    abcdk_closep(&efd);
+    abcdk_uring_free(&uring);
+    if (shard)
+    {
+        abcdk_pool_destroy(&shard->event_pool);
+        abcdk_heap_free(shard->wait_events);
+    }
+    abcdk_heap_free(shard);
+
+    return NULL;
+}
 
 void abcdk_mux_free(abcdk_mux_t **ctx)
 {
@@ -84,71 +347,379 @@ void abcdk_mux_free(abcdk_mux_t **ctx)
 
     ctx_p = *ctx;
 
+    if (ctx_p->shard_list)
+    {
+        for (size_t i = 0; i < ctx_p->shards; i++)
+            _abcdk_mux_shard_free(&ctx_p->shard_list[i]);
+    }
+
     abcdk_closep(&ctx_p->efd);
-    abcdk_pool_destroy(&ctx_p->event_pool);
-    abcdk_map_destroy(&ctx_p->node_map);
-    abcdk_mutex_destroy(&ctx_p->mutex);
+    abcdk_closep(&ctx_p->kick);
 
     /*free.*/
+    abcdk_heap_free(ctx_p->shard_list);
     abcdk_heap_free(ctx_p);
 
     /*Set to NULL(0).*/
     *ctx = NULL;
 }
 
+static int _abcdk_mux_parent_init(abcdk_mux_t *ctx)
+{
+    abcdk_mux_shard *shard = NULL;
+    abcdk_epoll_event tmp = {0};
+
+    ctx->efd = abcdk_epoll_create();
+    if (ctx->efd < 0)
+        return -1;
+
+    ctx->kick = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ctx->kick < 0)
+        return -1;
+
+    /*唤醒句柄的关联数据是分片数量。*/
+    tmp.events = ABCDK_EPOLL_INPUT;
+    tmp.data.u64 = ctx->shards;
+    if (abcdk_epoll_mark(ctx->efd, ctx->kick, &tmp, 1) != 0)
+        return -1;
+
+    for (size_t i = 0; i < ctx->shards; i++)
+    {
+        shard = ctx->shard_list[i];
+
+        /*分片的IO句柄有事件就绪时可读，关联数据是分片序号。*/
+        tmp.events = ABCDK_EPOLL_INPUT;
+        tmp.data.u64 = i;
+        if (abcdk_epoll_mark(ctx->efd, (shard->uring ? abcdk_uring_fd(shard->uring) : shard->efd), &tmp, 1) != 0)
+            return -1;
+
+        /*没有线程阻塞在分片的IO等待中，有线程等待事件时注册需要立即提交。*/
+        shard->wait_idle = &ctx->wait_idle;
+    }
+
+    return 0;
+}
+
+static int _abcdk_mux_single_init(abcdk_mux_t *ctx)
+{
+    abcdk_mux_shard *shard = ctx->shard_list[0];
+    abcdk_epoll_event tmp = {0};
+
+    ctx->kick = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (ctx->kick < 0)
+        return -1;
+
+    /*唤醒句柄注册到分片的IO句柄中，可以唤醒阻塞在IO等待中的主线程。注册序号是0，节点不会使用。*/
+    if (shard->uring)
+        return abcdk_uring_poll_add(shard->uring, ctx->kick, ABCDK_EPOLL_INPUT, (uint32_t)ctx->kick);
+
+    tmp.events = ABCDK_EPOLL_INPUT;
+    tmp.data.fd = ctx->kick;
+
+    return abcdk_epoll_mark(shard->efd, ctx->kick, &tmp, 1);
+}
+
 abcdk_mux_t *abcdk_mux_alloc()
 {
-    int efd = -1;
+    return abcdk_mux_alloc2(NULL);
+}
+
+abcdk_mux_t *abcdk_mux_alloc2(const abcdk_mux_param *param)
+{
     abcdk_mux_t *ctx = NULL;
-    
-    efd = abcdk_epoll_create();
-    if (efd < 0)
-        goto final_error;
+    size_t shards = 1;
+    time_t tick = ABCDK_MUX_WHEEL_TICK;
+    int wait_max = ABCDK_MUX_WAIT_MAX;
+    size_t queue_size = 0;
+    int backend = ABCDK_MUX_BACKEND_EPOLL;
+
+    if (param && param->shards > 1)
+        shards = param->shards;
+    if (param && param->watchdog_tick > 0)
+        tick = param->watchdog_tick;
+    if (param && param->wait_max > 0)
+        wait_max = param->wait_max;
+    if (param && param->queue_size > 0)
+        queue_size = param->queue_size;
+    else
+        queue_size = 4 * wait_max + 20;
+    if (param)
+        backend = param->backend;
 
     ctx = abcdk_heap_alloc(sizeof(abcdk_mux_t));
     if(!ctx)
         goto final_error;
 
-    ctx->efd = efd;
-    abcdk_pool_init(&ctx->event_pool, sizeof(abcdk_epoll_event), 4 * 20 + 20);
-    abcdk_map_init(&ctx->node_map,400);
-    abcdk_mutex_init2(&ctx->mutex,0);
-    ctx->watchdog_intvl = 5000;
-    ctx->watchdog_active = abcdk_time_clock2kind_with(CLOCK_MONOTONIC,3);
-    ctx->wait_leader = 0;
+    ctx->shards = shards;
+    ctx->thread_seq = 0;
+    ctx->wait_idle = 0;
+    ctx->efd = -1;
+    ctx->kick = -1;
+
+    ctx->shard_list = abcdk_heap_alloc(shards * sizeof(abcdk_mux_shard *));
+    if (!ctx->shard_list)
+        goto final_error;
+
+    for (size_t i = 0; i < shards; i++)
+    {
+        ctx->shard_list[i] = _abcdk_mux_shard_alloc(tick, wait_max, queue_size, backend);
+        if (!ctx->shard_list[i])
+            goto final_error;
+    }
+
+    if (shards > 1)
+    {
+        if (_abcdk_mux_parent_init(ctx) != 0)
+            goto final_error;
+    }
+    else
+    {
+        if (_abcdk_mux_single_init(ctx) != 0)
+            goto final_error;
+    }
 
     return ctx;
 
 final_error:
 
-    abcdk_closep(&efd);
-    abcdk_heap_free(ctx);
+    abcdk_mux_free(&ctx);
 
     return NULL;
 }
 
+static abcdk_mux_shard *_abcdk_mux_shard_of(abcdk_mux_t *ctx, int fd)
+{
+    return ctx->shard_list[(size_t)fd % ctx->shards];
+}
+
+static void _abcdk_mux_kick(abcdk_mux_t *ctx)
+{
+    uint64_t one = 1;
+
+    /*唤醒一个在上级EPOLL中等待的线程(多分片)，或阻塞在IO等待中的主线程(单分片)。*/
+    if (ctx->kick < 0)
+        return;
+
+    if (write(ctx->kick, &one, sizeof(one)) != sizeof(one))
+        return;
+}
+
+static int _abcdk_mux_node_grow(abcdk_mux_shard *shard, size_t need)
+{
+    abcdk_mux_node *table_new = NULL;
+    size_t max_new = ABCDK_MAX(shard->node_max, (size_t)ABCDK_MUX_NODE_MIN);
+
+    while (max_new < need)
+        max_new *= 2;
+
+    if (posix_memalign((void **)&table_new, ABCDK_MUX_CACHELINE, max_new * sizeof(abcdk_mux_node)) != 0)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, -1);
+
+    /*复制旧的节点，新增的节点清零。*/
+    if (shard->node_table)
+        memcpy(table_new, shard->node_table, shard->node_max * sizeof(abcdk_mux_node));
+    memset(&table_new[shard->node_max], 0, (max_new - shard->node_max) * sizeof(abcdk_mux_node));
+
+    abcdk_heap_free(shard->node_table);
+
+    shard->node_table = table_new;
+    shard->node_max = max_new;
+
+    return 0;
+}
+
+static abcdk_mux_node *_abcdk_mux_node_find(abcdk_mux_t *ctx, abcdk_mux_shard *shard, int fd, int create)
+{
+    size_t idx = (size_t)fd / ctx->shards;
+
+    if (idx >= shard->node_max)
+    {
+        if (!create)
+            ABCDK_ERRNO_AND_RETURN1(EAGAIN, NULL);
+
+        if (_abcdk_mux_node_grow(shard, idx + 1) != 0)
+            return NULL;
+    }
+
+    /*未关联的节点，仅在创建时返回。*/
+    if (!create && !shard->node_table[idx].add_first)
+        ABCDK_ERRNO_AND_RETURN1(EAGAIN, NULL);
+
+    return &shard->node_table[idx];
+}
+
+static void _abcdk_mux_wheel_unlink(abcdk_mux_t *ctx, abcdk_mux_shard *shard, abcdk_mux_node *node)
+{
+    if (node->wheel_slot < 0)
+        return;
+
+    if (node->wheel_prev >= 0)
+        _abcdk_mux_node_find(ctx, shard, node->wheel_prev, 0)->wheel_next = node->wheel_next;
+    else
+        shard->wheel_slots[node->wheel_slot] = node->wheel_next;
+
+    if (node->wheel_next >= 0)
+        _abcdk_mux_node_find(ctx, shard, node->wheel_next, 0)->wheel_prev = node->wheel_prev;
+
+    node->wheel_slot = node->wheel_prev = node->wheel_next = -1;
+    shard->wheel_count -= 1;
+}
+
+static uint64_t _abcdk_mux_wheel_expire(abcdk_mux_shard *shard, abcdk_mux_node *node)
+{
+    uint64_t expire;
+
+    /*到期时间所在的刻度，已经过去的刻度放到下一个刻度。*/
+    expire = (node->active + node->timeout + shard->wheel_tick - 1) / shard->wheel_tick;
+    if (expire <= shard->wheel_cursor)
+        expire = shard->wheel_cursor + 1;
+
+    return expire;
+}
+
+static int _abcdk_mux_wheel_earliest(abcdk_mux_shard *shard, abcdk_mux_node *node)
+{
+    uint64_t expire = _abcdk_mux_wheel_expire(shard, node);
+
+    /*到期刻度之前(包括到期刻度)的槽位都是空的，等待中的线程不会在到期前醒来。*/
+    for (uint64_t i = shard->wheel_cursor + 1; i <= expire && i <= shard->wheel_cursor + ABCDK_MUX_WHEEL_SLOTS; i++)
+    {
+        if (shard->wheel_slots[i % ABCDK_MUX_WHEEL_SLOTS] >= 0)
+            return 0;
+    }
+
+    return 1;
+}
+
+static void _abcdk_mux_wheel_link(abcdk_mux_t *ctx, abcdk_mux_shard *shard, abcdk_mux_node *node)
+{
+    uint64_t expire;
+
+    /*按到期时间所在的刻度散列。*/
+    expire = _abcdk_mux_wheel_expire(shard, node);
+
+    node->wheel_slot = expire % ABCDK_MUX_WHEEL_SLOTS;
+    node->wheel_prev = -1;
+    node->wheel_next = shard->wheel_slots[node->wheel_slot];
+
+    if (node->wheel_next >= 0)
+        _abcdk_mux_node_find(ctx, shard, node->wheel_next, 0)->wheel_prev = node->fd;
+
+    shard->wheel_slots[node->wheel_slot] = node->fd;
+    shard->wheel_count += 1;
+}
+
+static size_t _abcdk_mux_thread_home_of(abcdk_mux_t *ctx)
+{
+    /*线程第一次使用当前多路复用器时，按顺序分配所属分片。*/
+    if (_abcdk_mux_thread_ctx != ctx)
+    {
+        _abcdk_mux_thread_ctx = ctx;
+        _abcdk_mux_thread_home = (size_t)abcdk_atomic_fetch_and_add(&ctx->thread_seq, 1) % ctx->shards;
+    }
+
+    return _abcdk_mux_thread_home;
+}
+
+static uint64_t _abcdk_mux_uring_data(abcdk_mux_node *node)
+{
+    /*高32位是注册序号，低32位是句柄。*/
+    return ((uint64_t)node->uring_seq << 32) | (uint32_t)node->fd;
+}
+
+static void _abcdk_mux_uring_flush(abcdk_mux_shard *shard)
+{
+    /*
+     * WAIT主线程阻塞时(单分片)，或有线程等待事件时(多分片)立即提交。
+     * 否则留给下一次IO等待(单分片)或分片检查(多分片)一起提交。
+     * 内核中没有等待的线程，提前提交也不会更早的得到通知。
+    */
+    if (shard->wait_blocking || (shard->wait_idle && *shard->wait_idle > 0))
+        abcdk_uring_submit(shard->uring);
+}
+
+static int _abcdk_mux_backend_mark(abcdk_mux_shard *shard, abcdk_mux_node *node)
+{
+    abcdk_epoll_event tmp = {0};
+
+    if (!shard->uring)
+    {
+        tmp.events = node->event_mark;
+        tmp.data.fd = node->fd;
+
+        return abcdk_epoll_mark(shard->efd, node->fd, &tmp, node->mark_first);
+    }
+
+    /*已注册的事件相同，等待内核通知即可。*/
+    if (node->uring_armed == (ABCDK_MUX_URING_ARMED | node->event_mark))
+        return 0;
+
+    /*先删除旧的注册，被删除的注册不会返回事件。*/
+    if (node->uring_armed)
+    {
+        if (abcdk_uring_poll_remove(shard->uring, _abcdk_mux_uring_data(node)) != 0)
+            return -1;
+
+        node->uring_armed = 0;
+    }
+
+    node->uring_seq += 1;
+
+    if (abcdk_uring_poll_add(shard->uring, node->fd, node->event_mark, _abcdk_mux_uring_data(node)) != 0)
+        return -1;
+
+    node->uring_armed = ABCDK_MUX_URING_ARMED | node->event_mark;
+
+    _abcdk_mux_uring_flush(shard);
+
+    return 0;
+}
+
+static void _abcdk_mux_backend_drop(abcdk_mux_shard *shard, abcdk_mux_node *node)
+{
+    if (!shard->uring)
+    {
+        abcdk_epoll_drop(shard->efd, node->fd);
+        return;
+    }
+
+    if (!node->uring_armed)
+        return;
+
+    abcdk_uring_poll_remove(shard->uring, _abcdk_mux_uring_data(node));
+    node->uring_armed = 0;
+
+    _abcdk_mux_uring_flush(shard);
+}
+
 int abcdk_mux_detach(abcdk_mux_t *ctx,int fd)
 {
-    abcdk_allocator_t *p = NULL;
+    abcdk_mux_shard *shard = NULL;
     abcdk_mux_node *node = NULL;
+    uint32_t uring_seq;
     int chk = 0;
 
     assert(ctx != NULL && fd >= 0);
 
-    abcdk_mutex_lock(&ctx->mutex,1);
+    shard = _abcdk_mux_shard_of(ctx, fd);
 
-    p = abcdk_map_find(&ctx->node_map, &fd, sizeof(fd),0);
-    if(!p)
-        goto final_error;
+    _abcdk_mux_shard_lock(shard);
 
-    node = (abcdk_mux_node *)p->pptrs[ABCDK_MAP_VALUE];
+    node = _abcdk_mux_node_find(ctx, shard, fd, 0);
+    if(!node)
+        goto final_error;
 
     if (node->refcount > 0)
         ABCDK_ERRNO_AND_GOTO1(EBUSY, final_error);
 
-    abcdk_epoll_drop(ctx->efd,fd);
+    _abcdk_mux_backend_drop(shard, node);
+
+    _abcdk_mux_wheel_unlink(ctx, shard, node);
 
-    abcdk_map_remove(&ctx->node_map, &fd, sizeof(fd));
+    /*保留注册序号，句柄被复用时，过期的完成事件不会被当作新的注册。*/
+    uring_seq = node->uring_seq;
+    memset(node, 0, sizeof(*node));
+    node->uring_seq = uring_seq;
 
     /*No error.*/
     goto final;
@@ -159,26 +730,27 @@ final_error:
 
 final:
 
-    abcdk_mutex_unlock(&ctx->mutex);
+    abcdk_mutex_unlock(&shard->mutex);
 
     return chk;
 }
 
 int abcdk_mux_attach(abcdk_mux_t *ctx,int fd,const epoll_data_t *data,time_t timeout)
 {
-    abcdk_allocator_t *p = NULL;
+    abcdk_mux_shard *shard = NULL;
     abcdk_mux_node *node = NULL;
+    int kick = 0;
     int chk = 0;
 
     assert(ctx != NULL && fd >= 0 && data != NULL);
 
-    abcdk_mutex_lock(&ctx->mutex,1);
+    shard = _abcdk_mux_shard_of(ctx, fd);
 
-    p = abcdk_map_find(&ctx->node_map, &fd, sizeof(fd), sizeof(abcdk_mux_node));
-    if(!p)
-        goto final_error;
+    _abcdk_mux_shard_lock(shard);
 
-    node = (abcdk_mux_node *)p->pptrs[ABCDK_MAP_VALUE];
+    node = _abcdk_mux_node_find(ctx, shard, fd, 1);
+    if(!node)
+        goto final_error;
 
     if (node->add_first != 0)
         ABCDK_ERRNO_AND_GOTO1(EINVAL,final_error);
@@ -192,6 +764,23 @@ int abcdk_mux_attach(abcdk_mux_t *ctx,int fd,const epoll_data_t *data,time_t tim
     node->add_first = 1;
     node->event_mark = node->event_disp = 0;
     node->refcount = 0;
+    node->wheel_slot = node->wheel_prev = node->wheel_next = -1;
+
+    /*负值或零，不启用超时检查。*/
+    if (node->timeout > 0)
+    {
+        /*
+         * 等待中的线程按时间轮中最早的到期时间计算等待时长，新节点最早到期时需要唤醒它重新计算。
+         * 单分片时只有主线程阻塞在IO等待中才需要唤醒。
+        */
+        if (ctx->shards > 1 || shard->wait_blocking)
+            kick = _abcdk_mux_wheel_earliest(shard, node);
+
+        _abcdk_mux_wheel_link(ctx, shard, node);
+    }
+
+    if (kick)
+        _abcdk_mux_kick(ctx);
 
     /*No error.*/
     goto final;
@@ -202,7 +791,7 @@ final_error:
 
 final:
 
-    abcdk_mutex_unlock(&ctx->mutex);
+    abcdk_mutex_unlock(&shard->mutex);
 
     return chk;
 }
@@ -218,7 +807,57 @@ int abcdk_mux_attach2(abcdk_mux_t *ctx, int fd,time_t timeout)
     return abcdk_mux_attach(ctx,fd,&data,timeout);
 }
 
-static void _abcdk_mux_disp(abcdk_mux_t *ctx, abcdk_mux_node *node, uint32_t event)
+static int _abcdk_mux_queue_push(abcdk_mux_shard *shard, const abcdk_epoll_event *event)
+{
+    abcdk_mux_queue_item *item_p;
+
+    /*直接在队列中构造元素。*/
+    item_p = (abcdk_mux_queue_item *)abcdk_pool_reserve(&shard->event_pool, NULL);
+    if (!item_p)
+    {
+        /*队列满了，记录溢出次数，翻倍扩容。*/
+        ABCDK_MUX_COUNTER_ADD(shard, queue_overflow, 1);
+
+        if (abcdk_pool_expand(&shard->event_pool, shard->event_pool.table->numbers * 2) != 0)
+            return -1;
+
+        ABCDK_MUX_COUNTER_SET(shard, queue_size, shard->event_pool.table->numbers);
+
+        item_p = (abcdk_mux_queue_item *)abcdk_pool_reserve(&shard->event_pool, NULL);
+        if (!item_p)
+            return -1;
+    }
+
+    item_p->event = *event;
+    item_p->ready = abcdk_time_clock2kind_with(CLOCK_MONOTONIC, 9);
+
+    abcdk_pool_commit(&shard->event_pool, 1);
+
+    ABCDK_MUX_COUNTER_SET(shard, queue_count, shard->event_pool.count);
+
+    /*记录排队长度的最高值。*/
+    if (shard->event_pool.count > shard->counter.queue_peak)
+        ABCDK_MUX_COUNTER_SET(shard, queue_peak, shard->event_pool.count);
+
+    return 0;
+}
+
+static size_t _abcdk_mux_latency_bucket(uint64_t ns)
+{
+    uint64_t us = ns / 1000;
+    size_t bucket = 0;
+
+    /*按微秒的对数分桶，[0] 小于1微秒，[i] 位于[2^(i-1),2^i)微秒。*/
+    while (us > 0 && bucket < ABCDK_MUX_STAT_HIST_BUCKETS - 1)
+    {
+        us >>= 1;
+        bucket += 1;
+    }
+
+    return bucket;
+}
+
+static void _abcdk_mux_disp(abcdk_mux_shard *shard, abcdk_mux_node *node, uint32_t event)
 {
     abcdk_epoll_event disp = {0};
 
@@ -238,34 +877,52 @@ static void _abcdk_mux_disp(abcdk_mux_t *ctx, abcdk_mux_node *node, uint32_t eve
             disp.events = ABCDK_EPOLL_ERROR;
     }
 
+    /*没有需要通知的事件。*/
+    if (!disp.events)
+        return;
+
+    /*
+     * 先推送到活动队列，成功后再修改节点状态。
+     * 如果内存不足导致推送失败，节点状态保持不变，事件等待下一次分派，计数器不会泄漏。
+    */
+    disp.data = node->data;
+    if (_abcdk_mux_queue_push(shard, &disp) != 0)
+    {
+        syslog(LOG_WARNING, "mux: event queue is full and cannot be expanded(fd=%d,events=%08x).", node->fd, disp.events);
+        return;
+    }
+
     /*根据发生的事件增加计数器。*/
     if (disp.events & ABCDK_EPOLL_ERROR)
+    {
         node->refcount += 1;
+        ABCDK_MUX_COUNTER_ADD(shard, event_error, 1);
+    }
     if (disp.events & ABCDK_EPOLL_INPUT)
+    {
         node->refcount += 1;
+        ABCDK_MUX_COUNTER_ADD(shard, event_input, 1);
+    }
     if (disp.events & ABCDK_EPOLL_INOOB)
+    {
         node->refcount += 1;
+        ABCDK_MUX_COUNTER_ADD(shard, event_inoob, 1);
+    }
     if (disp.events & ABCDK_EPOLL_OUTPUT)
+    {
         node->refcount += 1;
+        ABCDK_MUX_COUNTER_ADD(shard, event_output, 1);
+    }
 
     /*在节点上附加本次分派的事件。*/
     node->event_disp |= disp.events;
 
     /*清除即将通知的事件，注册事件只通知一次。*/
     node->event_mark &= ~disp.events;
-
-    /*有事件时再推送到活动队列。*/
-    if (disp.events)
-    {
-        disp.data = node->data;
-        abcdk_pool_push(&ctx->event_pool,&disp,sizeof(disp));
-    }   
 }
 
-static void _abcdk_mux_mark(abcdk_mux_t *ctx, abcdk_mux_node *node, uint32_t want, uint32_t done)
+static void _abcdk_mux_mark(abcdk_mux_shard *shard, abcdk_mux_node *node, uint32_t want, uint32_t done)
 {
-    abcdk_epoll_event tmp = {0};
-
     /*清除分派的事件。*/
     node->event_disp &= ~done;
 
@@ -283,12 +940,9 @@ static void _abcdk_mux_mark(abcdk_mux_t *ctx, abcdk_mux_node *node, uint32_t wan
     /*如果未发生错误，进入正常流程。*/
     if (node->stable)
     {
-        tmp.events = node->event_mark;
-        tmp.data.fd = node->fd;
-
-        if (abcdk_epoll_mark(ctx->efd,node->fd,&tmp,node->mark_first) != 0)
+        if (_abcdk_mux_backend_mark(shard, node) != 0)
             node->stable = 0;
-        
+
         /*无论是否成功，第一次注册都已经完成。*/
         node->mark_first = 0;
 
@@ -301,24 +955,16 @@ static void _abcdk_mux_mark(abcdk_mux_t *ctx, abcdk_mux_node *node, uint32_t wan
      * 2：如果当前处理的事件包括ERROR事件，则不用再次发出通知。
     */
     if (!node->stable && !(done & ABCDK_EPOLL_ERROR))
-        _abcdk_mux_disp(ctx, node, ABCDK_EPOLL_ERROR);
+        _abcdk_mux_disp(shard, node, ABCDK_EPOLL_ERROR);
 
 }
 
-static int _abcdk_mux_mark_scan_cb(abcdk_allocator_t *alloc, void *opaque)
-{
-    abcdk_mux_t *ctx = (abcdk_mux_t *)opaque;
-    abcdk_mux_node *node = (abcdk_mux_node *)alloc->pptrs[ABCDK_MAP_VALUE];
-
-    _abcdk_mux_mark(ctx,node,ctx->broadcast_want,0);
-
-    return 1;
-}
 
 int abcdk_mux_mark(abcdk_mux_t *ctx, int fd, uint32_t want, uint32_t done)
 {
-    abcdk_allocator_t *p = NULL;
+    abcdk_mux_shard *shard = NULL;
     abcdk_mux_node *node = NULL;
+    size_t queued;
 
     int chk = 0;
 
@@ -326,142 +972,249 @@ int abcdk_mux_mark(abcdk_mux_t *ctx, int fd, uint32_t want, uint32_t done)
     assert((want & ~(ABCDK_EPOLL_INPUT | ABCDK_EPOLL_INOOB | ABCDK_EPOLL_OUTPUT | ABCDK_EPOLL_ERROR)) == 0);
     assert((done & ~(ABCDK_EPOLL_INPUT | ABCDK_EPOLL_INOOB | ABCDK_EPOLL_OUTPUT | ABCDK_EPOLL_ERROR)) == 0);
 
-    abcdk_mutex_lock(&ctx->mutex,1);
-
     if (fd >= 0)
     {
-        p = abcdk_map_find(&ctx->node_map, &fd, sizeof(fd), 0);
-        if (!p)
-            goto final_error;
+        shard = _abcdk_mux_shard_of(ctx, fd);
+
+        _abcdk_mux_shard_lock(shard);
 
-        node = (abcdk_mux_node *)p->pptrs[ABCDK_MAP_VALUE];
+        queued = shard->event_pool.count;
 
-        _abcdk_mux_mark(ctx, node, want, done);
+        node = _abcdk_mux_node_find(ctx, shard, fd, 0);
+        if (node)
+            _abcdk_mux_mark(shard, node, want, done);
+        else
+            chk = -1;
+
+        /*注册失败时派发了ERROR事件。*/
+        if (shard->event_pool.count > queued)
+            _abcdk_mux_kick(ctx);
+
+        abcdk_mutex_unlock(&shard->mutex);
     }
     else
     {
-        /*Set.*/
-        ctx->broadcast_want = want;
+        /*广播到所有分片。*/
+        for (size_t i = 0; i < ctx->shards; i++)
+        {
+            shard = ctx->shard_list[i];
+
+            _abcdk_mux_shard_lock(shard);
 
-        /*遍历。*/
-        ctx->node_map.dump_cb = _abcdk_mux_mark_scan_cb;
-        ctx->node_map.opaque = ctx;
-        abcdk_map_scan(&ctx->node_map);
+            /*遍历。*/
+            for (size_t j = 0; j < shard->node_max; j++)
+            {
+                node = &shard->node_table[j];
+                if (node->add_first)
+                    _abcdk_mux_mark(shard, node, want, 0);
+            }
 
-        /*Clear.*/
-        ctx->broadcast_want = 0;
+            /*唤醒等待线程，处理可能产生的事件。*/
+            abcdk_mutex_signal(&shard->mutex, 1);
+
+            abcdk_mutex_unlock(&shard->mutex);
+        }
+
+        _abcdk_mux_kick(ctx);
     }
 
-    /*No error.*/
-    goto final;
+    return chk;
+}
 
-final_error:
+static void _abcdk_mux_watchdog(abcdk_mux_t *ctx, abcdk_mux_shard *shard)
+{
+    uint64_t current = abcdk_time_clock2kind_with(CLOCK_MONOTONIC,3);
+    uint64_t now_tick = current / shard->wheel_tick;
+    uint64_t steps;
+    size_t slot;
+    abcdk_mux_node *node;
+    int fd, next;
 
-    chk = -1;
+    if (now_tick <= shard->wheel_cursor)
+        return;
 
-final:
+    /*落后超过一圈时，每个槽位只需要检查一次。*/
+    steps = ABCDK_MIN(now_tick - shard->wheel_cursor, (uint64_t)ABCDK_MUX_WHEEL_SLOTS);
+    slot = shard->wheel_cursor;
 
-    abcdk_mutex_unlock(&ctx->mutex);
+    /*先更新游标，使重新散列的节点落在未来的刻度。*/
+    shard->wheel_cursor = now_tick;
 
-    return chk;   
+    for (uint64_t i = 0; i < steps && shard->wheel_count > 0; i++)
+    {
+        slot = (slot + 1) % ABCDK_MUX_WHEEL_SLOTS;
+
+        /*摘下整个槽位的链表，只检查这个槽位中的节点。*/
+        fd = shard->wheel_slots[slot];
+        shard->wheel_slots[slot] = -1;
+
+        while (fd >= 0)
+        {
+            node = _abcdk_mux_node_find(ctx, shard, fd, 0);
+            next = node->wheel_next;
+
+            node->wheel_slot = node->wheel_prev = node->wheel_next = -1;
+            shard->wheel_count -= 1;
+
+            /*如果超时，派发ERROR事件，不再检查；否则按最新的活动时间重新散列。*/
+            if ((current - node->active) >= node->timeout)
+            {
+                ABCDK_MUX_COUNTER_ADD(shard, watchdog_timeouts, 1);
+                _abcdk_mux_disp(shard, node, ABCDK_EPOLL_ERROR);
+            }
+            else
+                _abcdk_mux_wheel_link(ctx, shard, node);
+
+            fd = next;
+        }
+    }
 }
 
-static int _abcdk_mux_watchdog_scan_cb(abcdk_allocator_t *alloc, void *opaque)
+static time_t _abcdk_mux_watchdog_remaining(abcdk_mux_shard *shard)
 {
-    abcdk_mux_t *ctx = (abcdk_mux_t *)opaque;
-    abcdk_mux_node *node = (abcdk_mux_node *)alloc->pptrs[ABCDK_MAP_VALUE];
+    uint64_t current;
 
-    /*负值或零，不启用超时检查。*/
-    if (node->timeout <= 0)
-        goto final;
+    if (shard->wheel_count <= 0)
+        return INT32_MAX;
 
-    /*当事件队列排队过长时，中断看门狗检查，优先处理队列中的事件。*/
-    if (ctx->event_pool.count >= 20)
-        return -1;
+    /*查找下一个非空的槽位。*/
+    for (size_t i = 1; i <= ABCDK_MUX_WHEEL_SLOTS; i++)
+    {
+        if (shard->wheel_slots[(shard->wheel_cursor + i) % ABCDK_MUX_WHEEL_SLOTS] < 0)
+            continue;
 
-    /*如果超时，派发ERROR事件。*/
-    if ((ctx->watchdog_active - node->active) >= node->timeout)
-        _abcdk_mux_disp(ctx, node, ABCDK_EPOLL_ERROR);
+        current = abcdk_time_clock2kind_with(CLOCK_MONOTONIC,3);
 
-final:
+        if ((shard->wheel_cursor + i) * shard->wheel_tick <= current)
+            return 0;
 
-    return 1;
+        return (shard->wheel_cursor + i) * shard->wheel_tick - current;
+    }
+
+    return INT32_MAX;
 }
 
-static void _abcdk_mux_watchdog(abcdk_mux_t *ctx)
+static void _abcdk_mux_kick_drain(abcdk_mux_t *ctx, abcdk_mux_shard *shard)
 {
-    uint64_t current = abcdk_time_clock2kind_with(CLOCK_MONOTONIC,3);
+    uint64_t val;
 
-    /*看门狗活动间隔时间不能太密集。*/
-    if ((current - ctx->watchdog_active) < ctx->watchdog_intvl)
-        return;
-
-    /*更新看门狗活动时间。*/
-    ctx->watchdog_active = current;
-
-    /*遍历。*/
-    ctx->node_map.dump_cb = _abcdk_mux_watchdog_scan_cb;
-    ctx->node_map.opaque = ctx;
-    abcdk_map_scan(&ctx->node_map);
+    if (read(ctx->kick, &val, sizeof(val)) != sizeof(val))
+        val = 0;
 
+    /*一次性注册已经完成，重新注册，留给下一次IO等待一起提交。*/
+    if (shard->uring)
+        abcdk_uring_poll_add(shard->uring, ctx->kick, ABCDK_EPOLL_INPUT, (uint32_t)ctx->kick);
 }
 
-static void _abcdk_mux_wait_disp(abcdk_mux_t *ctx,abcdk_epoll_event *events,int count)
+static void _abcdk_mux_wait_disp(abcdk_mux_t *ctx,abcdk_mux_shard *shard,abcdk_epoll_event *events,int count)
 {
     abcdk_epoll_event *e;
-    abcdk_allocator_t *p;
     abcdk_mux_node *node;
+    int fd;
 
     for (int i = 0; i < count; i++)
     {
         e = &events[i];
-        p = abcdk_map_find(&ctx->node_map, &e->data.fd,sizeof(e->data.fd), 0);
+        fd = (shard->uring ? (int)(uint32_t)e->data.u64 : e->data.fd);
+
+        /*唤醒句柄(仅单分片)，读取后重新计算等待时长。*/
+        if (fd == ctx->kick)
+        {
+            _abcdk_mux_kick_drain(ctx, shard);
+            continue;
+        }
+
+        node = _abcdk_mux_node_find(ctx, shard, fd, 0);
 
         /*有那么一瞬间，当前返回的事件并不在(可能被分离)锁保护范围内的，因此这要做些处理。*/
-        if (p == NULL)
+        if (node == NULL)
             continue;
-            
-        node = (abcdk_mux_node *)p->pptrs[ABCDK_MAP_VALUE];
+
+        if (shard->uring)
+        {
+            /*
+             * 序号不同的是被替换或已分离的旧注册，丢弃。
+             * 句柄被复用时，旧注册的完成事件不能派发给新的节点；被替换的注册，新的注册会重新检查句柄的状态。
+            */
+            if (e->data.u64 != _abcdk_mux_uring_data(node))
+                continue;
+
+            /*一次性注册已经完成。*/
+            node->uring_armed = 0;
+        }
 
         /*派发事件。*/
-        _abcdk_mux_disp(ctx,node,e->events);
+        _abcdk_mux_disp(shard,node,e->events);
 
         /*更节点新活动时间*/
         node->active = abcdk_time_clock2kind_with(CLOCK_MONOTONIC,3);
     }
 }
 
-static uint64_t _abcdk_mux_difference_timeout(uint64_t begin,uint64_t timeout)
+static time_t _abcdk_mux_difference_timeout(uint64_t begin,time_t timeout)
 {
-    uint64_t span = UINT64_MAX;
+    uint64_t span;
+
+    /*负值，直到有事件或出错。*/
+    if (timeout < 0)
+        return INT32_MAX;
 
-    if(timeout >= 0)
+    span = abcdk_time_clock2kind_with(CLOCK_MONOTONIC,3) - begin;
+    if (span >= timeout)
+        return 0;
+
+    return timeout - span;
+}
+
+static int _abcdk_mux_shard_pull(abcdk_mux_shard *shard,abcdk_epoll_event *events,int max)
+{
+    abcdk_mux_queue_item *items;
+    uint64_t current = 0;
+    size_t bucket, number;
+    int count = 0;
+
+    /*在同一个临界区内尽可能多的拉取，每次取出一段连续的元素。*/
+    while (count < max)
     {
-        span = abcdk_time_clock2kind_with(CLOCK_MONOTONIC,3) - begin;
+        number = max - count;
+        items = (abcdk_mux_queue_item *)abcdk_pool_peek(&shard->event_pool, &number);
+        if (!items)
+            break;
+
+        /*拉取后即返回，同一批事件使用同一个返回时间。*/
+        if (!current)
+            current = abcdk_time_clock2kind_with(CLOCK_MONOTONIC, 9);
 
-        return timeout - span;
+        for (size_t i = 0; i < number; i++)
+        {
+            bucket = _abcdk_mux_latency_bucket(current > items[i].ready ? current - items[i].ready : 0);
+            ABCDK_MUX_COUNTER_ADD(shard, latency_hist[bucket], 1);
+
+            events[count++] = items[i].event;
+        }
+
+        abcdk_pool_release(&shard->event_pool, number);
     }
 
-    return span;
+    if (count > 0)
+        ABCDK_MUX_COUNTER_SET(shard, queue_count, shard->event_pool.count);
+
+    return count;
 }
 
-int abcdk_mux_wait(abcdk_mux_t *ctx,abcdk_epoll_event *event,time_t timeout)
+static int _abcdk_mux_shard_wait(abcdk_mux_t *ctx,abcdk_mux_shard *shard,abcdk_epoll_event *events,int max,uint64_t begin,time_t timeout)
 {
-    abcdk_epoll_event w[20];
-    uint64_t begin = abcdk_time_clock2kind_with(CLOCK_MONOTONIC,3);
-    uint64_t remaining = 0;
+    time_t remaining = 0;
     int count;
     int chk = 0;
 
-    assert(ctx != NULL && event != NULL);
-    
-    abcdk_mutex_lock(&ctx->mutex,1);
+    _abcdk_mux_shard_lock(shard);
 
 try_again:
 
     /*优先从事件队列中拉取。*/
-    chk = abcdk_pool_pull(&ctx->event_pool, event, sizeof(*event));
-    if (chk >= 0)
+    chk = _abcdk_mux_shard_pull(shard, events, max);
+    if (chk > 0)
         goto final;
 
     /*计算剩余超时时长。*/
@@ -470,37 +1223,63 @@ try_again:
         ABCDK_ERRNO_AND_GOTO1(EINTR,final_error);
 
     /*多线程选主，只能有一个线程进入IO等待，其它线程等待事件通知。*/
-    if(abcdk_thread_leader_test(&ctx->wait_leader)==0)
+    if(abcdk_thread_leader_test(&shard->wait_leader)==0)
     {
+        ABCDK_MUX_COUNTER_ADD(shard, leader_handoffs, 1);
+
         /*通过看门狗检测长期不活动的节点。*/
-        _abcdk_mux_watchdog(ctx);
+        _abcdk_mux_watchdog(ctx, shard);
+
+        /*看门狗派发了事件，先处理队列中的事件。*/
+        if (shard->event_pool.count > 0)
+        {
+            /*唤醒其它线程，处理看门狗。*/
+            abcdk_mutex_signal(&shard->mutex,1);
+
+            /*主线程退出。*/
+            abcdk_thread_leader_quit(&shard->wait_leader);
+
+            goto try_again;
+        }
 
-        /*唤醒其它线程，处理看门狗。*/
-        abcdk_mutex_signal(&ctx->mutex,1);
+        /*IO等待时长不能超过看门狗下一次检查的时间。*/
+        remaining = ABCDK_MIN(remaining, _abcdk_mux_watchdog_remaining(shard));
+
+        /*阻塞期间，其它线程的注册需要立即提交。*/
+        shard->wait_blocking = 1;
 
         /*解锁，使其它接口被访问。*/
-        abcdk_mutex_unlock(&ctx->mutex);
+        abcdk_mutex_unlock(&shard->mutex);
 
         /*IO等待。*/
-        count = abcdk_epoll_wait(ctx->efd,w,ABCDK_ARRAY_SIZE(w),ABCDK_MIN(remaining,ctx->watchdog_intvl));
+        if (shard->uring)
+            count = abcdk_uring_wait(shard->uring,shard->wait_events,shard->wait_max,remaining);
+        else
+            count = abcdk_epoll_wait(shard->efd,shard->wait_events,shard->wait_max,remaining);
 
         /*加锁，禁其它接口被访问。*/
-        abcdk_mutex_lock(&ctx->mutex,1);
+        _abcdk_mux_shard_lock(shard);
+
+        shard->wait_blocking = 0;
+
+        ABCDK_MUX_COUNTER_ADD(shard, wait_calls, 1);
+        if (count > 0)
+            ABCDK_MUX_COUNTER_ADD(shard, wait_events, count);
 
         /*处理活动事件。*/
-        _abcdk_mux_wait_disp(ctx,w,count);
+        _abcdk_mux_wait_disp(ctx,shard,shard->wait_events,count);
 
         /*唤醒其它线程，处理事件。*/
-        abcdk_mutex_signal(&ctx->mutex,1);
+        abcdk_mutex_signal(&shard->mutex,1);
 
         /*主线程退出。*/
-        abcdk_thread_leader_quit(&ctx->wait_leader);
-        
+        abcdk_thread_leader_quit(&shard->wait_leader);
+
     }
     else
-    {   
+    {
         /*等待主线程的通知，或超时退出。*/
-        abcdk_mutex_wait(&ctx->mutex,remaining);
+        abcdk_mutex_wait(&shard->mutex,remaining);
     }
 
     /*No error, no event, try again.*/
@@ -512,29 +1291,221 @@ final_error:
 
 final:
 
-    abcdk_mutex_unlock(&ctx->mutex);
+    abcdk_mutex_unlock(&shard->mutex);
+
+    return chk;
+}
+
+static int _abcdk_mux_shard_sweep(abcdk_mux_t *ctx,abcdk_mux_shard *shard,abcdk_epoll_event *events,int max,time_t *remaining,int home)
+{
+    int count, count2;
+
+    /*
+     * 所属分片等待加锁，其它分片只尝试加锁，正被其它线程访问时跳过，不在其它线程的分片上排队。
+     * 跳过的分片可能有IO事件，上级EPOLL不会再次通知(边沿触发)，唤醒一个线程稍后再检查。
+    */
+    if (home)
+    {
+        _abcdk_mux_shard_lock(shard);
+    }
+    else
+    {
+        if (abcdk_mutex_lock(&shard->mutex, 0) != 0)
+        {
+            _abcdk_mux_kick(ctx);
+            return 0;
+        }
+
+        ABCDK_MUX_COUNTER_ADD(shard, lock_acquires, 1);
+    }
+
+    /*优先从事件队列中拉取。*/
+    count = _abcdk_mux_shard_pull(shard, events, max);
+
+    if (count < max)
+    {
+        /*通过看门狗检测长期不活动的节点。*/
+        _abcdk_mux_watchdog(ctx, shard);
+
+        /*在临界区内不等待的检查IO事件，同一时间只有一个线程检查同一个分片。*/
+        if (shard->uring)
+            count2 = abcdk_uring_wait(shard->uring, shard->wait_events, shard->wait_max, 0);
+        else
+            count2 = abcdk_epoll_wait(shard->efd, shard->wait_events, shard->wait_max, 0);
+
+        ABCDK_MUX_COUNTER_ADD(shard, wait_calls, 1);
+        if (count2 > 0)
+        {
+            ABCDK_MUX_COUNTER_ADD(shard, wait_events, count2);
+            _abcdk_mux_wait_disp(ctx, shard, shard->wait_events, count2);
+        }
+
+        count += _abcdk_mux_shard_pull(shard, &events[count], max - count);
+
+        /*IO事件可能没有取完，上级EPOLL不会再次通知(边沿触发)。*/
+        if (count2 >= shard->wait_max)
+            _abcdk_mux_kick(ctx);
+    }
+
+    /*完成队列中已有事件时，IO等待不进入内核。分派后一次提交所有线程在这期间的注册。*/
+    if (shard->uring && abcdk_uring_pending(shard->uring) > 0)
+        abcdk_uring_submit(shard->uring);
+
+    /*队列中还有事件，唤醒其它线程处理。*/
+    if (shard->event_pool.count > 0)
+        _abcdk_mux_kick(ctx);
+
+    /*等待时长不能超过看门狗下一次检查的时间。*/
+    *remaining = ABCDK_MIN(*remaining, _abcdk_mux_watchdog_remaining(shard));
+
+    abcdk_mutex_unlock(&shard->mutex);
+
+    return count;
+}
+
+static void _abcdk_mux_park(abcdk_mux_t *ctx,time_t timeout)
+{
+    abcdk_epoll_event events[4];
+    uint64_t val;
+    int count;
+
+    /*等待任意分片有IO事件，或被唤醒。*/
+    count = abcdk_epoll_wait(ctx->efd, events, ABCDK_ARRAY_SIZE(events), timeout);
+
+    for (int i = 0; i < count; i++)
+    {
+        if (events[i].data.u64 != ctx->shards)
+            continue;
+
+        if (read(ctx->kick, &val, sizeof(val)) != sizeof(val))
+            continue;
+    }
+}
+
+static int _abcdk_mux_shards_wait(abcdk_mux_t *ctx,abcdk_epoll_event *events,int max,uint64_t begin,time_t timeout)
+{
+    size_t home = _abcdk_mux_thread_home_of(ctx);
+    time_t remaining;
+    int count;
+
+    /*
+     * 检查分片之前登记，检查之后其它线程的注册立即提交。
+     * 检查之前的注册，在检查分片时提交。
+    */
+    abcdk_atomic_fetch_and_add(&ctx->wait_idle, 1);
+
+    for (;;)
+    {
+        /*计算剩余超时时长。*/
+        remaining = _abcdk_mux_difference_timeout(begin, timeout);
+
+        /*
+         * 从所属分片开始，依次检查每个分片的事件队列和IO事件。
+         * 每个线程都会检查所有的分片，任何分片都不依赖固定的线程。
+        */
+        count = 0;
+        for (size_t i = 0; i < ctx->shards && count < max; i++)
+            count += _abcdk_mux_shard_sweep(ctx, ctx->shard_list[(home + i) % ctx->shards], &events[count], max - count, &remaining, i == 0);
+
+        if (count > 0)
+            goto final;
+
+        if (remaining <= 0)
+            ABCDK_ERRNO_AND_GOTO1(EINTR, final_error);
+
+        _abcdk_mux_park(ctx, remaining);
+    }
+
+final_error:
+
+    count = -1;
+
+final:
+
+    abcdk_atomic_fetch_and_add(&ctx->wait_idle, -1);
+
+    return count;
+}
+
+int abcdk_mux_wait(abcdk_mux_t *ctx,abcdk_epoll_event *event,time_t timeout)
+{
+    int chk;
+
+    assert(ctx != NULL && event != NULL);
 
-    return chk; 
+    chk = abcdk_mux_wait_batch(ctx, event, 1, timeout);
+    if (chk <= 0)
+        return -1;
+
+    return 0;
+}
+
+int abcdk_mux_wait_batch(abcdk_mux_t *ctx,abcdk_epoll_event *events,int max,time_t timeout)
+{
+    uint64_t begin = abcdk_time_clock2kind_with(CLOCK_MONOTONIC,3);
+
+    assert(ctx != NULL && events != NULL && max > 0);
+
+    /*多分片时，空闲的线程在上级EPOLL中等待任意分片的事件。*/
+    if (ctx->shards > 1)
+        return _abcdk_mux_shards_wait(ctx, events, max, begin, timeout);
+
+    return _abcdk_mux_shard_wait(ctx, ctx->shard_list[0], events, max, begin, timeout);
+}
+
+void abcdk_mux_stat_fetch(abcdk_mux_t *ctx, abcdk_mux_stat *stat)
+{
+    abcdk_mux_shard *shard = NULL;
+
+    assert(ctx != NULL && stat != NULL);
+
+    memset(stat, 0, sizeof(*stat));
+
+    for (size_t i = 0; i < ctx->shards; i++)
+    {
+        shard = ctx->shard_list[i];
+
+        /*只读取计数器，不加锁。*/
+        stat->queue_count += ABCDK_MUX_COUNTER_GET(shard, queue_count);
+        stat->queue_size += ABCDK_MUX_COUNTER_GET(shard, queue_size);
+        stat->queue_peak = ABCDK_MAX(stat->queue_peak, (size_t)ABCDK_MUX_COUNTER_GET(shard, queue_peak));
+        stat->queue_overflow += ABCDK_MUX_COUNTER_GET(shard, queue_overflow);
+        stat->backend = (shard->uring ? ABCDK_MUX_BACKEND_URING : ABCDK_MUX_BACKEND_EPOLL);
+        stat->event_input += ABCDK_MUX_COUNTER_GET(shard, event_input);
+        stat->event_inoob += ABCDK_MUX_COUNTER_GET(shard, event_inoob);
+        stat->event_output += ABCDK_MUX_COUNTER_GET(shard, event_output);
+        stat->event_error += ABCDK_MUX_COUNTER_GET(shard, event_error);
+        stat->wait_calls += ABCDK_MUX_COUNTER_GET(shard, wait_calls);
+        stat->wait_events += ABCDK_MUX_COUNTER_GET(shard, wait_events);
+        stat->leader_handoffs += ABCDK_MUX_COUNTER_GET(shard, leader_handoffs);
+        stat->lock_acquires += ABCDK_MUX_COUNTER_GET(shard, lock_acquires);
+        stat->lock_contended += ABCDK_MUX_COUNTER_GET(shard, lock_contended);
+        stat->lock_wait_ns += ABCDK_MUX_COUNTER_GET(shard, lock_wait_ns);
+        stat->watchdog_timeouts += ABCDK_MUX_COUNTER_GET(shard, watchdog_timeouts);
+
+        for (size_t j = 0; j < ABCDK_MUX_STAT_HIST_BUCKETS; j++)
+            stat->latency_hist[j] += ABCDK_MUX_COUNTER_GET(shard, latency_hist[j]);
+    }
 }
 
 int abcdk_mux_unref(abcdk_mux_t *ctx,int fd, uint32_t events)
 {
-    abcdk_allocator_t *p = NULL;
+    abcdk_mux_shard *shard = NULL;
     abcdk_mux_node *node = NULL;
-    abcdk_epoll_event tmp = {0};
+    size_t queued;
     int chk = 0;
 
     assert(ctx != NULL && fd >= 0);
 
     assert((events & ~(ABCDK_EPOLL_INPUT | ABCDK_EPOLL_INOOB | ABCDK_EPOLL_OUTPUT | ABCDK_EPOLL_ERROR)) == 0);
 
-    abcdk_mutex_lock(&ctx->mutex,1);
+    shard = _abcdk_mux_shard_of(ctx, fd);
 
-    p = abcdk_map_find(&ctx->node_map, &fd, sizeof(fd),0);
-    if(!p)
-        goto final_error;
+    _abcdk_mux_shard_lock(shard);
 
-    node = (abcdk_mux_node *)p->pptrs[ABCDK_MAP_VALUE];
+    node = _abcdk_mux_node_find(ctx, shard, fd, 0);
+    if(!node)
+        goto final_error;
 
     /*无论成功或失败，记数器都要相应的减少，不然无法释放。*/
     if (events & ABCDK_EPOLL_ERROR)
@@ -551,7 +1522,14 @@ int abcdk_mux_unref(abcdk_mux_t *ctx,int fd, uint32_t events)
      * 2：如果当前处理的事件包括ERROR事件，则不用再次发出通知。
     */
     if (!node->stable && !(events & ABCDK_EPOLL_ERROR))
-        _abcdk_mux_disp(ctx, node, ABCDK_EPOLL_ERROR);
+    {
+        queued = shard->event_pool.count;
+
+        _abcdk_mux_disp(shard, node, ABCDK_EPOLL_ERROR);
+
+        if (shard->event_pool.count > queued)
+            _abcdk_mux_kick(ctx);
+    }
 
     /*No error.*/
     goto final;
@@ -562,7 +1540,7 @@ final_error:
 
 final:
 
-    abcdk_mutex_unlock(&ctx->mutex);
+    abcdk_mutex_unlock(&shard->mutex);
 
-    return chk; 
+    return chk;
 }
\ No newline at end of file
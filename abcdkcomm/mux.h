@@ -12,6 +12,7 @@
 #include "abcdkutil/thread.h"
 #include "abcdkutil/clock.h"
 #include "abcdkutil/epoll.h"
+#include "abcdkutil/uring.h"
 #include "abcdkutil/socket.h"
 
 __BEGIN_DECLS
@@ -19,6 +20,144 @@ __BEGIN_DECLS
 /** 多路复用器。*/
 typedef struct _abcdk_mux abcdk_mux_t;
 
+/**
+ * 多路复用器的IO后端。
+*/
+enum _abcdk_mux_backend
+{
+    /** EPOLL(默认)。*/
+    ABCDK_MUX_BACKEND_EPOLL = 0,
+#define ABCDK_MUX_BACKEND_EPOLL ABCDK_MUX_BACKEND_EPOLL
+
+    /**
+     * IO_URING。
+     * 
+     * 重新注册(一次性POLL)写入提交队列，在下一次IO等待时与等待合并为一次系统调用；
+     * 完成队列中的事件直接读取，不需要系统调用。
+     * 
+     * 多分片时，有线程等待事件期间的注册立即提交(否则等待中的线程得不到通知)，
+     * 所有线程都在处理事件期间的注册，在下一次检查分片时一起提交。
+     * 
+     * @note 内核或编译环境不支持时，自动使用EPOLL。
+    */
+    ABCDK_MUX_BACKEND_URING = 1
+#define ABCDK_MUX_BACKEND_URING ABCDK_MUX_BACKEND_URING
+};
+
+/**
+ * 多路复用器参数。
+ * 
+ * @note 未填写(0)的参数使用默认值。
+*/
+typedef struct _abcdk_mux_param
+{
+    /**
+     * 分片数量。
+     * 
+     * 句柄按数值散列到分片，每个分片拥有独立的EPOLL句柄、节点表、事件队列和互斥量。
+     * 
+     * @note 0,1 是等价的(单分片)。
+    */
+    size_t shards;
+
+    /**
+     * 看门狗刻度(毫秒)。
+     * 
+     * 超时检查的精度，与超时时长无关。默认：100。
+    */
+    time_t watchdog_tick;
+
+    /**
+     * IO等待一次获取事件的最大数量。
+     * 
+     * 繁忙的服务可以调大此值，以减少系统调用和加锁的次数。默认：20。
+    */
+    int wait_max;
+
+    /**
+     * 事件队列的初始容量(每个分片)。
+     * 
+     * 队列满了自动翻倍扩容，不会丢弃事件。默认：4 * wait_max + 20。
+    */
+    size_t queue_size;
+
+    /**
+     * IO后端。
+     * 
+     * 见ABCDK_MUX_BACKEND_*。默认：EPOLL。
+    */
+    int backend;
+
+} abcdk_mux_param;
+
+/** 等待延时直方图的桶数量。*/
+#define ABCDK_MUX_STAT_HIST_BUCKETS 32
+
+/**
+ * 多路复用器统计信息。
+ * 
+ * @note 多分片模式下是所有分片的汇总。
+ * @note 计数器在各自分片的临界区内更新，读取时不加锁，各字段之间不保证是同一时刻的快照。
+*/
+typedef struct _abcdk_mux_stat
+{
+    /** 事件队列当前的排队长度。*/
+    size_t queue_count;
+
+    /** 事件队列当前的容量。*/
+    size_t queue_size;
+
+    /** 事件队列排队长度的最高值(单个分片)。*/
+    size_t queue_peak;
+
+    /** 事件队列溢出(扩容)的次数。*/
+    uint64_t queue_overflow;
+
+    /** 实际使用的IO后端。*/
+    int backend;
+
+    /** 分派的INPUT事件数量。*/
+    uint64_t event_input;
+
+    /** 分派的INOOB事件数量。*/
+    uint64_t event_inoob;
+
+    /** 分派的OUTPUT事件数量。*/
+    uint64_t event_output;
+
+    /** 分派的ERROR事件数量(包括超时)。*/
+    uint64_t event_error;
+
+    /** IO等待(epoll_wait或io_uring_enter)的次数。*/
+    uint64_t wait_calls;
+
+    /** IO等待返回的事件数量。平均批量 = wait_events / wait_calls。*/
+    uint64_t wait_events;
+
+    /** WAIT主线程的更替次数(每次选主成功计一次)。*/
+    uint64_t leader_handoffs;
+
+    /** 加锁次数。*/
+    uint64_t lock_acquires;
+
+    /** 加锁时发生竞争的次数。*/
+    uint64_t lock_contended;
+
+    /** 加锁竞争时等待的总时长(纳秒)。*/
+    uint64_t lock_wait_ns;
+
+    /** 看门狗触发的超时次数。*/
+    uint64_t watchdog_timeouts;
+
+    /**
+     * 事件从就绪到被等待接口返回的时长分布。
+     * 
+     * 按微秒的对数分桶，[0] 小于1微秒，[i] 位于[2^(i-1),2^i)微秒，最后一个桶包括更长的时长。
+    */
+    uint64_t latency_hist[ABCDK_MUX_STAT_HIST_BUCKETS];
+
+} abcdk_mux_stat;
+
 /**
  * 销毁多路复用器环境。
 */
@@ -31,6 +170,15 @@ void abcdk_mux_free(abcdk_mux_t **ctx);
 */
 abcdk_mux_t *abcdk_mux_alloc();
 
+/**
+ * 创建多路复用器环境。
+ * 
+ * @param param 参数，NULL(0) 全部使用默认值。
+ * 
+ * @return !NULL(0) 成功(环境指针)，NULL(0) 失败。
+*/
+abcdk_mux_t *abcdk_mux_alloc2(const abcdk_mux_param *param);
+
 /**
  * 分离句柄。
  * 
@@ -76,12 +224,35 @@ int abcdk_mux_mark(abcdk_mux_t *ctx,int fd,uint32_t want,uint32_t done);
 /**
  * 等待事件。
  * 
+ * 多分片模式下，每个线程从所属分片开始依次检查所有分片(不等待)，都没有事件时在上级EPOLL中等待任意分片的事件。
+ * 等待线程的数量与分片数量无关。
+ * 
  * @param timeout 超时(毫秒)。>= 0 有事件或时间过期，< 0 直到有事件或出错。
  * 
  * @return >=0 成功，!0 失败(或超时)。
 */
 int abcdk_mux_wait(abcdk_mux_t *ctx,abcdk_epoll_event *event,time_t timeout);
 
+/**
+ * 批量等待事件。
+ * 
+ * 在一次临界区内拉取多个已就绪的事件，每个事件都需要单独调用abcdk_mux_unref释放引用。
+ * 
+ * @param events 事件数组。
+ * @param max 事件数组容量。> 0 的整数。
+ * @param timeout 超时(毫秒)。>= 0 有事件或时间过期，< 0 直到有事件或出错。
+ * 
+ * @return > 0 成功(事件数量)，<= 0 失败(或超时)。
+*/
+int abcdk_mux_wait_batch(abcdk_mux_t *ctx,abcdk_epoll_event *events,int max,time_t timeout);
+
+/**
+ * 获取统计信息。
+ * 
+ * 不需要加锁，可以在任意线程中调用。
+*/
+void abcdk_mux_stat_fetch(abcdk_mux_t *ctx, abcdk_mux_stat *stat);
+
 /**
  * 引用释放。
  * 
@@ -39,6 +39,16 @@ typedef struct _abcdk_allocator_hdr
     */
     void *opaque;
 
+    /**
+     * 映射长度。0 堆申请。
+    */
+    size_t map_size;
+
+    /**
+     * 区域。!NULL(0) 内存随区域一起释放。
+    */
+    abcdk_arena_t *arena;
+
     /**
      * 内存块信息。
      * 
@@ -56,6 +66,35 @@ typedef struct _abcdk_allocator_hdr
 #define ABCDK_ALLOCATOR_PTR_IN2OUT(PTR) \
     ABCDK_PTR2PTR(abcdk_allocator_t, (PTR), sizeof(abcdk_allocator_hdr) - sizeof(abcdk_allocator_t))
 
+/** 分配后端。*/
+static volatile int _abcdk_allocator_backend = ABCDK_ALLOCATOR_BACKEND_HEAP;
+
+int abcdk_allocator_backend_set(int backend)
+{
+    assert(backend == ABCDK_ALLOCATOR_BACKEND_HEAP || backend == ABCDK_ALLOCATOR_BACKEND_SLAB);
+
+    return __sync_lock_test_and_set(&_abcdk_allocator_backend, backend);
+}
+
+int abcdk_allocator_backend_get()
+{
+    return _abcdk_allocator_backend;
+}
+
+void *abcdk_allocator_heap_alloc(size_t size)
+{
+    if (_abcdk_allocator_backend == ABCDK_ALLOCATOR_BACKEND_SLAB)
+        return abcdk_slab_alloc(size);
+
+    return abcdk_heap_alloc(size);
+}
+
+void abcdk_allocator_heap_free(void *ptr)
+{
+    /*小块内存分配器可以识别内存块的来源，不需要记录申请时的后端。*/
+    abcdk_slab_free(ptr);
+}
+
 void abcdk_allocator_atfree(abcdk_allocator_t *alloc,
                            void (*destroy_cb)(abcdk_allocator_t *alloc, void *opaque),
                            void *opaque)
@@ -73,9 +112,81 @@ void abcdk_allocator_atfree(abcdk_allocator_t *alloc,
     in_p->opaque = opaque;
 }
 
+/** 大页长度。*/
+#define ABCDK_ALLOCATOR_HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+static void *_abcdk_allocator_mmap(size_t size, int flags, size_t *map_size)
+{
+    void *ptr = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    /*预留的大页，长度必须是大页的整数倍。*/
+    if (flags & ABCDK_ALLOCATOR_HUGEPAGE)
+    {
+        *map_size = abcdk_align(size, ABCDK_ALLOCATOR_HUGEPAGE_SIZE);
+        ptr = mmap(NULL, *map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (ptr != MAP_FAILED)
+            return ptr;
+    }
+#endif //MAP_HUGETLB
+
+    *map_size = size;
+    ptr = mmap(NULL, *map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+        return NULL;
+
+#ifdef MADV_HUGEPAGE
+    /*建议内核使用透明大页，失败不影响使用。*/
+    if (*map_size >= ABCDK_ALLOCATOR_HUGEPAGE_SIZE)
+        madvise(ptr, *map_size, MADV_HUGEPAGE);
+#endif //MADV_HUGEPAGE
+
+    return ptr;
+}
+
+static void *_abcdk_allocator_block_alloc(size_t size, int flags, size_t *map_size)
+{
+    *map_size = 0;
+
+    /*
+     * 1：指定大页的大块内存，映射匿名内存。
+     * 2：超过阈值的内存块，映射匿名内存，由内核在缺页时清零。
+    */
+    if (((flags & ABCDK_ALLOCATOR_HUGEPAGE) && size >= ABCDK_ALLOCATOR_HUGEPAGE_SIZE) || size >= ABCDK_ALLOCATOR_MMAP_THRESHOLD)
+        return _abcdk_allocator_mmap(size, flags, map_size);
+
+    /*不清零的内存，超过小块内存的长度时从堆申请，堆中回收的内存可以直接复用。*/
+    if ((flags & ABCDK_ALLOCATOR_UNINIT) && (size > ABCDK_SLAB_SIZE_MAX || _abcdk_allocator_backend != ABCDK_ALLOCATOR_BACKEND_SLAB))
+        return abcdk_heap_malloc(size);
+
+    return abcdk_allocator_heap_alloc(size);
+}
+
+static void _abcdk_allocator_block_free(abcdk_allocator_hdr *in_p)
+{
+    if (in_p->arena)
+        return;
+
+    if (in_p->map_size > 0)
+        munmap(in_p, in_p->map_size);
+    else
+        abcdk_allocator_heap_free(in_p);
+}
+
 abcdk_allocator_t *abcdk_allocator_alloc(size_t *sizes, size_t numbers, int drag)
+{
+    return abcdk_allocator_alloc3(sizes, numbers, drag, 0);
+}
+
+abcdk_allocator_t *abcdk_allocator_alloc3(size_t *sizes, size_t numbers, int drag, int flags)
+{
+    return abcdk_allocator_alloc4(sizes, numbers, drag, flags, NULL);
+}
+
+abcdk_allocator_t *abcdk_allocator_alloc4(size_t *sizes, size_t numbers, int drag, int flags, abcdk_arena_t *arena)
 {
     abcdk_allocator_hdr *in_p = NULL;
+    size_t map_size = 0;
     size_t need_size = 0;
     uint8_t *ptr_p = NULL;
 
@@ -100,15 +211,25 @@ abcdk_allocator_t *abcdk_allocator_alloc(size_t *sizes, size_t numbers, int drag
     /*
      * 一次性申请多个内存块，以便减少多次申请内存块时，碎片化内存块导致内存分页利用率低的问题。
     */
-    in_p = (abcdk_allocator_hdr *)abcdk_heap_alloc(need_size);
+    /*区域中的内存已经清零，不需要映射或大页。*/
+    if (arena)
+        in_p = (abcdk_allocator_hdr *)abcdk_arena_heap_alloc(arena, need_size);
+    else
+        in_p = (abcdk_allocator_hdr *)_abcdk_allocator_block_alloc(need_size, flags, &map_size);
 
     if (!in_p)
         ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
 
+    /*不清零时，头部和指针数组也是未初始化的，需要清零。*/
+    if (flags & ABCDK_ALLOCATOR_UNINIT)
+        memset(in_p, 0, sizeof(abcdk_allocator_hdr) + numbers * (sizeof(size_t) + sizeof(uint8_t *)));
+
     in_p->magic = ABCDK_ALLOCATOR_MAGIC;
     in_p->refcount = 1;
     in_p->destroy_cb = NULL;
     in_p->opaque = NULL;
+    in_p->map_size = map_size;
+    in_p->arena = arena;
 
     in_p->out.refcount = &in_p->refcount;
     in_p->out.numbers = numbers;
@@ -196,7 +317,7 @@ void abcdk_allocator_unref(abcdk_allocator_t **dst)
         in_p->out.pptrs = NULL;
 
         /* 只要释放一次即可全部释放，因为内存是一次性申请的。*/
-        abcdk_heap_free2((void **)&in_p);
+        _abcdk_allocator_block_free(in_p);
     }
 
     /*Set to NULL(0)*/
@@ -210,7 +331,8 @@ abcdk_allocator_t *abcdk_allocator_clone(abcdk_allocator_t *src)
     assert(src);
     assert(src->numbers > 0 && src->pptrs != NULL && src->sizes != NULL);
 
-    dst = abcdk_allocator_alloc(src->sizes, src->numbers,0);
+    /*内容全部被覆盖，不需要清零。*/
+    dst = abcdk_allocator_alloc3(src->sizes, src->numbers, 0, ABCDK_ALLOCATOR_UNINIT);
     if (!dst)
         ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
 
@@ -8,9 +8,49 @@
 #define ABCDKUTIL_ALLOCATOR_H
 
 #include "general.h"
+#include "slab.h"
+#include "arena.h"
 
 __BEGIN_DECLS
 
+/**
+ * 内存块的分配后端。
+*/
+enum _abcdk_allocator_backend
+{
+    /** 堆(默认)。*/
+    ABCDK_ALLOCATOR_BACKEND_HEAP = 0,
+#define ABCDK_ALLOCATOR_BACKEND_HEAP ABCDK_ALLOCATOR_BACKEND_HEAP
+
+    /**
+     * 小块内存分配器。
+     * 
+     * 适用于大量的树节点、字典元素等小块内存频繁申请和释放的场景。统计信息见abcdk_slab_stat_fetch。
+    */
+    ABCDK_ALLOCATOR_BACKEND_SLAB = 1
+#define ABCDK_ALLOCATOR_BACKEND_SLAB ABCDK_ALLOCATOR_BACKEND_SLAB
+};
+
+/** 申请标志：不清零。*/
+#define ABCDK_ALLOCATOR_UNINIT 0x01
+
+/**
+ * 申请标志：大页。
+ * 
+ * 优先使用预留的大页(MAP_HUGETLB)，不可用时映射匿名内存并建议内核使用透明大页。
+ * 
+ * @note 仅对不小于2M的内存块有效。适用于长期使用的大块内存(减少TLB缺失)，不适用于频繁的申请和释放。
+*/
+#define ABCDK_ALLOCATOR_HUGEPAGE 0x02
+
+/**
+ * 大块内存的阈值(字节)。
+ * 
+ * 超过阈值的内存块直接映射匿名内存，并建议内核使用透明大页。
+ * 与glibc的最大映射阈值相同，更大的内存块在glibc中也是每次映射，不能复用。
+*/
+#define ABCDK_ALLOCATOR_MMAP_THRESHOLD (32 * 1024 * 1024)
+
 /**
  * 带引用计数器的内存块信息。
  *
@@ -44,6 +84,37 @@ typedef struct _abcdk_allocator
 
 } abcdk_allocator_t;
 
+/**
+ * 设置分配后端。
+ * 
+ * 可以随时切换，已经申请的内存块按原来的后端释放。
+ * 
+ * @param backend 见ABCDK_ALLOCATOR_BACKEND_*。
+ * 
+ * @return 切换前的后端。
+*/
+int abcdk_allocator_backend_set(int backend);
+
+/**
+ * 获取分配后端。
+*/
+int abcdk_allocator_backend_get();
+
+/**
+ * 按当前的分配后端申请内存。
+ * 
+ * @note 已清零。
+ * @note 必须使用abcdk_allocator_heap_free释放。
+*/
+void *abcdk_allocator_heap_alloc(size_t size);
+
+/**
+ * 释放由abcdk_allocator_heap_alloc申请的内存。
+ * 
+ * @param ptr 内存指针。NULL(0) 忽略。
+*/
+void abcdk_allocator_heap_free(void *ptr);
+
 /**
  * 注册内存块析构函数。
  *
@@ -62,6 +133,26 @@ void abcdk_allocator_atfree(abcdk_allocator_t *alloc,
 */
 abcdk_allocator_t *abcdk_allocator_alloc(size_t *sizes, size_t numbers, int drag);
 
+/**
+ * 申请多个内存块。
+ * 
+ * @param flags 标志。见ABCDK_ALLOCATOR_UNINIT和ABCDK_ALLOCATOR_HUGEPAGE。
+ * 
+ * @note 不清零时，只有内存块的内容未初始化，内存块信息总是有效的。
+*/
+abcdk_allocator_t *abcdk_allocator_alloc3(size_t *sizes, size_t numbers, int drag, int flags);
+
+/**
+ * 从区域中申请多个内存块。
+ * 
+ * 引用计数和析构函数照常使用，最后一个引用释放时只执行析构函数，内存随区域一起释放。
+ * 
+ * @param arena 区域。NULL(0) 与abcdk_allocator_alloc3相同。
+ * 
+ * @warning 区域销毁后，区域中的内存块不能再访问(包括引用和释放)。
+*/
+abcdk_allocator_t *abcdk_allocator_alloc4(size_t *sizes, size_t numbers, int drag, int flags, abcdk_arena_t *arena);
+
 /**
  * 申请一个内存块。
  * 
@@ -0,0 +1,167 @@
+/*
+ * This file is part of ABCDK.
+ *
+ * MIT License
+ *
+ */
+#include "arena.h"
+
+/** 默认的大块内存长度。*/
+#define ABCDK_ARENA_CHUNK_DEFAULT (64 * 1024)
+
+/** 大块内存的最大长度(翻倍的上限)。*/
+#define ABCDK_ARENA_CHUNK_MAX (4 * 1024 * 1024)
+
+/** 对齐。*/
+#define ABCDK_ARENA_ALIGN 16
+
+/**
+ * 大块内存。
+*/
+typedef struct _abcdk_arena_chunk
+{
+    /** 前一块。*/
+    struct _abcdk_arena_chunk *prev;
+
+    /** 长度(不包括头部)。*/
+    size_t size;
+
+    /** 已切分的长度。*/
+    size_t used;
+
+    /** 数据。*/
+    uint8_t data[] __attribute__((aligned(ABCDK_ARENA_ALIGN)));
+
+} abcdk_arena_chunk;
+
+/**
+ * 区域。
+*/
+typedef struct _abcdk_arena
+{
+    /** 当前的大块内存(链表头)。*/
+    abcdk_arena_chunk *chunk;
+
+    /** 下一块大块内存的长度。*/
+    size_t next_size;
+
+    /** 统计信息。*/
+    abcdk_arena_stat stat;
+
+} abcdk_arena_t;
+
+void abcdk_arena_free(abcdk_arena_t **ctx)
+{
+    abcdk_arena_t *ctx_p;
+    abcdk_arena_chunk *chunk, *prev;
+
+    if (!ctx || !*ctx)
+        return;
+
+    ctx_p = *ctx;
+
+    for (chunk = ctx_p->chunk; chunk; chunk = prev)
+    {
+        prev = chunk->prev;
+        abcdk_heap_free(chunk);
+    }
+
+    abcdk_heap_free(ctx_p);
+
+    /*Set to NULL(0).*/
+    *ctx = NULL;
+}
+
+abcdk_arena_t *abcdk_arena_alloc(size_t chunk)
+{
+    abcdk_arena_t *ctx;
+
+    ctx = abcdk_heap_alloc(sizeof(abcdk_arena_t));
+    if (!ctx)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+
+    ctx->next_size = abcdk_align(chunk > 0 ? chunk : ABCDK_ARENA_CHUNK_DEFAULT, ABCDK_ARENA_ALIGN);
+
+    return ctx;
+}
+
+static abcdk_arena_chunk *_abcdk_arena_chunk_alloc(abcdk_arena_t *ctx, size_t size)
+{
+    abcdk_arena_chunk *chunk;
+
+    /*堆内存已经清零，大块内存由内核在缺页时清零。*/
+    chunk = abcdk_heap_alloc(sizeof(abcdk_arena_chunk) + size);
+    if (!chunk)
+        return NULL;
+
+    chunk->size = size;
+
+    ctx->stat.chunk_bytes += size;
+    ctx->stat.chunk_count += 1;
+
+    return chunk;
+}
+
+void *abcdk_arena_heap_alloc(abcdk_arena_t *ctx, size_t size)
+{
+    abcdk_arena_chunk *chunk;
+    void *ptr;
+
+    assert(ctx != NULL && size > 0);
+
+    size = abcdk_align(size, ABCDK_ARENA_ALIGN);
+
+    chunk = ctx->chunk;
+    if (!chunk || chunk->used + size > chunk->size)
+    {
+        /*大的内存单独占用一块，挂在当前块的后面，当前块还可以继续切分。*/
+        if (size > ctx->next_size / 4)
+        {
+            chunk = _abcdk_arena_chunk_alloc(ctx, size);
+            if (!chunk)
+                ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+
+            chunk->used = size;
+
+            if (ctx->chunk)
+            {
+                chunk->prev = ctx->chunk->prev;
+                ctx->chunk->prev = chunk;
+            }
+            else
+            {
+                ctx->chunk = chunk;
+            }
+
+            ctx->stat.alloc_count += 1;
+            ctx->stat.used_bytes += size;
+
+            return chunk->data;
+        }
+
+        chunk = _abcdk_arena_chunk_alloc(ctx, ctx->next_size);
+        if (!chunk)
+            ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+
+        chunk->prev = ctx->chunk;
+        ctx->chunk = chunk;
+
+        /*区域越大，每块越大，大块内存的数量按对数增长。*/
+        ctx->next_size = ABCDK_MIN(ctx->next_size * 2, (size_t)ABCDK_ARENA_CHUNK_MAX);
+    }
+
+    ptr = chunk->data + chunk->used;
+    chunk->used += size;
+
+    ctx->stat.alloc_count += 1;
+    ctx->stat.used_bytes += size;
+
+    return ptr;
+}
+
+void abcdk_arena_stat_fetch(abcdk_arena_t *ctx, abcdk_arena_stat *stat)
+{
+    assert(ctx != NULL && stat != NULL);
+
+    *stat = ctx->stat;
+}
@@ -0,0 +1,76 @@
+/*
+ * This file is part of ABCDK.
+ *
+ * MIT License
+ *
+ */
+#ifndef ABCDKUTIL_ARENA_H
+#define ABCDKUTIL_ARENA_H
+
+#include "general.h"
+
+__BEGIN_DECLS
+
+/**
+ * 区域(arena)。
+ *
+ * 从大块内存中按顺序切分，不能单独释放，销毁时一次性释放全部。
+ * 适用于生命周期相同的大量小块内存，例如一颗树的全部节点。
+ *
+ * @note 申请的内存已经清零，按16字节对齐。
+ * @note 多线程访问需要外部加锁。
+*/
+typedef struct _abcdk_arena abcdk_arena_t;
+
+/**
+ * 区域的统计信息。
+*/
+typedef struct _abcdk_arena_stat
+{
+    /** 申请的次数。*/
+    uint64_t alloc_count;
+
+    /** 已切分的长度(包括对齐)。*/
+    uint64_t used_bytes;
+
+    /** 大块内存的总长度。*/
+    uint64_t chunk_bytes;
+
+    /** 大块内存的数量。*/
+    uint64_t chunk_count;
+
+} abcdk_arena_stat;
+
+/**
+ * 销毁。
+ *
+ * 释放区域中申请的全部内存。
+*/
+void abcdk_arena_free(abcdk_arena_t **ctx);
+
+/**
+ * 创建。
+ *
+ * @param chunk 第一块大块内存的长度，之后每块翻倍(不超过4M)。0 使用默认值(64K)。
+ *
+ * @return !NULL(0) 成功，NULL(0) 失败。
+*/
+abcdk_arena_t *abcdk_arena_alloc(size_t chunk);
+
+/**
+ * 申请内存。
+ *
+ * @note 超过大块内存长度1/4的内存单独占用一块。
+ *
+ * @return !NULL(0) 成功，NULL(0) 失败。
+*/
+void *abcdk_arena_heap_alloc(abcdk_arena_t *ctx, size_t size);
+
+/**
+ * 获取统计信息。
+*/
+void abcdk_arena_stat_fetch(abcdk_arena_t *ctx, abcdk_arena_stat *stat);
+
+__END_DECLS
+
+#endif //ABCDKUTIL_ARENA_H
@@ -20,7 +20,7 @@ ssize_t abcdk_block_read(int fd, void *data, size_t size,abcdk_buffer_t *buf)
 
         while (rsize < size)
         {
-            if (buf->wsize > 0)
+            if (abcdk_buffer_readable(buf) > 0)
             {
                 /*缓存有数据，先从缓存读取。*/
                 rsize2 = abcdk_buffer_read(buf, ABCDK_PTR2PTR(void, data, rsize), size - rsize);
@@ -30,10 +30,10 @@ ssize_t abcdk_block_read(int fd, void *data, size_t size,abcdk_buffer_t *buf)
                 /*累加读取长度。*/
                 rsize += rsize2;
 
-                /*吸收已经读取的缓存数据。*/
+                /*吸收已经读取的缓存数据(环形缓存不移动数据)。*/
                 abcdk_buffer_drain(buf);
             }
-            else if (buf->wsize == 0 || (size - rsize) < buf->size)
+            else if (abcdk_buffer_readable(buf) == 0 || (size - rsize) < buf->size)
             {
                 /*
                  * 满足以下两个条件之一，则先读取到缓存空间。
@@ -88,7 +88,7 @@ ssize_t abcdk_block_write(int fd, const void *data, size_t size,abcdk_buffer_t *
 
         while (wsize < size)
         {
-            if (buf->wsize > 0 && buf->wsize == buf->size)
+            if (abcdk_buffer_writable(buf) == 0)
             {
                 /*缓存空间已满，先把缓存数据导出到文件。*/
                 wsize2 = abcdk_buffer_export_atmost(buf, fd, buf->size);
@@ -98,7 +98,7 @@ ssize_t abcdk_block_write(int fd, const void *data, size_t size,abcdk_buffer_t *
                 /*吸收已经导出(已经写入到文件)的缓存数据。*/
                 abcdk_buffer_drain(buf);
             }
-            else if (buf->wsize > 0 || (size - wsize) < buf->size)
+            else if (abcdk_buffer_readable(buf) > 0 || (size - wsize) < buf->size)
             {
                 /* 
                  * 满足以下两个条件之一，则先把数据写进缓存空间。
@@ -152,7 +152,7 @@ int abcdk_block_write_trailer(int fd, uint8_t stuffing,abcdk_buffer_t *buf)
     assert(buf->data != NULL && buf->size > 0);
 
     /*缓存无数据。*/
-    if (buf->wsize == 0)
+    if (abcdk_buffer_readable(buf) == 0)
         return 0;
 
     /*缓存有数据，先用填充物填满缓存空间。*/
@@ -167,8 +167,550 @@ int abcdk_block_write_trailer(int fd, uint8_t stuffing,abcdk_buffer_t *buf)
     abcdk_buffer_drain(buf);
 
     /*检查是否有数据未导出。*/
-    if (buf->wsize == 0)
+    if (abcdk_buffer_readable(buf) == 0)
         return 0;
 
     return -1;
 }
+
+/*------------------------------------------------------------------------------------------------*/
+
+/**
+ * 异步的块写入器。
+*/
+typedef struct _abcdk_block_writer
+{
+    /** 文件句柄。*/
+    int fd;
+
+    /** 块大小。*/
+    size_t block;
+
+    /** 块数量。*/
+    int blocks;
+
+    /** 块内存(连续的多个块)。*/
+    uint8_t *data;
+
+    /** 当前块已填充的长度。*/
+    size_t fill;
+
+    /** 已提交的块数量(调用者)。*/
+    uint64_t head;
+
+    /** 已写完的块数量(写线程)。*/
+    uint64_t tail;
+
+    /** 写入失败的错误码。*/
+    int error;
+
+    /** 退出标志。*/
+    int exit;
+
+    /** 互斥量和事件。*/
+    abcdk_mutex_t mutex;
+
+    /** 写线程。*/
+    abcdk_thread_t thread;
+
+    /** 统计信息。*/
+    abcdk_block_writer_stat stat;
+
+} abcdk_block_writer_t;
+
+static void *_abcdk_block_writer_routine(void *opaque)
+{
+    abcdk_block_writer_t *ctx = (abcdk_block_writer_t *)opaque;
+    uint8_t *block_p;
+    ssize_t wsize;
+    int error;
+
+    abcdk_thread_setname("%s", "block-writer");
+
+    abcdk_mutex_lock(&ctx->mutex, 1);
+
+    for (;;)
+    {
+        if (ctx->tail == ctx->head)
+        {
+            /*提交的块已经全部写完，退出。*/
+            if (ctx->exit)
+                break;
+
+            /*第一块之前的等待不算。*/
+            if (ctx->tail > 0)
+                ctx->stat.idles += 1;
+
+            while (ctx->tail == ctx->head && !ctx->exit)
+                abcdk_mutex_wait(&ctx->mutex, -1);
+
+            continue;
+        }
+
+        block_p = ctx->data + (ctx->tail % ctx->blocks) * ctx->block;
+
+        /*错误标志在解锁前取出，写入期间不访问共享的字段。*/
+        error = ctx->error;
+
+        /*写入时不持有锁，调用者可以继续填充其它的块。*/
+        abcdk_mutex_unlock(&ctx->mutex);
+        wsize = (error ? -1 : abcdk_write(ctx->fd, block_p, ctx->block));
+        abcdk_mutex_lock(&ctx->mutex, 1);
+
+        if (wsize == ctx->block)
+        {
+            ctx->stat.blocks += 1;
+            ctx->stat.bytes += wsize;
+        }
+        else if (!ctx->error)
+        {
+            /*出错后丢弃后面的块，错误在调用者下次写入时返回。*/
+            ctx->error = ((wsize < 0 && errno) ? errno : ENOSPC);
+        }
+
+        ctx->tail += 1;
+
+        abcdk_mutex_signal(&ctx->mutex, 1);
+    }
+
+    abcdk_mutex_unlock(&ctx->mutex);
+
+    return NULL;
+}
+
+void abcdk_block_writer_free(abcdk_block_writer_t **ctx)
+{
+    abcdk_block_writer_t *ctx_p;
+
+    if (!ctx || !*ctx)
+        return;
+
+    ctx_p = *ctx;
+
+    abcdk_mutex_lock(&ctx_p->mutex, 1);
+    ctx_p->exit = 1;
+    abcdk_mutex_signal(&ctx_p->mutex, 1);
+    abcdk_mutex_unlock(&ctx_p->mutex);
+
+    abcdk_thread_join(&ctx_p->thread);
+
+    abcdk_mutex_destroy(&ctx_p->mutex);
+    abcdk_heap_free(ctx_p->data);
+    abcdk_heap_free(ctx_p);
+
+    /*Set to NULL(0).*/
+    *ctx = NULL;
+}
+
+abcdk_block_writer_t *abcdk_block_writer_alloc(int fd, size_t block, int blocks)
+{
+    abcdk_block_writer_t *ctx;
+
+    assert(fd >= 0 && block > 0 && blocks >= 2);
+
+    ctx = abcdk_heap_alloc(sizeof(abcdk_block_writer_t));
+    if (!ctx)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+
+    ctx->fd = fd;
+    ctx->block = block;
+    ctx->blocks = blocks;
+
+    /*按页对齐，可以用于直接IO。*/
+    if (posix_memalign((void **)&ctx->data, sysconf(_SC_PAGESIZE), block * blocks) != 0)
+    {
+        abcdk_heap_free(ctx);
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+    }
+
+    abcdk_mutex_init2(&ctx->mutex, 0);
+
+    ctx->thread.routine = _abcdk_block_writer_routine;
+    ctx->thread.opaque = ctx;
+
+    if (abcdk_thread_create(&ctx->thread, 1) != 0)
+    {
+        abcdk_mutex_destroy(&ctx->mutex);
+        abcdk_heap_free(ctx->data);
+        abcdk_heap_free(ctx);
+        ABCDK_ERRNO_AND_RETURN1(EAGAIN, NULL);
+    }
+
+    return ctx;
+}
+
+/*
+ * 获取当前块。
+ *
+ * 所有块都在等待写入时，等待写线程写完一块。
+*/
+static uint8_t *_abcdk_block_writer_current(abcdk_block_writer_t *ctx)
+{
+    uint8_t *block_p = NULL;
+
+    abcdk_mutex_lock(&ctx->mutex, 1);
+
+    if (ctx->head - ctx->tail >= ctx->blocks && !ctx->error)
+    {
+        ctx->stat.stalls += 1;
+
+        while (ctx->head - ctx->tail >= ctx->blocks && !ctx->error)
+            abcdk_mutex_wait(&ctx->mutex, -1);
+    }
+
+    if (ctx->error)
+        errno = ctx->error;
+    else
+        block_p = ctx->data + (ctx->head % ctx->blocks) * ctx->block;
+
+    abcdk_mutex_unlock(&ctx->mutex);
+
+    return block_p;
+}
+
+static void _abcdk_block_writer_submit(abcdk_block_writer_t *ctx)
+{
+    abcdk_mutex_lock(&ctx->mutex, 1);
+
+    ctx->head += 1;
+    ctx->fill = 0;
+
+    abcdk_mutex_signal(&ctx->mutex, 1);
+    abcdk_mutex_unlock(&ctx->mutex);
+}
+
+ssize_t abcdk_block_writer_write(abcdk_block_writer_t *ctx, const void *data, size_t size)
+{
+    ssize_t wsize = 0;
+    size_t wsize2 = 0;
+    uint8_t *block_p;
+
+    assert(ctx != NULL && data != NULL && size > 0);
+
+    while (wsize < size)
+    {
+        block_p = _abcdk_block_writer_current(ctx);
+        if (!block_p)
+            break;
+
+        wsize2 = ABCDK_MIN(ctx->block - ctx->fill, size - wsize);
+        memcpy(block_p + ctx->fill, ABCDK_PTR2VPTR(data, wsize), wsize2);
+
+        ctx->fill += wsize2;
+        wsize += wsize2;
+
+        /*块已满，交给写线程。*/
+        if (ctx->fill == ctx->block)
+            _abcdk_block_writer_submit(ctx);
+    }
+
+    return (wsize > 0 ? wsize : -1);
+}
+
+int abcdk_block_writer_trailer(abcdk_block_writer_t *ctx, uint8_t stuffing)
+{
+    uint8_t *block_p;
+    int chk;
+
+    assert(ctx != NULL);
+
+    /*当前块有数据，先用填充物填满。*/
+    if (ctx->fill > 0)
+    {
+        block_p = _abcdk_block_writer_current(ctx);
+        if (!block_p)
+            return -1;
+
+        memset(block_p + ctx->fill, stuffing, ctx->block - ctx->fill);
+        _abcdk_block_writer_submit(ctx);
+    }
+
+    /*等待全部写完。*/
+    abcdk_mutex_lock(&ctx->mutex, 1);
+
+    while (ctx->tail != ctx->head)
+        abcdk_mutex_wait(&ctx->mutex, -1);
+
+    chk = (ctx->error ? -1 : 0);
+    if (ctx->error)
+        errno = ctx->error;
+
+    abcdk_mutex_unlock(&ctx->mutex);
+
+    return chk;
+}
+
+void abcdk_block_writer_stat_fetch(abcdk_block_writer_t *ctx, abcdk_block_writer_stat *stat)
+{
+    assert(ctx != NULL && stat != NULL);
+
+    abcdk_mutex_lock(&ctx->mutex, 1);
+    *stat = ctx->stat;
+    abcdk_mutex_unlock(&ctx->mutex);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+
+/**
+ * 预读的块读取器。
+*/
+typedef struct _abcdk_block_reader
+{
+    /** 文件句柄。*/
+    int fd;
+
+    /** 块大小。*/
+    size_t block;
+
+    /** 块数量。*/
+    int blocks;
+
+    /** 块内存(连续的多个块)。*/
+    uint8_t *data;
+
+    /** 每块读入的长度。*/
+    size_t *lens;
+
+    /** 当前块已取走的长度。*/
+    size_t off;
+
+    /** 已读入的块数量(读线程)。*/
+    uint64_t head;
+
+    /** 已取完的块数量(调用者)。*/
+    uint64_t tail;
+
+    /** 末尾标志。*/
+    int eof;
+
+    /** 读取失败的错误码。*/
+    int error;
+
+    /** 退出标志。*/
+    int exit;
+
+    /** 互斥量和事件。*/
+    abcdk_mutex_t mutex;
+
+    /** 读线程。*/
+    abcdk_thread_t thread;
+
+    /** 统计信息。*/
+    abcdk_block_reader_stat stat;
+
+} abcdk_block_reader_t;
+
+static void *_abcdk_block_reader_routine(void *opaque)
+{
+    abcdk_block_reader_t *ctx = (abcdk_block_reader_t *)opaque;
+    uint8_t *block_p;
+    ssize_t rsize;
+
+    abcdk_thread_setname("%s", "block-reader");
+
+    abcdk_mutex_lock(&ctx->mutex, 1);
+
+    while (!ctx->exit && !ctx->eof && !ctx->error)
+    {
+        if (ctx->head - ctx->tail >= ctx->blocks)
+        {
+            /*所有块都有数据，等待调用者取走一块。*/
+            ctx->stat.idles += 1;
+
+            while (ctx->head - ctx->tail >= ctx->blocks && !ctx->exit)
+                abcdk_mutex_wait(&ctx->mutex, -1);
+
+            continue;
+        }
+
+        block_p = ctx->data + (ctx->head % ctx->blocks) * ctx->block;
+
+        /*读取时不持有锁，调用者可以继续从其它的块取数据。*/
+        abcdk_mutex_unlock(&ctx->mutex);
+        rsize = abcdk_read(ctx->fd, block_p, ctx->block);
+        abcdk_mutex_lock(&ctx->mutex, 1);
+
+        if (rsize > 0)
+        {
+            ctx->lens[ctx->head % ctx->blocks] = rsize;
+            ctx->head += 1;
+
+            ctx->stat.blocks += 1;
+            ctx->stat.bytes += rsize;
+        }
+        else if (rsize == 0)
+        {
+            ctx->eof = 1;
+        }
+        else
+        {
+            /*出错后停止预读，错误在调用者取完已读入的块后返回。*/
+            ctx->error = (errno ? errno : EIO);
+        }
+
+        abcdk_mutex_signal(&ctx->mutex, 1);
+    }
+
+    abcdk_mutex_unlock(&ctx->mutex);
+
+    return NULL;
+}
+
+void abcdk_block_reader_free(abcdk_block_reader_t **ctx)
+{
+    abcdk_block_reader_t *ctx_p;
+
+    if (!ctx || !*ctx)
+        return;
+
+    ctx_p = *ctx;
+
+    abcdk_mutex_lock(&ctx_p->mutex, 1);
+    ctx_p->exit = 1;
+    abcdk_mutex_signal(&ctx_p->mutex, 1);
+    abcdk_mutex_unlock(&ctx_p->mutex);
+
+    abcdk_thread_join(&ctx_p->thread);
+
+    abcdk_mutex_destroy(&ctx_p->mutex);
+    abcdk_heap_free(ctx_p->lens);
+    abcdk_heap_free(ctx_p->data);
+    abcdk_heap_free(ctx_p);
+
+    /*Set to NULL(0).*/
+    *ctx = NULL;
+}
+
+abcdk_block_reader_t *abcdk_block_reader_alloc(int fd, size_t block, int blocks)
+{
+    abcdk_block_reader_t *ctx;
+
+    assert(fd >= 0 && block > 0 && blocks >= 2);
+
+    ctx = abcdk_heap_alloc(sizeof(abcdk_block_reader_t));
+    if (!ctx)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+
+    ctx->fd = fd;
+    ctx->block = block;
+    ctx->blocks = blocks;
+
+    ctx->lens = abcdk_heap_alloc(sizeof(size_t) * blocks);
+    if (!ctx->lens)
+        goto final_error;
+
+    /*按页对齐，可以用于直接IO。*/
+    if (posix_memalign((void **)&ctx->data, sysconf(_SC_PAGESIZE), block * blocks) != 0)
+        goto final_error;
+
+    abcdk_mutex_init2(&ctx->mutex, 0);
+
+    ctx->thread.routine = _abcdk_block_reader_routine;
+    ctx->thread.opaque = ctx;
+
+    if (abcdk_thread_create(&ctx->thread, 1) != 0)
+    {
+        abcdk_mutex_destroy(&ctx->mutex);
+        goto final_error;
+    }
+
+    return ctx;
+
+final_error:
+
+    abcdk_heap_free(ctx->data);
+    abcdk_heap_free(ctx->lens);
+    abcdk_heap_free(ctx);
+
+    ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+}
+
+ssize_t abcdk_block_reader_fetch(abcdk_block_reader_t *ctx, const void **data)
+{
+    ssize_t rsize = 0;
+
+    assert(ctx != NULL && data != NULL);
+
+    abcdk_mutex_lock(&ctx->mutex, 1);
+
+    if (ctx->head == ctx->tail && !ctx->eof && !ctx->error)
+    {
+        ctx->stat.stalls += 1;
+
+        while (ctx->head == ctx->tail && !ctx->eof && !ctx->error)
+            abcdk_mutex_wait(&ctx->mutex, -1);
+    }
+
+    if (ctx->head != ctx->tail)
+    {
+        /*已读入的块先取完，再返回末尾或错误。*/
+        *data = ctx->data + (ctx->tail % ctx->blocks) * ctx->block + ctx->off;
+        rsize = ctx->lens[ctx->tail % ctx->blocks] - ctx->off;
+    }
+    else if (ctx->error)
+    {
+        errno = ctx->error;
+        rsize = -1;
+    }
+
+    abcdk_mutex_unlock(&ctx->mutex);
+
+    return rsize;
+}
+
+void abcdk_block_reader_drain(abcdk_block_reader_t *ctx, size_t size)
+{
+    assert(ctx != NULL);
+
+    abcdk_mutex_lock(&ctx->mutex, 1);
+
+    assert(ctx->head != ctx->tail || size == 0);
+    assert(size <= ctx->lens[ctx->tail % ctx->blocks] - ctx->off);
+
+    ctx->off += size;
+
+    /*块已取完，交还给读线程。*/
+    if (size > 0 && ctx->off == ctx->lens[ctx->tail % ctx->blocks])
+    {
+        ctx->off = 0;
+        ctx->tail += 1;
+
+        abcdk_mutex_signal(&ctx->mutex, 1);
+    }
+
+    abcdk_mutex_unlock(&ctx->mutex);
+}
+
+ssize_t abcdk_block_reader_read(abcdk_block_reader_t *ctx, void *data, size_t size)
+{
+    ssize_t rsize = 0;
+    ssize_t rsize2 = 0;
+    const void *block_p;
+
+    assert(ctx != NULL && data != NULL && size > 0);
+
+    while (rsize < size)
+    {
+        rsize2 = abcdk_block_reader_fetch(ctx, &block_p);
+        if (rsize2 <= 0)
+            break;
+
+        rsize2 = ABCDK_MIN((size_t)rsize2, size - rsize);
+        memcpy(ABCDK_PTR2VPTR(data, rsize), block_p, rsize2);
+
+        abcdk_block_reader_drain(ctx, rsize2);
+
+        rsize += rsize2;
+    }
+
+    return (rsize > 0 ? rsize : rsize2);
+}
+
+void abcdk_block_reader_stat_fetch(abcdk_block_reader_t *ctx, abcdk_block_reader_stat *stat)
+{
+    assert(ctx != NULL && stat != NULL);
+
+    abcdk_mutex_lock(&ctx->mutex, 1);
+    *stat = ctx->stat;
+    abcdk_mutex_unlock(&ctx->mutex);
+}
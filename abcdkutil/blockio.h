@@ -9,12 +9,15 @@
 
 #include "general.h"
 #include "buffer.h"
+#include "thread.h"
 
 __BEGIN_DECLS
 
 /**
  * 以块为单位读数据。
  * 
+ * @note 建议使用环形缓存(abcdk_buffer_alloc3)，每次从缓存读取后不需要移动未读数据。
+ * 
  * @param buf 缓存。NULL(0) 自由块大小，!NULL(0) 定长块大小。
  * 
  * @return > 0 读取的长度，<= 0 读取失败或已到末尾。
@@ -40,6 +43,174 @@ ssize_t abcdk_block_write(int fd, const void *data, size_t size,abcdk_buffer_t *
 */
 int abcdk_block_write_trailer(int fd, uint8_t stuffing,abcdk_buffer_t *buf);
 
+/*------------------------------------------------------------------------------------------------*/
+
+/**
+ * 异步的块写入器。
+ * 
+ * 多个定长的块组成环，调用者填充当前块，填满后交给写线程，然后继续填充下一块。
+ * 写线程按顺序把块写入文件，调用者和设备(磁带、磁盘)同时工作，磁带可以保持连续走带。
+ * 
+ * @note 每次写入一个完整的块，与abcdk_block_write定长块模式的写入方式相同。
+ * @note 多线程访问需要外部加锁(写线程除外)。
+*/
+typedef struct _abcdk_block_writer abcdk_block_writer_t;
+
+/**
+ * 块写入器的统计信息。
+*/
+typedef struct _abcdk_block_writer_stat
+{
+    /** 写入的块数量。*/
+    uint64_t blocks;
+
+    /** 写入的长度(Bytes)。*/
+    uint64_t bytes;
+
+    /** 调用者等待空闲块的次数(设备慢于调用者)。*/
+    uint64_t stalls;
+
+    /** 写线程等待数据的次数(调用者慢于设备，磁带可能停止走带)。*/
+    uint64_t idles;
+
+} abcdk_block_writer_stat;
+
+/**
+ * 销毁。
+ * 
+ * 等待已经提交的块全部写完，未填满的块被丢弃(需要先调用abcdk_block_writer_trailer)。
+ * 
+ * @note 不关闭文件句柄。
+*/
+void abcdk_block_writer_free(abcdk_block_writer_t **ctx);
+
+/**
+ * 创建。
+ * 
+ * @param fd 文件句柄。
+ * @param block 块大小(Bytes)。
+ * @param blocks 块数量，至少2块。
+ * 
+ * @return !NULL(0) 成功，NULL(0) 失败。
+*/
+abcdk_block_writer_t *abcdk_block_writer_alloc(int fd, size_t block, int blocks);
+
+/**
+ * 写数据。
+ * 
+ * 复制到当前块，块填满后交给写线程。所有块都在等待写入时，阻塞到有空闲块。
+ * 
+ * @note 写入失败在后续的调用中返回。
+ * 
+ * @return > 0 写入的长度，<= 0 写入失败或空间不足。
+*/
+ssize_t abcdk_block_writer_write(abcdk_block_writer_t *ctx, const void *data, size_t size);
+
+/**
+ * 写补齐数据，并等待全部写完。
+ * 
+ * @param stuffing 填充物。
+ * 
+ * @return 0 成功，< 0 写入失败或空间不足。
+*/
+int abcdk_block_writer_trailer(abcdk_block_writer_t *ctx, uint8_t stuffing);
+
+/**
+ * 获取统计信息。
+*/
+void abcdk_block_writer_stat_fetch(abcdk_block_writer_t *ctx, abcdk_block_writer_stat *stat);
+
+/*------------------------------------------------------------------------------------------------*/
+
+/**
+ * 预读的块读取器。
+ * 
+ * 多个定长的块组成环，读线程按顺序把块从文件读入空闲块，调用者从已读入的块中取数据。
+ * 调用者处理数据时，设备(磁带、磁盘)继续读取后面的块。
+ * 
+ * @note 每次读取一个完整的块，与abcdk_block_read定长块模式的读取方式相同。
+ * @note 多线程访问需要外部加锁(读线程除外)。
+*/
+typedef struct _abcdk_block_reader abcdk_block_reader_t;
+
+/**
+ * 块读取器的统计信息。
+*/
+typedef struct _abcdk_block_reader_stat
+{
+    /** 读取的块数量。*/
+    uint64_t blocks;
+
+    /** 读取的长度(Bytes)。*/
+    uint64_t bytes;
+
+    /** 调用者等待数据的次数(设备慢于调用者)。*/
+    uint64_t stalls;
+
+    /** 读线程等待空闲块的次数(调用者慢于设备，磁带可能停止走带)。*/
+    uint64_t idles;
+
+} abcdk_block_reader_stat;
+
+/**
+ * 销毁。
+ * 
+ * 未取走的数据被丢弃。
+ * 
+ * @note 不关闭文件句柄。
+ * @note 读线程正在读取时，等待读取返回。
+*/
+void abcdk_block_reader_free(abcdk_block_reader_t **ctx);
+
+/**
+ * 创建。
+ * 
+ * @param fd 文件句柄。
+ * @param block 块大小(Bytes)。
+ * @param blocks 块数量(预读深度)，至少2块。
+ * 
+ * @return !NULL(0) 成功，NULL(0) 失败。
+*/
+abcdk_block_reader_t *abcdk_block_reader_alloc(int fd, size_t block, int blocks);
+
+/**
+ * 获取当前块的未读数据(不复制)。
+ * 
+ * 当前块没有已读入的数据时，阻塞到读线程读入一块。
+ * 
+ * @note 数据在调用abcdk_block_reader_drain之前有效。
+ * 
+ * @param data 用于返回数据的指针。
+ * 
+ * @return > 0 数据的长度，= 0 末尾，< 0 读取失败。
+*/
+ssize_t abcdk_block_reader_fetch(abcdk_block_reader_t *ctx, const void **data);
+
+/**
+ * 排出数据。
+ * 
+ * 丢弃当前块前面size字节的数据，当前块排空后交还给读线程。
+ * 
+ * @param size 长度，不能超过abcdk_block_reader_fetch返回的长度。
+*/
+void abcdk_block_reader_drain(abcdk_block_reader_t *ctx, size_t size);
+
+/**
+ * 读数据。
+ * 
+ * 从已读入的块中复制。
+ * 
+ * @note 读取失败在后续的调用中返回。
+ * 
+ * @return > 0 读取的长度，<= 0 读取失败或已到末尾。
+*/
+ssize_t abcdk_block_reader_read(abcdk_block_reader_t *ctx, void *data, size_t size);
+
+/**
+ * 获取统计信息。
+*/
+void abcdk_block_reader_stat_fetch(abcdk_block_reader_t *ctx, abcdk_block_reader_stat *stat);
+
 __END_DECLS
 
 
@@ -0,0 +1,989 @@
+/*
+ * This file is part of ABCDK.
+ *
+ * MIT License
+ *
+ */
+#include "bptree.h"
+
+/** 节点的最大数量(叶子节点的元素，分支节点的子节点)。*/
+#define ABCDK_BPTREE_MAX 32
+
+/** 节点的最小数量(根节点除外)。*/
+#define ABCDK_BPTREE_MIN (ABCDK_BPTREE_MAX / 2)
+
+/** 最大深度(分支节点的层数)。*/
+#define ABCDK_BPTREE_DEPTH_MAX 32
+
+/** 节点内保存的KEY的最大长度。*/
+#define ABCDK_BPTREE_INLINE 16
+
+/**
+ * 节点中的KEY。
+ *
+ * 短KEY直接保存在节点中，查找时不需要访问节点以外的内存。长KEY保存指针，叶子节点中指向元素的KEY，
+ * 分支节点中指向KEY的副本。
+*/
+typedef struct _abcdk_bptree_key
+{
+    /** 长度。*/
+    size_t size;
+
+    union
+    {
+        /** 短KEY。*/
+        uint8_t buf[ABCDK_BPTREE_INLINE];
+
+        /** 长KEY。*/
+        void *ptr;
+    };
+
+} abcdk_bptree_key;
+
+#define ABCDK_BPTREE_KEY(k) ((k)->size <= ABCDK_BPTREE_INLINE ? (const void *)(k)->buf : (const void *)(k)->ptr), (k)->size
+
+/**
+ * 节点头部。
+*/
+typedef struct _abcdk_bptree_node
+{
+    /** !0 叶子节点，0 分支节点。*/
+    int leaf;
+
+    /** 数量。叶子节点是元素数量，分支节点是子节点数量。*/
+    int count;
+
+} abcdk_bptree_node;
+
+/**
+ * 叶子节点。
+*/
+typedef struct _abcdk_bptree_leaf
+{
+    /** 头部。*/
+    abcdk_bptree_node hdr;
+
+    /** 前一个叶子节点。*/
+    struct _abcdk_bptree_leaf *prev;
+
+    /** 后一个叶子节点。*/
+    struct _abcdk_bptree_leaf *next;
+
+    /** 元素的KEY(与元素一一对应)。*/
+    abcdk_bptree_key keys[ABCDK_BPTREE_MAX + 1];
+
+    /** 元素(按KEY升序)。多一个位置，添加时先放进去再分裂。*/
+    abcdk_allocator_t *allocs[ABCDK_BPTREE_MAX + 1];
+
+} abcdk_bptree_leaf;
+
+/**
+ * 分支节点。
+*/
+typedef struct _abcdk_bptree_inner
+{
+    /** 头部。*/
+    abcdk_bptree_node hdr;
+
+    /**
+     * 分隔KEY。
+     *
+     * keys[i]大于child[i]中的所有KEY，不大于child[i+1]中的所有KEY。
+    */
+    abcdk_bptree_key keys[ABCDK_BPTREE_MAX];
+
+    /** 子节点。多一个位置，添加时先放进去再分裂。*/
+    abcdk_bptree_node *child[ABCDK_BPTREE_MAX + 1];
+
+} abcdk_bptree_inner;
+
+/**
+ * 有序MAP(B+树)。
+*/
+typedef struct _abcdk_bptree
+{
+    /** 回调函数。*/
+    abcdk_bptree_callback cb;
+
+    /** 根节点。*/
+    abcdk_bptree_node *root;
+
+    /** 元素数量。*/
+    size_t count;
+
+    /** 高度。*/
+    size_t height;
+
+} abcdk_bptree_t;
+
+/**
+ * 查找路径。
+*/
+typedef struct _abcdk_bptree_path
+{
+    /** 分支节点。*/
+    abcdk_bptree_inner *nodes[ABCDK_BPTREE_DEPTH_MAX];
+
+    /** 子节点的索引。*/
+    int idx[ABCDK_BPTREE_DEPTH_MAX];
+
+    /** 深度。*/
+    int depth;
+
+} abcdk_bptree_path;
+
+#define ABCDK_BPTREE_ALLOC_KEY(alloc) (alloc)->pptrs[ABCDK_MAP_KEY], (alloc)->sizes[ABCDK_MAP_KEY]
+
+/** 移动叶子节点中的元素(和KEY)。*/
+#define ABCDK_BPTREE_LEAF_MOVE(dst, dpos, src, spos, n)                                            \
+    do                                                                                             \
+    {                                                                                              \
+        memmove(&(dst)->keys[dpos], &(src)->keys[spos], (n) * sizeof(abcdk_bptree_key));           \
+        memmove(&(dst)->allocs[dpos], &(src)->allocs[spos], (n) * sizeof(abcdk_allocator_t *));    \
+    } while (0)
+
+int abcdk_bptree_compare(const void *key1, size_t size1, const void *key2, size_t size2, void *opaque)
+{
+    int chk;
+
+    chk = memcmp(key1, key2, ABCDK_MIN(size1, size2));
+    if (chk != 0)
+        return chk;
+
+    return (size1 > size2 ? 1 : (size1 < size2 ? -1 : 0));
+}
+
+static abcdk_bptree_node *_abcdk_bptree_node_alloc(int leaf)
+{
+    abcdk_bptree_node *node;
+
+    node = abcdk_heap_alloc(leaf ? sizeof(abcdk_bptree_leaf) : sizeof(abcdk_bptree_inner));
+    if (!node)
+        return NULL;
+
+    node->leaf = leaf;
+
+    return node;
+}
+
+/**
+ * 设置叶子节点中的KEY(长KEY指向元素的KEY)。
+*/
+static void _abcdk_bptree_key_refer(abcdk_bptree_key *dst, abcdk_allocator_t *alloc)
+{
+    dst->size = alloc->sizes[ABCDK_MAP_KEY];
+
+    if (dst->size <= ABCDK_BPTREE_INLINE)
+        memcpy(dst->buf, alloc->pptrs[ABCDK_MAP_KEY], dst->size);
+    else
+        dst->ptr = alloc->pptrs[ABCDK_MAP_KEY];
+}
+
+/**
+ * 复制KEY作为分支节点的分隔KEY(长KEY复制到堆上)。
+*/
+static int _abcdk_bptree_key_clone(abcdk_bptree_key *dst, const abcdk_bptree_key *src)
+{
+    if (src->size <= ABCDK_BPTREE_INLINE)
+    {
+        *dst = *src;
+        return 0;
+    }
+
+    dst->ptr = abcdk_heap_clone(src->ptr, src->size);
+    if (!dst->ptr)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, -1);
+
+    dst->size = src->size;
+
+    return 0;
+}
+
+/**
+ * 释放分支节点的分隔KEY。
+*/
+static void _abcdk_bptree_key_free(abcdk_bptree_key *key)
+{
+    if (key->size > ABCDK_BPTREE_INLINE)
+        abcdk_heap_free(key->ptr);
+
+    key->size = 0;
+}
+
+/**
+ * 释放节点。
+ *
+ * @param child !0 同时释放子节点。
+ * @param unref !0 同时释放元素。
+*/
+static void _abcdk_bptree_node_free(abcdk_bptree_node *node, int child, int unref)
+{
+    abcdk_bptree_leaf *leaf;
+    abcdk_bptree_inner *inner;
+
+    if (!node)
+        return;
+
+    if (node->leaf)
+    {
+        leaf = (abcdk_bptree_leaf *)node;
+
+        for (int i = 0; unref && i < leaf->hdr.count; i++)
+            abcdk_allocator_unref(&leaf->allocs[i]);
+    }
+    else
+    {
+        inner = (abcdk_bptree_inner *)node;
+
+        for (int i = 0; i < inner->hdr.count - 1; i++)
+            _abcdk_bptree_key_free(&inner->keys[i]);
+
+        for (int i = 0; child && i < inner->hdr.count; i++)
+            _abcdk_bptree_node_free(inner->child[i], child, unref);
+    }
+
+    abcdk_heap_free(node);
+}
+
+void abcdk_bptree_free(abcdk_bptree_t **ctx)
+{
+    abcdk_bptree_t *ctx_p;
+
+    if (!ctx || !*ctx)
+        return;
+
+    ctx_p = *ctx;
+
+    _abcdk_bptree_node_free(ctx_p->root, 1, 1);
+    abcdk_heap_free(ctx_p);
+
+    /*Set to NULL(0).*/
+    *ctx = NULL;
+}
+
+abcdk_bptree_t *abcdk_bptree_alloc(const abcdk_bptree_callback *cb)
+{
+    abcdk_bptree_t *ctx;
+
+    ctx = abcdk_heap_alloc(sizeof(abcdk_bptree_t));
+    if (!ctx)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+
+    if (cb)
+        ctx->cb = *cb;
+
+    /* 如果未指定，则启用默认函数。 */
+    if (!ctx->cb.compare_cb)
+        ctx->cb.compare_cb = abcdk_bptree_compare;
+
+    /*空树也有一个叶子节点，查找时不需要判断。*/
+    ctx->root = _abcdk_bptree_node_alloc(1);
+    if (!ctx->root)
+        goto final_error;
+
+    ctx->height = 1;
+
+    return ctx;
+
+final_error:
+
+    abcdk_bptree_free(&ctx);
+
+    ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+}
+
+size_t abcdk_bptree_count(abcdk_bptree_t *ctx)
+{
+    assert(ctx != NULL);
+
+    return ctx->count;
+}
+
+size_t abcdk_bptree_height(abcdk_bptree_t *ctx)
+{
+    assert(ctx != NULL);
+
+    return ctx->height;
+}
+
+/**
+ * 在叶子节点中查找。
+ *
+ * @param strict 0 第一个不小于KEY的位置，!0 第一个大于KEY的位置。
+*/
+static int _abcdk_bptree_leaf_search(abcdk_bptree_t *ctx, abcdk_bptree_leaf *leaf, const void *key, size_t ksize, int strict)
+{
+    int l = 0, r = leaf->hdr.count, m, chk;
+
+    while (l < r)
+    {
+        m = (l + r) / 2;
+        chk = ctx->cb.compare_cb(ABCDK_BPTREE_KEY(&leaf->keys[m]), key, ksize, ctx->cb.opaque);
+
+        if (chk < 0 || (strict && chk == 0))
+            l = m + 1;
+        else
+            r = m;
+    }
+
+    return l;
+}
+
+/**
+ * 在分支节点中查找KEY所在的子节点(不大于KEY的分隔KEY的数量)。
+*/
+static int _abcdk_bptree_inner_search(abcdk_bptree_t *ctx, abcdk_bptree_inner *inner, const void *key, size_t ksize)
+{
+    int l = 0, r = inner->hdr.count - 1, m, chk;
+
+    while (l < r)
+    {
+        m = (l + r) / 2;
+        chk = ctx->cb.compare_cb(ABCDK_BPTREE_KEY(&inner->keys[m]), key, ksize, ctx->cb.opaque);
+
+        if (chk <= 0)
+            l = m + 1;
+        else
+            r = m;
+    }
+
+    return l;
+}
+
+/**
+ * 查找KEY所在的叶子节点。
+ *
+ * @param path 查找路径，NULL(0) 忽略。
+*/
+static abcdk_bptree_leaf *_abcdk_bptree_descend(abcdk_bptree_t *ctx, const void *key, size_t ksize, abcdk_bptree_path *path)
+{
+    abcdk_bptree_node *node = ctx->root;
+    abcdk_bptree_inner *inner;
+    int depth = 0, idx;
+
+    while (!node->leaf)
+    {
+        inner = (abcdk_bptree_inner *)node;
+        idx = _abcdk_bptree_inner_search(ctx, inner, key, ksize);
+
+        if (path)
+        {
+            path->nodes[depth] = inner;
+            path->idx[depth] = idx;
+        }
+
+        depth += 1;
+        node = inner->child[idx];
+    }
+
+    if (path)
+        path->depth = depth;
+
+    return (abcdk_bptree_leaf *)node;
+}
+
+/**
+ * 定位第一个不小于(或大于)KEY的元素。
+ *
+ * @return !NULL(0) 叶子节点(pos是元素的位置)，NULL(0) 不存在。
+*/
+static abcdk_bptree_leaf *_abcdk_bptree_seek(abcdk_bptree_t *ctx, const void *key, size_t ksize, int strict, int *pos)
+{
+    abcdk_bptree_leaf *leaf;
+
+    leaf = _abcdk_bptree_descend(ctx, key, ksize, NULL);
+    *pos = _abcdk_bptree_leaf_search(ctx, leaf, key, ksize, strict);
+
+    /*除根节点外，叶子节点不会是空的，下一个节点的第一个元素就是结果。*/
+    if (*pos >= leaf->hdr.count)
+    {
+        leaf = leaf->next;
+        *pos = 0;
+    }
+
+    return leaf;
+}
+
+static abcdk_allocator_t *_abcdk_bptree_create(abcdk_bptree_t *ctx, abcdk_bptree_path *path, abcdk_bptree_leaf *leaf, int pos,
+                                               const void *key, size_t ksize, size_t vsize)
+{
+    abcdk_bptree_node *spares[ABCDK_BPTREE_DEPTH_MAX + 2] = {0};
+    int spare_count = 0, spare_used = 0;
+    abcdk_bptree_key sep = {0}, tmp;
+    abcdk_bptree_leaf *right;
+    abcdk_bptree_inner *inner, *inner_right;
+    abcdk_bptree_node *child;
+    abcdk_allocator_t *alloc = NULL;
+    size_t sizes[2] = {ksize, vsize};
+    int d, idx, half;
+
+    /*
+     * 叶子节点满了，先申请好分裂需要的节点和分隔KEY，分裂过程中不会失败。
+     *
+     * 分裂后右半部分的第一个元素是分隔KEY。
+    */
+    if (leaf->hdr.count >= ABCDK_BPTREE_MAX)
+    {
+        if (path->depth + 1 >= ABCDK_BPTREE_DEPTH_MAX)
+            ABCDK_ERRNO_AND_RETURN1(ENOSPC, NULL);
+
+        spares[spare_count++] = _abcdk_bptree_node_alloc(1);
+
+        for (d = path->depth - 1; d >= 0; d--)
+        {
+            if (path->nodes[d]->hdr.count < ABCDK_BPTREE_MAX)
+                break;
+
+            spares[spare_count++] = _abcdk_bptree_node_alloc(0);
+        }
+
+        /*根节点也满了，需要一个新的根节点。*/
+        if (d < 0)
+            spares[spare_count++] = _abcdk_bptree_node_alloc(0);
+
+        for (int i = 0; i < spare_count; i++)
+        {
+            if (!spares[i])
+                goto final_error;
+        }
+
+        half = (ABCDK_BPTREE_MAX + 1) / 2;
+        if (pos == half)
+        {
+            tmp.size = ksize;
+            if (ksize <= ABCDK_BPTREE_INLINE)
+                memcpy(tmp.buf, key, ksize);
+            else
+                tmp.ptr = (void *)key;
+        }
+        else
+        {
+            tmp = leaf->keys[pos < half ? half - 1 : half];
+        }
+
+        if (_abcdk_bptree_key_clone(&sep, &tmp) != 0)
+            goto final_error;
+    }
+
+    /*KEY和VALUE在同一块内存中。*/
+    alloc = abcdk_allocator_alloc(sizes, 2, 0);
+    if (!alloc)
+        goto final_error;
+
+    /* 注册数据节点的析构函数。*/
+    if (ctx->cb.destructor_cb)
+        abcdk_allocator_atfree(alloc, ctx->cb.destructor_cb, ctx->cb.opaque);
+
+    /*复制KEY。*/
+    memcpy(alloc->pptrs[ABCDK_MAP_KEY], key, ksize);
+
+    /*也许有构造函数要处理一下。*/
+    if (ctx->cb.construct_cb)
+        ctx->cb.construct_cb(alloc, ctx->cb.opaque);
+
+    ABCDK_BPTREE_LEAF_MOVE(leaf, pos + 1, leaf, pos, leaf->hdr.count - pos);
+    _abcdk_bptree_key_refer(&leaf->keys[pos], alloc);
+    leaf->allocs[pos] = alloc;
+    leaf->hdr.count += 1;
+    ctx->count += 1;
+
+    if (leaf->hdr.count <= ABCDK_BPTREE_MAX)
+        return alloc;
+
+    /*分裂叶子节点，右半部分放到新节点。*/
+    right = (abcdk_bptree_leaf *)spares[spare_used++];
+    half = leaf->hdr.count / 2;
+
+    right->hdr.count = leaf->hdr.count - half;
+    ABCDK_BPTREE_LEAF_MOVE(right, 0, leaf, half, right->hdr.count);
+    leaf->hdr.count = half;
+
+    right->prev = leaf;
+    right->next = leaf->next;
+    if (leaf->next)
+        leaf->next->prev = right;
+    leaf->next = right;
+
+    /*分隔KEY和新节点逐层向上插入，分支节点满了继续分裂。*/
+    child = &right->hdr;
+    for (d = path->depth - 1; d >= 0; d--)
+    {
+        inner = path->nodes[d];
+        idx = path->idx[d];
+
+        memmove(&inner->keys[idx + 1], &inner->keys[idx], (inner->hdr.count - 1 - idx) * sizeof(abcdk_bptree_key));
+        memmove(&inner->child[idx + 2], &inner->child[idx + 1], (inner->hdr.count - 1 - idx) * sizeof(abcdk_bptree_node *));
+        inner->keys[idx] = sep;
+        inner->child[idx + 1] = child;
+        inner->hdr.count += 1;
+
+        if (inner->hdr.count <= ABCDK_BPTREE_MAX)
+        {
+            child = NULL;
+            break;
+        }
+
+        /*中间的分隔KEY移到上一层，不需要复制。*/
+        inner_right = (abcdk_bptree_inner *)spares[spare_used++];
+        half = inner->hdr.count / 2;
+
+        inner_right->hdr.count = inner->hdr.count - half;
+        memcpy(inner_right->child, &inner->child[half], inner_right->hdr.count * sizeof(abcdk_bptree_node *));
+        memcpy(inner_right->keys, &inner->keys[half], (inner_right->hdr.count - 1) * sizeof(abcdk_bptree_key));
+        sep = inner->keys[half - 1];
+        inner->hdr.count = half;
+
+        child = &inner_right->hdr;
+    }
+
+    /*根节点分裂，树长高一层。*/
+    if (child)
+    {
+        inner = (abcdk_bptree_inner *)spares[spare_used++];
+        inner->hdr.count = 2;
+        inner->child[0] = ctx->root;
+        inner->child[1] = child;
+        inner->keys[0] = sep;
+
+        ctx->root = &inner->hdr;
+        ctx->height += 1;
+    }
+
+    assert(spare_used == spare_count);
+
+    return alloc;
+
+final_error:
+
+    for (int i = 0; i < spare_count; i++)
+        abcdk_heap_free(spares[i]);
+
+    _abcdk_bptree_key_free(&sep);
+
+    ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+}
+
+abcdk_allocator_t *abcdk_bptree_find(abcdk_bptree_t *ctx, const void *key, size_t ksize, size_t vsize)
+{
+    abcdk_bptree_path path;
+    abcdk_bptree_leaf *leaf;
+    int pos;
+
+    assert(ctx != NULL && key != NULL && ksize > 0);
+
+    leaf = _abcdk_bptree_descend(ctx, key, ksize, &path);
+    pos = _abcdk_bptree_leaf_search(ctx, leaf, key, ksize, 0);
+
+    if (pos < leaf->hdr.count)
+    {
+        if (ctx->cb.compare_cb(ABCDK_BPTREE_KEY(&leaf->keys[pos]), key, ksize, ctx->cb.opaque) == 0)
+            return leaf->allocs[pos];
+    }
+
+    /*如果节点不存在并且需要创建。*/
+    if (vsize > 0)
+        return _abcdk_bptree_create(ctx, &path, leaf, pos, key, ksize, vsize);
+
+    ABCDK_ERRNO_AND_RETURN1(EAGAIN, NULL);
+}
+
+/**
+ * 从兄弟节点借一个。
+ *
+ * @param s 分隔KEY(left和right之间)在父节点中的索引。
+ * @param from_left !0 从左边借，0 从右边借。
+ *
+ * @return 0 成功，-1 失败(内存不足)。
+*/
+static int _abcdk_bptree_borrow(abcdk_bptree_inner *parent, int s, abcdk_bptree_node *left, abcdk_bptree_node *right, int from_left)
+{
+    abcdk_bptree_leaf *lleaf, *rleaf;
+    abcdk_bptree_inner *linner, *rinner;
+    abcdk_bptree_key sep;
+
+    if (left->leaf)
+    {
+        lleaf = (abcdk_bptree_leaf *)left;
+        rleaf = (abcdk_bptree_leaf *)right;
+
+        /*叶子节点的分隔KEY是右边节点的第一个元素，需要复制。*/
+        if (from_left)
+        {
+            if (_abcdk_bptree_key_clone(&sep, &lleaf->keys[lleaf->hdr.count - 1]) != 0)
+                return -1;
+
+            ABCDK_BPTREE_LEAF_MOVE(rleaf, 1, rleaf, 0, rleaf->hdr.count);
+            ABCDK_BPTREE_LEAF_MOVE(rleaf, 0, lleaf, lleaf->hdr.count - 1, 1);
+            rleaf->hdr.count += 1;
+            lleaf->hdr.count -= 1;
+        }
+        else
+        {
+            if (_abcdk_bptree_key_clone(&sep, &rleaf->keys[1]) != 0)
+                return -1;
+
+            ABCDK_BPTREE_LEAF_MOVE(lleaf, lleaf->hdr.count, rleaf, 0, 1);
+            lleaf->hdr.count += 1;
+            ABCDK_BPTREE_LEAF_MOVE(rleaf, 0, rleaf, 1, rleaf->hdr.count - 1);
+            rleaf->hdr.count -= 1;
+        }
+
+        _abcdk_bptree_key_free(&parent->keys[s]);
+        parent->keys[s] = sep;
+    }
+    else
+    {
+        linner = (abcdk_bptree_inner *)left;
+        rinner = (abcdk_bptree_inner *)right;
+
+        /*分支节点的分隔KEY经过父节点轮转，不需要复制。*/
+        if (from_left)
+        {
+            memmove(&rinner->keys[1], &rinner->keys[0], (rinner->hdr.count - 1) * sizeof(abcdk_bptree_key));
+            memmove(&rinner->child[1], &rinner->child[0], rinner->hdr.count * sizeof(abcdk_bptree_node *));
+            rinner->keys[0] = parent->keys[s];
+            rinner->child[0] = linner->child[linner->hdr.count - 1];
+            rinner->hdr.count += 1;
+
+            parent->keys[s] = linner->keys[linner->hdr.count - 2];
+            linner->hdr.count -= 1;
+        }
+        else
+        {
+            linner->keys[linner->hdr.count - 1] = parent->keys[s];
+            linner->child[linner->hdr.count] = rinner->child[0];
+            linner->hdr.count += 1;
+
+            parent->keys[s] = rinner->keys[0];
+            memmove(&rinner->keys[0], &rinner->keys[1], (rinner->hdr.count - 2) * sizeof(abcdk_bptree_key));
+            memmove(&rinner->child[0], &rinner->child[1], (rinner->hdr.count - 1) * sizeof(abcdk_bptree_node *));
+            rinner->hdr.count -= 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * 把右边节点合并到左边节点，并从父节点中移除。
+ *
+ * @param s 分隔KEY(left和right之间)在父节点中的索引。
+*/
+static void _abcdk_bptree_merge(abcdk_bptree_inner *parent, int s, abcdk_bptree_node *left, abcdk_bptree_node *right)
+{
+    abcdk_bptree_leaf *lleaf, *rleaf;
+    abcdk_bptree_inner *linner, *rinner;
+
+    if (left->leaf)
+    {
+        lleaf = (abcdk_bptree_leaf *)left;
+        rleaf = (abcdk_bptree_leaf *)right;
+
+        ABCDK_BPTREE_LEAF_MOVE(lleaf, lleaf->hdr.count, rleaf, 0, rleaf->hdr.count);
+        lleaf->hdr.count += rleaf->hdr.count;
+
+        lleaf->next = rleaf->next;
+        if (rleaf->next)
+            rleaf->next->prev = lleaf;
+
+        _abcdk_bptree_key_free(&parent->keys[s]);
+    }
+    else
+    {
+        linner = (abcdk_bptree_inner *)left;
+        rinner = (abcdk_bptree_inner *)right;
+
+        /*父节点的分隔KEY下移到两个节点之间。*/
+        linner->keys[linner->hdr.count - 1] = parent->keys[s];
+        memcpy(&linner->keys[linner->hdr.count], rinner->keys, (rinner->hdr.count - 1) * sizeof(abcdk_bptree_key));
+        memcpy(&linner->child[linner->hdr.count], rinner->child, rinner->hdr.count * sizeof(abcdk_bptree_node *));
+        linner->hdr.count += rinner->hdr.count;
+    }
+
+    abcdk_heap_free(right);
+
+    memmove(&parent->keys[s], &parent->keys[s + 1], (parent->hdr.count - 2 - s) * sizeof(abcdk_bptree_key));
+    memmove(&parent->child[s + 1], &parent->child[s + 2], (parent->hdr.count - 2 - s) * sizeof(abcdk_bptree_node *));
+    parent->hdr.count -= 1;
+}
+
+static void _abcdk_bptree_rebalance(abcdk_bptree_t *ctx, abcdk_bptree_path *path, abcdk_bptree_node *node)
+{
+    abcdk_bptree_inner *parent, *root;
+    abcdk_bptree_node *left, *right, *sib;
+    int d, s;
+
+    for (d = path->depth - 1; d >= 0; d--)
+    {
+        if (node->count >= ABCDK_BPTREE_MIN)
+            return;
+
+        parent = path->nodes[d];
+        s = (path->idx[d] > 0 ? path->idx[d] - 1 : 0);
+        left = parent->child[s];
+        right = parent->child[s + 1];
+        sib = (left == node ? right : left);
+
+        if (sib->count > ABCDK_BPTREE_MIN && _abcdk_bptree_borrow(parent, s, left, right, sib == left) == 0)
+            return;
+
+        /*借不到(内存不足)并且合并后放不下时，暂时保持不足的状态，节点不会是空的。*/
+        if (left->count + right->count > ABCDK_BPTREE_MAX)
+            return;
+
+        _abcdk_bptree_merge(parent, s, left, right);
+        node = &parent->hdr;
+    }
+
+    /*根节点只剩一个子节点时，树降低一层。*/
+    if (!ctx->root->leaf && ctx->root->count == 1)
+    {
+        root = (abcdk_bptree_inner *)ctx->root;
+        ctx->root = root->child[0];
+        ctx->height -= 1;
+
+        abcdk_heap_free(root);
+    }
+}
+
+int abcdk_bptree_remove(abcdk_bptree_t *ctx, const void *key, size_t ksize)
+{
+    abcdk_bptree_path path;
+    abcdk_bptree_leaf *leaf;
+    abcdk_allocator_t *alloc;
+    int pos;
+
+    assert(ctx != NULL && key != NULL && ksize > 0);
+
+    leaf = _abcdk_bptree_descend(ctx, key, ksize, &path);
+    pos = _abcdk_bptree_leaf_search(ctx, leaf, key, ksize, 0);
+
+    if (pos >= leaf->hdr.count)
+        ABCDK_ERRNO_AND_RETURN1(EAGAIN, -1);
+
+    if (ctx->cb.compare_cb(ABCDK_BPTREE_KEY(&leaf->keys[pos]), key, ksize, ctx->cb.opaque) != 0)
+        ABCDK_ERRNO_AND_RETURN1(EAGAIN, -1);
+
+    alloc = leaf->allocs[pos];
+
+    ABCDK_BPTREE_LEAF_MOVE(leaf, pos, leaf, pos + 1, leaf->hdr.count - 1 - pos);
+    leaf->hdr.count -= 1;
+    ctx->count -= 1;
+
+    _abcdk_bptree_rebalance(ctx, &path, &leaf->hdr);
+
+    abcdk_allocator_unref(&alloc);
+
+    return 0;
+}
+
+abcdk_allocator_t *abcdk_bptree_lower_bound(abcdk_bptree_t *ctx, const void *key, size_t ksize)
+{
+    abcdk_bptree_leaf *leaf;
+    int pos;
+
+    assert(ctx != NULL && key != NULL && ksize > 0);
+
+    leaf = _abcdk_bptree_seek(ctx, key, ksize, 0, &pos);
+    if (!leaf)
+        ABCDK_ERRNO_AND_RETURN1(EAGAIN, NULL);
+
+    return leaf->allocs[pos];
+}
+
+abcdk_allocator_t *abcdk_bptree_upper_bound(abcdk_bptree_t *ctx, const void *key, size_t ksize)
+{
+    abcdk_bptree_leaf *leaf;
+    int pos;
+
+    assert(ctx != NULL && key != NULL && ksize > 0);
+
+    leaf = _abcdk_bptree_seek(ctx, key, ksize, 1, &pos);
+    if (!leaf)
+        ABCDK_ERRNO_AND_RETURN1(EAGAIN, NULL);
+
+    return leaf->allocs[pos];
+}
+
+int abcdk_bptree_load(abcdk_bptree_t *ctx, abcdk_allocator_t *allocs[], size_t count)
+{
+    abcdk_bptree_node **level = NULL, **upper = NULL;
+    abcdk_bptree_key *mins = NULL, *upper_mins = NULL;
+    abcdk_bptree_leaf *leaf, *prev = NULL;
+    abcdk_bptree_inner *inner;
+    size_t n, m = 0, b, e, built = 0;
+    size_t height = 1;
+
+    assert(ctx != NULL && (allocs != NULL || count == 0));
+
+    if (ctx->count > 0)
+        ABCDK_ERRNO_AND_RETURN1(EINVAL, -1);
+
+    for (size_t i = 1; i < count; i++)
+    {
+        if (ctx->cb.compare_cb(ABCDK_BPTREE_ALLOC_KEY(allocs[i - 1]), ABCDK_BPTREE_ALLOC_KEY(allocs[i]), ctx->cb.opaque) >= 0)
+            ABCDK_ERRNO_AND_RETURN1(EINVAL, -1);
+    }
+
+    if (count == 0)
+        return 0;
+
+    /*
+     * 自底向上逐层构建。
+     *
+     * 每层的元素平均分配到最少的节点中，节点数量大于1时，每个节点不少于最小数量。
+    */
+    n = abcdk_align(count, ABCDK_BPTREE_MAX) / ABCDK_BPTREE_MAX;
+    level = abcdk_heap_alloc(n * sizeof(abcdk_bptree_node *));
+    mins = abcdk_heap_alloc(n * sizeof(abcdk_bptree_key));
+    if (!level || !mins)
+        goto final_error;
+
+    for (built = 0; built < n; built++)
+    {
+        leaf = (abcdk_bptree_leaf *)_abcdk_bptree_node_alloc(1);
+        if (!leaf)
+            goto final_error;
+
+        b = count * built / n;
+        e = count * (built + 1) / n;
+
+        for (size_t i = b; i < e; i++)
+        {
+            _abcdk_bptree_key_refer(&leaf->keys[i - b], allocs[i]);
+            leaf->allocs[i - b] = allocs[i];
+        }
+
+        leaf->hdr.count = e - b;
+
+        leaf->prev = prev;
+        if (prev)
+            prev->next = leaf;
+        prev = leaf;
+
+        level[built] = &leaf->hdr;
+        mins[built] = leaf->keys[0];
+    }
+
+    while (n > 1)
+    {
+        m = abcdk_align(n, ABCDK_BPTREE_MAX) / ABCDK_BPTREE_MAX;
+        upper = abcdk_heap_alloc(m * sizeof(abcdk_bptree_node *));
+        upper_mins = abcdk_heap_alloc(m * sizeof(abcdk_bptree_key));
+        if (!upper || !upper_mins)
+            goto final_error;
+
+        for (size_t i = 0; i < m; i++)
+        {
+            inner = (abcdk_bptree_inner *)_abcdk_bptree_node_alloc(0);
+            if (!inner)
+                goto final_upper_error;
+
+            upper[i] = &inner->hdr;
+            upper_mins[i] = mins[n * i / m];
+
+            b = n * i / m;
+            e = n * (i + 1) / m;
+
+            inner->child[0] = level[b];
+            inner->hdr.count = 1;
+
+            /*分隔KEY是子树中最小的KEY。*/
+            for (size_t j = b + 1; j < e; j++)
+            {
+                if (_abcdk_bptree_key_clone(&inner->keys[j - b - 1], &mins[j]) != 0)
+                    goto final_upper_error;
+
+                inner->child[j - b] = level[j];
+                inner->hdr.count += 1;
+            }
+        }
+
+        abcdk_heap_free(level);
+        abcdk_heap_free(mins);
+        level = upper;
+        mins = upper_mins;
+        upper = NULL;
+        upper_mins = NULL;
+        n = m;
+        height += 1;
+    }
+
+    _abcdk_bptree_node_free(ctx->root, 1, 1);
+    ctx->root = level[0];
+    ctx->count = count;
+    ctx->height = height;
+
+    /* 注册数据节点的析构函数。*/
+    for (size_t i = 0; ctx->cb.destructor_cb && i < count; i++)
+        abcdk_allocator_atfree(allocs[i], ctx->cb.destructor_cb, ctx->cb.opaque);
+
+    abcdk_heap_free(level);
+    abcdk_heap_free(mins);
+
+    return 0;
+
+final_upper_error:
+
+    /*上一层只释放节点，子节点在本层释放。*/
+    for (size_t i = 0; i < m; i++)
+        _abcdk_bptree_node_free(upper[i], 0, 0);
+
+final_error:
+
+    /*元素的所有权不变，只释放节点。*/
+    for (size_t i = 0; level && i < (height > 1 ? n : built); i++)
+        _abcdk_bptree_node_free(level[i], 1, 0);
+
+    abcdk_heap_free(level);
+    abcdk_heap_free(mins);
+    abcdk_heap_free(upper);
+    abcdk_heap_free(upper_mins);
+
+    ABCDK_ERRNO_AND_RETURN1(ENOMEM, -1);
+}
+
+size_t abcdk_bptree_scan(abcdk_bptree_t *ctx, const void *begin, size_t bsize, const void *end, size_t esize,
+                         int (*dump_cb)(abcdk_allocator_t *alloc, void *opaque), void *opaque)
+{
+    abcdk_bptree_node *node;
+    abcdk_bptree_leaf *leaf;
+    abcdk_allocator_t *alloc;
+    size_t n = 0;
+    int pos = 0;
+
+    assert(ctx != NULL && dump_cb != NULL);
+    assert(begin == NULL || bsize > 0);
+    assert(end == NULL || esize > 0);
+
+    if (begin)
+    {
+        leaf = _abcdk_bptree_seek(ctx, begin, bsize, 0, &pos);
+    }
+    else
+    {
+        for (node = ctx->root; !node->leaf;)
+            node = ((abcdk_bptree_inner *)node)->child[0];
+
+        leaf = (abcdk_bptree_leaf *)node;
+    }
+
+    /*沿叶子节点的链表向后遍历。*/
+    for (; leaf; leaf = leaf->next, pos = 0)
+    {
+        for (; pos < leaf->hdr.count; pos++)
+        {
+            alloc = leaf->allocs[pos];
+
+            if (end && ctx->cb.compare_cb(ABCDK_BPTREE_KEY(&leaf->keys[pos]), end, esize, ctx->cb.opaque) >= 0)
+                return n;
+
+            n += 1;
+
+            if (dump_cb(alloc, opaque) < 0)
+                return n;
+        }
+    }
+
+    return n;
+}
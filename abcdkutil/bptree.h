@@ -0,0 +1,159 @@
+/*
+ * This file is part of ABCDK.
+ *
+ * MIT License
+ *
+ */
+#ifndef ABCDKUTIL_BPTREE_H
+#define ABCDKUTIL_BPTREE_H
+
+#include "general.h"
+#include "allocator.h"
+#include "map.h"
+
+__BEGIN_DECLS
+
+/**
+ * 有序MAP(B+树)。
+ *
+ * 元素保存在叶子节点中，叶子节点按KEY的顺序双向链接，范围查找和顺序遍历只需要找到起点后沿链表遍历。
+ * 每个节点最多保存32个元素(或子节点)，除根节点外不少于16个。
+ *
+ * 元素的分配和释放规则与abcdk_map_t相同(每个元素的KEY和VALUE只申请一次内存，删除时自动释放)。
+ *
+ * @note 元素的KEY和VALUE字段索引与abcdk_map_t相同(ABCDK_MAP_KEY，ABCDK_MAP_VALUE)。
+ * @note 多线程访问需要外部加锁。
+*/
+typedef struct _abcdk_bptree abcdk_bptree_t;
+
+/**
+ * 有序MAP的回调函数。
+ *
+ * @note 未填写(NULL)的比较函数使用abcdk_bptree_compare。
+*/
+typedef struct _abcdk_bptree_callback
+{
+    /**
+     * KEY比较函数。
+     *
+     * @return > 0 is key1 > key2，0 is key1 == key2，< 0 is key1 < key2。
+    */
+    int (*compare_cb)(const void *key1, size_t size1, const void *key2, size_t size2, void *opaque);
+
+    /**
+     * 构造函数。
+    */
+    void (*construct_cb)(abcdk_allocator_t *alloc, void *opaque);
+
+    /**
+     * 析构函数。
+    */
+    void (*destructor_cb)(abcdk_allocator_t *alloc, void *opaque);
+
+    /**
+     * 环境指针。
+    */
+    void *opaque;
+
+} abcdk_bptree_callback;
+
+/**
+ * 比较函数。
+ *
+ * 按字节比较，相同前缀时短的在前。
+ *
+ * @note 整数KEY需要按大端字节序保存(abcdk_endian_h_to_b64等)才能按数值排序，或者使用自定义的比较函数。
+ *
+ * @return > 0 is key1 > key2，0 is key1 == key2，< 0 is key1 < key2。
+*/
+int abcdk_bptree_compare(const void *key1, size_t size1, const void *key2, size_t size2, void *opaque);
+
+/**
+ * 销毁。
+*/
+void abcdk_bptree_free(abcdk_bptree_t **ctx);
+
+/**
+ * 创建。
+ *
+ * @param cb 回调函数，NULL(0) 全部使用默认值。
+ *
+ * @return !NULL(0) 成功，NULL(0) 失败。
+*/
+abcdk_bptree_t *abcdk_bptree_alloc(const abcdk_bptree_callback *cb);
+
+/**
+ * 获取元素数量。
+*/
+size_t abcdk_bptree_count(abcdk_bptree_t *ctx);
+
+/**
+ * 获取树的高度(叶子节点为1)。
+*/
+size_t abcdk_bptree_height(abcdk_bptree_t *ctx);
+
+/**
+ * 查找或创建。
+ *
+ * @param ksize Key size。
+ * @param vsize Value size。 0 仅查找，>0 不存在则创建。
+ *
+ * @return !NULL(0) 成功(复制的指针，不需要主动释放)，NULL(0) 不存在或创建失败。
+*/
+abcdk_allocator_t *abcdk_bptree_find(abcdk_bptree_t *ctx, const void *key, size_t ksize, size_t vsize);
+
+/**
+ * 删除。
+ *
+ * @return 0 成功，-1 不存在。
+*/
+int abcdk_bptree_remove(abcdk_bptree_t *ctx, const void *key, size_t ksize);
+
+/**
+ * 查找第一个不小于KEY的元素。
+ *
+ * @return !NULL(0) 成功(复制的指针，不需要主动释放)，NULL(0) 不存在。
+*/
+abcdk_allocator_t *abcdk_bptree_lower_bound(abcdk_bptree_t *ctx, const void *key, size_t ksize);
+
+/**
+ * 查找第一个大于KEY的元素。
+ *
+ * @return !NULL(0) 成功(复制的指针，不需要主动释放)，NULL(0) 不存在。
+*/
+abcdk_allocator_t *abcdk_bptree_upper_bound(abcdk_bptree_t *ctx, const void *key, size_t ksize);
+
+/**
+ * 批量加载。
+ *
+ * 自底向上构建，叶子节点填满，比逐个添加快很多。
+ *
+ * @note 成功后元素由树接管(不需要主动释放)，失败时元素的所有权不变。
+ * @note 元素的KEY和VALUE字段索引与abcdk_map_t相同。析构函数被替换为树的析构函数(如果有)。
+ *
+ * @param allocs 元素数组，KEY必须严格升序。
+ * @param count 元素数量。
+ *
+ * @return 0 成功，-1 失败(树不是空的，KEY不是严格升序，或内存不足)。
+*/
+int abcdk_bptree_load(abcdk_bptree_t *ctx, abcdk_allocator_t *allocs[], size_t count);
+
+/**
+ * 按顺序扫描节点。
+ *
+ * 遍历[begin，end)范围内的元素。
+ *
+ * @note 回显函数中不能添加或删除节点。
+ *
+ * @param begin 起始KEY(包括)，NULL(0) 从第一个元素开始。
+ * @param end 结束KEY(不包括)，NULL(0) 直到最后一个元素。
+ * @param dump_cb 回显函数。返回 -1 终止，1 继续。
+ *
+ * @return 遍历的元素数量。
+*/
+size_t abcdk_bptree_scan(abcdk_bptree_t *ctx, const void *begin, size_t bsize, const void *end, size_t esize,
+                         int (*dump_cb)(abcdk_allocator_t *alloc, void *opaque), void *opaque);
+
+__END_DECLS
+
+#endif //ABCDKUTIL_BPTREE_H
@@ -43,7 +43,8 @@ abcdk_buffer_t *abcdk_buffer_alloc2(size_t size)
 
     if(size > 0)
     {
-        alloc = abcdk_allocator_alloc2(size);
+        /*缓存总是先写入再读取，不需要清零。*/
+        alloc = abcdk_allocator_alloc3(&size, 1, 0, ABCDK_ALLOCATOR_UNINIT);
         if (!alloc)
             goto final_error;
     }
@@ -61,6 +62,122 @@ final_error:
     return NULL;
 }
 
+static void _abcdk_buffer_mirror_munmap_cb(abcdk_allocator_t *alloc, void *opaque)
+{
+    int chk;
+
+    assert(alloc);
+    assert(alloc->pptrs[0] != MAP_FAILED);
+    assert(alloc->sizes[0] > 0);
+
+    /*两个映射一起解除。*/
+    chk = munmap(alloc->pptrs[0], alloc->sizes[0] * 2);
+    assert(chk == 0);
+}
+
+static abcdk_allocator_t *_abcdk_buffer_mirror_alloc(size_t size)
+{
+    abcdk_allocator_t *alloc = NULL;
+    uint8_t *mmptr = MAP_FAILED;
+    void *chk_p = MAP_FAILED;
+    int fd = -1;
+
+#ifdef MFD_CLOEXEC
+
+    assert(size > 0 && size % sysconf(_SC_PAGESIZE) == 0);
+
+    fd = memfd_create("abcdk-buffer", MFD_CLOEXEC);
+    if (fd < 0)
+        goto final_error;
+
+    if (ftruncate(fd, size) != 0)
+        goto final_error;
+
+    /*先占用两倍容量的连续地址空间，再把同一个文件映射到前后两半。*/
+    mmptr = mmap(NULL, size * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mmptr == MAP_FAILED)
+        goto final_error;
+
+    chk_p = mmap(mmptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    if (chk_p == MAP_FAILED)
+        goto final_error;
+
+    chk_p = mmap(mmptr + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+    if (chk_p == MAP_FAILED)
+        goto final_error;
+
+    /*映射后不再需要文件句柄。*/
+    abcdk_closep(&fd);
+
+    alloc = abcdk_allocator_alloc(NULL, 1, 0);
+    if (!alloc)
+        goto final_error;
+
+    /*绑定内存和特定的释放函数，用于支持引用计数器。*/
+    alloc->pptrs[0] = mmptr;
+    alloc->sizes[0] = size;
+
+    abcdk_allocator_atfree(alloc, _abcdk_buffer_mirror_munmap_cb, NULL);
+
+    return alloc;
+
+final_error:
+
+    if (mmptr != MAP_FAILED)
+        munmap(mmptr, size * 2);
+
+    abcdk_closep(&fd);
+
+#endif //MFD_CLOEXEC
+
+    return NULL;
+}
+
+static abcdk_allocator_t *_abcdk_buffer_ring_alloc(size_t *size, int *mirror)
+{
+    abcdk_allocator_t *alloc = NULL;
+
+    if (*mirror)
+    {
+        alloc = _abcdk_buffer_mirror_alloc(abcdk_align(*size, sysconf(_SC_PAGESIZE)));
+        if (alloc)
+            return alloc;
+
+        /*不支持镜像映射，使用普通的环形缓存。*/
+        *mirror = 0;
+    }
+
+    /*缓存总是先写入再读取，不需要清零。*/
+    return abcdk_allocator_alloc3(size, 1, 0, ABCDK_ALLOCATOR_UNINIT);
+}
+
+abcdk_buffer_t *abcdk_buffer_alloc3(size_t size, int mirror)
+{
+    abcdk_buffer_t *buf = NULL;
+    abcdk_allocator_t *alloc = NULL;
+
+    assert(size > 0);
+
+    alloc = _abcdk_buffer_ring_alloc(&size, &mirror);
+    if (!alloc)
+        goto final_error;
+
+    buf = abcdk_buffer_alloc(alloc);
+    if (!buf)
+        goto final_error;
+
+    buf->ring = 1;
+    buf->mirror = mirror;
+
+    return buf;
+
+final_error:
+
+    abcdk_allocator_unref(&alloc);
+
+    return NULL;
+}
+
 void abcdk_buffer_free(abcdk_buffer_t **dst)
 {
     abcdk_buffer_t *buf_p = NULL;
@@ -93,6 +210,8 @@ abcdk_buffer_t *abcdk_buffer_copy(abcdk_buffer_t *src)
 
         buf->rsize = src->rsize;
         buf->wsize = src->wsize;
+        buf->ring = src->ring;
+        buf->mirror = src->mirror;
     }
     else
     {
@@ -110,7 +229,10 @@ abcdk_buffer_t *abcdk_buffer_clone(abcdk_buffer_t *src)
 
     if(src->data != NULL && src->size > 0)
     {
-        buf = abcdk_buffer_alloc2(src->size);
+        if (src->ring)
+            buf = abcdk_buffer_alloc3(src->size, src->mirror);
+        else
+            buf = abcdk_buffer_alloc2(src->size);
         if (!buf)
             return NULL;
 
@@ -139,6 +261,10 @@ int abcdk_buffer_privatize(abcdk_buffer_t *dst)
         if (!new_p)
             ABCDK_ERRNO_AND_RETURN1(ENOMEM, -1);
 
+        /*克隆的内存块是普通内存，不再有镜像映射。*/
+        if (new_p->pptrs[0] != dst->data)
+            dst->mirror = 0;
+
         /*旧的指针换成新的指针。*/
         dst->alloc = new_p;
 
@@ -149,21 +275,147 @@ int abcdk_buffer_privatize(abcdk_buffer_t *dst)
     return 0;
 }
 
+static int _abcdk_buffer_span(abcdk_buffer_t *buf, size_t pos, size_t len, struct iovec vec[2])
+{
+    size_t off;
+
+    if (len <= 0)
+        return 0;
+
+    off = (buf->ring ? pos % buf->size : pos);
+
+    vec[0].iov_base = ABCDK_PTR2VPTR(buf->data, off);
+    vec[0].iov_len = len;
+
+    /*镜像映射的内存，跨过末尾的数据在第二个映射中也是连续的。*/
+    if (!buf->ring || buf->mirror || off + len <= buf->size)
+        return 1;
+
+    vec[0].iov_len = buf->size - off;
+    vec[1].iov_base = buf->data;
+    vec[1].iov_len = len - vec[0].iov_len;
+
+    return 2;
+}
+
+static int _abcdk_buffer_vec_trim(struct iovec vec[2], int n, size_t howmuch)
+{
+    if (n > 0 && vec[0].iov_len >= howmuch)
+    {
+        vec[0].iov_len = howmuch;
+        return 1;
+    }
+
+    if (n > 1 && vec[0].iov_len + vec[1].iov_len > howmuch)
+        vec[1].iov_len = howmuch - vec[0].iov_len;
+
+    return n;
+}
+
+static size_t _abcdk_buffer_vec_copyin(struct iovec vec[2], int n, const void *data, size_t size)
+{
+    size_t len = 0, len2;
+
+    for (int i = 0; i < n && len < size; i++)
+    {
+        len2 = ABCDK_MIN(vec[i].iov_len, size - len);
+        memcpy(vec[i].iov_base, ABCDK_PTR2VPTR(data, len), len2);
+        len += len2;
+    }
+
+    return len;
+}
+
+static size_t _abcdk_buffer_vec_copyout(struct iovec vec[2], int n, void *data, size_t size)
+{
+    size_t len = 0, len2;
+
+    for (int i = 0; i < n && len < size; i++)
+    {
+        len2 = ABCDK_MIN(vec[i].iov_len, size - len);
+        memcpy(ABCDK_PTR2VPTR(data, len), vec[i].iov_base, len2);
+        len += len2;
+    }
+
+    return len;
+}
+
+size_t abcdk_buffer_readable(abcdk_buffer_t *buf)
+{
+    assert(buf != NULL);
+
+    if (buf->rsize >= buf->wsize)
+        return 0;
+
+    return buf->wsize - buf->rsize;
+}
+
+size_t abcdk_buffer_writable(abcdk_buffer_t *buf)
+{
+    assert(buf != NULL);
+
+    if (buf->ring)
+        return buf->size - (buf->wsize - buf->rsize);
+
+    if (buf->wsize >= buf->size)
+        return 0;
+
+    return buf->size - buf->wsize;
+}
+
+int abcdk_buffer_rvec(abcdk_buffer_t *buf, struct iovec vec[2])
+{
+    assert(buf != NULL && vec != NULL);
+
+    return _abcdk_buffer_span(buf, buf->rsize, abcdk_buffer_readable(buf), vec);
+}
+
+int abcdk_buffer_wvec(abcdk_buffer_t *buf, struct iovec vec[2])
+{
+    assert(buf != NULL && vec != NULL);
+
+    return _abcdk_buffer_span(buf, buf->wsize, abcdk_buffer_writable(buf), vec);
+}
+
 int abcdk_buffer_resize(abcdk_buffer_t *buf, size_t size)
 {
     abcdk_allocator_t *alloc_new = NULL;
+    struct iovec vec[2];
+    int mirror;
+    int n;
 
     assert(buf != NULL && size > 0);
 
     if (buf->size == size)
         return 0;
 
-    alloc_new = abcdk_allocator_alloc2(size);
-    if (!alloc_new)
-        return -1;
+    if (buf->ring)
+    {
+        mirror = buf->mirror;
+        alloc_new = _abcdk_buffer_ring_alloc(&size, &mirror);
+        if (!alloc_new)
+            return -1;
+
+        /*未读数据复制到新内存块的首地址，超出容量的部分被丢弃。*/
+        n = abcdk_buffer_rvec(buf, vec);
+        buf->wsize = _abcdk_buffer_vec_copyout(vec, n, alloc_new->pptrs[0], size);
+        buf->rsize = 0;
+        buf->mirror = mirror;
+    }
+    else
+    {
+        alloc_new = abcdk_allocator_alloc3(&size, 1, 0, ABCDK_ALLOCATOR_UNINIT);
+        if (!alloc_new)
+            return -1;
+
+        /*复制数据。*/
+        memcpy(alloc_new->pptrs[0], buf->data, ABCDK_MIN(buf->size, size));
 
-    /*复制数据。*/
-    memcpy(alloc_new->pptrs[0], buf->data, buf->size);
+        if (buf->wsize > size)
+            buf->wsize = size;
+        if (buf->rsize > size)
+            buf->rsize = size;
+    }
 
     /*解除旧的内存块*/
     abcdk_allocator_unref(&buf->alloc);
@@ -174,17 +426,14 @@ int abcdk_buffer_resize(abcdk_buffer_t *buf, size_t size)
     buf->data = alloc_new->pptrs[0];
     buf->size = alloc_new->sizes[0];
 
-    if (buf->wsize > size)
-        buf->wsize = size;
-    if (buf->rsize > size)
-        buf->rsize = size;
-
     return 0;
 }
 
 ssize_t abcdk_buffer_write(abcdk_buffer_t *buf, const void *data, size_t size)
 {
     ssize_t wsize2 = 0;
+    struct iovec vec[2];
+    int n;
 
     if (abcdk_buffer_privatize(buf) != 0)
         ABCDK_ERRNO_AND_RETURN1(EMLINK, -1);
@@ -192,11 +441,11 @@ ssize_t abcdk_buffer_write(abcdk_buffer_t *buf, const void *data, size_t size)
     assert(buf != NULL && data != NULL && size > 0);
     assert(buf->data != NULL && buf->size > 0);
 
-    if (buf->wsize >= buf->size)
+    n = abcdk_buffer_wvec(buf, vec);
+    if (n <= 0)
         ABCDK_ERRNO_AND_RETURN1(ENOSPC, 0);
 
-    wsize2 = ABCDK_MIN(buf->size - buf->wsize, size);
-    memcpy(ABCDK_PTR2PTR(void, buf->data, buf->wsize), data, wsize2);
+    wsize2 = _abcdk_buffer_vec_copyin(vec, n, data, size);
     buf->wsize += wsize2;
 
     return wsize2;
@@ -205,15 +454,17 @@ ssize_t abcdk_buffer_write(abcdk_buffer_t *buf, const void *data, size_t size)
 ssize_t abcdk_buffer_read(abcdk_buffer_t *buf, void *data, size_t size)
 {
     ssize_t rsize2 = 0;
+    struct iovec vec[2];
+    int n;
 
     assert(buf != NULL && data != NULL && size > 0);
     assert(buf->data != NULL && buf->size > 0);
 
-    if (buf->rsize >= buf->wsize)
+    n = abcdk_buffer_rvec(buf, vec);
+    if (n <= 0)
         ABCDK_ERRNO_AND_RETURN1(ESPIPE, 0);
 
-    rsize2 = ABCDK_MIN(buf->wsize - buf->rsize, size);
-    memcpy(data, ABCDK_PTR2PTR(void, buf->data, buf->rsize), rsize2);
+    rsize2 = _abcdk_buffer_vec_copyout(vec, n, data, size);
     buf->rsize += rsize2;
 
     return rsize2;
@@ -223,23 +474,31 @@ ssize_t abcdk_buffer_readline(abcdk_buffer_t *buf, void *data, size_t size)
 {
     ssize_t rsize2 = 0;
     ssize_t rsize3 = 0;
+    struct iovec vec[2];
+    uint8_t *eol;
+    int n;
 
     assert(buf != NULL && data != NULL && size > 0);
     assert(buf->data != NULL && buf->size > 0);
 
-    if (buf->rsize >= buf->wsize)
+    n = abcdk_buffer_rvec(buf, vec);
+    if (n <= 0)
         ABCDK_ERRNO_AND_RETURN1(ESPIPE, 0);
 
     /*查找行尾标志。*/
-    for (size_t i = 0; i < (buf->wsize - buf->rsize); i++)
+    for (int i = 0; i < n; i++)
     {
-        rsize3 += 1;
-        if (ABCDK_PTR2I8(buf->data, buf->rsize + i) == '\n')
+        eol = (uint8_t *)abcdk_memdelim(vec[i].iov_base, vec[i].iov_len, '\n');
+        if (eol)
+        {
+            rsize3 += eol - (uint8_t *)vec[i].iov_base + 1;
             break;
+        }
+
+        rsize3 += vec[i].iov_len;
     }
 
-    rsize2 = ABCDK_MIN(rsize3, size);
-    memcpy(data, ABCDK_PTR2VPTR(buf->data, buf->rsize), rsize2);
+    rsize2 = _abcdk_buffer_vec_copyout(vec, n, data, ABCDK_MIN(rsize3, size));
     buf->rsize += rsize3;//累加行真实长度。
 
     /*添加结束符。*/
@@ -249,15 +508,95 @@ ssize_t abcdk_buffer_readline(abcdk_buffer_t *buf, void *data, size_t size)
     return rsize2;
 }
 
-void abcdk_buffer_drain(abcdk_buffer_t *buf)
+static int _abcdk_buffer_ring_linearize(abcdk_buffer_t *buf)
 {
-    assert(abcdk_buffer_privatize(buf) == 0);
+    struct iovec vec[2];
+    void *tmp = NULL;
+    size_t len;
+    int n;
+
+    if (abcdk_buffer_privatize(buf) != 0)
+        ABCDK_ERRNO_AND_RETURN1(EMLINK, -1);
+
+    n = abcdk_buffer_rvec(buf, vec);
+    len = abcdk_buffer_readable(buf);
+
+    tmp = abcdk_heap_malloc(len);
+    if (!tmp)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, -1);
+
+    _abcdk_buffer_vec_copyout(vec, n, tmp, len);
+    memcpy(buf->data, tmp, len);
+
+    buf->rsize = 0;
+    buf->wsize = len;
 
+    abcdk_heap_free(tmp);
+
+    return 0;
+}
+
+ssize_t abcdk_buffer_readline2(abcdk_buffer_t *buf, const void **line)
+{
+    const uint8_t *eol;
+    struct iovec vec[2];
+    size_t len;
+    int n;
+
+    assert(buf != NULL && line != NULL);
+    assert(buf->data != NULL && buf->size > 0);
+
+    n = abcdk_buffer_rvec(buf, vec);
+    if (n <= 0)
+        ABCDK_ERRNO_AND_RETURN1(ESPIPE, 0);
+
+    eol = (const uint8_t *)abcdk_memdelim(vec[0].iov_base, vec[0].iov_len, '\n');
+
+    /*环形缓存(非镜像)中跨过末尾的行，先把未读数据移到首地址(每轮最多一次)。*/
+    if (!eol && n > 1)
+    {
+        if (_abcdk_buffer_ring_linearize(buf) != 0)
+            return -1;
+
+        n = abcdk_buffer_rvec(buf, vec);
+        eol = (const uint8_t *)abcdk_memdelim(vec[0].iov_base, vec[0].iov_len, '\n');
+    }
+
+    len = (eol ? eol - (const uint8_t *)vec[0].iov_base + 1 : vec[0].iov_len);
+
+    *line = vec[0].iov_base;
+    buf->rsize += len;
+
+    return len;
+}
+
+void abcdk_buffer_drain(abcdk_buffer_t *buf)
+{
     assert(buf != NULL);
     assert(buf->data != NULL && buf->size > 0);
 
     assert(buf->rsize <= buf->wsize);
 
+    if (buf->ring)
+    {
+        /*
+         * 不移动数据，只折算累计的读写长度。
+         * 1：无未读数据，回到首地址，之后写入的数据不会跨过末尾。
+         * 2：已读长度超过容量，同时减去容量的整数倍，偏移量不变。
+        */
+        if (buf->rsize == buf->wsize)
+            buf->rsize = buf->wsize = 0;
+        else if (buf->rsize >= buf->size)
+        {
+            buf->wsize -= buf->rsize - buf->rsize % buf->size;
+            buf->rsize %= buf->size;
+        }
+
+        return;
+    }
+
+    assert(abcdk_buffer_privatize(buf) == 0);
+
     if (buf->rsize > 0)
     {
         buf->wsize -= buf->rsize;
@@ -269,6 +608,8 @@ void abcdk_buffer_drain(abcdk_buffer_t *buf)
 ssize_t abcdk_buffer_fill(abcdk_buffer_t *buf, uint8_t stuffing)
 {
     ssize_t wsize2 = 0;
+    struct iovec vec[2];
+    int n;
 
     if (abcdk_buffer_privatize(buf) != 0)
         ABCDK_ERRNO_AND_RETURN1(EMLINK, -1);
@@ -276,13 +617,59 @@ ssize_t abcdk_buffer_fill(abcdk_buffer_t *buf, uint8_t stuffing)
     assert(buf != NULL);
     assert(buf->data != NULL && buf->size > 0);
 
-    if (buf->wsize >= buf->size)
+    n = abcdk_buffer_wvec(buf, vec);
+    if (n <= 0)
         ABCDK_ERRNO_AND_RETURN1(ENOSPC, 0);
 
-    wsize2 = buf->size - buf->wsize;
-    memset(ABCDK_PTR2PTR(void, buf->data, buf->wsize), stuffing, wsize2);
+    for (int i = 0; i < n; i++)
+    {
+        memset(vec[i].iov_base, stuffing, vec[i].iov_len);
+        wsize2 += vec[i].iov_len;
+    }
+
+    buf->wsize += wsize2;
+
+    return wsize2;
+}
+
+static ssize_t _abcdk_buffer_ring_vprintf(abcdk_buffer_t *buf, const char *fmt, va_list args)
+{
+    ssize_t wsize2 = 0;
+    struct iovec vec[2];
+    va_list args2;
+    char *tmp = NULL;
+    int n;
+
+    n = abcdk_buffer_wvec(buf, vec);
+    if (n <= 0)
+        ABCDK_ERRNO_AND_RETURN1(ENOSPC, 0);
+
+    va_copy(args2, args);
+    wsize2 = vsnprintf((char *)vec[0].iov_base, vec[0].iov_len, fmt, args2);
+    va_end(args2);
+
+    if (wsize2 <= 0)
+        return wsize2;
+
+    /*第一段放得下(包括结束符)，直接写入。*/
+    if (wsize2 < vec[0].iov_len)
+    {
+        buf->wsize += wsize2;
+        return wsize2;
+    }
+
+    /*第一段放不下，先格式化到临时内存，再分段复制，超出可写空间的部分被丢弃。*/
+    tmp = (char *)abcdk_heap_malloc(wsize2 + 1);
+    if (!tmp)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, -1);
+
+    vsnprintf(tmp, wsize2 + 1, fmt, args);
+
+    wsize2 = _abcdk_buffer_vec_copyin(vec, n, tmp, wsize2);
     buf->wsize += wsize2;
 
+    abcdk_heap_free(tmp);
+
     return wsize2;
 }
 
@@ -296,6 +683,9 @@ ssize_t abcdk_buffer_vprintf(abcdk_buffer_t *buf, const char *fmt, va_list args)
     assert(buf != NULL && fmt != NULL && args != NULL);
     assert(buf->data != NULL && buf->size > 0);
 
+    if (buf->ring)
+        return _abcdk_buffer_ring_vprintf(buf, fmt, args);
+
     if (buf->wsize >= buf->size)
         ABCDK_ERRNO_AND_RETURN1(ENOSPC, 0);
 
@@ -336,10 +726,43 @@ ssize_t abcdk_buffer_import(abcdk_buffer_t *buf, int fd)
     return abcdk_buffer_import_atmost(buf, fd, attr.st_size);
 }
 
+static ssize_t _abcdk_buffer_readv(int fd, struct iovec vec[2], int n)
+{
+    ssize_t rsize = 0;
+    ssize_t rsize2 = 0;
+    size_t off;
+
+    if (n == 1)
+        return abcdk_read(fd, vec[0].iov_base, vec[0].iov_len);
+
+    rsize = readv(fd, vec, n);
+    if (rsize <= 0 || rsize >= vec[0].iov_len + vec[1].iov_len)
+        return rsize;
+
+    /*与abcdk_read相同，未读满时继续读取剩余的部分。*/
+    if (rsize < vec[0].iov_len)
+    {
+        vec[0].iov_base = ABCDK_PTR2VPTR(vec[0].iov_base, rsize);
+        vec[0].iov_len -= rsize;
+        rsize2 = _abcdk_buffer_readv(fd, vec, 2);
+    }
+    else
+    {
+        off = rsize - vec[0].iov_len;
+        rsize2 = abcdk_read(fd, ABCDK_PTR2VPTR(vec[1].iov_base, off), vec[1].iov_len - off);
+    }
+
+    if (rsize2 > 0)
+        rsize += rsize2;
+
+    return rsize;
+}
+
 ssize_t abcdk_buffer_import_atmost(abcdk_buffer_t *buf, int fd, size_t howmuch)
 {
-    ssize_t wsize2 = 0;
     ssize_t wsize3 = 0;
+    struct iovec vec[2];
+    int n;
 
     if (abcdk_buffer_privatize(buf) != 0)
         ABCDK_ERRNO_AND_RETURN1(EMLINK, -1);
@@ -347,11 +770,12 @@ ssize_t abcdk_buffer_import_atmost(abcdk_buffer_t *buf, int fd, size_t howmuch)
     assert(buf != NULL && fd >= 0 && howmuch > 0);
     assert(buf->data != NULL && buf->size > 0);
 
-    if (buf->wsize >= buf->size)
+    n = abcdk_buffer_wvec(buf, vec);
+    if (n <= 0)
         ABCDK_ERRNO_AND_RETURN1(ENOSPC, 0);
 
-    wsize2 = ABCDK_MIN(buf->size - buf->wsize, howmuch);
-    wsize3 = abcdk_read(fd, ABCDK_PTR2PTR(void, buf->data, buf->wsize), wsize2);
+    n = _abcdk_buffer_vec_trim(vec, n, howmuch);
+    wsize3 = _abcdk_buffer_readv(fd, vec, n);
     if (wsize3 > 0)
         buf->wsize += wsize3;
 
@@ -363,21 +787,55 @@ ssize_t abcdk_buffer_export(abcdk_buffer_t *buf, int fd)
     return abcdk_buffer_export_atmost(buf, fd, INT16_MAX);
 }
 
+static ssize_t _abcdk_buffer_writev(int fd, struct iovec vec[2], int n)
+{
+    ssize_t wsize = 0;
+    ssize_t wsize2 = 0;
+    size_t off;
+
+    if (n == 1)
+        return abcdk_write(fd, vec[0].iov_base, vec[0].iov_len);
+
+    wsize = writev(fd, vec, n);
+    if (wsize <= 0 || wsize >= vec[0].iov_len + vec[1].iov_len)
+        return wsize;
+
+    /*与abcdk_write相同，未写完时继续写入剩余的部分。*/
+    if (wsize < vec[0].iov_len)
+    {
+        vec[0].iov_base = ABCDK_PTR2VPTR(vec[0].iov_base, wsize);
+        vec[0].iov_len -= wsize;
+        wsize2 = _abcdk_buffer_writev(fd, vec, 2);
+    }
+    else
+    {
+        off = wsize - vec[0].iov_len;
+        wsize2 = abcdk_write(fd, ABCDK_PTR2VPTR(vec[1].iov_base, off), vec[1].iov_len - off);
+    }
+
+    if (wsize2 > 0)
+        wsize += wsize2;
+
+    return wsize;
+}
+
 ssize_t abcdk_buffer_export_atmost(abcdk_buffer_t *buf, int fd, size_t howmuch)
 {
-    ssize_t rsize2 = 0;
     ssize_t rsize3 = 0;
+    struct iovec vec[2];
+    int n;
 
     assert(buf != NULL && fd >= 0 && howmuch > 0);
     assert(buf->data != NULL && buf->size > 0);
 
-    if (buf->rsize >= buf->wsize)
+    n = abcdk_buffer_rvec(buf, vec);
+    if (n <= 0)
         ABCDK_ERRNO_AND_RETURN1(ESPIPE, 0);
 
-    rsize2 = ABCDK_MIN(buf->wsize - buf->rsize, howmuch);
-    rsize3 = abcdk_write(fd, ABCDK_PTR2PTR(void, buf->data, buf->rsize), rsize2);
+    n = _abcdk_buffer_vec_trim(vec, n, howmuch);
+    rsize3 = _abcdk_buffer_writev(fd, vec, n);
     if (rsize3 > 0)
         buf->rsize += rsize3;
 
     return rsize3;
-}
\ No newline at end of file
+}
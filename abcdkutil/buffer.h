@@ -15,6 +15,10 @@ __BEGIN_DECLS
 /**
  * 简单的缓存。
  * 
+ * 线性模式：rsize和wsize是距离首地址的偏移量，写满后需要排出(abcdk_buffer_drain)已读数据才能继续写入。
+ * 环形模式：rsize和wsize是累计的读写长度，对容量取余即为偏移量，写到末尾后回绕到首地址，排出已读数据不需要移动内存。
+ * 
+ * @note 环形模式下，未读数据可能分成两段(末尾和首地址)，使用abcdk_buffer_rvec和abcdk_buffer_wvec获取内存段。
 */
 typedef struct _abcdk_buffer
 {
@@ -46,6 +50,20 @@ typedef struct _abcdk_buffer
     */
     size_t wsize;
 
+    /**
+     * 环形模式。
+     * 
+     * 0 线性，!0 环形。
+    */
+    int ring;
+
+    /**
+     * 镜像映射。
+     * 
+     * !0 容量之后紧跟同一块物理内存的第二个映射，从任意偏移量开始不超过容量的数据都是连续的(只有一段)。
+    */
+    int mirror;
+
 } abcdk_buffer_t;
 
 /**
@@ -62,11 +80,26 @@ abcdk_buffer_t *abcdk_buffer_alloc(abcdk_allocator_t *alloc);
  * 
  * @param size 容量(Bytes)。
  * 
+ * @note 缓存的内容未初始化。
+ * 
  * @return !NULL(0) 成功，NULL(0) 失败。
  * 
  */
 abcdk_buffer_t *abcdk_buffer_alloc2(size_t size);
 
+/**
+ * 创建环形缓存。
+ * 
+ * @param size 容量(Bytes)。
+ * @param mirror 镜像映射。0 否，!0 是(容量按页对齐)，不支持或失败时与0相同。
+ * 
+ * @note 缓存的内容未初始化。
+ * 
+ * @return !NULL(0) 成功，NULL(0) 失败。
+ * 
+ */
+abcdk_buffer_t *abcdk_buffer_alloc3(size_t size, int mirror);
+
 /**
  * 释放。
  * 
@@ -104,6 +137,36 @@ int abcdk_buffer_privatize(abcdk_buffer_t *dst);
 */
 int abcdk_buffer_resize(abcdk_buffer_t *buf,size_t size);
 
+/**
+ * 获取未读数据的长度。
+*/
+size_t abcdk_buffer_readable(abcdk_buffer_t *buf);
+
+/**
+ * 获取可写空间的长度。
+ * 
+ * @note 线性模式不包括已读数据占用的空间。
+*/
+size_t abcdk_buffer_writable(abcdk_buffer_t *buf);
+
+/**
+ * 获取未读数据的内存段。
+ * 
+ * @note 读取后由调用者累加rsize。
+ * 
+ * @return 内存段的数量(0，1，2)。
+*/
+int abcdk_buffer_rvec(abcdk_buffer_t *buf, struct iovec vec[2]);
+
+/**
+ * 获取可写空间的内存段。
+ * 
+ * @note 写入前由调用者私有化(abcdk_buffer_privatize)，写入后由调用者累加wsize。
+ * 
+ * @return 内存段的数量(0，1，2)。
+*/
+int abcdk_buffer_wvec(abcdk_buffer_t *buf, struct iovec vec[2]);
+
 /**
  * 写入数据。
  * 
@@ -128,7 +191,23 @@ ssize_t abcdk_buffer_read(abcdk_buffer_t *buf, void *data, size_t size);
 ssize_t abcdk_buffer_readline(abcdk_buffer_t *buf, void *data, size_t size);
 
 /**
- * 排出已读数据，未读数据移动到缓存首地址。
+ * 读取一行数据(不复制)。
+ * 
+ * @note 行的内容包括行尾标志(如果有)，没有结束符。
+ * @note 返回的指针在下一次写入、排出或调整容量之前有效。
+ * @note 环形缓存(非镜像)中跨过末尾的行，先把未读数据移到首地址。
+ * 
+ * @param line 行的指针。
+ * 
+ * @return > 0 行的长度(Bytes)，= 0 末尾，< 0 出错。
+*/
+ssize_t abcdk_buffer_readline2(abcdk_buffer_t *buf, const void **line);
+
+/**
+ * 排出已读数据。
+ * 
+ * 线性模式，未读数据移动到缓存首地址。
+ * 环形模式，不移动数据，仅把累计的读写长度折算到容量以内。
 */
 void abcdk_buffer_drain(abcdk_buffer_t *buf);
 
@@ -163,6 +242,8 @@ ssize_t abcdk_buffer_import(abcdk_buffer_t *buf,int fd);
 /**
  * 从文件导入数据。
  * 
+ * @note 环形模式下可写空间分成两段时，使用readv一次导入。
+ * 
  * 阻塞模式的句柄，可能会因为导入数据不足而阻塞。
 */
 ssize_t abcdk_buffer_import_atmost(abcdk_buffer_t *buf,int fd,size_t howmuch);
@@ -174,6 +255,8 @@ ssize_t abcdk_buffer_export(abcdk_buffer_t *buf,int fd);
 
 /**
  * 导出数据到文件。
+ * 
+ * @note 环形模式下未读数据分成两段时，使用writev一次导出。
 */
 ssize_t abcdk_buffer_export_atmost(abcdk_buffer_t *buf,int fd,size_t howmuch);
 
@@ -0,0 +1,627 @@
+/*
+ * This file is part of ABCDK.
+ *
+ * MIT License
+ *
+ */
+#include "chain.h"
+
+/** 追加数据时，新分段的最小长度。*/
+#define ABCDK_CHAIN_SLICE_SIZE (16 * 1024)
+
+/** 一次导出的最大分段数量。*/
+#define ABCDK_CHAIN_IOV_MAX 64
+
+/**
+ * 分段。
+*/
+typedef struct _abcdk_chain_slice
+{
+    /** 前一段。*/
+    struct _abcdk_chain_slice *prev;
+
+    /** 后一段。*/
+    struct _abcdk_chain_slice *next;
+
+    /** 内存块(每个分段持有一个引用)。*/
+    abcdk_allocator_t *alloc;
+
+    /** 偏移量。*/
+    size_t off;
+
+    /** 长度。*/
+    size_t len;
+
+} abcdk_chain_slice;
+
+/**
+ * 分段缓存。
+*/
+typedef struct _abcdk_chain
+{
+    /** 第一段。*/
+    abcdk_chain_slice *head;
+
+    /** 最后一段。*/
+    abcdk_chain_slice *tail;
+
+    /** 分段数量。*/
+    size_t count;
+
+    /** 数据长度。*/
+    size_t length;
+
+} abcdk_chain_t;
+
+static abcdk_chain_slice *_abcdk_chain_slice_alloc(abcdk_allocator_t *alloc, size_t off, size_t len)
+{
+    abcdk_chain_slice *slice;
+
+    slice = abcdk_heap_alloc(sizeof(abcdk_chain_slice));
+    if (!slice)
+        return NULL;
+
+    slice->alloc = alloc;
+    slice->off = off;
+    slice->len = len;
+
+    return slice;
+}
+
+static void _abcdk_chain_slice_free(abcdk_chain_slice **slice)
+{
+    abcdk_allocator_unref(&(*slice)->alloc);
+    abcdk_heap_free2((void **)slice);
+}
+
+static void _abcdk_chain_link_tail(abcdk_chain_t *ctx, abcdk_chain_slice *slice)
+{
+    slice->prev = ctx->tail;
+    slice->next = NULL;
+
+    if (ctx->tail)
+        ctx->tail->next = slice;
+    else
+        ctx->head = slice;
+
+    ctx->tail = slice;
+    ctx->count += 1;
+    ctx->length += slice->len;
+}
+
+static void _abcdk_chain_link_head(abcdk_chain_t *ctx, abcdk_chain_slice *slice)
+{
+    slice->prev = NULL;
+    slice->next = ctx->head;
+
+    if (ctx->head)
+        ctx->head->prev = slice;
+    else
+        ctx->tail = slice;
+
+    ctx->head = slice;
+    ctx->count += 1;
+    ctx->length += slice->len;
+}
+
+static void _abcdk_chain_unlink(abcdk_chain_t *ctx, abcdk_chain_slice *slice)
+{
+    if (slice->prev)
+        slice->prev->next = slice->next;
+    else
+        ctx->head = slice->next;
+
+    if (slice->next)
+        slice->next->prev = slice->prev;
+    else
+        ctx->tail = slice->prev;
+
+    slice->prev = slice->next = NULL;
+
+    ctx->count -= 1;
+    ctx->length -= slice->len;
+}
+
+/*
+ * 分段的剩余空间。
+ *
+ * 内存块只被当前分段引用时，分段后面的空间可以继续写入。
+*/
+static size_t _abcdk_chain_slice_spare(abcdk_chain_slice *slice)
+{
+    if (!slice || abcdk_atomic_load((int *)slice->alloc->refcount) != 1)
+        return 0;
+
+    return slice->alloc->sizes[0] - (slice->off + slice->len);
+}
+
+void abcdk_chain_free(abcdk_chain_t **ctx)
+{
+    abcdk_chain_t *ctx_p;
+    abcdk_chain_slice *slice;
+
+    if (!ctx || !*ctx)
+        return;
+
+    ctx_p = *ctx;
+
+    while (ctx_p->head)
+    {
+        slice = ctx_p->head;
+        _abcdk_chain_unlink(ctx_p, slice);
+        _abcdk_chain_slice_free(&slice);
+    }
+
+    abcdk_heap_free(ctx_p);
+
+    /*Set to NULL(0).*/
+    *ctx = NULL;
+}
+
+abcdk_chain_t *abcdk_chain_alloc()
+{
+    abcdk_chain_t *ctx;
+
+    ctx = abcdk_heap_alloc(sizeof(abcdk_chain_t));
+    if (!ctx)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+
+    return ctx;
+}
+
+size_t abcdk_chain_length(abcdk_chain_t *ctx)
+{
+    assert(ctx != NULL);
+
+    return ctx->length;
+}
+
+size_t abcdk_chain_count(abcdk_chain_t *ctx)
+{
+    assert(ctx != NULL);
+
+    return ctx->count;
+}
+
+static abcdk_chain_slice *_abcdk_chain_slice_refer(abcdk_allocator_t *alloc, size_t off, size_t len)
+{
+    abcdk_chain_slice *slice;
+
+    assert(alloc != NULL && len > 0);
+    assert(alloc->numbers > 0 && alloc->pptrs[0] != NULL && off + len <= alloc->sizes[0]);
+
+    slice = _abcdk_chain_slice_alloc(alloc, off, len);
+    if (!slice)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+
+    abcdk_allocator_refer(alloc);
+
+    return slice;
+}
+
+int abcdk_chain_append(abcdk_chain_t *ctx, abcdk_allocator_t *alloc, size_t off, size_t len)
+{
+    abcdk_chain_slice *slice;
+
+    assert(ctx != NULL);
+
+    slice = _abcdk_chain_slice_refer(alloc, off, len);
+    if (!slice)
+        return -1;
+
+    _abcdk_chain_link_tail(ctx, slice);
+
+    return 0;
+}
+
+static abcdk_chain_slice *_abcdk_chain_slice_clone(const void *data, size_t size, size_t capacity)
+{
+    abcdk_allocator_t *alloc;
+    abcdk_chain_slice *slice;
+
+    /*剩余空间留给后面的数据，不需要清零。*/
+    alloc = abcdk_allocator_alloc3(&capacity, 1, 0, ABCDK_ALLOCATOR_UNINIT);
+    if (!alloc)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+
+    slice = _abcdk_chain_slice_alloc(alloc, 0, size);
+    if (!slice)
+    {
+        abcdk_allocator_unref(&alloc);
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+    }
+
+    if (data && size > 0)
+        memcpy(alloc->pptrs[0], data, size);
+
+    return slice;
+}
+
+int abcdk_chain_append2(abcdk_chain_t *ctx, const void *data, size_t size)
+{
+    abcdk_chain_slice *tail, *slice = NULL;
+    size_t spare;
+
+    assert(ctx != NULL && data != NULL && size > 0);
+
+    tail = ctx->tail;
+    spare = ABCDK_MIN(_abcdk_chain_slice_spare(tail), size);
+
+    /*先申请新的分段，失败时不写入任何数据。*/
+    if (size > spare)
+    {
+        slice = _abcdk_chain_slice_clone(ABCDK_PTR2VPTR(data, spare), size - spare,
+                                         ABCDK_MAX(size - spare, (size_t)ABCDK_CHAIN_SLICE_SIZE));
+        if (!slice)
+            return -1;
+    }
+
+    if (spare > 0)
+    {
+        memcpy(tail->alloc->pptrs[0] + tail->off + tail->len, data, spare);
+        tail->len += spare;
+        ctx->length += spare;
+    }
+
+    if (slice)
+        _abcdk_chain_link_tail(ctx, slice);
+
+    return 0;
+}
+
+int abcdk_chain_append3(abcdk_chain_t *ctx, abcdk_buffer_t *buf)
+{
+    struct iovec vec[2];
+    size_t off, len;
+    int n;
+
+    assert(ctx != NULL && buf != NULL);
+
+    n = abcdk_buffer_rvec(buf, vec);
+
+    for (int i = 0; i < n; i++)
+    {
+        assert(buf->alloc != NULL);
+
+        off = (uint8_t *)vec[i].iov_base - (uint8_t *)buf->data;
+        len = vec[i].iov_len;
+
+        /*镜像映射的缓存，跨过末尾的部分在第二个映射中，分段只引用第一个映射。*/
+        if (off + len > buf->size)
+        {
+            if (abcdk_chain_append(ctx, buf->alloc, off, buf->size - off) != 0)
+                return -1;
+
+            len -= buf->size - off;
+            off = 0;
+        }
+
+        if (abcdk_chain_append(ctx, buf->alloc, off, len) != 0)
+            return -1;
+    }
+
+    return 0;
+}
+
+int abcdk_chain_prepend(abcdk_chain_t *ctx, abcdk_allocator_t *alloc, size_t off, size_t len)
+{
+    abcdk_chain_slice *slice;
+
+    assert(ctx != NULL);
+
+    slice = _abcdk_chain_slice_refer(alloc, off, len);
+    if (!slice)
+        return -1;
+
+    _abcdk_chain_link_head(ctx, slice);
+
+    return 0;
+}
+
+int abcdk_chain_prepend2(abcdk_chain_t *ctx, const void *data, size_t size)
+{
+    abcdk_chain_slice *slice;
+
+    assert(ctx != NULL && data != NULL && size > 0);
+
+    /*前面的数据一般是协议头部，长度刚好即可。*/
+    slice = _abcdk_chain_slice_clone(data, size, size);
+    if (!slice)
+        return -1;
+
+    _abcdk_chain_link_head(ctx, slice);
+
+    return 0;
+}
+
+void abcdk_chain_splice(abcdk_chain_t *dst, abcdk_chain_t *src)
+{
+    assert(dst != NULL && src != NULL && dst != src);
+
+    if (!src->head)
+        return;
+
+    if (dst->tail)
+    {
+        dst->tail->next = src->head;
+        src->head->prev = dst->tail;
+    }
+    else
+    {
+        dst->head = src->head;
+    }
+
+    dst->tail = src->tail;
+    dst->count += src->count;
+    dst->length += src->length;
+
+    src->head = src->tail = NULL;
+    src->count = src->length = 0;
+}
+
+abcdk_chain_t *abcdk_chain_split(abcdk_chain_t *ctx, size_t size)
+{
+    abcdk_chain_t *front;
+    abcdk_chain_slice *slice;
+
+    assert(ctx != NULL);
+
+    front = abcdk_chain_alloc();
+    if (!front)
+        return NULL;
+
+    size = ABCDK_MIN(size, ctx->length);
+
+    /*整段移动。*/
+    while (ctx->head && ctx->head->len <= size)
+    {
+        slice = ctx->head;
+        size -= slice->len;
+
+        _abcdk_chain_unlink(ctx, slice);
+        _abcdk_chain_link_tail(front, slice);
+    }
+
+    /*跨过拆分位置的分段，前后两部分共享内存块。*/
+    if (size > 0)
+    {
+        slice = _abcdk_chain_slice_refer(ctx->head->alloc, ctx->head->off, size);
+        if (!slice)
+        {
+            /*已经移动的分段放回去。*/
+            abcdk_chain_splice(front, ctx);
+            abcdk_chain_splice(ctx, front);
+            abcdk_chain_free(&front);
+            return NULL;
+        }
+
+        _abcdk_chain_link_tail(front, slice);
+
+        ctx->head->off += size;
+        ctx->head->len -= size;
+        ctx->length -= size;
+    }
+
+    return front;
+}
+
+abcdk_chain_t *abcdk_chain_copy(abcdk_chain_t *src)
+{
+    abcdk_chain_t *ctx;
+
+    assert(src != NULL);
+
+    ctx = abcdk_chain_alloc();
+    if (!ctx)
+        return NULL;
+
+    for (abcdk_chain_slice *p = src->head; p; p = p->next)
+    {
+        if (p->len <= 0)
+            continue;
+
+        if (abcdk_chain_append(ctx, p->alloc, p->off, p->len) != 0)
+            goto final_error;
+    }
+
+    return ctx;
+
+final_error:
+
+    abcdk_chain_free(&ctx);
+
+    return NULL;
+}
+
+ssize_t abcdk_chain_read(abcdk_chain_t *ctx, void *data, size_t size)
+{
+    size_t rsize = 0, rsize2;
+
+    assert(ctx != NULL && data != NULL && size > 0);
+
+    if (ctx->length <= 0)
+        ABCDK_ERRNO_AND_RETURN1(ESPIPE, 0);
+
+    for (abcdk_chain_slice *p = ctx->head; p && rsize < size; p = p->next)
+    {
+        rsize2 = ABCDK_MIN(p->len, size - rsize);
+        memcpy(ABCDK_PTR2VPTR(data, rsize), p->alloc->pptrs[0] + p->off, rsize2);
+        rsize += rsize2;
+    }
+
+    abcdk_chain_drain(ctx, rsize);
+
+    return rsize;
+}
+
+size_t abcdk_chain_drain(abcdk_chain_t *ctx, size_t size)
+{
+    abcdk_chain_slice *slice;
+    size_t dsize = 0;
+
+    assert(ctx != NULL);
+
+    while (ctx->head && dsize < size)
+    {
+        slice = ctx->head;
+
+        if (slice->len > size - dsize)
+        {
+            slice->off += size - dsize;
+            slice->len -= size - dsize;
+            ctx->length -= size - dsize;
+            dsize = size;
+            break;
+        }
+
+        dsize += slice->len;
+
+        /*最后一段有剩余空间时保留，后面追加的数据可以继续写入。*/
+        if (slice == ctx->tail && _abcdk_chain_slice_spare(slice) > 0)
+        {
+            ctx->length -= slice->len;
+            slice->off += slice->len;
+            slice->len = 0;
+            break;
+        }
+
+        _abcdk_chain_unlink(ctx, slice);
+        _abcdk_chain_slice_free(&slice);
+    }
+
+    return dsize;
+}
+
+int abcdk_chain_iovec(abcdk_chain_t *ctx, struct iovec *vec, int max)
+{
+    int n = 0;
+
+    assert(ctx != NULL && vec != NULL && max > 0);
+
+    for (abcdk_chain_slice *p = ctx->head; p && n < max; p = p->next)
+    {
+        if (p->len <= 0)
+            continue;
+
+        vec[n].iov_base = p->alloc->pptrs[0] + p->off;
+        vec[n].iov_len = p->len;
+        n += 1;
+    }
+
+    return n;
+}
+
+static ssize_t _abcdk_chain_readv(int fd, struct iovec *vec, int n)
+{
+    ssize_t rsize = 0;
+    ssize_t rsize2 = 0;
+
+    while (n > 0)
+    {
+        rsize2 = readv(fd, vec, n);
+        if (rsize2 <= 0)
+            break;
+
+        rsize += rsize2;
+
+        /*与abcdk_read相同，未读满时继续读取剩余的部分。*/
+        while (n > 0 && rsize2 >= vec->iov_len)
+        {
+            rsize2 -= vec->iov_len;
+            vec += 1;
+            n -= 1;
+        }
+
+        if (n > 0)
+        {
+            vec->iov_base = ABCDK_PTR2VPTR(vec->iov_base, rsize2);
+            vec->iov_len -= rsize2;
+        }
+    }
+
+    return (rsize > 0 ? rsize : rsize2);
+}
+
+ssize_t abcdk_chain_import_atmost(abcdk_chain_t *ctx, int fd, size_t howmuch)
+{
+    abcdk_chain_slice *tail, *slice = NULL;
+    struct iovec vec[2];
+    ssize_t rsize;
+    size_t spare;
+    int n = 0;
+
+    assert(ctx != NULL && fd >= 0 && howmuch > 0);
+
+    tail = ctx->tail;
+    spare = ABCDK_MIN(_abcdk_chain_slice_spare(tail), howmuch);
+
+    if (spare > 0)
+    {
+        vec[n].iov_base = tail->alloc->pptrs[0] + tail->off + tail->len;
+        vec[n].iov_len = spare;
+        n += 1;
+    }
+
+    if (howmuch > spare)
+    {
+        slice = _abcdk_chain_slice_clone(NULL, 0, howmuch - spare);
+        if (!slice)
+            return -1;
+
+        vec[n].iov_base = slice->alloc->pptrs[0];
+        vec[n].iov_len = howmuch - spare;
+        n += 1;
+    }
+
+    rsize = _abcdk_chain_readv(fd, vec, n);
+
+    if (rsize > 0)
+    {
+        spare = ABCDK_MIN(spare, (size_t)rsize);
+        if (tail && spare > 0)
+        {
+            tail->len += spare;
+            ctx->length += spare;
+        }
+
+        if (slice && rsize > spare)
+        {
+            slice->len = rsize - spare;
+            _abcdk_chain_link_tail(ctx, slice);
+            slice = NULL;
+        }
+    }
+
+    if (slice)
+        _abcdk_chain_slice_free(&slice);
+
+    return rsize;
+}
+
+ssize_t abcdk_chain_export(abcdk_chain_t *ctx, int fd)
+{
+    struct iovec vec[ABCDK_CHAIN_IOV_MAX];
+    ssize_t wsize = 0;
+    ssize_t wsize2 = 0;
+    int n;
+
+    assert(ctx != NULL && fd >= 0);
+
+    if (ctx->length <= 0)
+        ABCDK_ERRNO_AND_RETURN1(ESPIPE, 0);
+
+    while (ctx->length > 0)
+    {
+        n = abcdk_chain_iovec(ctx, vec, ABCDK_CHAIN_IOV_MAX);
+
+        wsize2 = writev(fd, vec, n);
+        if (wsize2 <= 0)
+            break;
+
+        /*与abcdk_write相同，未写完时继续写入剩余的部分。*/
+        abcdk_chain_drain(ctx, wsize2);
+        wsize += wsize2;
+    }
+
+    return (wsize > 0 ? wsize : wsize2);
+}
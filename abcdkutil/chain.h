@@ -0,0 +1,166 @@
+/*
+ * This file is part of ABCDK.
+ *
+ * MIT License
+ *
+ */
+#ifndef ABCDKUTIL_CHAIN_H
+#define ABCDKUTIL_CHAIN_H
+
+#include "general.h"
+#include "allocator.h"
+#include "buffer.h"
+
+__BEGIN_DECLS
+
+/**
+ * 分段缓存(链)。
+ *
+ * 数据保存在多个分段中，每个分段引用内存块(abcdk_allocator_t)的一部分。
+ * 追加、前插、拆分、拼接只修改链表和引用计数，不复制数据；多个链可以共享同一个内存块。
+ * 导出时使用writev一次写出多个分段。
+ *
+ * @note 内存块只有一个引用时，尾部分段的剩余空间可以继续写入；被共享的内存块是只读的。
+ * @note 多线程访问需要外部加锁。
+*/
+typedef struct _abcdk_chain abcdk_chain_t;
+
+/**
+ * 销毁。
+*/
+void abcdk_chain_free(abcdk_chain_t **ctx);
+
+/**
+ * 创建。
+ *
+ * @return !NULL(0) 成功，NULL(0) 失败。
+*/
+abcdk_chain_t *abcdk_chain_alloc();
+
+/**
+ * 获取数据长度。
+*/
+size_t abcdk_chain_length(abcdk_chain_t *ctx);
+
+/**
+ * 获取分段数量。
+*/
+size_t abcdk_chain_count(abcdk_chain_t *ctx);
+
+/**
+ * 追加分段(引用内存块，不复制数据)。
+ *
+ * @param alloc 内存块。使用第一块内存(pptrs[0])。
+ * @param off 偏移量。
+ * @param len 长度。
+ *
+ * @return 0 成功，-1 失败。
+*/
+int abcdk_chain_append(abcdk_chain_t *ctx, abcdk_allocator_t *alloc, size_t off, size_t len);
+
+/**
+ * 追加数据(复制)。
+ *
+ * @note 优先写入尾部分段的剩余空间。
+ *
+ * @return 0 成功，-1 失败。
+*/
+int abcdk_chain_append2(abcdk_chain_t *ctx, const void *data, size_t size);
+
+/**
+ * 追加缓存中的未读数据(引用内存块，不复制数据)。
+ *
+ * @note 不修改缓存的读写位置。
+ *
+ * @return 0 成功，-1 失败。
+*/
+int abcdk_chain_append3(abcdk_chain_t *ctx, abcdk_buffer_t *buf);
+
+/**
+ * 前插分段(引用内存块，不复制数据)。
+ *
+ * @return 0 成功，-1 失败。
+*/
+int abcdk_chain_prepend(abcdk_chain_t *ctx, abcdk_allocator_t *alloc, size_t off, size_t len);
+
+/**
+ * 前插数据(复制)。
+ *
+ * @return 0 成功，-1 失败。
+*/
+int abcdk_chain_prepend2(abcdk_chain_t *ctx, const void *data, size_t size);
+
+/**
+ * 拼接。
+ *
+ * 把src的全部分段移动到dst的尾部，src变为空的。
+*/
+void abcdk_chain_splice(abcdk_chain_t *dst, abcdk_chain_t *src);
+
+/**
+ * 拆分。
+ *
+ * 把前面size字节的数据移动到新的链中。跨过拆分位置的分段由两个链共享内存块。
+ *
+ * @return !NULL(0) 成功(前面的数据)，NULL(0) 失败。
+*/
+abcdk_chain_t *abcdk_chain_split(abcdk_chain_t *ctx, size_t size);
+
+/**
+ * 复制。
+ *
+ * 新的链与源共享全部内存块，不复制数据。
+ *
+ * @return !NULL(0) 成功，NULL(0) 失败。
+*/
+abcdk_chain_t *abcdk_chain_copy(abcdk_chain_t *src);
+
+/**
+ * 读取数据。
+ *
+ * @return > 0 读取的长度(Bytes)，= 0 末尾。
+*/
+ssize_t abcdk_chain_read(abcdk_chain_t *ctx, void *data, size_t size);
+
+/**
+ * 排出数据。
+ *
+ * 丢弃前面size字节的数据，释放已经排空的分段。
+ *
+ * @return 排出的长度(Bytes)。
+*/
+size_t abcdk_chain_drain(abcdk_chain_t *ctx, size_t size);
+
+/**
+ * 获取前面的内存段。
+ *
+ * @param vec 内存段数组。
+ * @param max 数组的容量。
+ *
+ * @return 内存段的数量。
+*/
+int abcdk_chain_iovec(abcdk_chain_t *ctx, struct iovec *vec, int max);
+
+/**
+ * 从文件导入数据。
+ *
+ * 尾部分段的剩余空间和新的分段使用readv一次导入。
+ *
+ * 阻塞模式的句柄，可能会因为导入数据不足而阻塞。
+ *
+ * @return > 0 导入的长度(Bytes)，= 0 末尾，< 0 出错。
+*/
+ssize_t abcdk_chain_import_atmost(abcdk_chain_t *ctx, int fd, size_t howmuch);
+
+/**
+ * 导出数据到文件。
+ *
+ * 多个分段使用writev一次导出，已导出的数据被排出。
+ *
+ * @return > 0 导出的长度(Bytes)，= 0 无数据，< 0 出错。
+*/
+ssize_t abcdk_chain_export(abcdk_chain_t *ctx, int fd);
+
+__END_DECLS
+
+#endif //ABCDKUTIL_CHAIN_H
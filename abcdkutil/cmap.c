@@ -0,0 +1,736 @@
+/*
+ * This file is part of ABCDK.
+ *
+ * MIT License
+ *
+ */
+#include "cmap.h"
+
+/** 分段数量(2的幂)。*/
+#define ABCDK_CMAP_STRIPE_BITS 6
+#define ABCDK_CMAP_STRIPES (1 << ABCDK_CMAP_STRIPE_BITS)
+
+/** 每个分段的最小桶数量(2的幂)。*/
+#define ABCDK_CMAP_BUCKETS_MIN 8
+
+/** 每删除多少次尝试推进一次纪元。*/
+#define ABCDK_CMAP_RECLAIM_STEP 32
+
+/**
+ * 节点。
+*/
+typedef struct _abcdk_cmap_node
+{
+    /**
+     * 链表中的下一个节点。
+     *
+     * @note 节点移除后保持不变，正在遍历的线程可以继续向后遍历。
+    */
+    struct _abcdk_cmap_node *next;
+
+    /** HASH值。*/
+    uint64_t hash;
+
+    /** 元素(节点持有一个引用)。*/
+    abcdk_allocator_t *alloc;
+
+    /** 待释放链表。*/
+    struct _abcdk_cmap_node *retire_next;
+
+} abcdk_cmap_node;
+
+/**
+ * 桶数组。
+*/
+typedef struct _abcdk_cmap_buckets
+{
+    /** 待释放链表。*/
+    struct _abcdk_cmap_buckets *retire_next;
+
+    /** 掩码(数量-1)。*/
+    size_t mask;
+
+    /** 链表头。*/
+    abcdk_cmap_node *heads[];
+
+} abcdk_cmap_buckets;
+
+/**
+ * 待释放列表(同一个纪元中移除的节点和桶数组)。
+*/
+typedef struct _abcdk_cmap_limbo
+{
+    /** 纪元。*/
+    uint64_t epoch;
+
+    /** 节点。*/
+    abcdk_cmap_node *nodes;
+
+    /** 桶数组。*/
+    abcdk_cmap_buckets *buckets;
+
+} abcdk_cmap_limbo;
+
+/**
+ * 分段。
+*/
+typedef struct _abcdk_cmap_stripe
+{
+    /** 写锁。*/
+    abcdk_mutex_t mutex;
+
+    /** 桶数组。*/
+    abcdk_cmap_buckets *buckets;
+
+    /** 元素数量。*/
+    size_t count;
+
+    /**
+     * 待释放列表。
+     *
+     * 按纪元对3取余索引，纪元推进两次后可以释放，所以同时最多有3个纪元的待释放列表。
+    */
+    abcdk_cmap_limbo limbo[3];
+
+    /** 删除计数(用于推进纪元)。*/
+    size_t retire_count;
+
+} __attribute__((aligned(64))) abcdk_cmap_stripe;
+
+/**
+ * 并发MAP。
+*/
+typedef struct _abcdk_cmap
+{
+    /** 回调函数。*/
+    abcdk_cmap_callback cb;
+
+    /** 分段。*/
+    abcdk_cmap_stripe stripes[ABCDK_CMAP_STRIPES];
+
+} abcdk_cmap_t;
+
+/**
+ * 线程的纪元记录。
+*/
+typedef struct _abcdk_cmap_reader
+{
+    /** 进入查找时的纪元。*/
+    volatile uint64_t epoch;
+
+    /** 嵌套深度，> 0 正在查找。*/
+    volatile int depth;
+
+    /** 链表。*/
+    struct _abcdk_cmap_reader *prev;
+    struct _abcdk_cmap_reader *next;
+
+} __attribute__((aligned(64))) abcdk_cmap_reader;
+
+/**
+ * 全局环境。
+*/
+typedef struct _abcdk_cmap_global
+{
+    /** 线程记录的键(用于线程退出时注销)。*/
+    pthread_key_t key;
+
+    /** 全局纪元。*/
+    volatile uint64_t epoch __attribute__((aligned(64)));
+
+    /** 互斥量(保护线程记录链表)。*/
+    abcdk_mutex_t mutex __attribute__((aligned(64)));
+
+    /** 线程记录链表。*/
+    abcdk_cmap_reader *readers;
+
+} abcdk_cmap_global;
+
+static volatile int _abcdk_cmap_init_status = 0;
+static abcdk_cmap_global _abcdk_cmap_global = {0};
+static __thread abcdk_cmap_reader *_abcdk_cmap_thread_reader = NULL;
+
+static void _abcdk_cmap_reader_destroy(void *opaque)
+{
+    abcdk_cmap_global *g = &_abcdk_cmap_global;
+    abcdk_cmap_reader *reader = (abcdk_cmap_reader *)opaque;
+
+    abcdk_mutex_lock(&g->mutex, 1);
+
+    if (reader->prev)
+        reader->prev->next = reader->next;
+    else
+        g->readers = reader->next;
+
+    if (reader->next)
+        reader->next->prev = reader->prev;
+
+    abcdk_mutex_unlock(&g->mutex);
+
+    abcdk_heap_free(reader);
+    _abcdk_cmap_thread_reader = NULL;
+}
+
+static int _abcdk_cmap_init(void *opaque)
+{
+    abcdk_cmap_global *g = (abcdk_cmap_global *)opaque;
+
+    if (pthread_key_create(&g->key, _abcdk_cmap_reader_destroy) != 0)
+        return -1;
+
+    abcdk_mutex_init2(&g->mutex, 0);
+
+    /*从1开始，0 表示不在查找中。*/
+    g->epoch = 1;
+    g->readers = NULL;
+
+    return 0;
+}
+
+static abcdk_cmap_reader *_abcdk_cmap_reader_get()
+{
+    abcdk_cmap_global *g = &_abcdk_cmap_global;
+    abcdk_cmap_reader *reader = _abcdk_cmap_thread_reader;
+
+    if (reader)
+        return reader;
+
+    /*独占缓存行，查找时只写自己的记录。*/
+    if (posix_memalign((void **)&reader, 64, sizeof(abcdk_cmap_reader)) != 0)
+        return NULL;
+
+    memset(reader, 0, sizeof(*reader));
+
+    if (pthread_setspecific(g->key, reader) != 0)
+    {
+        abcdk_heap_free(reader);
+        return NULL;
+    }
+
+    abcdk_mutex_lock(&g->mutex, 1);
+
+    reader->next = g->readers;
+    if (g->readers)
+        g->readers->prev = reader;
+    g->readers = reader;
+
+    abcdk_mutex_unlock(&g->mutex);
+
+    _abcdk_cmap_thread_reader = reader;
+
+    return reader;
+}
+
+static abcdk_cmap_reader *_abcdk_cmap_read_enter()
+{
+    abcdk_cmap_reader *reader = _abcdk_cmap_reader_get();
+
+    if (!reader)
+        return NULL;
+
+    if (reader->depth++ > 0)
+        return reader;
+
+    __atomic_store_n(&reader->epoch, __atomic_load_n(&_abcdk_cmap_global.epoch, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+
+    /*纪元对其它线程可见之后，才能读取节点。*/
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    return reader;
+}
+
+static void _abcdk_cmap_read_leave(abcdk_cmap_reader *reader)
+{
+    if (--reader->depth > 0)
+        return;
+
+    __atomic_store_n(&reader->epoch, 0, __ATOMIC_RELEASE);
+}
+
+static void _abcdk_cmap_epoch_advance()
+{
+    abcdk_cmap_global *g = &_abcdk_cmap_global;
+    uint64_t epoch, seen;
+
+    /*其它线程正在推进时跳过。*/
+    if (abcdk_mutex_lock(&g->mutex, 0) != 0)
+        return;
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    epoch = __atomic_load_n(&g->epoch, __ATOMIC_RELAXED);
+
+    /*所有正在查找的线程都进入了当前纪元，才能推进。*/
+    for (abcdk_cmap_reader *p = g->readers; p; p = p->next)
+    {
+        seen = __atomic_load_n(&p->epoch, __ATOMIC_ACQUIRE);
+        if (seen != 0 && seen != epoch)
+            goto final;
+    }
+
+    __atomic_store_n(&g->epoch, epoch + 1, __ATOMIC_RELEASE);
+
+final:
+
+    abcdk_mutex_unlock(&g->mutex);
+}
+
+static void _abcdk_cmap_node_free(abcdk_cmap_node *node)
+{
+    abcdk_allocator_unref(&node->alloc);
+    abcdk_heap_free(node);
+}
+
+static void _abcdk_cmap_limbo_free(abcdk_cmap_limbo *limbo)
+{
+    abcdk_cmap_node *node_p;
+    abcdk_cmap_buckets *buckets_p;
+
+    while ((node_p = limbo->nodes) != NULL)
+    {
+        limbo->nodes = node_p->retire_next;
+        _abcdk_cmap_node_free(node_p);
+    }
+
+    while ((buckets_p = limbo->buckets) != NULL)
+    {
+        limbo->buckets = buckets_p->retire_next;
+        abcdk_heap_free(buckets_p);
+    }
+}
+
+static void _abcdk_cmap_stripe_reclaim(abcdk_cmap_stripe *stripe)
+{
+    uint64_t epoch;
+
+    if (++stripe->retire_count % ABCDK_CMAP_RECLAIM_STEP == 0)
+        _abcdk_cmap_epoch_advance();
+
+    epoch = __atomic_load_n(&_abcdk_cmap_global.epoch, __ATOMIC_ACQUIRE);
+
+    /*移除后纪元推进了两次，移除前进入查找的线程都已经离开。*/
+    for (int i = 0; i < 3; i++)
+    {
+        if (stripe->limbo[i].epoch + 2 <= epoch)
+            _abcdk_cmap_limbo_free(&stripe->limbo[i]);
+    }
+}
+
+static void _abcdk_cmap_retire(abcdk_cmap_stripe *stripe, abcdk_cmap_node *node, abcdk_cmap_buckets *buckets)
+{
+    abcdk_cmap_limbo *limbo;
+    uint64_t epoch;
+
+    /*移除对其它线程可见之后，才能读取纪元。*/
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    epoch = __atomic_load_n(&_abcdk_cmap_global.epoch, __ATOMIC_RELAXED);
+
+    /*列表中是3个纪元之前的，可以直接释放。*/
+    limbo = &stripe->limbo[epoch % 3];
+    if (limbo->epoch != epoch)
+    {
+        _abcdk_cmap_limbo_free(limbo);
+        limbo->epoch = epoch;
+    }
+
+    if (node)
+    {
+        node->retire_next = limbo->nodes;
+        limbo->nodes = node;
+    }
+
+    if (buckets)
+    {
+        buckets->retire_next = limbo->buckets;
+        limbo->buckets = buckets;
+    }
+}
+
+static abcdk_cmap_buckets *_abcdk_cmap_buckets_alloc(size_t number)
+{
+    abcdk_cmap_buckets *buckets;
+
+    buckets = abcdk_heap_alloc(sizeof(abcdk_cmap_buckets) + number * sizeof(abcdk_cmap_node *));
+    if (!buckets)
+        return NULL;
+
+    buckets->mask = number - 1;
+
+    return buckets;
+}
+
+static void _abcdk_cmap_stripe_grow(abcdk_cmap_stripe *stripe)
+{
+    abcdk_cmap_buckets *old = stripe->buckets, *buckets;
+    abcdk_cmap_node *node, *copy, *copies = NULL;
+    size_t number = (old->mask + 1) * 2;
+
+    buckets = _abcdk_cmap_buckets_alloc(number);
+    if (!buckets)
+        return;
+
+    /*
+     * 正在查找的线程可能在遍历旧的链表，节点不能移动。
+     * 复制所有节点到新的桶数组，旧的节点和桶数组延迟释放。
+    */
+    for (size_t i = 0; i <= old->mask; i++)
+    {
+        for (node = old->heads[i]; node; node = node->next)
+        {
+            copy = abcdk_heap_alloc(sizeof(abcdk_cmap_node));
+            if (!copy)
+                goto final_error;
+
+            copy->hash = node->hash;
+            copy->alloc = abcdk_allocator_refer(node->alloc);
+            copy->next = buckets->heads[copy->hash & buckets->mask];
+            buckets->heads[copy->hash & buckets->mask] = copy;
+
+            /*借用待释放链表，失败时用于回收复制的节点。*/
+            copy->retire_next = copies;
+            copies = copy;
+        }
+    }
+
+    __atomic_store_n(&stripe->buckets, buckets, __ATOMIC_RELEASE);
+
+    for (size_t i = 0; i <= old->mask; i++)
+    {
+        for (node = old->heads[i]; node; node = copy)
+        {
+            copy = node->next;
+            _abcdk_cmap_retire(stripe, node, NULL);
+        }
+    }
+
+    _abcdk_cmap_retire(stripe, NULL, old);
+    _abcdk_cmap_stripe_reclaim(stripe);
+
+    return;
+
+final_error:
+
+    while ((copy = copies) != NULL)
+    {
+        copies = copy->retire_next;
+        _abcdk_cmap_node_free(copy);
+    }
+
+    abcdk_heap_free(buckets);
+}
+
+void abcdk_cmap_free(abcdk_cmap_t **ctx)
+{
+    abcdk_cmap_t *ctx_p;
+    abcdk_cmap_stripe *stripe;
+    abcdk_cmap_node *node, *next;
+
+    if (!ctx || !*ctx)
+        return;
+
+    ctx_p = *ctx;
+
+    for (int i = 0; i < ABCDK_CMAP_STRIPES; i++)
+    {
+        stripe = &ctx_p->stripes[i];
+
+        for (size_t j = 0; stripe->buckets && j <= stripe->buckets->mask; j++)
+        {
+            for (node = stripe->buckets->heads[j]; node; node = next)
+            {
+                next = node->next;
+                _abcdk_cmap_node_free(node);
+            }
+        }
+
+        abcdk_heap_free(stripe->buckets);
+
+        /*没有线程在访问，全部释放。*/
+        for (int j = 0; j < 3; j++)
+            _abcdk_cmap_limbo_free(&stripe->limbo[j]);
+
+        abcdk_mutex_destroy(&stripe->mutex);
+    }
+
+    abcdk_heap_free(ctx_p);
+
+    /*Set to NULL(0).*/
+    *ctx = NULL;
+}
+
+abcdk_cmap_t *abcdk_cmap_alloc(size_t size, const abcdk_cmap_callback *cb)
+{
+    abcdk_cmap_t *ctx = NULL;
+    size_t number = ABCDK_CMAP_BUCKETS_MIN;
+
+    if (abcdk_once(&_abcdk_cmap_init_status, _abcdk_cmap_init, &_abcdk_cmap_global) < 0)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+
+    if (posix_memalign((void **)&ctx, 64, sizeof(abcdk_cmap_t)) != 0)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+
+    memset(ctx, 0, sizeof(*ctx));
+
+    if (cb)
+        ctx->cb = *cb;
+
+    /* 如果未指定，则启用默认函数。 */
+    if (!ctx->cb.hash_cb)
+        ctx->cb.hash_cb = abcdk_map_hash;
+    if (!ctx->cb.compare_cb)
+        ctx->cb.compare_cb = abcdk_map_compare;
+
+    while (number * ABCDK_CMAP_STRIPES < size)
+        number <<= 1;
+
+    for (int i = 0; i < ABCDK_CMAP_STRIPES; i++)
+    {
+        abcdk_mutex_init2(&ctx->stripes[i].mutex, 0);
+
+        ctx->stripes[i].buckets = _abcdk_cmap_buckets_alloc(number);
+        if (!ctx->stripes[i].buckets)
+            goto final_error;
+    }
+
+    return ctx;
+
+final_error:
+
+    abcdk_cmap_free(&ctx);
+
+    ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+}
+
+size_t abcdk_cmap_count(abcdk_cmap_t *ctx)
+{
+    size_t count = 0;
+
+    assert(ctx != NULL);
+
+    for (int i = 0; i < ABCDK_CMAP_STRIPES; i++)
+        count += __atomic_load_n(&ctx->stripes[i].count, __ATOMIC_RELAXED);
+
+    return count;
+}
+
+static inline abcdk_cmap_stripe *_abcdk_cmap_stripe(abcdk_cmap_t *ctx, uint64_t hash)
+{
+    /*高位选择分段，低位选择桶。*/
+    return &ctx->stripes[hash >> (64 - ABCDK_CMAP_STRIPE_BITS)];
+}
+
+static abcdk_cmap_node *_abcdk_cmap_lookup(abcdk_cmap_t *ctx, abcdk_cmap_stripe *stripe, uint64_t hash,
+                                           const void *key, size_t ksize, abcdk_cmap_node ***pprev)
+{
+    abcdk_cmap_buckets *buckets = __atomic_load_n(&stripe->buckets, __ATOMIC_ACQUIRE);
+    abcdk_cmap_node **link = &buckets->heads[hash & buckets->mask];
+    abcdk_cmap_node *node;
+
+    for (; (node = __atomic_load_n(link, __ATOMIC_ACQUIRE)) != NULL; link = &node->next)
+    {
+        if (node->hash != hash || node->alloc->sizes[ABCDK_MAP_KEY] != ksize)
+            continue;
+
+        if (ctx->cb.compare_cb(node->alloc->pptrs[ABCDK_MAP_KEY], key, ksize, ctx->cb.opaque) == 0)
+            break;
+    }
+
+    if (pprev)
+        *pprev = link;
+
+    return node;
+}
+
+static abcdk_allocator_t *_abcdk_cmap_create(abcdk_cmap_t *ctx, abcdk_cmap_stripe *stripe, uint64_t hash,
+                                             const void *key, size_t ksize, size_t vsize)
+{
+    abcdk_allocator_t *alloc = NULL;
+    abcdk_cmap_buckets *buckets;
+    abcdk_cmap_node *node;
+    size_t sizes[2] = {ksize, vsize};
+
+    abcdk_mutex_lock(&stripe->mutex, 1);
+
+    /*加锁前其它线程可能已经创建。*/
+    node = _abcdk_cmap_lookup(ctx, stripe, hash, key, ksize, NULL);
+    if (node)
+    {
+        alloc = abcdk_allocator_refer(node->alloc);
+        goto final;
+    }
+
+    node = abcdk_heap_alloc(sizeof(abcdk_cmap_node));
+    if (!node)
+        goto final;
+
+    node->alloc = abcdk_allocator_alloc(sizes, 2, 0);
+    if (!node->alloc)
+    {
+        abcdk_heap_free(node);
+        goto final;
+    }
+
+    /* 注册数据节点的析构函数。*/
+    if (ctx->cb.destructor_cb)
+        abcdk_allocator_atfree(node->alloc, ctx->cb.destructor_cb, ctx->cb.opaque);
+
+    /*复制KEY。*/
+    memcpy(node->alloc->pptrs[ABCDK_MAP_KEY], key, ksize);
+
+    /*也许有构造函数要处理一下。*/
+    if (ctx->cb.construct_cb)
+        ctx->cb.construct_cb(node->alloc, ctx->cb.opaque);
+
+    /*节点的内容写完后再加入链表头。*/
+    buckets = stripe->buckets;
+    node->hash = hash;
+    node->next = buckets->heads[hash & buckets->mask];
+    __atomic_store_n(&buckets->heads[hash & buckets->mask], node, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&stripe->count, stripe->count + 1, __ATOMIC_RELAXED);
+
+    alloc = abcdk_allocator_refer(node->alloc);
+
+    /*平均链表长度超过1时扩容。*/
+    if (stripe->count > buckets->mask + 1)
+        _abcdk_cmap_stripe_grow(stripe);
+
+final:
+
+    abcdk_mutex_unlock(&stripe->mutex);
+
+    if (!alloc)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+
+    return alloc;
+}
+
+abcdk_allocator_t *abcdk_cmap_find(abcdk_cmap_t *ctx, const void *key, size_t ksize, size_t vsize)
+{
+    abcdk_cmap_reader *reader;
+    abcdk_cmap_stripe *stripe;
+    abcdk_cmap_node *node;
+    abcdk_allocator_t *alloc = NULL;
+    uint64_t hash;
+
+    assert(ctx != NULL && key != NULL && ksize > 0);
+
+    hash = ctx->cb.hash_cb(key, ksize, ctx->cb.opaque);
+    stripe = _abcdk_cmap_stripe(ctx, hash);
+
+    /*线程记录不可用时，退化为加锁查找。*/
+    reader = _abcdk_cmap_read_enter();
+    if (!reader)
+        abcdk_mutex_lock(&stripe->mutex, 1);
+
+    node = _abcdk_cmap_lookup(ctx, stripe, hash, key, ksize, NULL);
+    if (node)
+        alloc = abcdk_allocator_refer(node->alloc);
+
+    if (reader)
+        _abcdk_cmap_read_leave(reader);
+    else
+        abcdk_mutex_unlock(&stripe->mutex);
+
+    if (alloc)
+        return alloc;
+
+    /*如果节点不存在并且需要创建。*/
+    if (vsize > 0)
+        return _abcdk_cmap_create(ctx, stripe, hash, key, ksize, vsize);
+
+    ABCDK_ERRNO_AND_RETURN1(EAGAIN, NULL);
+}
+
+int abcdk_cmap_visit(abcdk_cmap_t *ctx, const void *key, size_t ksize,
+                     int (*visit_cb)(abcdk_allocator_t *alloc, void *opaque), void *opaque)
+{
+    abcdk_cmap_reader *reader;
+    abcdk_cmap_stripe *stripe;
+    abcdk_cmap_node *node;
+    uint64_t hash;
+    int chk = -1;
+
+    assert(ctx != NULL && key != NULL && ksize > 0 && visit_cb != NULL);
+
+    hash = ctx->cb.hash_cb(key, ksize, ctx->cb.opaque);
+    stripe = _abcdk_cmap_stripe(ctx, hash);
+
+    reader = _abcdk_cmap_read_enter();
+    if (!reader)
+        abcdk_mutex_lock(&stripe->mutex, 1);
+
+    node = _abcdk_cmap_lookup(ctx, stripe, hash, key, ksize, NULL);
+    if (node)
+        chk = visit_cb(node->alloc, opaque);
+
+    if (reader)
+        _abcdk_cmap_read_leave(reader);
+    else
+        abcdk_mutex_unlock(&stripe->mutex);
+
+    if (!node)
+        ABCDK_ERRNO_AND_RETURN1(EAGAIN, -1);
+
+    return ABCDK_MAX(chk, 0);
+}
+
+int abcdk_cmap_remove(abcdk_cmap_t *ctx, const void *key, size_t ksize)
+{
+    abcdk_cmap_stripe *stripe;
+    abcdk_cmap_node *node, **link;
+    uint64_t hash;
+
+    assert(ctx != NULL && key != NULL && ksize > 0);
+
+    hash = ctx->cb.hash_cb(key, ksize, ctx->cb.opaque);
+    stripe = _abcdk_cmap_stripe(ctx, hash);
+
+    abcdk_mutex_lock(&stripe->mutex, 1);
+
+    node = _abcdk_cmap_lookup(ctx, stripe, hash, key, ksize, &link);
+    if (node)
+    {
+        /*从链表中移除，节点的next保持不变。*/
+        __atomic_store_n(link, node->next, __ATOMIC_RELEASE);
+        __atomic_store_n(&stripe->count, stripe->count - 1, __ATOMIC_RELAXED);
+
+        _abcdk_cmap_retire(stripe, node, NULL);
+        _abcdk_cmap_stripe_reclaim(stripe);
+    }
+
+    abcdk_mutex_unlock(&stripe->mutex);
+
+    return (node ? 0 : -1);
+}
+
+void abcdk_cmap_scan(abcdk_cmap_t *ctx, int (*dump_cb)(abcdk_allocator_t *alloc, void *opaque), void *opaque)
+{
+    abcdk_cmap_reader *reader;
+    abcdk_cmap_buckets *buckets;
+    abcdk_cmap_node *node;
+    int chk = 1;
+
+    assert(ctx != NULL && dump_cb != NULL);
+
+    for (int i = 0; i < ABCDK_CMAP_STRIPES && chk >= 0; i++)
+    {
+        reader = _abcdk_cmap_read_enter();
+        if (!reader)
+            abcdk_mutex_lock(&ctx->stripes[i].mutex, 1);
+
+        buckets = __atomic_load_n(&ctx->stripes[i].buckets, __ATOMIC_ACQUIRE);
+
+        for (size_t j = 0; j <= buckets->mask && chk >= 0; j++)
+        {
+            node = __atomic_load_n(&buckets->heads[j], __ATOMIC_ACQUIRE);
+            for (; node && chk >= 0; node = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE))
+                chk = dump_cb(node->alloc, opaque);
+        }
+
+        if (reader)
+            _abcdk_cmap_read_leave(reader);
+        else
+            abcdk_mutex_unlock(&ctx->stripes[i].mutex);
+    }
+}
@@ -0,0 +1,133 @@
+/*
+ * This file is part of ABCDK.
+ *
+ * MIT License
+ *
+ */
+#ifndef ABCDKUTIL_CMAP_H
+#define ABCDKUTIL_CMAP_H
+
+#include "general.h"
+#include "thread.h"
+#include "map.h"
+
+__BEGIN_DECLS
+
+/**
+ * 并发MAP。
+ *
+ * 多个线程共享，不需要外部加锁。
+ *
+ * 表格按HASH值的高位分成多个分段，每个分段有独立的写锁和桶数组，添加和删除只锁住一个分段。
+ * 查找不加锁，删除的节点按纪元(epoch)延迟释放，直到所有正在查找的线程都离开后才释放。
+ *
+ * @note 元素的KEY和VALUE字段索引与abcdk_map_t相同(ABCDK_MAP_KEY，ABCDK_MAP_VALUE)。
+*/
+typedef struct _abcdk_cmap abcdk_cmap_t;
+
+/**
+ * 并发MAP的回调函数。
+ *
+ * @note 未填写(NULL)的HASH函数和比较函数使用abcdk_map_hash和abcdk_map_compare。
+*/
+typedef struct _abcdk_cmap_callback
+{
+    /**
+     * KEY哈希函数。
+    */
+    uint64_t (*hash_cb)(const void *key, size_t size, void *opaque);
+
+    /**
+     * KEY比较函数。
+    */
+    int (*compare_cb)(const void *key1, const void *key2, size_t size, void *opaque);
+
+    /**
+     * 构造函数。
+     *
+     * 在分段的写锁内执行，执行完成后其它线程才能查找到。
+    */
+    void (*construct_cb)(abcdk_allocator_t *alloc, void *opaque);
+
+    /**
+     * 析构函数。
+     *
+     * 最后一个引用释放时执行，可能在任意线程中。
+    */
+    void (*destructor_cb)(abcdk_allocator_t *alloc, void *opaque);
+
+    /**
+     * 环境指针。
+    */
+    void *opaque;
+
+} abcdk_cmap_callback;
+
+/**
+ * 销毁。
+ *
+ * @warning 没有线程在访问时才能销毁。
+*/
+void abcdk_cmap_free(abcdk_cmap_t **ctx);
+
+/**
+ * 创建。
+ *
+ * @param size 预计的元素数量。
+ * @param cb 回调函数，NULL(0) 全部使用默认值。
+ *
+ * @return !NULL(0) 成功，NULL(0) 失败。
+*/
+abcdk_cmap_t *abcdk_cmap_alloc(size_t size, const abcdk_cmap_callback *cb);
+
+/**
+ * 获取元素数量。
+ *
+ * @note 多线程访问时仅供参考。
+*/
+size_t abcdk_cmap_count(abcdk_cmap_t *ctx);
+
+/**
+ * 查找或创建。
+ *
+ * @param vsize Value size。 0 仅查找，>0 不存在则创建。
+ *
+ * @return !NULL(0) 成功(元素的引用，使用完后调用abcdk_allocator_unref释放)，NULL(0) 不存在或创建失败。
+*/
+abcdk_allocator_t *abcdk_cmap_find(abcdk_cmap_t *ctx, const void *key, size_t ksize, size_t vsize);
+
+/**
+ * 查找并访问。
+ *
+ * 回调函数在查找的临界区内执行，期间元素不会被释放。不增加引用，多个线程同时访问同一个元素时没有写竞争。
+ *
+ * @note 回调函数中不能长时间阻塞，否则会推迟所有已删除节点的释放。
+ *
+ * @param visit_cb 访问函数。
+ *
+ * @return >= 0 成功(访问函数的返回值)，-1 不存在。
+*/
+int abcdk_cmap_visit(abcdk_cmap_t *ctx, const void *key, size_t ksize,
+                     int (*visit_cb)(abcdk_allocator_t *alloc, void *opaque), void *opaque);
+
+/**
+ * 删除。
+ *
+ * 元素从表格中移除，其它线程持有的引用仍然有效。
+ *
+ * @return 0 成功，-1 不存在。
+*/
+int abcdk_cmap_remove(abcdk_cmap_t *ctx, const void *key, size_t ksize);
+
+/**
+ * 扫描节点。
+ *
+ * 不加锁遍历，扫描期间添加或删除的节点可能被遍历到，也可能不会。
+ *
+ * @param dump_cb 回显函数。返回 -1 终止，1 继续。
+*/
+void abcdk_cmap_scan(abcdk_cmap_t *ctx, int (*dump_cb)(abcdk_allocator_t *alloc, void *opaque), void *opaque);
+
+__END_DECLS
+
+#endif //ABCDKUTIL_CMAP_H
@@ -45,10 +45,13 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/sendfile.h>
 #include <sys/file.h>
 #include <sys/wait.h>
 #include <sys/ioctl.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <sys/mtio.h>
 #include <scsi/scsi.h>
 #include <scsi/scsi_ioctl.h>
@@ -58,6 +61,14 @@
 #include <arpa/inet.h>
 #include <net/if.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif //__SSE2__
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif //defined(__x86_64__) || defined(__i386__)
+
 /**
  * 主版本号。
  * 
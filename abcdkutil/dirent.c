@@ -15,7 +15,7 @@ void abcdk_dirscan(abcdk_tree_t *father,size_t depth,int onefs)
     char *c_path = NULL;
     struct stat *c_stat = NULL;
     abcdk_tree_t *node = NULL;
-    size_t sizes[2] = {PATH_MAX,sizeof(struct stat)};
+    size_t sizes[2] = {0,sizeof(struct stat)};
 
     assert(father);
     assert(father->alloc->numbers >= 2);
@@ -45,7 +45,10 @@ void abcdk_dirscan(abcdk_tree_t *father,size_t depth,int onefs)
         if (abcdk_strcmp(c_dir->d_name, ".", 1) == 0 || abcdk_strcmp(c_dir->d_name, "..", 1) == 0)
             continue;
 
-        node = abcdk_tree_alloc2(sizes,2,0);
+        /*名字的长度刚好够用(对齐到8字节，状态紧跟在后面)，节点和父节点在同一个区域中。*/
+        sizes[0] = abcdk_align(strlen(f_path) + strlen(c_dir->d_name) + 2, 8);
+
+        node = abcdk_tree_alloc4(father, sizes, 2, 0);
         if (!node)
             break;
 
@@ -61,6 +64,7 @@ void abcdk_dirscan(abcdk_tree_t *father,size_t depth,int onefs)
         /*node->d_type 有些文件系统有BUG未设置有效值，因此不能直接使用，这里用替待方案。 */
         if (lstat(c_path, c_stat) == -1)
         {
+            abcdk_tree_unlink(node);
             abcdk_tree_free(&node);
             break;
         }
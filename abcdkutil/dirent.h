@@ -34,9 +34,10 @@ enum _abcdk_dirent_field
 /**
  * 目录扫描。
  * 
- * 扫描的结果会自动生成一个颗“树”。
+ * 扫描的结果会自动生成一个颗“树”。子节点与父节点在同一个区域中(见abcdk_tree_arena_alloc)，
+ * 子节点的名字字段刚好容纳完整路径。
  * 
- * @warning 如果目录和文件较多，则需要较多的内存。
+ * @warning 如果目录和文件较多，则需要较多的内存，建议使用区域的根节点。
  * 
  * @param depth 遍历深度。0 只遍历当前目录，>= 1 遍历多级目录。
  * @param onefs 0 不辨别文件系统是否相同，!0 只在同一个文件系统中遍历。
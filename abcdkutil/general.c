@@ -74,6 +74,13 @@ void *abcdk_heap_alloc(size_t size)
     return calloc(1,size);
 }
 
+void *abcdk_heap_malloc(size_t size)
+{
+    assert(size > 0);
+
+    return malloc(size);
+}
+
 void* abcdk_heap_realloc(void *buf,size_t size)
 {
     assert(size > 0);
@@ -394,6 +401,156 @@ final_error:
 
 /*------------------------------------------------------------------------------------------------*/
 
+typedef const void *(*_abcdk_memdelim_func)(const void *data, size_t size, uint8_t delim);
+
+static const void *_abcdk_memdelim_scalar(const void *data, size_t size, uint8_t delim)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        if (p[i] == delim)
+            return p + i;
+    }
+
+    return NULL;
+}
+
+#ifdef __SSE2__
+
+static const void *_abcdk_memdelim_sse2(const void *data, size_t size, uint8_t delim)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    __m128i d = _mm_set1_epi8((char)delim);
+    uint32_t mask;
+    size_t i = 0;
+
+    if (size < 16)
+        return _abcdk_memdelim_scalar(p, size, delim);
+
+    for (; i + 16 <= size; i += 16)
+    {
+        mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + i)), d));
+        if (mask)
+            return p + i + __builtin_ctz(mask);
+    }
+
+    if (i >= size)
+        return NULL;
+
+    /*剩余不足16字节，从末尾向前重叠读取，移出已经比较过的字节。*/
+    mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + size - 16)), d));
+    mask >>= 16 - (size - i);
+    if (mask)
+        return p + i + __builtin_ctz(mask);
+
+    return NULL;
+}
+
+#endif //__SSE2__
+
+#if defined(__x86_64__) || defined(__i386__)
+
+__attribute__((target("avx2")))
+static const void *_abcdk_memdelim_avx2(const void *data, size_t size, uint8_t delim)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    __m256i d = _mm256_set1_epi8((char)delim);
+    __m256i c1, c2;
+    uint32_t mask;
+    size_t i = 0;
+
+    if (size < 32)
+    {
+#ifdef __SSE2__
+        return _abcdk_memdelim_sse2(p, size, delim);
+#else //__SSE2__
+        return _abcdk_memdelim_scalar(p, size, delim);
+#endif //__SSE2__
+    }
+
+    /*短行的分隔符大多在前32字节中，先比较一次。*/
+    mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)p), d));
+    if (mask)
+        return p + __builtin_ctz(mask);
+
+    i = 32;
+
+    /*每次比较64字节，两组的结果合并后再判断，命中后再区分是哪一组。*/
+    for (; i + 64 <= size; i += 64)
+    {
+        c1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + i)), d);
+        c2 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + i + 32)), d);
+        if (!_mm256_movemask_epi8(_mm256_or_si256(c1, c2)))
+            continue;
+
+        mask = _mm256_movemask_epi8(c1);
+        if (mask)
+            return p + i + __builtin_ctz(mask);
+
+        return p + i + 32 + __builtin_ctz(_mm256_movemask_epi8(c2));
+    }
+
+    for (; i + 32 <= size; i += 32)
+    {
+        mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + i)), d));
+        if (mask)
+            return p + i + __builtin_ctz(mask);
+    }
+
+    if (i >= size)
+        return NULL;
+
+    /*剩余不足32字节，从末尾向前重叠读取，移出已经比较过的字节。*/
+    mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + size - 32)), d));
+    mask >>= 32 - (size - i);
+    if (mask)
+        return p + i + __builtin_ctz(mask);
+
+    return NULL;
+}
+
+#endif //defined(__x86_64__) || defined(__i386__)
+
+static _abcdk_memdelim_func _abcdk_memdelim_select()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return _abcdk_memdelim_avx2;
+#endif //defined(__x86_64__) || defined(__i386__)
+
+#ifdef __SSE2__
+    return _abcdk_memdelim_sse2;
+#else //__SSE2__
+    return _abcdk_memdelim_scalar;
+#endif //__SSE2__
+}
+
+static const void *_abcdk_memdelim_first(const void *data, size_t size, uint8_t delim);
+
+/*
+ * 第一次调用时按CPU支持的指令集选择实现。
+ * 多线程同时第一次调用时，选择的结果相同，重复赋值不影响。
+*/
+static _abcdk_memdelim_func _abcdk_memdelim_impl = _abcdk_memdelim_first;
+
+static const void *_abcdk_memdelim_first(const void *data, size_t size, uint8_t delim)
+{
+    _abcdk_memdelim_impl = _abcdk_memdelim_select();
+
+    return _abcdk_memdelim_impl(data, size, delim);
+}
+
+const void *abcdk_memdelim(const void *data, size_t size, uint8_t delim)
+{
+    assert(data != NULL || size <= 0);
+
+    return _abcdk_memdelim_impl(data, size, delim);
+}
+
+/*------------------------------------------------------------------------------------------------*/
+
 int abcdk_fnmatch(const char *str,const char *wildcard,int caseAb,int ispath)
 {
     int flag = 0;
@@ -443,6 +600,174 @@ uint64_t abcdk_hash_bkdr64(const void* data,size_t size)
     return hash; 
 }
 
+/** WYHASH的常量。*/
+static const uint64_t _abcdk_hash_wy_secret[4] = {
+    0xa0761d6478bd642fULL, 0xe7037ed1a0b428dbULL, 0x8ebc6af09c88c6e3ULL, 0x589965cc75374cc3ULL};
+
+static inline void _abcdk_hash_wy_mum(uint64_t *a, uint64_t *b)
+{
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = (__uint128_t)*a * *b;
+
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#else //__SIZEOF_INT128__
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32), c = (t < rl);
+    uint64_t lo = t + (rm1 << 32);
+
+    c += (lo < t);
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif //__SIZEOF_INT128__
+}
+
+static inline uint64_t _abcdk_hash_wy_mix(uint64_t a, uint64_t b)
+{
+    _abcdk_hash_wy_mum(&a, &b);
+    return a ^ b;
+}
+
+static inline uint64_t _abcdk_hash_wy_r8(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t _abcdk_hash_wy_r4(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint64_t abcdk_hash_wy64(const void* data,size_t size,uint64_t seed)
+{
+    const uint64_t *s = _abcdk_hash_wy_secret;
+    const uint8_t *p = (const uint8_t *)data;
+    uint64_t a, b;
+    size_t i;
+
+    assert(data || size <= 0);
+
+    seed ^= _abcdk_hash_wy_mix(seed ^ s[0], s[1]);
+
+    if (size <= 16)
+    {
+        if (size >= 4)
+        {
+            /*首尾各读两次4字节，中间重叠。*/
+            a = (_abcdk_hash_wy_r4(p) << 32) | _abcdk_hash_wy_r4(p + ((size >> 3) << 2));
+            b = (_abcdk_hash_wy_r4(p + size - 4) << 32) | _abcdk_hash_wy_r4(p + size - 4 - ((size >> 3) << 2));
+        }
+        else if (size > 0)
+        {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[size >> 1] << 8) | p[size - 1];
+            b = 0;
+        }
+        else
+        {
+            a = b = 0;
+        }
+    }
+    else
+    {
+        i = size;
+
+        /*三路并行，互不依赖的乘法可以同时执行。*/
+        if (i > 48)
+        {
+            uint64_t see1 = seed, see2 = seed;
+
+            do
+            {
+                seed = _abcdk_hash_wy_mix(_abcdk_hash_wy_r8(p) ^ s[1], _abcdk_hash_wy_r8(p + 8) ^ seed);
+                see1 = _abcdk_hash_wy_mix(_abcdk_hash_wy_r8(p + 16) ^ s[2], _abcdk_hash_wy_r8(p + 24) ^ see1);
+                see2 = _abcdk_hash_wy_mix(_abcdk_hash_wy_r8(p + 32) ^ s[3], _abcdk_hash_wy_r8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+
+            seed ^= see1 ^ see2;
+        }
+
+        while (i > 16)
+        {
+            seed = _abcdk_hash_wy_mix(_abcdk_hash_wy_r8(p) ^ s[1], _abcdk_hash_wy_r8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+
+        /*最后16字节(与前面可能重叠)。*/
+        a = _abcdk_hash_wy_r8(p + i - 16);
+        b = _abcdk_hash_wy_r8(p + i - 8);
+    }
+
+    a ^= s[1];
+    b ^= seed;
+    _abcdk_hash_wy_mum(&a, &b);
+
+    return _abcdk_hash_wy_mix(a ^ s[0] ^ size, b ^ s[1]);
+}
+
+uint64_t abcdk_hash_mix64(uint64_t key,uint64_t seed)
+{
+    /*MurmurHash3的fmix64，每一步都是可逆的。*/
+    key ^= seed;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+
+    return key;
+}
+
+uint32_t abcdk_hash_mix32(uint32_t key,uint32_t seed)
+{
+    /*lowbias32，每一步都是可逆的。*/
+    key ^= seed;
+    key ^= key >> 16;
+    key *= 0x7feb352dU;
+    key ^= key >> 15;
+    key *= 0x846ca68bU;
+    key ^= key >> 16;
+
+    return key;
+}
+
+static uint64_t _abcdk_hash_seed = 0;
+
+uint64_t abcdk_hash_seed()
+{
+    uint64_t seed, old = 0;
+    int fd;
+
+    seed = __atomic_load_n(&_abcdk_hash_seed, __ATOMIC_RELAXED);
+    if (seed)
+        return seed;
+
+    /*系统的随机数不可用时，使用时间、进程ID和地址。*/
+    fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || read(fd, &seed, sizeof(seed)) != sizeof(seed))
+        seed = abcdk_hash_mix64(abcdk_time_clock2kind_with(CLOCK_MONOTONIC, 9) ^ ((uint64_t)getpid() << 32), (uint64_t)&seed);
+
+    if (fd >= 0)
+        close(fd);
+
+    /*0 表示未初始化。*/
+    if (!seed)
+        seed = _abcdk_hash_wy_secret[0];
+
+    /*多个线程同时初始化时，只保留第一个。*/
+    if (!__atomic_compare_exchange_n(&_abcdk_hash_seed, &old, seed, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        return old;
+
+    return seed;
+}
+
 /*------------------------------------------------------------------------------------------------*/
 
 int abcdk_endian_check(int big)
@@ -42,6 +42,13 @@ int abcdk_once(volatile int* status,int (*routine)(void *opaque),void *opaque);
  */
 void* abcdk_heap_alloc(size_t size);
 
+/**
+ * 内存申请(不清零)。
+ * 
+ * 内容未初始化，适用于申请后立即被覆盖的内存。
+ */
+void* abcdk_heap_malloc(size_t size);
+
 /**
  * 内存重新申请。
  */
@@ -184,6 +191,17 @@ char* abcdk_strrep(const char* str,const char *src, const char *dst, int caseAb)
 
 /*------------------------------------------------------------------------------------------------*/
 
+/**
+ * 查找分隔符。
+ * 
+ * 运行时按CPU支持的指令集(AVX2，SSE2)选择实现，每次比较多个字节，都不支持时逐字节比较。
+ * 
+ * @return !NULL(0) 第一个分隔符的指针，NULL(0) 未找到。
+*/
+const void *abcdk_memdelim(const void *data, size_t size, uint8_t delim);
+
+/*------------------------------------------------------------------------------------------------*/
+
 /**
  * 字符串匹配。
  * 
@@ -205,6 +223,36 @@ uint32_t abcdk_hash_bkdr(const void* data,size_t size);
 */
 uint64_t abcdk_hash_bkdr64(const void* data,size_t size);
 
+/**
+ * WYHASH(64位)。
+ * 
+ * 按8字节(长于48字节时每轮48字节)读取，使用64x64->128位的乘法混合，长KEY比BKDR快得多。
+ * 
+ * @param seed 种子。不同的种子得到不同的HASH值，使用随机的种子(abcdk_hash_seed)可以抵御HASH洪水攻击。
+*/
+uint64_t abcdk_hash_wy64(const void* data,size_t size,uint64_t seed);
+
+/**
+ * 整数混合(64位)。
+ * 
+ * 定长整数KEY(句柄、编号等)的HASH函数，输入的每个比特都会影响输出的所有比特。
+ * 
+ * @note 种子相同时，不同的输入一定得到不同的输出。
+*/
+uint64_t abcdk_hash_mix64(uint64_t key,uint64_t seed);
+
+/**
+ * 整数混合(32位)。
+*/
+uint32_t abcdk_hash_mix32(uint32_t key,uint32_t seed);
+
+/**
+ * 获取进程的随机种子。
+ * 
+ * 第一次调用时从系统的随机数生成，进程内不变。
+*/
+uint64_t abcdk_hash_seed();
+
 /*------------------------------------------------------------------------------------------------*/
 
 /**
@@ -50,11 +50,114 @@ static ssize_t _abcdk_getargs_getline(FILE *fp, char **line, size_t *len, uint8_
     return chk;
 }
 
+/*
+ * 从文本中读取一行(包括分割字符)，复制到行缓存。
+ *
+ * 与_abcdk_getargs_getline相同，跳过空行和注释行。
+*/
+static ssize_t _abcdk_getargs_getline2(const char **text, const char *end, char **line, size_t *len, uint8_t delim, char note)
+{
+    const char *line_p = NULL;
+    const char *eol = NULL;
+    size_t len2 = 0;
+    char *tmp = NULL;
+
+    while (*text < end)
+    {
+        line_p = *text;
+
+        /*向量化查找分割字符。*/
+        eol = (const char *)abcdk_memdelim(line_p, end - line_p, delim);
+        len2 = (eol ? eol - line_p + 1 : end - line_p);
+
+        *text += len2;
+
+        if (*line_p == '\0' || *line_p == note || iscntrl(*line_p))
+            continue;
+
+        if (*len < len2 + 1)
+        {
+            tmp = (char *)realloc(*line, len2 + 1);
+            if (!tmp)
+                return -1;
+
+            *line = tmp;
+            *len = len2 + 1;
+        }
+
+        memcpy(*line, line_p, len2);
+        (*line)[len2] = '\0';
+
+        return len2;
+    }
+
+    return -1;
+}
+
 int _abcdk_getargs_valtrim(int c)
 {
     return (iscntrl(c) || (c == '\"') || (c == '\''));
 }
 
+/*
+ * 解析一行。
+ *
+ * @return 0 成功，-1 失败(内存不足)。
+*/
+static int _abcdk_getargs_parse(abcdk_tree_t *opt, char *line, const char *prefix, size_t prefix_len, const char **it_key)
+{
+    char *key_p = NULL;
+    char *val_p = NULL;
+
+    if (prefix != NULL)
+    {
+        /* 去掉字符串两端所有空白字符。 */
+        abcdk_strtrim(line, isspace, 2);
+
+        if (abcdk_strncmp(line, prefix, prefix_len, 1) != 0)
+        {
+            abcdk_option_set(opt, *it_key, line);
+        }
+        else
+        {
+            if (*it_key != prefix)
+                abcdk_heap_free2((void **)it_key);
+
+            *it_key = abcdk_heap_clone(line, strlen(line) + 1);
+            if (!*it_key)
+                return -1;
+
+            abcdk_option_set(opt, *it_key, NULL);
+        }
+    }
+    else
+    {
+        /* Find key.*/
+        key_p = line;
+
+        /* Find Value.*/
+        val_p = strchr(line, '=');
+        if (!val_p)
+            val_p = strchr(line, ':');
+
+        if (val_p)
+        {
+            *val_p = '\0'; // for key end.
+            val_p += 1;
+
+            /* 去掉value两端所有控制字符、双引号、单引号。 */
+            abcdk_strtrim(val_p, _abcdk_getargs_valtrim, 2);
+        }
+
+        /* 去掉key两端所有空白字符。 */
+        abcdk_strtrim(key_p, isspace, 2);
+
+        abcdk_option_set(opt, key_p, val_p);
+    }
+
+    return 0;
+}
+
 void abcdk_getargs_fp(abcdk_tree_t *opt, FILE *fp, uint8_t delim, char note,
                       const char *argv0, const char *prefix)
 {
@@ -62,9 +165,6 @@ void abcdk_getargs_fp(abcdk_tree_t *opt, FILE *fp, uint8_t delim, char note,
     const char *it_key = NULL;
     char *line = NULL;
     size_t len = 0;
-    size_t rows = 0;
-    char *key_p = NULL;
-    char *val_p = NULL;
 
     assert(opt != NULL && fp != NULL);
 
@@ -75,55 +175,12 @@ void abcdk_getargs_fp(abcdk_tree_t *opt, FILE *fp, uint8_t delim, char note,
 
         if (argv0)
             abcdk_option_set(opt, it_key, argv0);
-
-        while (_abcdk_getargs_getline(fp, &line, &len, delim, note) != -1)
-        {
-            /* 去掉字符串两端所有空白字符。 */
-            abcdk_strtrim(line, isspace, 2);
-
-            if (abcdk_strncmp(line, prefix, prefix_len, 1) != 0)
-            {
-                abcdk_option_set(opt, it_key, line);
-            }
-            else
-            {
-                if (it_key != prefix)
-                    abcdk_heap_free2((void **)&it_key);
-
-                it_key = abcdk_heap_clone(line, len + 1);
-                if (!it_key)
-                    break;
-
-                abcdk_option_set(opt, it_key, NULL);
-            }
-        }
     }
-    else
-    {
-        while (_abcdk_getargs_getline(fp, &line, &len, delim, note) != -1)
-        {
-            /* Find key.*/
-            key_p = line;
-
-            /* Find Value.*/
-            val_p = strchr(line, '=');
-            if (!val_p)
-                val_p = strchr(line, ':');
 
-            if (val_p)
-            {
-                *val_p = '\0'; // for key end.
-                val_p += 1;
-
-                /* 去掉value两端所有控制字符、双引号、单引号。 */
-                abcdk_strtrim(val_p, _abcdk_getargs_valtrim, 2);
-            }
-
-            /* 去掉key两端所有空白字符。 */
-            abcdk_strtrim(key_p, isspace, 2);
-
-            abcdk_option_set(opt, key_p, val_p);
-        }
+    while (_abcdk_getargs_getline(fp, &line, &len, delim, note) != -1)
+    {
+        if (_abcdk_getargs_parse(opt, line, prefix, prefix_len, &it_key) != 0)
+            break;
     }
 
     /*不要忘记释放这两块内存，不然可能会有内存泄漏的风险。 */
@@ -136,31 +193,75 @@ void abcdk_getargs_fp(abcdk_tree_t *opt, FILE *fp, uint8_t delim, char note,
 void abcdk_getargs_file(abcdk_tree_t *opt, const char *file, uint8_t delim, char note,
                         const char *argv0, const char *prefix)
 {
+    abcdk_allocator_t *fmem = NULL;
     FILE *fp = NULL;
+    struct stat attr;
+    int fd = -1;
 
     assert(opt != NULL && file != NULL);
 
-    fp = fopen(file, "r");
-    if (!fp)
+    /*只打开一次，管道的数据读出后就没有了，不能先试探再重新打开。*/
+    fd = abcdk_open(file, 0, 0, 0);
+    if (fd < 0)
         return;
 
-    abcdk_getargs_fp(opt, fp, delim, note, argv0, prefix);
+    if (fstat(fd, &attr) == -1)
+        goto final;
+
+    /*有内容的普通文件映射到内存后按文本导入。*/
+    if (S_ISREG(attr.st_mode) && attr.st_size > 0)
+    {
+        fmem = abcdk_mmap(fd, 0, 0);
+        if (fmem)
+        {
+            abcdk_getargs_text(opt, (char *)fmem->pptrs[0], fmem->sizes[0], delim, note, argv0, prefix);
+            abcdk_allocator_unref(&fmem);
+            goto final;
+        }
+    }
+
+    /*其它文件(空文件、管道、proc等)按流读取，句柄交给fp关闭。*/
+    fp = fdopen(fd, "r");
+    if (!fp)
+        goto final;
 
+    fd = -1;
+    abcdk_getargs_fp(opt, fp, delim, note, argv0, prefix);
     fclose(fp);
+
+final:
+
+    abcdk_closep(&fd);
 }
 
 void abcdk_getargs_text(abcdk_tree_t *opt, const char *text, size_t len, uint8_t delim, char note,
                         const char *argv0, const char *prefix)
 {
-    FILE *fp = NULL;
+    size_t prefix_len = 0;
+    const char *it_key = NULL;
+    const char *end = text + len;
+    char *line = NULL;
+    size_t line_len = 0;
 
     assert(opt != NULL && text != NULL && len > 0);
 
-    fp = fmemopen((char *)text, len, "r");
-    if (!fp)
-        return;
+    if (prefix != NULL)
+    {
+        prefix_len = strlen(prefix);
+        it_key = prefix;
 
-    abcdk_getargs_fp(opt, fp, delim, note, argv0, prefix);
+        if (argv0)
+            abcdk_option_set(opt, it_key, argv0);
+    }
 
-    fclose(fp);
-}
\ No newline at end of file
+    while (_abcdk_getargs_getline2(&text, end, &line, &line_len, delim, note) != -1)
+    {
+        if (_abcdk_getargs_parse(opt, line, prefix, prefix_len, &it_key) != 0)
+            break;
+    }
+
+    if (line)
+        free(line);
+    if (it_key != prefix)
+        abcdk_heap_free2((void **)&it_key);
+}
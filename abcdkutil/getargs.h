@@ -9,6 +9,7 @@
 
 #include "general.h"
 #include "option.h"
+#include "mman.h"
 
 __BEGIN_DECLS
 
@@ -58,6 +59,8 @@ void abcdk_getargs_file(abcdk_tree_t *opt, const char *file, uint8_t delim, char
 /**
  * 从文本导入参数。
  * 
+ * 直接在文本中查找分割字符(向量化)，不需要经过文件流。
+ * 
  * @param text 文本的指针。
  * @param len 文本的长度。
 */
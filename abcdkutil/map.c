@@ -1,14 +1,126 @@
 /*
  * This file is part of ABCDK.
- * 
+ *
  * MIT License
- * 
+ *
 */
 #include "map.h"
 
+/** 每组的槽位数量。*/
+#define ABCDK_MAP_GROUP 16
+
+/** 控制字节：空闲。*/
+#define ABCDK_MAP_CTRL_EMPTY ((uint8_t)0x80)
+
+/** 控制字节：已删除。*/
+#define ABCDK_MAP_CTRL_DELETED ((uint8_t)0xFE)
+
+/** 负载因子(7/8)。*/
+#define ABCDK_MAP_LOAD_MAX(cap) ((cap) - (cap) / 8)
+
+/** 缩容的负载因子(7/32)，缩容后负载不超过7/16。*/
+#define ABCDK_MAP_LOAD_MIN(cap) (ABCDK_MAP_LOAD_MAX(cap) / 4)
+
+/** 预备扩容的负载因子(3/4)。*/
+#define ABCDK_MAP_LOAD_STAGE(cap) ((cap) - (cap) / 4)
+
+/** 每次添加或删除时迁移的槽位数量。*/
+#define ABCDK_MAP_MIGRATE_STEP 64
+
+/** 每次添加或删除时初始化预备表格的长度(字节)。*/
+#define ABCDK_MAP_STAGE_STEP 4096
+
+/** 旧表格已迁移的槽位，每次归还给系统的最小长度(字节)。*/
+#define ABCDK_MAP_TRIM_STEP (64 * 1024)
+
+/**
+ * 槽位。
+*/
+typedef struct _abcdk_map_slot
+{
+    /** HASH值。*/
+    uint64_t hash;
+
+    /** 元素。*/
+    abcdk_allocator_t *alloc;
+
+} abcdk_map_slot;
+
+/**
+ * 表格。
+*/
+typedef struct _abcdk_map_table
+{
+    /** 槽位。*/
+    abcdk_map_slot *slots;
+
+    /**
+     * 控制字节。
+     *
+     * 长度是容量+一组，尾部复制头部的一组，探测时不需要处理绕回。
+    */
+    uint8_t *ctrls;
+
+    /** 容量(2的幂)。*/
+    size_t capacity;
+
+    /** 元素数量。*/
+    size_t count;
+
+    /** 已删除的槽位数量。*/
+    size_t deleted;
+
+    /** 最小容量(初始化时的容量)，不会缩容到更小。*/
+    size_t floor;
+
+    /**
+     * 扩容或缩容前的表格。
+     *
+     * 元素分批迁移到当前表格，迁移完成后释放。
+    */
+    struct _abcdk_map_table *prev;
+
+    /** 旧表格的迁移游标。*/
+    size_t prev_pos;
+
+    /** 已归还给系统的槽位内存长度(字节，从头部开始)。*/
+    size_t trimmed;
+
+    /**
+     * 预备的表格。
+     *
+     * 负载超过3/4(扩容)或低于7/32(缩容)时申请，之后的添加和删除中分批初始化，
+     * 负载超过7/8或初始化完成(缩容)时替换当前表格。
+    */
+    struct _abcdk_map_table *next;
+
+    /** 预备表格已初始化的长度(字节)。*/
+    size_t next_pos;
+
+    /** !0 正在扫描，不能添加或删除。*/
+    int scanning;
+
+} abcdk_map_table;
+
 uint64_t abcdk_map_hash(const void *data, size_t size, void *opaque)
 {
-    return abcdk_hash_bkdr64(data, size);
+    uint64_t seed = abcdk_hash_seed();
+    uint64_t u64;
+    uint32_t u32;
+
+    /*定长的整数KEY直接混合。*/
+    if (size == sizeof(uint64_t))
+    {
+        memcpy(&u64, data, sizeof(u64));
+        return abcdk_hash_mix64(u64, seed);
+    }
+    else if (size == sizeof(uint32_t))
+    {
+        memcpy(&u32, data, sizeof(u32));
+        return abcdk_hash_mix64(u32, seed);
+    }
+
+    return abcdk_hash_wy64(data, size, seed);
 }
 
 int abcdk_map_compare(const void *data1, const void *data2, size_t size, void *opaque)
@@ -16,12 +128,400 @@ int abcdk_map_compare(const void *data1, const void *data2, size_t size, void *o
     return memcmp(data1, data2, size);
 }
 
+static void _abcdk_map_table_free(abcdk_map_table **table)
+{
+    abcdk_map_table *table_p;
+
+    if (!table || !*table)
+        return;
+
+    table_p = *table;
+
+    _abcdk_map_table_free(&table_p->prev);
+    _abcdk_map_table_free(&table_p->next);
+    abcdk_heap_free(table_p->slots);
+    abcdk_heap_free(table_p);
+
+    /*Set to NULL(0).*/
+    *table = NULL;
+}
+
+static size_t _abcdk_map_table_bytes(size_t capacity)
+{
+    return capacity * sizeof(abcdk_map_slot) + capacity + ABCDK_MAP_GROUP;
+}
+
+/*
+ * 初始化表格的一段内存。
+ *
+ * 槽位清零(只是为了提前触发缺页)，控制字节标记为空闲。
+ *
+ * @return 已初始化的长度(字节)。
+*/
+static size_t _abcdk_map_table_init(abcdk_map_table *table, size_t pos, size_t size)
+{
+    size_t ctrls_off = table->capacity * sizeof(abcdk_map_slot);
+    size_t end = _abcdk_map_table_bytes(table->capacity);
+
+    end = ABCDK_MIN(end - pos, size) + pos;
+
+    if (pos < ctrls_off)
+        memset(ABCDK_PTR2PTR(uint8_t, table->slots, pos), 0, ABCDK_MIN(end, ctrls_off) - pos);
+    if (end > ctrls_off)
+        memset(ABCDK_PTR2PTR(uint8_t, table->slots, ABCDK_MAX(pos, ctrls_off)), ABCDK_MAP_CTRL_EMPTY, end - ABCDK_MAX(pos, ctrls_off));
+
+    return end;
+}
+
+static abcdk_map_table *_abcdk_map_table_alloc(size_t capacity, int init)
+{
+    abcdk_map_table *table;
+
+    assert(capacity >= ABCDK_MAP_GROUP && (capacity & (capacity - 1)) == 0);
+
+    table = (abcdk_map_table *)abcdk_heap_alloc(sizeof(abcdk_map_table));
+    if (!table)
+        return NULL;
+
+    /*槽位和控制字节在同一块内存中。*/
+    table->slots = (abcdk_map_slot *)abcdk_heap_malloc(_abcdk_map_table_bytes(capacity));
+    if (!table->slots)
+    {
+        abcdk_heap_free(table);
+        return NULL;
+    }
+
+    table->ctrls = ABCDK_PTR2PTR(uint8_t, table->slots, capacity * sizeof(abcdk_map_slot));
+
+    table->capacity = capacity;
+    table->count = 0;
+    table->deleted = 0;
+    table->floor = capacity;
+    table->prev = NULL;
+    table->prev_pos = 0;
+    table->trimmed = 0;
+    table->next = NULL;
+    table->next_pos = 0;
+
+    /*槽位是写入后才读取的，立即使用时只需要初始化控制字节。*/
+    if (init)
+        memset(table->ctrls, ABCDK_MAP_CTRL_EMPTY, capacity + ABCDK_MAP_GROUP);
+
+    return table;
+}
+
+static size_t _abcdk_map_capacity(size_t count)
+{
+    size_t capacity = ABCDK_MAP_GROUP;
+
+    /*满足负载因子的最小容量。*/
+    while (ABCDK_MAP_LOAD_MAX(capacity) < count)
+        capacity <<= 1;
+
+    return capacity;
+}
+
+static inline void _abcdk_map_ctrl_set(abcdk_map_table *table, size_t pos, uint8_t ctrl)
+{
+    table->ctrls[pos] = ctrl;
+
+    /*头部的一组同时写入尾部。*/
+    table->ctrls[((pos - ABCDK_MAP_GROUP) & (table->capacity - 1)) + ABCDK_MAP_GROUP] = ctrl;
+}
+
+/*
+ * 一组控制字节的匹配结果，每个槽位一个比特。
+*/
+
+static inline uint32_t _abcdk_map_group_match(const uint8_t *ctrls, uint8_t h2)
+{
+#ifdef __SSE2__
+    __m128i group = _mm_loadu_si128((const __m128i *)ctrls);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(h2)));
+#else //__SSE2__
+    uint32_t mask = 0;
+    for (int i = 0; i < ABCDK_MAP_GROUP; i++)
+        mask |= (uint32_t)(ctrls[i] == h2) << i;
+    return mask;
+#endif //__SSE2__
+}
+
+static inline uint32_t _abcdk_map_group_empty(const uint8_t *ctrls)
+{
+    return _abcdk_map_group_match(ctrls, ABCDK_MAP_CTRL_EMPTY);
+}
+
+static inline uint32_t _abcdk_map_group_free(const uint8_t *ctrls)
+{
+#ifdef __SSE2__
+    /*空闲和已删除的最高位是1，HASH值的最高位是0。*/
+    return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrls));
+#else //__SSE2__
+    uint32_t mask = 0;
+    for (int i = 0; i < ABCDK_MAP_GROUP; i++)
+        mask |= (uint32_t)(ctrls[i] >> 7) << i;
+    return mask;
+#endif //__SSE2__
+}
+
+static ssize_t _abcdk_map_table_lookup(abcdk_map_t *map, abcdk_map_table *table, uint64_t hash, const void *key, size_t ksize)
+{
+    size_t mask = table->capacity - 1;
+    size_t pos = (hash >> 7) & mask;
+    uint8_t h2 = hash & 0x7F;
+    uint32_t bits;
+    size_t idx;
+
+    /*按组探测，步长依次增加一组，所有组都会被探测到。*/
+    for (size_t step = ABCDK_MAP_GROUP; step <= table->capacity; step += ABCDK_MAP_GROUP)
+    {
+        bits = _abcdk_map_group_match(table->ctrls + pos, h2);
+        while (bits)
+        {
+            idx = (pos + __builtin_ctz(bits)) & mask;
+            bits &= bits - 1;
+
+            if (table->slots[idx].hash != hash)
+                continue;
+            if (table->slots[idx].alloc->sizes[ABCDK_MAP_KEY] != ksize)
+                continue;
+            if (map->compare_cb(table->slots[idx].alloc->pptrs[ABCDK_MAP_KEY], key, ksize, map->opaque) == 0)
+                return idx;
+        }
+
+        /*组内有空闲槽位，探测结束。*/
+        if (_abcdk_map_group_empty(table->ctrls + pos))
+            break;
+
+        pos = (pos + step) & mask;
+    }
+
+    return -1;
+}
+
+static size_t _abcdk_map_table_insert(abcdk_map_table *table, uint64_t hash, abcdk_allocator_t *alloc)
+{
+    size_t mask = table->capacity - 1;
+    size_t pos = (hash >> 7) & mask;
+    uint32_t bits;
+    size_t idx;
+
+    /*负载因子保证一定有空闲槽位。*/
+    for (size_t step = ABCDK_MAP_GROUP;; step += ABCDK_MAP_GROUP)
+    {
+        bits = _abcdk_map_group_free(table->ctrls + pos);
+        if (bits)
+            break;
+
+        pos = (pos + step) & mask;
+    }
+
+    idx = (pos + __builtin_ctz(bits)) & mask;
+
+    if (table->ctrls[idx] == ABCDK_MAP_CTRL_DELETED)
+        table->deleted -= 1;
+
+    _abcdk_map_ctrl_set(table, idx, hash & 0x7F);
+    table->slots[idx].hash = hash;
+    table->slots[idx].alloc = alloc;
+    table->count += 1;
+
+    return idx;
+}
+
+static void _abcdk_map_table_erase(abcdk_map_table *table, size_t idx)
+{
+    size_t mask = table->capacity - 1;
+    uint32_t before, after;
+    int empty_run;
+
+    /*
+     * 前后相邻的空闲槽位不足一组时，说明探测不会越过这个槽位，可以直接标记为空闲，
+     * 否则需要标记为已删除，保证后面的元素能被探测到。
+    */
+    before = _abcdk_map_group_empty(table->ctrls + ((idx - ABCDK_MAP_GROUP) & mask));
+    after = _abcdk_map_group_empty(table->ctrls + idx);
+
+    empty_run = (before && after && (__builtin_clz(before << 16) + __builtin_ctz(after)) < ABCDK_MAP_GROUP);
+
+    if (empty_run)
+    {
+        _abcdk_map_ctrl_set(table, idx, ABCDK_MAP_CTRL_EMPTY);
+    }
+    else
+    {
+        _abcdk_map_ctrl_set(table, idx, ABCDK_MAP_CTRL_DELETED);
+        table->deleted += 1;
+    }
+
+    table->slots[idx].alloc = NULL;
+    table->count -= 1;
+}
+
+static void _abcdk_map_table_trim(abcdk_map_table *table, size_t pos)
+{
+    static size_t page = 0;
+    uintptr_t base = (uintptr_t)table->slots;
+    uintptr_t begin, end;
+
+    if (!page)
+        page = sysconf(_SC_PAGESIZE);
+
+    /*只归还完整的页面。*/
+    begin = abcdk_align(base + table->trimmed, page);
+    end = (base + pos * sizeof(abcdk_map_slot)) / page * page;
+
+    if (end <= begin || end - begin < ABCDK_MAP_TRIM_STEP)
+        return;
+
+    /*页面被再次访问时是清零的，这里不会再访问。*/
+    madvise((void *)begin, end - begin, MADV_DONTNEED);
+
+    table->trimmed = end - base;
+}
+
+static void _abcdk_map_migrate(abcdk_map_table *table, size_t step)
+{
+    abcdk_map_table *prev = table->prev;
+    size_t idx;
+
+    if (!prev)
+        return;
+
+    /*HASH值保存在槽位中，不需要重新计算。*/
+    for (; step > 0 && prev->count > 0 && table->prev_pos < prev->capacity; step--)
+    {
+        idx = table->prev_pos++;
+
+        if (prev->ctrls[idx] & 0x80)
+            continue;
+
+        _abcdk_map_table_insert(table, prev->slots[idx].hash, prev->slots[idx].alloc);
+
+        /*从旧表格中删除，保证同一个元素只在一个表格中。*/
+        _abcdk_map_table_erase(prev, idx);
+    }
+
+    /*迁移完成，释放旧表格。*/
+    if (prev->count <= 0 || table->prev_pos >= prev->capacity)
+    {
+        _abcdk_map_table_free(&table->prev);
+        return;
+    }
+
+    /*
+     * 已迁移的槽位不会再被访问(控制字节已标记为空闲或已删除)，分批归还给系统，
+     * 释放旧表格时不需要一次归还全部内存。
+    */
+    if (step != SIZE_MAX)
+        _abcdk_map_table_trim(prev, table->prev_pos);
+}
+
+static int _abcdk_map_switch(abcdk_map_t *map, size_t capacity)
+{
+    abcdk_map_table *table = map->table;
+    abcdk_map_table *table_new = table->next;
+
+    /*上一次迁移还没完成，先全部迁移。*/
+    _abcdk_map_migrate(table, SIZE_MAX);
+
+    if (table_new && table_new->capacity == capacity)
+    {
+        /*预备的表格还没初始化完成(负载增长过快)，一次完成。*/
+        table->next_pos = _abcdk_map_table_init(table_new, table->next_pos, SIZE_MAX);
+        table->next = NULL;
+    }
+    else
+    {
+        _abcdk_map_table_free(&table->next);
+
+        table_new = _abcdk_map_table_alloc(capacity, 1);
+        if (!table_new)
+            ABCDK_ERRNO_AND_RETURN1(ENOMEM, -1);
+    }
+
+    /*旧表格挂在新表格上，之后的添加和删除分批迁移，避免一次迁移全部元素的延时。*/
+    table_new->floor = table->floor;
+    table_new->prev = table;
+    table_new->prev_pos = 0;
+
+    map->table = table_new;
+
+    return 0;
+}
+
+static size_t _abcdk_map_grow_capacity(abcdk_map_table *table)
+{
+    /*已删除的槽位较多时，按原容量重建。*/
+    if (table->deleted >= table->capacity / 4)
+        return table->capacity;
+
+    return table->capacity << 1;
+}
+
+static void _abcdk_map_stage(abcdk_map_t *map)
+{
+    abcdk_map_table *table = map->table;
+    size_t capacity = 0;
+    int shrink;
+
+    /*负载过低时缩容(同时清除已删除的槽位)，不小于初始化时的容量。*/
+    shrink = (table->capacity > table->floor && table->count < ABCDK_MAP_LOAD_MIN(table->capacity));
+
+    if (shrink)
+        capacity = table->capacity / 2;
+    else if (table->count + table->deleted >= ABCDK_MAP_LOAD_STAGE(table->capacity))
+        capacity = _abcdk_map_grow_capacity(table);
+
+    /*负载变化后，预备的表格不再适用。*/
+    if (table->next && table->next->capacity != capacity)
+        _abcdk_map_table_free(&table->next);
+
+    if (capacity <= 0)
+        return;
+
+    /*
+     * 提前申请下一个表格，在之后的添加和删除中分批初始化，避免一次初始化全部内存的延时。
+     * 负载从3/4增长到7/8至少需要1/8容量次添加，每次初始化的长度远大于平均需要的长度。
+     * 申请失败时，扩容时再申请。
+    */
+    if (!table->next)
+    {
+        table->next = _abcdk_map_table_alloc(capacity, 0);
+        table->next_pos = 0;
+        return;
+    }
+
+    if (table->next_pos < _abcdk_map_table_bytes(capacity))
+    {
+        table->next_pos = _abcdk_map_table_init(table->next, table->next_pos, ABCDK_MAP_STAGE_STEP);
+        return;
+    }
+
+    /*缩容的表格初始化完成，并且上一次迁移已经完成，替换当前表格。*/
+    if (shrink && !table->prev)
+        _abcdk_map_switch(map, capacity);
+}
+
 void abcdk_map_destroy(abcdk_map_t *map)
 {
+    abcdk_map_table *table;
+
     assert(map);
 
-    /* 全部释放。*/
-    abcdk_tree_free(&map->table);
+    /* 全部释放(包括迁移中的旧表格)。*/
+    for (table = map->table; table; table = table->prev)
+    {
+        for (size_t i = 0; i < table->capacity; i++)
+        {
+            if (table->ctrls[i] & 0x80)
+                continue;
+
+            abcdk_allocator_unref(&table->slots[i].alloc);
+        }
+    }
+
+    _abcdk_map_table_free(&map->table);
 
     memset(map, 0, sizeof(*map));
 }
@@ -30,8 +530,8 @@ int abcdk_map_init(abcdk_map_t *map, size_t size)
 {
     assert(map && size > 0);
 
-    /* 创建树节点，用于表格。 */
-    map->table = abcdk_tree_alloc2(NULL, size,0);
+    /* 创建表格。 */
+    map->table = _abcdk_map_table_alloc(_abcdk_map_capacity(size), 1);
 
     if (!map->table)
         ABCDK_ERRNO_AND_RETURN1(ENOMEM, -1);
@@ -45,126 +545,148 @@ int abcdk_map_init(abcdk_map_t *map, size_t size)
     return 0;
 }
 
-static abcdk_tree_t *_abcdk_map_find(abcdk_map_t *map, const void *key, size_t ksize, size_t vsize)
+size_t abcdk_map_count(abcdk_map_t *map)
 {
-    abcdk_tree_t *it = NULL;
-    abcdk_tree_t *node = NULL;
-    uint64_t hash = 0;
-    uint64_t bucket = -1;
-    int chk = 0;
-
-    assert(map && key && ksize > 0);
+    assert(map && map->table);
 
-    assert(map->table);
-    assert(map->hash_cb);
-    assert(map->compare_cb);
+    return map->table->count + (map->table->prev ? map->table->prev->count : 0);
+}
 
-    hash = map->hash_cb(key, ksize, map->opaque);
-    bucket = hash % map->table->alloc->numbers;
+size_t abcdk_map_capacity(abcdk_map_t *map)
+{
+    assert(map && map->table);
 
-    /* 查找桶，不存在则创建。*/
-    it = (abcdk_tree_t *)map->table->alloc->pptrs[bucket];
-    if (!it)
-    {
-        it = abcdk_tree_alloc3(sizeof(bucket));
-        if (it)
-        {
-            /*存放桶的索引值。*/
-            ABCDK_PTR2OBJ(uint64_t, it->alloc->pptrs[ABCDK_MAP_BUCKET], 0) = bucket;
+    return map->table->capacity;
+}
 
-            /* 桶加入到表格中。*/
-            abcdk_tree_insert2(map->table, it, 0);
-            map->table->alloc->pptrs[bucket] = (uint8_t *)it;
-        }
-    }
+static abcdk_allocator_t *_abcdk_map_create(abcdk_map_t *map, uint64_t hash, const void *key, size_t ksize, size_t vsize)
+{
+    abcdk_map_table *table = map->table;
+    abcdk_allocator_t *alloc = NULL;
+    size_t sizes[2] = {ksize, vsize};
 
-    if (!it)
-        ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+    /*扫描期间添加会移动或迁移元素，遍历会遗漏或重复。*/
+    assert(!table->scanning);
 
-    /* 链表存储的节点，依次比较查找。*/
-    node = abcdk_tree_child(it, 1);
-    while (node)
+    /*超过负载因子，扩容；已删除的槽位较多时，按原容量重建。*/
+    if (table->count + table->deleted + 1 > ABCDK_MAP_LOAD_MAX(table->capacity))
     {
-        if (node->alloc->sizes[ABCDK_MAP_KEY] == ksize)
-        {
-            chk = map->compare_cb(node->alloc->pptrs[ABCDK_MAP_KEY], key, ksize, map->opaque);
-            if (chk == 0)
-                break;
-        }
-
-        node = abcdk_tree_sibling(node, 0);
+        if (_abcdk_map_switch(map, _abcdk_map_grow_capacity(table)) != 0)
+            return NULL;
     }
 
-    /*如果节点不存在并且需要创建，则添加到链表头。 */
-    if (!node && vsize > 0)
-    {
-        size_t sizes[2] = {ksize, vsize};
-        node = abcdk_tree_alloc2(sizes, 2,0);
+    /*KEY和VALUE在同一块内存中。*/
+    alloc = abcdk_allocator_alloc(sizes, 2, 0);
+    if (!alloc)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
 
-        if (!node)
-            ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+    /* 注册数据节点的析构函数。*/
+    if (map->destructor_cb)
+        abcdk_allocator_atfree(alloc, map->destructor_cb, map->opaque);
 
-        /* 注册数据节点的析构函数。*/
-        if (map->destructor_cb)
-            abcdk_allocator_atfree(node->alloc, map->destructor_cb, map->opaque);
+    /*复制KEY。*/
+    memcpy(alloc->pptrs[ABCDK_MAP_KEY], key, ksize);
 
-        /*复制KEY。*/
-        memcpy(node->alloc->pptrs[ABCDK_MAP_KEY], key, ksize);
+    /*也许有构造函数要处理一下。*/
+    if (map->construct_cb)
+        map->construct_cb(alloc, map->opaque);
 
-        /*也许有构造函数要处理一下。*/
-        if(map->construct_cb)
-            map->construct_cb(node->alloc,map->opaque);
+    _abcdk_map_table_insert(map->table, hash, alloc);
 
-        /* 加入到链表头。 */
-        abcdk_tree_insert2(it, node, 1);
-    }
+    /*分批迁移，分批初始化预备的表格。*/
+    _abcdk_map_migrate(map->table, ABCDK_MAP_MIGRATE_STEP);
+    _abcdk_map_stage(map);
 
-    return node;
+    return alloc;
 }
 
 abcdk_allocator_t *abcdk_map_find(abcdk_map_t *map, const void *key, size_t ksize, size_t vsize)
 {
-    abcdk_tree_t *node = _abcdk_map_find(map, key, ksize, vsize);
+    uint64_t hash;
+    ssize_t idx;
 
-    if (node)
-        return node->alloc;
+    assert(map && key && ksize > 0);
+    assert(map->table && map->hash_cb && map->compare_cb);
+
+    hash = map->hash_cb(key, ksize, map->opaque);
+
+    idx = _abcdk_map_table_lookup(map, map->table, hash, key, ksize);
+    if (idx >= 0)
+        return map->table->slots[idx].alloc;
+
+    /*迁移中，再查找旧表格。*/
+    if (map->table->prev)
+    {
+        idx = _abcdk_map_table_lookup(map, map->table->prev, hash, key, ksize);
+        if (idx >= 0)
+            return map->table->prev->slots[idx].alloc;
+    }
+
+    /*如果节点不存在并且需要创建。*/
+    if (vsize > 0)
+        return _abcdk_map_create(map, hash, key, ksize, vsize);
 
     ABCDK_ERRNO_AND_RETURN1(EAGAIN, NULL);
 }
 
 void abcdk_map_remove(abcdk_map_t *map, const void *key, size_t ksize)
 {
-    abcdk_tree_t *node = NULL;
+    abcdk_map_table *table;
+    abcdk_allocator_t *alloc;
+    uint64_t hash;
+    ssize_t idx;
 
     assert(map);
     assert(map->table && map->hash_cb && map->compare_cb);
     assert(key && ksize > 0);
+    assert(!map->table->scanning);
+
+    hash = map->hash_cb(key, ksize, map->opaque);
 
-    node = _abcdk_map_find(map, key, ksize, 0);
-    if (node)
+    /*迁移中，元素可能在旧表格中。*/
+    for (table = map->table; table; table = table->prev)
     {
-        abcdk_tree_unlink(node);
-        abcdk_tree_free(&node);
+        idx = _abcdk_map_table_lookup(map, table, hash, key, ksize);
+        if (idx >= 0)
+            break;
     }
-}
 
-static int _abcdk_map_scan_cb(size_t depth, abcdk_tree_t *node, void *opaque)
-{
-    abcdk_map_t *map = (abcdk_map_t *)opaque;
+    if (!table)
+        return;
+
+    alloc = table->slots[idx].alloc;
+    _abcdk_map_table_erase(table, idx);
 
-    /*跳过组织结构。*/
-    if (depth <= 1)
-        return 1;
+    abcdk_allocator_unref(&alloc);
 
-    return map->dump_cb(node->alloc, map->opaque);
+    /*分批迁移，负载过低时缩容(不小于初始化时的容量)。*/
+    _abcdk_map_migrate(map->table, ABCDK_MAP_MIGRATE_STEP);
+    _abcdk_map_stage(map);
 }
 
 void abcdk_map_scan(abcdk_map_t *map)
 {
-    assert(map != NULL);
+    abcdk_map_table *table;
+
+    assert(map != NULL && map->table != NULL);
     assert(map->dump_cb != NULL);
 
-    abcdk_tree_iterator_t it = {0,_abcdk_map_scan_cb,(void*)map};
+    map->table->scanning = 1;
 
-    abcdk_tree_scan(map->table,&it);
-}
\ No newline at end of file
+    /*迁移中，两个表格都要遍历。*/
+    for (table = map->table; table; table = table->prev)
+    {
+        for (size_t i = 0; i < table->capacity; i++)
+        {
+            if (table->ctrls[i] & 0x80)
+                continue;
+
+            if (map->dump_cb(table->slots[i].alloc, map->opaque) < 0)
+                goto final;
+        }
+    }
+
+final:
+
+    map->table->scanning = 0;
+}
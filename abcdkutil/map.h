@@ -12,19 +12,31 @@
 
 __BEGIN_DECLS
 
+/**
+ * MAP的表格。
+*/
+typedef struct _abcdk_map_table abcdk_map_table;
+
 /**
  * MAP。
  * 
- * HASH和DEQUE存储结构。
+ * 开放寻址的HASH表。槽位按16个一组探测，每个槽位有一个控制字节(空闲、已删除或HASH值的低7位)，
+ * 先比较一组控制字节，匹配后再比较KEY。
+ * 
+ * 每个元素(KEY和VALUE)只申请一次内存，元素的地址在删除之前不会改变。
+ * 
+ * 负载超过7/8时扩容，低于7/32时缩容(不小于初始化时的容量)。扩容和缩容时，旧表格中的元素
+ * 在之后的添加和删除中分批迁移，迁移期间查找需要探测两个表格。新表格在负载达到3/4时预先申请，
+ * 之后每次添加或删除初始化一部分；旧表格中已迁移的部分随迁移逐步归还给系统。
 */
 typedef struct _abcdk_map
 {
     /**
      * 表格。
      * 
-     * @note 尽量不要直接修改。
+     * @note 不透明的指针。以前是abcdk_tree_t*(桶和链表)，不能再直接遍历，使用abcdk_map_scan。
     */
-    abcdk_tree_t *table;
+    abcdk_map_table *table;
 
     /**
      * KEY哈希函数。
@@ -86,6 +98,10 @@ enum _abcdk_map_field
 
 /**
  * HASH函数。
+ * 
+ * 4字节和8字节的KEY使用整数混合，其它长度使用WYHASH，种子是进程的随机种子。
+ * 
+ * @note 不同进程中，相同KEY的HASH值不同。
 */
 uint64_t abcdk_map_hash(const void* data,size_t size,void *opaque);
 
@@ -104,10 +120,24 @@ void abcdk_map_destroy(abcdk_map_t* map);
 /**
  * 初始化。
  * 
+ * @param size 预计的元素数量。表格满了会自动扩容，也不会缩容到小于这个数量。
+ * 
+ * @note 以前是桶的数量，现在是元素数量，容量按负载不超过7/8向上取2的幂。
+ * 
  * @return 0 成功，!0 失败。
 */
 int abcdk_map_init(abcdk_map_t* map,size_t size);
 
+/**
+ * 获取元素数量。
+*/
+size_t abcdk_map_count(abcdk_map_t *map);
+
+/**
+ * 获取容量(槽位数量)。
+*/
+size_t abcdk_map_capacity(abcdk_map_t *map);
+
 /**
  * 查找或创建。
  * 
@@ -127,7 +157,10 @@ void abcdk_map_remove(abcdk_map_t* map,const void* key,size_t ksize);
 /**
  * 扫描节点。
  * 
- * 深度优先遍历节点。
+ * 按槽位顺序遍历节点。
+ * 
+ * @note 回显函数中不能添加或删除节点(以前可以)，添加或删除会移动元素，遍历会遗漏或重复。
+ * 调试版本中断言失败。
 */
 void abcdk_map_scan(abcdk_map_t *map);
 
@@ -37,6 +37,8 @@ enum _abcdk_option_field
  * @param value 值的指针，可以为NULL0)。
  * 
  * 支持一对多键值组合，相同键的值次序由添加顺序决定。
+ * 
+ * @note 选项节点从堆申请，删除后立即回收，opt不能是区域(abcdk_tree_arena_alloc)中的节点。
 */
 int abcdk_option_set(abcdk_tree_t *opt, const char *key, const char *value);
 
@@ -19,7 +19,8 @@ int abcdk_pool_init(abcdk_pool_t *pool, size_t size, size_t number)
 {
     assert(pool != NULL && size > 0 && number > 0);
 
-    pool->table = abcdk_allocator_alloc(&size, number, 1);
+    /*池子中的元素总是先写入再读取，不需要清零。*/
+    pool->table = abcdk_allocator_alloc3(&size, number, 1, ABCDK_ALLOCATOR_UNINIT);
     if (!pool->table)
         return -1;
 
@@ -30,6 +31,34 @@ int abcdk_pool_init(abcdk_pool_t *pool, size_t size, size_t number)
     return 0;
 }
 
+int abcdk_pool_expand(abcdk_pool_t *pool, size_t number)
+{
+    abcdk_allocator_t *table_new = NULL;
+    size_t pos;
+
+    assert(pool != NULL && pool->table != NULL && number >= pool->count);
+
+    table_new = abcdk_allocator_alloc3(pool->table->sizes, number, 1, ABCDK_ALLOCATOR_UNINIT);
+    if (!table_new)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, -1);
+
+    /*按拉取顺序复制到新池子的头部。*/
+    for (size_t i = 0; i < pool->count; i++)
+    {
+        pos = (pool->pull_pos + i) % pool->table->numbers;
+        memcpy(table_new->pptrs[i], pool->table->pptrs[pos], pool->table->sizes[pos]);
+    }
+
+    abcdk_allocator_unref(&pool->table);
+    pool->table = table_new;
+
+    /*重置游标。*/
+    pool->pull_pos = 0;
+    pool->push_pos = pool->count % number;
+
+    return 0;
+}
+
 ssize_t abcdk_pool_pull(abcdk_pool_t *pool, void *buf, size_t size)
 {
     ssize_t len = -1;
@@ -75,3 +104,73 @@ ssize_t abcdk_pool_push(abcdk_pool_t *pool, const void *buf, size_t size)
 
     return len;
 }
+
+void *abcdk_pool_reserve(abcdk_pool_t *pool, size_t *number)
+{
+    size_t want, len;
+
+    assert(pool != NULL && pool->table != NULL);
+
+    want = (number ? *number : 1);
+    assert(want > 0);
+
+    /*池不能是满的。*/
+    if (pool->count >= pool->table->numbers)
+        return NULL;
+
+    /*空闲的元素在推送游标到表尾之间是连续的，绕回表头后需要再次预留。*/
+    len = ABCDK_MIN(pool->table->numbers - pool->count, pool->table->numbers - pool->push_pos);
+
+    if (number)
+        *number = ABCDK_MIN(want, len);
+
+    return pool->table->pptrs[pool->push_pos];
+}
+
+void abcdk_pool_commit(abcdk_pool_t *pool, size_t number)
+{
+    assert(pool != NULL && pool->table != NULL);
+    assert(number <= pool->table->numbers - pool->count);
+    assert(number <= pool->table->numbers - pool->push_pos);
+
+    /*队列长度增加。*/
+    pool->count += number;
+
+    /*滚动游标。*/
+    pool->push_pos = (pool->push_pos + number) % pool->table->numbers;
+}
+
+void *abcdk_pool_peek(abcdk_pool_t *pool, size_t *number)
+{
+    size_t want, len;
+
+    assert(pool != NULL && pool->table != NULL);
+
+    want = (number ? *number : 1);
+    assert(want > 0);
+
+    /*池不能是空的。*/
+    if (pool->count <= 0)
+        return NULL;
+
+    /*数据在拉取游标到表尾之间是连续的，绕回表头后需要再次查看。*/
+    len = ABCDK_MIN(pool->count, pool->table->numbers - pool->pull_pos);
+
+    if (number)
+        *number = ABCDK_MIN(want, len);
+
+    return pool->table->pptrs[pool->pull_pos];
+}
+
+void abcdk_pool_release(abcdk_pool_t *pool, size_t number)
+{
+    assert(pool != NULL && pool->table != NULL);
+    assert(number <= pool->count);
+    assert(number <= pool->table->numbers - pool->pull_pos);
+
+    /*队列长度减少。*/
+    pool->count -= number;
+
+    /*滚动游标。*/
+    pool->pull_pos = (pool->pull_pos + number) % pool->table->numbers;
+}
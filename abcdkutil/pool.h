@@ -65,6 +65,17 @@ void abcdk_pool_destroy(abcdk_pool_t *pool);
 */
 int abcdk_pool_init(abcdk_pool_t *pool, size_t size, size_t number);
 
+/**
+ * 扩容。
+ * 
+ * 保持池内数据的顺序不变。
+ * 
+ * @param number 新的数量。不能小于池内数据的数量。
+ * 
+ * @return 0 成功，!0 失败(原池不变)。
+*/
+int abcdk_pool_expand(abcdk_pool_t *pool, size_t number);
+
 /**
  * 拉取数据。
  * 
@@ -81,6 +92,48 @@ ssize_t abcdk_pool_pull(abcdk_pool_t *pool, void *buf, size_t size);
 */
 ssize_t abcdk_pool_push(abcdk_pool_t *pool, const void *buf, size_t size);
 
+/**
+ * 预留推送空间。
+ *
+ * 返回推送游标处的元素指针，调用者直接在池内构造数据，然后调用abcdk_pool_commit提交。
+ * 连续的多个元素首尾相接，第i个元素的地址是：指针 + i * 元素大小。
+ *
+ * @note 提交之前不能推送、扩容或销毁。
+ *
+ * @param number 数量。NULL(0) 预留1个。输入期望的数量，输出连续可写的数量(不超过期望的数量)。
+ *
+ * @return !NULL(0) 成功(第一个元素的指针)，NULL(0) 失败(满了)。
+*/
+void *abcdk_pool_reserve(abcdk_pool_t *pool, size_t *number);
+
+/**
+ * 提交推送。
+ *
+ * @param number 数量。不能超过预留的数量。
+*/
+void abcdk_pool_commit(abcdk_pool_t *pool, size_t number);
+
+/**
+ * 查看待拉取的数据。
+ *
+ * 返回拉取游标处的元素指针，调用者直接在池内读取数据，然后调用abcdk_pool_release释放。
+ * 连续的多个元素首尾相接，第i个元素的地址是：指针 + i * 元素大小。
+ *
+ * @note 释放之前不能拉取、扩容或销毁。
+ *
+ * @param number 数量。NULL(0) 查看1个。输入期望的数量，输出连续可读的数量(不超过期望的数量)。
+ *
+ * @return !NULL(0) 成功(第一个元素的指针)，NULL(0) 失败(空了)。
+*/
+void *abcdk_pool_peek(abcdk_pool_t *pool, size_t *number);
+
+/**
+ * 释放已查看的数据。
+ *
+ * @param number 数量。不能超过查看的数量。
+*/
+void abcdk_pool_release(abcdk_pool_t *pool, size_t number);
+
 __END_DECLS
 
 #endif //ABCDKUTIL_POOL_H
\ No newline at end of file
@@ -0,0 +1,210 @@
+/*
+ * This file is part of ABCDK.
+ *
+ * MIT License
+ *
+ */
+#include "ring.h"
+
+/** 缓存行长度。*/
+#define ABCDK_RING_CACHELINE 64
+
+/**
+ * 槽位头部。
+ *
+ * 序号等于推送游标时可写，等于推送游标+1时可读。
+*/
+typedef struct _abcdk_ring_slot
+{
+    /** 序号。*/
+    uint64_t seq;
+
+} abcdk_ring_slot;
+
+/**
+ * 无锁的环形池子。
+*/
+typedef struct _abcdk_ring
+{
+    /** 推送游标。*/
+    uint64_t push_pos __attribute__((aligned(ABCDK_RING_CACHELINE)));
+
+    /** 拉取游标。*/
+    uint64_t pull_pos __attribute__((aligned(ABCDK_RING_CACHELINE)));
+
+    /** 槽位表(只读部分)。*/
+    uint8_t *slots __attribute__((aligned(ABCDK_RING_CACHELINE)));
+
+    /** 槽位长度(包括头部，8字节对齐)。*/
+    size_t stride;
+
+    /** 元素大小。*/
+    size_t size;
+
+    /** 容量掩码(容量-1)。*/
+    uint64_t mask;
+
+    /** 并发模式。*/
+    int mode;
+
+} abcdk_ring_t;
+
+#define ABCDK_RING_SLOT(ring, pos) \
+    ABCDK_PTR2PTR(abcdk_ring_slot, (ring)->slots, ((pos) & (ring)->mask) * (ring)->stride)
+
+#define ABCDK_RING_SLOT_DATA(slot) \
+    ABCDK_PTR2VPTR((slot), sizeof(abcdk_ring_slot))
+
+void abcdk_ring_free(abcdk_ring_t **ring)
+{
+    abcdk_ring_t *ring_p;
+
+    if (!ring || !*ring)
+        return;
+
+    ring_p = *ring;
+
+    abcdk_heap_free(ring_p->slots);
+    abcdk_heap_free(ring_p);
+
+    /*Set to NULL(0).*/
+    *ring = NULL;
+}
+
+abcdk_ring_t *abcdk_ring_alloc(size_t size, size_t number, int mode)
+{
+    abcdk_ring_t *ring = NULL;
+    uint64_t cap = 1;
+
+    assert(size > 0 && number > 0);
+    assert(mode == ABCDK_RING_MPMC || mode == ABCDK_RING_SPSC || mode == ABCDK_RING_MPSC);
+
+    while (cap < number)
+        cap <<= 1;
+
+    if (posix_memalign((void **)&ring, ABCDK_RING_CACHELINE, sizeof(abcdk_ring_t)) != 0)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+
+    memset(ring, 0, sizeof(*ring));
+
+    ring->size = size;
+    ring->stride = abcdk_align(sizeof(abcdk_ring_slot) + size, sizeof(uint64_t));
+    ring->mask = cap - 1;
+    ring->mode = mode;
+
+    if (posix_memalign((void **)&ring->slots, ABCDK_RING_CACHELINE, cap * ring->stride) != 0)
+        goto final_error;
+
+    /*槽位的初始序号等于槽位的位置(可写)。*/
+    for (uint64_t i = 0; i < cap; i++)
+        ABCDK_RING_SLOT(ring, i)->seq = i;
+
+    return ring;
+
+final_error:
+
+    abcdk_ring_free(&ring);
+
+    ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+}
+
+size_t abcdk_ring_capacity(abcdk_ring_t *ring)
+{
+    assert(ring != NULL);
+
+    return ring->mask + 1;
+}
+
+size_t abcdk_ring_count(abcdk_ring_t *ring)
+{
+    uint64_t push_pos, pull_pos;
+
+    assert(ring != NULL);
+
+    pull_pos = __atomic_load_n(&ring->pull_pos, __ATOMIC_ACQUIRE);
+    push_pos = __atomic_load_n(&ring->push_pos, __ATOMIC_ACQUIRE);
+
+    return (push_pos > pull_pos ? push_pos - pull_pos : 0);
+}
+
+static abcdk_ring_slot *_abcdk_ring_claim(abcdk_ring_t *ring, uint64_t *cursor, uint64_t offset, int single)
+{
+    abcdk_ring_slot *slot;
+    uint64_t pos, seq;
+    int64_t diff;
+
+    pos = __atomic_load_n(cursor, __ATOMIC_RELAXED);
+
+    for (;;)
+    {
+        slot = ABCDK_RING_SLOT(ring, pos);
+        seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        diff = (int64_t)(seq - (pos + offset));
+
+        /*序号落后，推送时是满了，拉取时是空了。*/
+        if (diff < 0)
+            return NULL;
+
+        /*序号超前，其它线程已经占用了这个位置，重新读取游标。*/
+        if (diff > 0)
+        {
+            pos = __atomic_load_n(cursor, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        /*单线程端不存在竞争，直接移动游标。*/
+        if (single)
+        {
+            __atomic_store_n(cursor, pos + 1, __ATOMIC_RELAXED);
+            return slot;
+        }
+
+        /*失败时pos被更新为最新的游标。*/
+        if (__atomic_compare_exchange_n(cursor, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            return slot;
+    }
+}
+
+ssize_t abcdk_ring_pull(abcdk_ring_t *ring, void *buf, size_t size)
+{
+    abcdk_ring_slot *slot;
+    uint64_t seq;
+    ssize_t len;
+
+    assert(ring != NULL && buf != NULL && size > 0);
+
+    slot = _abcdk_ring_claim(ring, &ring->pull_pos, 1, ring->mode != ABCDK_RING_MPMC);
+    if (!slot)
+        return -1;
+
+    len = ABCDK_MIN(ring->size, size);
+    memcpy(buf, ABCDK_RING_SLOT_DATA(slot), len);
+
+    /*槽位序号前进一圈，下一圈的推送可写。*/
+    seq = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->seq, seq + ring->mask, __ATOMIC_RELEASE);
+
+    return len;
+}
+
+ssize_t abcdk_ring_push(abcdk_ring_t *ring, const void *buf, size_t size)
+{
+    abcdk_ring_slot *slot;
+    uint64_t seq;
+    ssize_t len;
+
+    assert(ring != NULL && buf != NULL && size > 0);
+
+    slot = _abcdk_ring_claim(ring, &ring->push_pos, 0, ring->mode == ABCDK_RING_SPSC);
+    if (!slot)
+        return -1;
+
+    len = ABCDK_MIN(ring->size, size);
+    memcpy(ABCDK_RING_SLOT_DATA(slot), buf, len);
+
+    /*槽位序号加1，拉取可读。*/
+    seq = __atomic_load_n(&slot->seq, __ATOMIC_RELAXED);
+    __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELEASE);
+
+    return len;
+}
@@ -0,0 +1,92 @@
+/*
+ * This file is part of ABCDK.
+ *
+ * MIT License
+ *
+ */
+#ifndef ABCDKUTIL_RING_H
+#define ABCDKUTIL_RING_H
+
+#include "general.h"
+
+__BEGIN_DECLS
+
+/**
+ * 无锁的环形池子。
+ *
+ * 与abcdk_pool_t的推送和拉取规则相同(定长元素，先进先出，满了推送失败，空了拉取失败)，
+ * 多线程访问不需要加锁。
+ *
+ * 每个槽位带有序号，生产者和消费者通过序号判断槽位是否可写或可读，游标各自占用一个缓存行。
+*/
+typedef struct _abcdk_ring abcdk_ring_t;
+
+/**
+ * 环形池子的并发模式。
+*/
+enum _abcdk_ring_mode
+{
+    /** 多生产者，多消费者。*/
+    ABCDK_RING_MPMC = 0,
+#define ABCDK_RING_MPMC ABCDK_RING_MPMC
+
+    /** 单生产者，单消费者。推送和拉取都不需要原子交换。*/
+    ABCDK_RING_SPSC = 1,
+#define ABCDK_RING_SPSC ABCDK_RING_SPSC
+
+    /** 多生产者，单消费者。拉取不需要原子交换。*/
+    ABCDK_RING_MPSC = 2
+#define ABCDK_RING_MPSC ABCDK_RING_MPSC
+};
+
+/**
+ * 销毁。
+ *
+ * @warning 没有线程在推送或拉取时才能销毁。
+*/
+void abcdk_ring_free(abcdk_ring_t **ring);
+
+/**
+ * 创建。
+ *
+ * @param size 元素大小。
+ * @param number 数量。向上取整到2的幂。
+ * @param mode 并发模式。见ABCDK_RING_*。
+ *
+ * @return !NULL(0) 成功，NULL(0) 失败。
+*/
+abcdk_ring_t *abcdk_ring_alloc(size_t size, size_t number, int mode);
+
+/**
+ * 获取容量(元素数量)。
+*/
+size_t abcdk_ring_capacity(abcdk_ring_t *ring);
+
+/**
+ * 获取队列长度。
+ *
+ * @note 多线程访问时仅供参考。
+*/
+size_t abcdk_ring_count(abcdk_ring_t *ring);
+
+/**
+ * 拉取数据。
+ *
+ * @note SPSC和MPSC模式，同一时间只能有一个线程拉取。
+ *
+ * @return >= 0 成功(读取数据长度)，< 0 失败(空了)。
+*/
+ssize_t abcdk_ring_pull(abcdk_ring_t *ring, void *buf, size_t size);
+
+/**
+ * 推送数据。
+ *
+ * @note SPSC模式，同一时间只能有一个线程推送。
+ *
+ * @return >= 0 成功(写入数据长度)，< 0 失败(满了)。
+*/
+ssize_t abcdk_ring_push(abcdk_ring_t *ring, const void *buf, size_t size);
+
+__END_DECLS
+
+#endif //ABCDKUTIL_RING_H
@@ -0,0 +1,532 @@
+/*
+ * This file is part of ABCDK.
+ *
+ * MIT License
+ *
+ */
+#include "slab.h"
+
+/** 页长度(2的幂)。*/
+#define ABCDK_SLAB_PAGE_SHIFT 16
+#define ABCDK_SLAB_PAGE_SIZE (1UL << ABCDK_SLAB_PAGE_SHIFT)
+
+/** 分类数量。*/
+#define ABCDK_SLAB_CLASSES 28
+
+/** 弹匣的最大容量(内存块数量)。*/
+#define ABCDK_SLAB_MAG_MAX 64
+
+/** 弹匣的目标长度(字节)。*/
+#define ABCDK_SLAB_MAG_BYTES 16384
+
+/** 计数器增加(仅所属线程调用)。*/
+#define ABCDK_SLAB_COUNTER_ADD(ptr, n) \
+    __atomic_store_n((ptr), *(ptr) + (n), __ATOMIC_RELAXED)
+
+/** 计数器读取。*/
+#define ABCDK_SLAB_COUNTER_GET(ptr) \
+    __atomic_load_n((ptr), __ATOMIC_RELAXED)
+
+/**
+ * 分类的大小。
+ *
+ * 128以内按16递增，之后每个2的幂之间分为4级。
+*/
+static const uint32_t _abcdk_slab_class_size[ABCDK_SLAB_CLASSES] = {
+    16, 32, 48, 64, 80, 96, 112, 128,
+    160, 192, 224, 256,
+    320, 384, 448, 512,
+    640, 768, 896, 1024,
+    1280, 1536, 1792, 2048,
+    2560, 3072, 3584, 4096};
+
+/**
+ * 线程缓存的分类槽。
+*/
+typedef struct _abcdk_slab_bin
+{
+    /** 空闲链表(内存块的第一个字是下一个内存块的指针)。*/
+    void *head;
+
+    /** 空闲链表的长度。*/
+    uint32_t count;
+
+    /** 正在切分的页的游标。*/
+    uint8_t *carve;
+
+    /** 正在切分的页的末尾(可切分部分)。*/
+    uint8_t *carve_end;
+
+} abcdk_slab_bin;
+
+/**
+ * 线程缓存。
+*/
+typedef struct _abcdk_slab_cache
+{
+    /** 链表(用于统计)。*/
+    struct _abcdk_slab_cache *prev;
+    struct _abcdk_slab_cache *next;
+
+    /** 分类槽。*/
+    abcdk_slab_bin bins[ABCDK_SLAB_CLASSES];
+
+    /** 申请的次数(按分类)。*/
+    uint64_t alloc_count[ABCDK_SLAB_CLASSES];
+
+    /** 释放的次数(按分类)。*/
+    uint64_t free_count[ABCDK_SLAB_CLASSES];
+
+    /** 转交给堆申请的次数。*/
+    uint64_t heap_count;
+
+} abcdk_slab_cache;
+
+/**
+ * 全局仓库的分类槽。
+*/
+typedef struct _abcdk_slab_depot
+{
+    /** 互斥量。*/
+    abcdk_mutex_t mutex;
+
+    /** 满弹匣链表(弹匣第一个内存块的第二个字是下一个弹匣的指针)。*/
+    void *mags;
+
+    /** 零散的内存块链表(线程退出时归还的)。*/
+    void *loose;
+
+    /** 线程退出时未切分完的页。*/
+    uint8_t *carve;
+    uint8_t *carve_end;
+
+} abcdk_slab_depot;
+
+/**
+ * 全局环境。
+*/
+typedef struct _abcdk_slab_global
+{
+    /** 线程缓存的键(用于线程退出时归还)。*/
+    pthread_key_t key;
+
+    /** 预留地址空间的起始地址。NULL(0) 不可用。*/
+    uint8_t *base;
+
+    /** 预留地址空间的长度。*/
+    size_t size;
+
+    /** 已切分的长度。*/
+    volatile size_t used;
+
+    /** 按页索引的分类表。*/
+    uint8_t *page_class;
+
+    /** 按长度(16字节对齐)索引的分类表。*/
+    uint8_t size_class[ABCDK_SLAB_SIZE_MAX / 16 + 1];
+
+    /** 全局仓库。*/
+    abcdk_slab_depot depot[ABCDK_SLAB_CLASSES];
+
+    /** 互斥量(保护线程缓存链表和已退出线程的计数器)。*/
+    abcdk_mutex_t mutex;
+
+    /** 线程缓存链表。*/
+    abcdk_slab_cache *caches;
+
+    /** 已退出线程的计数器。*/
+    abcdk_slab_cache retired;
+
+} abcdk_slab_global;
+
+static volatile int _abcdk_slab_init_status = 0;
+static abcdk_slab_global _abcdk_slab_global = {0};
+static __thread abcdk_slab_cache *_abcdk_slab_thread_cache = NULL;
+
+static uint32_t _abcdk_slab_mag_cap(int cls)
+{
+    return ABCDK_MIN(ABCDK_SLAB_MAG_MAX, ABCDK_MAX(4, ABCDK_SLAB_MAG_BYTES / _abcdk_slab_class_size[cls]));
+}
+
+static void _abcdk_slab_depot_put_list(int cls, void *head, uint8_t *carve, uint8_t *carve_end)
+{
+    abcdk_slab_depot *depot = &_abcdk_slab_global.depot[cls];
+    void *tail = head;
+
+    while (tail && *(void **)tail)
+        tail = *(void **)tail;
+
+    abcdk_mutex_lock(&depot->mutex, 1);
+
+    if (tail)
+    {
+        *(void **)tail = depot->loose;
+        depot->loose = head;
+    }
+
+    /*只保留一个未切分完的页，其它的剩余部分放弃。*/
+    if (carve < carve_end && depot->carve >= depot->carve_end)
+    {
+        depot->carve = carve;
+        depot->carve_end = carve_end;
+    }
+
+    abcdk_mutex_unlock(&depot->mutex);
+}
+
+static void _abcdk_slab_cache_destroy(void *opaque)
+{
+    abcdk_slab_global *g = &_abcdk_slab_global;
+    abcdk_slab_cache *cache = (abcdk_slab_cache *)opaque;
+    abcdk_slab_bin *bin;
+
+    if (!cache)
+        return;
+
+    /*线程退出，缓存的内存块全部归还到全局仓库。*/
+    for (int i = 0; i < ABCDK_SLAB_CLASSES; i++)
+    {
+        bin = &cache->bins[i];
+
+        if (bin->head || bin->carve < bin->carve_end)
+            _abcdk_slab_depot_put_list(i, bin->head, bin->carve, bin->carve_end);
+    }
+
+    abcdk_mutex_lock(&g->mutex, 1);
+
+    for (int i = 0; i < ABCDK_SLAB_CLASSES; i++)
+    {
+        g->retired.alloc_count[i] += cache->alloc_count[i];
+        g->retired.free_count[i] += cache->free_count[i];
+    }
+    g->retired.heap_count += cache->heap_count;
+
+    if (cache->prev)
+        cache->prev->next = cache->next;
+    else
+        g->caches = cache->next;
+    if (cache->next)
+        cache->next->prev = cache->prev;
+
+    abcdk_mutex_unlock(&g->mutex);
+
+    _abcdk_slab_thread_cache = NULL;
+    abcdk_heap_free(cache);
+}
+
+static void *_abcdk_slab_reserve(size_t *size, size_t align)
+{
+    void *ptr;
+
+    /*只预留地址空间，物理内存在使用时才分配。严格的内存过量使用策略下，逐级减小。*/
+    for (; *size >= 128UL * 1024 * 1024; *size /= 8)
+    {
+        ptr = mmap(NULL, *size + align, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (ptr != MAP_FAILED)
+            return ptr;
+    }
+
+    return NULL;
+}
+
+static int _abcdk_slab_init(void *opaque)
+{
+    abcdk_slab_global *g = (abcdk_slab_global *)opaque;
+    size_t size = (sizeof(void *) >= 8 ? 64UL * 1024 * 1024 * 1024 : 512UL * 1024 * 1024);
+    size_t table_size;
+    uint8_t *ptr;
+
+    if (pthread_key_create(&g->key, _abcdk_slab_cache_destroy) != 0)
+        return -1;
+
+    abcdk_mutex_init2(&g->mutex, 0);
+    for (int i = 0; i < ABCDK_SLAB_CLASSES; i++)
+        abcdk_mutex_init2(&g->depot[i].mutex, 0);
+
+    for (size_t i = 0, c = 0; i <= ABCDK_SLAB_SIZE_MAX / 16; i++)
+    {
+        while (_abcdk_slab_class_size[c] < i * 16)
+            c += 1;
+
+        g->size_class[i] = c;
+    }
+
+    /*地址空间不可用时，全部转交给堆申请。*/
+    ptr = _abcdk_slab_reserve(&size, ABCDK_SLAB_PAGE_SIZE);
+    if (!ptr)
+        return 0;
+
+    table_size = size >> ABCDK_SLAB_PAGE_SHIFT;
+    g->page_class = mmap(NULL, table_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (g->page_class == MAP_FAILED)
+    {
+        g->page_class = NULL;
+        munmap(ptr, size + ABCDK_SLAB_PAGE_SIZE);
+        return 0;
+    }
+
+    g->base = (uint8_t *)abcdk_align((size_t)ptr, ABCDK_SLAB_PAGE_SIZE);
+    g->size = size;
+    g->used = 0;
+
+    return 0;
+}
+
+static abcdk_slab_cache *_abcdk_slab_cache_get()
+{
+    abcdk_slab_global *g = &_abcdk_slab_global;
+    abcdk_slab_cache *cache = _abcdk_slab_thread_cache;
+
+    if (cache)
+        return cache;
+
+    if (abcdk_once(&_abcdk_slab_init_status, _abcdk_slab_init, g) < 0)
+        return NULL;
+
+    cache = abcdk_heap_alloc(sizeof(abcdk_slab_cache));
+    if (!cache)
+        return NULL;
+
+    if (pthread_setspecific(g->key, cache) != 0)
+    {
+        abcdk_heap_free(cache);
+        return NULL;
+    }
+
+    abcdk_mutex_lock(&g->mutex, 1);
+
+    cache->next = g->caches;
+    if (g->caches)
+        g->caches->prev = cache;
+    g->caches = cache;
+
+    abcdk_mutex_unlock(&g->mutex);
+
+    return _abcdk_slab_thread_cache = cache;
+}
+
+static int _abcdk_slab_refill(abcdk_slab_bin *bin, int cls)
+{
+    abcdk_slab_global *g = &_abcdk_slab_global;
+    abcdk_slab_depot *depot = &g->depot[cls];
+    uint32_t cap = _abcdk_slab_mag_cap(cls);
+    size_t off;
+    void *p;
+
+    /*优先从全局仓库取回。*/
+    abcdk_mutex_lock(&depot->mutex, 1);
+
+    if (depot->mags)
+    {
+        bin->head = depot->mags;
+        bin->count = cap;
+        depot->mags = ((void **)bin->head)[1];
+    }
+    else if (depot->loose)
+    {
+        for (; depot->loose && bin->count < cap; bin->count++)
+        {
+            p = depot->loose;
+            depot->loose = *(void **)p;
+            *(void **)p = bin->head;
+            bin->head = p;
+        }
+    }
+    else if (depot->carve < depot->carve_end)
+    {
+        bin->carve = depot->carve;
+        bin->carve_end = depot->carve_end;
+        depot->carve = depot->carve_end = NULL;
+    }
+
+    abcdk_mutex_unlock(&depot->mutex);
+
+    if (bin->head || bin->carve < bin->carve_end)
+        return 0;
+
+    if (!g->base)
+        return -1;
+
+    /*切分新的页。*/
+    off = abcdk_atomic_fetch_and_add(&g->used, ABCDK_SLAB_PAGE_SIZE);
+    if (off + ABCDK_SLAB_PAGE_SIZE > g->size)
+        return -1;
+
+    g->page_class[off >> ABCDK_SLAB_PAGE_SHIFT] = cls;
+
+    bin->carve = g->base + off;
+    bin->carve_end = bin->carve + (ABCDK_SLAB_PAGE_SIZE / _abcdk_slab_class_size[cls]) * _abcdk_slab_class_size[cls];
+
+    return 0;
+}
+
+void *abcdk_slab_alloc(size_t size)
+{
+    abcdk_slab_cache *cache;
+    abcdk_slab_bin *bin;
+    uint32_t cls_size;
+    void *p;
+    int cls;
+
+    assert(size > 0);
+
+    cache = _abcdk_slab_cache_get();
+    if (!cache)
+        return abcdk_heap_alloc(size);
+
+    if (size > ABCDK_SLAB_SIZE_MAX)
+        goto final_heap;
+
+    cls = _abcdk_slab_global.size_class[(size + 15) >> 4];
+    cls_size = _abcdk_slab_class_size[cls];
+    bin = &cache->bins[cls];
+
+    if (!bin->head && bin->carve >= bin->carve_end)
+    {
+        if (_abcdk_slab_refill(bin, cls) != 0)
+            goto final_heap;
+    }
+
+    if (bin->head)
+    {
+        p = bin->head;
+        bin->head = *(void **)p;
+        bin->count -= 1;
+
+        /*回收的内存块需要清零，新切分的页本来就是零。*/
+        memset(p, 0, cls_size);
+    }
+    else
+    {
+        p = bin->carve;
+        bin->carve += cls_size;
+    }
+
+    ABCDK_SLAB_COUNTER_ADD(&cache->alloc_count[cls], 1);
+
+    return p;
+
+final_heap:
+
+    ABCDK_SLAB_COUNTER_ADD(&cache->heap_count, 1);
+
+    return abcdk_heap_alloc(size);
+}
+
+int abcdk_slab_owned(const void *ptr)
+{
+    abcdk_slab_global *g = &_abcdk_slab_global;
+
+    return (g->base && (uint8_t *)ptr >= g->base && (uint8_t *)ptr < g->base + g->size);
+}
+
+void abcdk_slab_free(void *ptr)
+{
+    abcdk_slab_global *g = &_abcdk_slab_global;
+    abcdk_slab_depot *depot;
+    abcdk_slab_cache *cache;
+    abcdk_slab_bin *bin;
+    uint32_t cap;
+    void *tail;
+    int cls;
+
+    if (!ptr)
+        return;
+
+    if (!abcdk_slab_owned(ptr))
+    {
+        abcdk_heap_free(ptr);
+        return;
+    }
+
+    cls = g->page_class[((uint8_t *)ptr - g->base) >> ABCDK_SLAB_PAGE_SHIFT];
+
+    cache = _abcdk_slab_cache_get();
+    if (!cache)
+    {
+        /*内存不足，无法创建线程缓存，直接归还到全局仓库。*/
+        *(void **)ptr = NULL;
+        _abcdk_slab_depot_put_list(cls, ptr, NULL, NULL);
+        return;
+    }
+
+    bin = &cache->bins[cls];
+
+    *(void **)ptr = bin->head;
+    bin->head = ptr;
+    bin->count += 1;
+
+    ABCDK_SLAB_COUNTER_ADD(&cache->free_count[cls], 1);
+
+    cap = _abcdk_slab_mag_cap(cls);
+    if (bin->count < 2 * cap)
+        return;
+
+    /*缓存过多，归还一个满弹匣到全局仓库。*/
+    tail = bin->head;
+    for (uint32_t i = 1; i < cap; i++)
+        tail = *(void **)tail;
+
+    ptr = bin->head;
+    bin->head = *(void **)tail;
+    bin->count -= cap;
+    *(void **)tail = NULL;
+
+    depot = &g->depot[cls];
+
+    abcdk_mutex_lock(&depot->mutex, 1);
+
+    ((void **)ptr)[1] = depot->mags;
+    depot->mags = ptr;
+
+    abcdk_mutex_unlock(&depot->mutex);
+}
+
+void abcdk_slab_stat_fetch(abcdk_slab_stat *stat)
+{
+    abcdk_slab_global *g = &_abcdk_slab_global;
+    uint64_t alloc_count[ABCDK_SLAB_CLASSES] = {0};
+    uint64_t free_count[ABCDK_SLAB_CLASSES] = {0};
+    uint64_t live, chunk;
+
+    assert(stat != NULL);
+
+    memset(stat, 0, sizeof(*stat));
+
+    if (abcdk_once(&_abcdk_slab_init_status, _abcdk_slab_init, g) < 0)
+        return;
+
+    /*只锁线程缓存链表，线程的申请和释放不受影响。*/
+    abcdk_mutex_lock(&g->mutex, 1);
+
+    for (abcdk_slab_cache *it = &g->retired; it; it = (it == &g->retired ? g->caches : it->next))
+    {
+        for (int i = 0; i < ABCDK_SLAB_CLASSES; i++)
+        {
+            alloc_count[i] += ABCDK_SLAB_COUNTER_GET(&it->alloc_count[i]);
+            free_count[i] += ABCDK_SLAB_COUNTER_GET(&it->free_count[i]);
+        }
+
+        stat->heap_count += ABCDK_SLAB_COUNTER_GET(&it->heap_count);
+    }
+
+    abcdk_mutex_unlock(&g->mutex);
+
+    for (int i = 0; i < ABCDK_SLAB_CLASSES; i++)
+    {
+        stat->alloc_count += alloc_count[i];
+        stat->free_count += free_count[i];
+
+        /*各线程的计数器不是同一时刻读取的，可能短暂的出现释放多于申请。*/
+        live = (alloc_count[i] > free_count[i] ? alloc_count[i] - free_count[i] : 0);
+
+        /*堆分配的每个内存块有8字节的头部，按16字节对齐，最小32字节。*/
+        chunk = ABCDK_MAX(32UL, abcdk_align(_abcdk_slab_class_size[i] + 8, 16));
+
+        stat->live_bytes += live * _abcdk_slab_class_size[i];
+        stat->heap_bytes += live * chunk;
+    }
+
+    stat->page_bytes = ABCDK_MIN(abcdk_atomic_load(&g->used), g->size);
+    stat->rss_saved = (int64_t)stat->heap_bytes - (int64_t)stat->page_bytes;
+}
@@ -0,0 +1,94 @@
+/*
+ * This file is part of ABCDK.
+ *
+ * MIT License
+ *
+ */
+#ifndef ABCDKUTIL_SLAB_H
+#define ABCDKUTIL_SLAB_H
+
+#include "general.h"
+#include "thread.h"
+
+__BEGIN_DECLS
+
+/**
+ * 小块内存分配器(按大小分类的线程缓存)。
+ *
+ * 小块内存从预留的地址空间中按64K的页切分，每页只存放一种大小的内存块。
+ * 释放的内存块进入当前线程的缓存，缓存过多时以弹匣(一组内存块)为单位归还到全局仓库，
+ * 线程缓存为空时优先从全局仓库取回一个弹匣，仓库也为空时才切分新的页。
+ *
+ * @note 申请的内存块已经清零，与abcdk_heap_alloc相同。
+ * @note 超过最大分类的长度，或者地址空间耗尽时，使用abcdk_heap_alloc申请。
+ * @note 内存块可以在任意线程中释放。
+*/
+
+/** 小块内存的最大长度。*/
+#define ABCDK_SLAB_SIZE_MAX 4096
+
+/**
+ * 小块内存分配器的统计信息。
+ *
+ * @note 所有线程的汇总(包括已经退出的线程)。
+*/
+typedef struct _abcdk_slab_stat
+{
+    /** 申请的次数(小块内存)。*/
+    uint64_t alloc_count;
+
+    /** 释放的次数(小块内存)。*/
+    uint64_t free_count;
+
+    /** 转交给abcdk_heap_alloc申请的次数。*/
+    uint64_t heap_count;
+
+    /** 使用中的小块内存的总长度(按分类大小计算)。*/
+    uint64_t live_bytes;
+
+    /** 已切分的页的总长度，即小块内存占用的物理内存的上限。*/
+    uint64_t page_bytes;
+
+    /** 使用中的小块内存由堆分配时(每块都有头部和对齐)估算的占用长度。*/
+    uint64_t heap_bytes;
+
+    /** 节省的物理内存(heap_bytes - page_bytes)。< 0 表示多占用。*/
+    int64_t rss_saved;
+
+} abcdk_slab_stat;
+
+/**
+ * 申请内存块。
+ *
+ * @param size 长度。> 0 的整数。
+ *
+ * @return !NULL(0) 成功(已清零)，NULL(0) 失败。
+*/
+void *abcdk_slab_alloc(size_t size);
+
+/**
+ * 释放内存块。
+ *
+ * 可以释放由abcdk_heap_alloc申请的内存块。
+ *
+ * @param ptr 内存块指针。NULL(0) 忽略。
+*/
+void abcdk_slab_free(void *ptr);
+
+/**
+ * 判断内存块是否由小块内存分配器管理。
+ *
+ * @return !0 是，0 否。
+*/
+int abcdk_slab_owned(const void *ptr);
+
+/**
+ * 获取统计信息。
+ *
+ * 可以在任意线程中调用，不影响其它线程的申请和释放。
+*/
+void abcdk_slab_stat_fetch(abcdk_slab_stat *stat);
+
+__END_DECLS
+
+#endif //ABCDKUTIL_SLAB_H
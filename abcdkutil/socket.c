@@ -257,6 +257,54 @@ int abcdk_bind(int fd, const abcdk_sockaddr_t *addr)
     return bind(fd, &addr->addr, sizeof(abcdk_sockaddr_t));
 }
 
+int abcdk_listen_reuseport(int fds[], int count, const abcdk_sockaddr_t *addr, int backlog)
+{
+    int flag = 1;
+    int chk;
+
+    assert(fds != NULL && count > 0 && addr != NULL);
+    assert(addr->family == ABCDK_IPV4 || addr->family == ABCDK_IPV6);
+
+    for (int i = 0; i < count; i++)
+        fds[i] = -1;
+
+    for (int i = 0; i < count; i++)
+    {
+        fds[i] = abcdk_socket(addr->family, 0);
+        if (fds[i] < 0)
+            goto final_error;
+
+        chk = abcdk_sockopt_option_int(fds[i], SOL_SOCKET, SO_REUSEPORT, &flag, 2);
+        if (chk != 0)
+            goto final_error;
+
+        chk = abcdk_sockopt_option_int(fds[i], SOL_SOCKET, SO_REUSEADDR, &flag, 2);
+        if (chk != 0)
+            goto final_error;
+
+        chk = abcdk_bind(fds[i], addr);
+        if (chk != 0)
+            goto final_error;
+
+        chk = listen(fds[i], (backlog > 0 ? backlog : SOMAXCONN));
+        if (chk != 0)
+            goto final_error;
+
+        chk = abcdk_fflag_add(fds[i], O_NONBLOCK);
+        if (chk != 0)
+            goto final_error;
+    }
+
+    return 0;
+
+final_error:
+
+    for (int i = 0; i < count; i++)
+        abcdk_closep(&fds[i]);
+
+    return -1;
+}
+
 int abcdk_accept(int fd, abcdk_sockaddr_t *addr)
 {
     int sub_fd = -1;
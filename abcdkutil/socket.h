@@ -191,6 +191,21 @@ int abcdk_socket(sa_family_t family, int udp);
 */
 int abcdk_bind(int fd, const abcdk_sockaddr_t *addr);
 
+/**
+ * 创建多个绑定到相同地址的监听SOCKET句柄(SO_REUSEPORT)。
+ * 
+ * 内核按连接的四元组把新连接分散到各个监听句柄，每个工作线程(或分片)可以拥有独立的监听句柄。
+ * 
+ * @note 句柄已经被设置为非阻塞。
+ * 
+ * @param fds 句柄数组。
+ * @param count 数量。
+ * @param backlog 等待队列长度，<= 0 使用SOMAXCONN。
+ * 
+ * @return 0 成功，-1 失败(已经创建的句柄会被关闭)。
+*/
+int abcdk_listen_reuseport(int fds[], int count, const abcdk_sockaddr_t *addr, int backlog);
+
 /**
  * 接收一个已经连接的SOCKET句柄。
  * 
@@ -244,6 +244,7 @@ void abcdk_tar_fill(abcdk_tar_hdr *hdr, char typeflag,
     /*较验和的字段长度8个字节，但只有6个数字，跟着一个NULL(0)，最后一个是空格。*/
     memset(hdr->chksum,' ',sizeof(hdr->chksum));
     abcdk_tar_num2char(abcdk_tar_calc_checksum(hdr), hdr->chksum, 7);
+    hdr->chksum[6] = '\0';
 }
 
 int abcdk_tar_verify(abcdk_tar_hdr *hdr, const char *magic, size_t size)
@@ -269,6 +270,9 @@ ssize_t abcdk_tar_read(abcdk_tar_t *tar, void *data, size_t size)
 {
     assert(tar != NULL && data != NULL && size > 0);
 
+    if (tar->reader)
+        return abcdk_block_reader_read(tar->reader, data, size);
+
     return abcdk_block_read(tar->fd, data, size, tar->buf);
 }
 
@@ -293,6 +297,9 @@ ssize_t abcdk_tar_write(abcdk_tar_t *tar, const void *data, size_t size)
 {
     assert(tar != NULL && data != NULL && size > 0);
 
+    if (tar->writer)
+        return abcdk_block_writer_write(tar->writer, data, size);
+
     return abcdk_block_write(tar->fd, data, size, tar->buf);
 }
 
@@ -317,7 +324,10 @@ int abcdk_tar_write_trailer(abcdk_tar_t *tar, uint8_t stuffing)
 {
     assert(tar != NULL);
 
-    return abcdk_block_write_trailer(tar->fd, 0, tar->buf);
+    if (tar->writer)
+        return abcdk_block_writer_trailer(tar->writer, stuffing);
+
+    return abcdk_block_write_trailer(tar->fd, stuffing, tar->buf);
 }
 
 int abcdk_tar_read_hdr(abcdk_tar_t *tar, char name[PATH_MAX], struct stat *attr, char linkname[PATH_MAX])
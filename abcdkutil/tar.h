@@ -78,6 +78,20 @@ typedef struct _abcdk_tar
     */
     abcdk_buffer_t *buf;
 
+    /**
+     * 异步的块写入器。
+     * 
+     * !NULL(0) 写入时使用(忽略缓存)，NULL(0) 同步写入。
+    */
+    abcdk_block_writer_t *writer;
+
+    /**
+     * 预读的块读取器。
+     * 
+     * !NULL(0) 读取时使用(忽略缓存)，NULL(0) 同步读取。
+    */
+    abcdk_block_reader_t *reader;
+
 } abcdk_tar_t;
 
 /** 
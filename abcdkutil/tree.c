@@ -6,6 +6,19 @@
  */
 #include "tree.h"
 
+/**
+ * 区域的根节点。
+*/
+typedef struct _abcdk_tree_region
+{
+    /** 根节点(必须是第一个元素)。*/
+    abcdk_tree_t root;
+
+    /** 区域。*/
+    abcdk_arena_t *arena;
+
+} abcdk_tree_region;
+
 abcdk_tree_t *abcdk_tree_father(const abcdk_tree_t *self)
 {
     assert(self);
@@ -87,6 +100,9 @@ void abcdk_tree_insert(abcdk_tree_t *father, abcdk_tree_t *child, abcdk_tree_t *
     assert(NULL == child->chain[ABCDK_TREE_CHAIN_SIBLING_PREV]);
     assert(NULL == child->chain[ABCDK_TREE_CHAIN_SIBLING_NEXT]);
 
+    /*在同一个区域中，释放时不会遗漏或重复。*/
+    assert(father->region == child->region);
+
     /* 绑定新父节点。*/
     child->chain[ABCDK_TREE_CHAIN_FATHER] = father;
 
@@ -205,6 +221,19 @@ void abcdk_tree_free(abcdk_tree_t **root)
     assert(NULL == root_p->chain[ABCDK_TREE_CHAIN_SIBLING_PREV]);
     assert(NULL == root_p->chain[ABCDK_TREE_CHAIN_SIBLING_NEXT]);
 
+    /* 区域中的节点随区域一起释放。*/
+    if (root_p->region)
+    {
+        if (root_p->region == root_p)
+        {
+            abcdk_arena_free(&((abcdk_tree_region *)root_p)->arena);
+            abcdk_heap_free(root_p);
+        }
+
+        *root = NULL;
+        return;
+    }
+
     while (root_p)
     {
         node = abcdk_tree_child(root_p,0);
@@ -223,7 +252,7 @@ void abcdk_tree_free(abcdk_tree_t **root)
                 abcdk_tree_unlink(node);
 
                 abcdk_allocator_unref(&node->alloc);
-                abcdk_heap_free2((void**)&node);
+                abcdk_allocator_heap_free(node);
             }
         }
         else
@@ -234,13 +263,14 @@ void abcdk_tree_free(abcdk_tree_t **root)
     }
 
     abcdk_allocator_unref(&(*root)->alloc);
-    abcdk_heap_free2((void**)root);
+    abcdk_allocator_heap_free(*root);
+    *root = NULL;
 
 }
 
 abcdk_tree_t *abcdk_tree_alloc(abcdk_allocator_t *alloc)
 {
-    abcdk_tree_t *node = (abcdk_tree_t *)abcdk_heap_alloc(sizeof(abcdk_tree_t));
+    abcdk_tree_t *node = (abcdk_tree_t *)abcdk_allocator_heap_alloc(sizeof(abcdk_tree_t));
 
     if (!node)
         ABCDK_ERRNO_AND_RETURN1(ENOMEM,NULL);
@@ -276,6 +306,68 @@ abcdk_tree_t *abcdk_tree_alloc3(size_t size)
     return abcdk_tree_alloc2(&size,1,0);
 }
 
+abcdk_tree_t *abcdk_tree_alloc4(abcdk_tree_t *near, size_t *sizes, size_t numbers, int drag)
+{
+    abcdk_arena_t *arena = NULL;
+    abcdk_tree_t *node = NULL;
+
+    if (!near || !near->region)
+        return abcdk_tree_alloc2(sizes, numbers, drag);
+
+    arena = ((abcdk_tree_region *)near->region)->arena;
+
+    /* 节点和数据在区域中相邻，失败时不需要释放。*/
+    node = (abcdk_tree_t *)abcdk_arena_heap_alloc(arena, sizeof(abcdk_tree_t));
+    if (!node)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+
+    node->alloc = abcdk_allocator_alloc4(sizes, numbers, drag, 0, arena);
+    if (!node->alloc)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+
+    node->region = near->region;
+
+    return node;
+}
+
+abcdk_tree_t *abcdk_tree_arena_alloc(size_t *sizes, size_t numbers, int drag)
+{
+    abcdk_tree_region *region = NULL;
+
+    region = (abcdk_tree_region *)abcdk_heap_alloc(sizeof(abcdk_tree_region));
+    if (!region)
+        ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+
+    region->arena = abcdk_arena_alloc(0);
+    if (!region->arena)
+        goto final_error;
+
+    region->root.alloc = abcdk_allocator_alloc4(sizes, numbers, drag, 0, region->arena);
+    if (!region->root.alloc)
+        goto final_error;
+
+    region->root.region = &region->root;
+
+    return &region->root;
+
+final_error:
+
+    abcdk_arena_free(&region->arena);
+    abcdk_heap_free(region);
+
+    ABCDK_ERRNO_AND_RETURN1(ENOMEM, NULL);
+}
+
+abcdk_arena_t *abcdk_tree_arena(const abcdk_tree_t *node)
+{
+    assert(node != NULL);
+
+    if (!node->region)
+        return NULL;
+
+    return ((abcdk_tree_region *)node->region)->arena;
+}
+
 void abcdk_tree_scan(abcdk_tree_t *root,abcdk_tree_iterator_t* it)
 {
     abcdk_tree_t *node = NULL;
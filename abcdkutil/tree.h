@@ -33,6 +33,15 @@ typedef struct _abcdk_tree
     */
     abcdk_allocator_t *alloc;
 
+    /**
+     * 区域的根节点。
+     * 
+     * NULL(0) 节点和数据从堆申请。!NULL(0) 节点和数据从根节点的区域申请，根节点释放时一次性回收。
+     * 
+     * @note 尽量不要直接访问或修改。
+    */
+    struct _abcdk_tree *region;
+
 }abcdk_tree_t;
 
 /**
@@ -148,6 +157,7 @@ void abcdk_tree_unlink(abcdk_tree_t *self);
  * @param child 孩子。
  * @param where NULL(0) 孩子为小弟，!NULL(0) 孩子为兄长。
  * 
+ * @warning 父和孩子必须在同一个区域中(或者都不在区域中)。
 */
 void abcdk_tree_insert(abcdk_tree_t *father, abcdk_tree_t *child, abcdk_tree_t *where);
 
@@ -174,6 +184,10 @@ void abcdk_tree_swap(abcdk_tree_t *src,abcdk_tree_t *dst);
  * 
  * 包括自己，自己的孩子，以孩子的孩子都会被删除。
  * 
+ * @note 区域的根节点释放时，整个区域一次性释放，不会逐个释放节点，也不会执行数据的析构函数。
+ * @note 区域中的其它节点释放时只断开指针，内存在区域的根节点释放时回收。长期存在的区域中反复创建、删除节点，
+ * 内存只增不减，这类树(选项等)应从堆申请。
+ * 
  * @param root 节点指针的指针。当接口返回时，被赋值NULL(0)。
 */
 void abcdk_tree_free(abcdk_tree_t **root);
@@ -196,6 +210,34 @@ abcdk_tree_t *abcdk_tree_alloc2(size_t *sizes,size_t numbers,int drag);
 */
 abcdk_tree_t *abcdk_tree_alloc3(size_t size);
 
+/**
+ * 创建节点，同时申请数据内存块。
+ * 
+ * 节点和数据与near在同一个区域中，near不在区域中时从堆申请(与abcdk_tree_alloc2相同)。
+ * 
+ * @param near 参照节点，通常是将要插入的父节点。NULL(0) 从堆申请。
+*/
+abcdk_tree_t *abcdk_tree_alloc4(abcdk_tree_t *near, size_t *sizes, size_t numbers, int drag);
+
+/**
+ * 创建区域的根节点，同时申请数据内存块。
+ * 
+ * 子孙节点通过abcdk_tree_alloc4创建，与根节点在同一个区域中。适用于一次性构建、整体释放的大树(目录扫描等)。
+ * 
+ * @warning 区域中的数据不支持析构函数，也不能把堆中的数据(alloc)替换到区域的节点中。
+ * @warning 根节点释放后，区域中的数据不能再访问(包括引用和释放)。
+*/
+abcdk_tree_t *abcdk_tree_arena_alloc(size_t *sizes, size_t numbers, int drag);
+
+/**
+ * 获取节点所在的区域。
+ * 
+ * 可以申请与树的生命周期相同的其它内存。
+ * 
+ * @return !NULL(0) 区域，NULL(0) 不在区域中。
+*/
+abcdk_arena_t *abcdk_tree_arena(const abcdk_tree_t *node);
+
 /**
  * 扫描树节点。
  * 
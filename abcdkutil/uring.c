@@ -0,0 +1,388 @@
+/*
+ * This file is part of ABCDK.
+ *
+ * MIT License
+ *
+ */
+#include "uring.h"
+
+#if defined(LINUX_IO_URING_H) && defined(__NR_io_uring_setup) && defined(IORING_FEAT_EXT_ARG)
+
+/** 内部请求的关联数据，完成后直接丢弃。*/
+#define ABCDK_URING_DATA_IGNORE UINT64_MAX
+
+/**
+ * IO_URING环境。
+*/
+struct _abcdk_uring
+{
+    /** 句柄。*/
+    int fd;
+
+    /** 提交队列的映射内存。*/
+    void *sq_ptr;
+    size_t sq_len;
+
+    /** 完成队列的映射内存(可能与提交队列共享)。*/
+    void *cq_ptr;
+    size_t cq_len;
+
+    /** 提交队列。*/
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned sq_mask;
+    unsigned sq_entries;
+
+    /** 请求数组。*/
+    struct io_uring_sqe *sqes;
+    size_t sqes_len;
+
+    /** 完成队列。*/
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe *cqes;
+};
+
+static int _abcdk_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+    return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int _abcdk_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags, const void *arg, size_t argsz)
+{
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, argsz);
+}
+
+void abcdk_uring_free(abcdk_uring_t **ctx)
+{
+    abcdk_uring_t *ctx_p;
+
+    if (!ctx || !*ctx)
+        return;
+
+    ctx_p = *ctx;
+
+    if (ctx_p->sqes)
+        munmap(ctx_p->sqes, ctx_p->sqes_len);
+    if (ctx_p->cq_ptr && ctx_p->cq_ptr != ctx_p->sq_ptr)
+        munmap(ctx_p->cq_ptr, ctx_p->cq_len);
+    if (ctx_p->sq_ptr)
+        munmap(ctx_p->sq_ptr, ctx_p->sq_len);
+
+    abcdk_closep(&ctx_p->fd);
+
+    /*free.*/
+    abcdk_heap_free(ctx_p);
+
+    /*Set to NULL(0).*/
+    *ctx = NULL;
+}
+
+abcdk_uring_t *abcdk_uring_alloc(unsigned entries)
+{
+    abcdk_uring_t *ctx = NULL;
+    struct io_uring_params p = {0};
+    unsigned *sq_array;
+
+    assert(entries > 0);
+
+    ctx = abcdk_heap_alloc(sizeof(abcdk_uring_t));
+    if (!ctx)
+        return NULL;
+
+    ctx->fd = _abcdk_uring_setup(entries, &p);
+    if (ctx->fd < 0)
+        goto final_error;
+
+    /* 添加个非必要标志，忽略可能的出错信息。 */
+    abcdk_fflag_add(ctx->fd, O_CLOEXEC);
+
+    /*等待超时依赖EXT_ARG(5.11+)。*/
+    if (!(p.features & IORING_FEAT_EXT_ARG))
+        ABCDK_ERRNO_AND_GOTO1(ENOSYS, final_error);
+
+    ctx->sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    ctx->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+        ctx->sq_len = ctx->cq_len = ABCDK_MAX(ctx->sq_len, ctx->cq_len);
+
+    ctx->sq_ptr = mmap(NULL, ctx->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ctx->fd, IORING_OFF_SQ_RING);
+    if (ctx->sq_ptr == MAP_FAILED)
+    {
+        ctx->sq_ptr = NULL;
+        goto final_error;
+    }
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        ctx->cq_ptr = ctx->sq_ptr;
+    }
+    else
+    {
+        ctx->cq_ptr = mmap(NULL, ctx->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ctx->fd, IORING_OFF_CQ_RING);
+        if (ctx->cq_ptr == MAP_FAILED)
+        {
+            ctx->cq_ptr = NULL;
+            goto final_error;
+        }
+    }
+
+    ctx->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    ctx->sqes = mmap(NULL, ctx->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ctx->fd, IORING_OFF_SQES);
+    if (ctx->sqes == MAP_FAILED)
+    {
+        ctx->sqes = NULL;
+        goto final_error;
+    }
+
+    ctx->sq_head = ABCDK_PTR2PTR(unsigned, ctx->sq_ptr, p.sq_off.head);
+    ctx->sq_tail = ABCDK_PTR2PTR(unsigned, ctx->sq_ptr, p.sq_off.tail);
+    ctx->sq_mask = *ABCDK_PTR2PTR(unsigned, ctx->sq_ptr, p.sq_off.ring_mask);
+    ctx->sq_entries = *ABCDK_PTR2PTR(unsigned, ctx->sq_ptr, p.sq_off.ring_entries);
+
+    ctx->cq_head = ABCDK_PTR2PTR(unsigned, ctx->cq_ptr, p.cq_off.head);
+    ctx->cq_tail = ABCDK_PTR2PTR(unsigned, ctx->cq_ptr, p.cq_off.tail);
+    ctx->cq_mask = *ABCDK_PTR2PTR(unsigned, ctx->cq_ptr, p.cq_off.ring_mask);
+    ctx->cqes = ABCDK_PTR2PTR(struct io_uring_cqe, ctx->cq_ptr, p.cq_off.cqes);
+
+    /*请求数组与索引数组一一对应，只需要初始化一次。*/
+    sq_array = ABCDK_PTR2PTR(unsigned, ctx->sq_ptr, p.sq_off.array);
+    for (unsigned i = 0; i < ctx->sq_entries; i++)
+        sq_array[i] = i;
+
+    return ctx;
+
+final_error:
+
+    abcdk_uring_free(&ctx);
+
+    return NULL;
+}
+
+static struct io_uring_sqe *_abcdk_uring_sqe_get(abcdk_uring_t *ctx)
+{
+    unsigned tail = *ctx->sq_tail;
+    struct io_uring_sqe *sqe;
+
+    /*队列满了，先提交。*/
+    if (tail - __atomic_load_n(ctx->sq_head, __ATOMIC_ACQUIRE) >= ctx->sq_entries)
+    {
+        if (abcdk_uring_submit(ctx) < 0)
+            return NULL;
+
+        if (tail - __atomic_load_n(ctx->sq_head, __ATOMIC_ACQUIRE) >= ctx->sq_entries)
+            ABCDK_ERRNO_AND_RETURN1(EBUSY, NULL);
+    }
+
+    sqe = &ctx->sqes[tail & ctx->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+
+    return sqe;
+}
+
+static void _abcdk_uring_sqe_put(abcdk_uring_t *ctx)
+{
+    /*请求写完后再更新队尾，内核才能看到完整的请求。*/
+    __atomic_store_n(ctx->sq_tail, *ctx->sq_tail + 1, __ATOMIC_RELEASE);
+}
+
+int abcdk_uring_poll_add(abcdk_uring_t *ctx, int fd, uint32_t events, uint64_t data)
+{
+    struct io_uring_sqe *sqe;
+    uint32_t mask = (POLLERR | POLLHUP | POLLRDHUP);
+
+    assert(ctx != NULL && fd >= 0 && data != ABCDK_URING_DATA_IGNORE);
+    assert((events & ~(ABCDK_EPOLL_INPUT | ABCDK_EPOLL_INOOB | ABCDK_EPOLL_OUTPUT | ABCDK_EPOLL_ERROR)) == 0);
+
+    /*如果注册事件中包括错误事件，则直接跳转出错流程。*/
+    if (events & ABCDK_EPOLL_ERROR)
+        return -1;
+
+    /*转换事件。*/
+    if (events & ABCDK_EPOLL_INPUT)
+        mask |= POLLIN;
+    if (events & ABCDK_EPOLL_INOOB)
+        mask |= POLLPRI;
+    if (events & ABCDK_EPOLL_OUTPUT)
+        mask |= POLLOUT;
+
+    sqe = _abcdk_uring_sqe_get(ctx);
+    if (!sqe)
+        return -1;
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = mask;
+    sqe->user_data = data;
+
+    _abcdk_uring_sqe_put(ctx);
+
+    return 0;
+}
+
+int abcdk_uring_poll_remove(abcdk_uring_t *ctx, uint64_t data)
+{
+    struct io_uring_sqe *sqe;
+
+    assert(ctx != NULL && data != ABCDK_URING_DATA_IGNORE);
+
+    sqe = _abcdk_uring_sqe_get(ctx);
+    if (!sqe)
+        return -1;
+
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = data;
+    sqe->user_data = ABCDK_URING_DATA_IGNORE;
+
+    _abcdk_uring_sqe_put(ctx);
+
+    return 0;
+}
+
+int abcdk_uring_fd(abcdk_uring_t *ctx)
+{
+    assert(ctx != NULL);
+
+    return ctx->fd;
+}
+
+unsigned abcdk_uring_pending(abcdk_uring_t *ctx)
+{
+    assert(ctx != NULL);
+
+    return *ctx->sq_tail - __atomic_load_n(ctx->sq_head, __ATOMIC_ACQUIRE);
+}
+
+int abcdk_uring_submit(abcdk_uring_t *ctx)
+{
+    unsigned pending;
+
+    assert(ctx != NULL);
+
+    pending = abcdk_uring_pending(ctx);
+    if (pending <= 0)
+        return 0;
+
+    return _abcdk_uring_enter(ctx->fd, pending, 0, 0, NULL, 0);
+}
+
+static int _abcdk_uring_reap(abcdk_uring_t *ctx, abcdk_epoll_event *events, int max)
+{
+    unsigned head = *ctx->cq_head;
+    unsigned tail = __atomic_load_n(ctx->cq_tail, __ATOMIC_ACQUIRE);
+    struct io_uring_cqe *cqe;
+    int count = 0;
+
+    for (; head != tail && count < max; head++)
+    {
+        cqe = &ctx->cqes[head & ctx->cq_mask];
+
+        /*内部请求，或被删除的注册。*/
+        if (cqe->user_data == ABCDK_URING_DATA_IGNORE || cqe->res == -ECANCELED)
+            continue;
+
+        events[count].data.u64 = cqe->user_data;
+        events[count].events = 0;
+
+        /*转换事件。*/
+        if (cqe->res < 0)
+        {
+            events[count].events |= ABCDK_EPOLL_ERROR;
+        }
+        else
+        {
+            if (cqe->res & POLLIN)
+                events[count].events |= ABCDK_EPOLL_INPUT;
+            if (cqe->res & POLLPRI)
+                events[count].events |= ABCDK_EPOLL_INOOB;
+            if (cqe->res & POLLOUT)
+                events[count].events |= ABCDK_EPOLL_OUTPUT;
+            if (cqe->res & (POLLERR | POLLHUP | POLLRDHUP | POLLNVAL))
+                events[count].events |= ABCDK_EPOLL_ERROR;
+        }
+
+        count += 1;
+    }
+
+    __atomic_store_n(ctx->cq_head, head, __ATOMIC_RELEASE);
+
+    return count;
+}
+
+int abcdk_uring_wait(abcdk_uring_t *ctx, abcdk_epoll_event *events, int max, time_t timeout)
+{
+    struct __kernel_timespec ts = {0};
+    struct io_uring_getevents_arg arg = {0};
+    int chk;
+
+    assert(ctx != NULL && events != NULL && max > 0);
+
+    /*完成队列中已有事件，不需要进入内核。*/
+    chk = _abcdk_uring_reap(ctx, events, max);
+    if (chk > 0)
+        return chk;
+
+    if (timeout >= 0 && timeout < INT32_MAX)
+    {
+        ts.tv_sec = timeout / 1000;
+        ts.tv_nsec = (timeout % 1000) * 1000000;
+        arg.ts = (uint64_t)(uintptr_t)&ts;
+    }
+
+    /*提交和等待在一次系统调用中完成。*/
+    chk = _abcdk_uring_enter(ctx->fd, abcdk_uring_pending(ctx), 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    if (chk < 0 && errno != ETIME && errno != EINTR)
+        return -1;
+
+    return _abcdk_uring_reap(ctx, events, max);
+}
+
+#else //defined(LINUX_IO_URING_H) && defined(__NR_io_uring_setup) && defined(IORING_FEAT_EXT_ARG)
+
+void abcdk_uring_free(abcdk_uring_t **ctx)
+{
+    if (!ctx || !*ctx)
+        return;
+
+    *ctx = NULL;
+}
+
+abcdk_uring_t *abcdk_uring_alloc(unsigned entries)
+{
+    ABCDK_ERRNO_AND_RETURN1(ENOSYS, NULL);
+}
+
+int abcdk_uring_poll_add(abcdk_uring_t *ctx, int fd, uint32_t events, uint64_t data)
+{
+    ABCDK_ERRNO_AND_RETURN1(ENOSYS, -1);
+}
+
+int abcdk_uring_poll_remove(abcdk_uring_t *ctx, uint64_t data)
+{
+    ABCDK_ERRNO_AND_RETURN1(ENOSYS, -1);
+}
+
+int abcdk_uring_fd(abcdk_uring_t *ctx)
+{
+    ABCDK_ERRNO_AND_RETURN1(ENOSYS, -1);
+}
+
+unsigned abcdk_uring_pending(abcdk_uring_t *ctx)
+{
+    return 0;
+}
+
+int abcdk_uring_submit(abcdk_uring_t *ctx)
+{
+    ABCDK_ERRNO_AND_RETURN1(ENOSYS, -1);
+}
+
+int abcdk_uring_wait(abcdk_uring_t *ctx, abcdk_epoll_event *events, int max, time_t timeout)
+{
+    ABCDK_ERRNO_AND_RETURN1(ENOSYS, -1);
+}
+
+#endif //defined(LINUX_IO_URING_H) && defined(__NR_io_uring_setup) && defined(IORING_FEAT_EXT_ARG)
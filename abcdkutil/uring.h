@@ -0,0 +1,105 @@
+/*
+ * This file is part of ABCDK.
+ *
+ * MIT License
+ *
+ */
+#ifndef ABCDKUTIL_URING_H
+#define ABCDKUTIL_URING_H
+
+#include "general.h"
+#include "epoll.h"
+
+#include <sys/syscall.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif //__has_include(<linux/io_uring.h>)
+#endif //defined(__linux__) && defined(__has_include)
+
+__BEGIN_DECLS
+
+/**
+ * IO_URING环境。
+ *
+ * 仅使用POLL_ADD(一次性)和POLL_REMOVE两种请求，事件的值与EPOLL相同。
+ *
+ * @note 提交队列(注册、删除、提交)的访问需要调用者加锁保护。
+ * @note 同一时间只能有一个线程调用abcdk_uring_wait。
+ * @note abcdk_uring_wait可以与已加锁的提交操作并发执行。
+*/
+typedef struct _abcdk_uring abcdk_uring_t;
+
+/**
+ * 释放。
+*/
+void abcdk_uring_free(abcdk_uring_t **ctx);
+
+/**
+ * 申请。
+ *
+ * @param entries 提交队列长度，内核会向上取整到2的幂。
+ *
+ * @return !NULL(0) 成功，NULL(0) 失败(内核或编译环境不支持时，errno为ENOSYS)。
+*/
+abcdk_uring_t *abcdk_uring_alloc(unsigned entries);
+
+/**
+ * 注册句柄和事件(一次性)。
+ *
+ * 仅写入提交队列，在提交或等待时才被内核处理。事件通知后，需要重新注册才能再次通知。
+ *
+ * @param data 关联数据，随事件返回。UINT64_MAX 保留。
+ *
+ * @return 0 成功，-1 失败。
+*/
+int abcdk_uring_poll_add(abcdk_uring_t *ctx, int fd, uint32_t events, uint64_t data);
+
+/**
+ * 删除已注册的句柄和事件。
+ *
+ * 仅写入提交队列。被删除的注册不会再返回事件。
+ *
+ * @param data 注册时的关联数据。
+ *
+ * @return 0 成功，-1 失败。
+*/
+int abcdk_uring_poll_remove(abcdk_uring_t *ctx, uint64_t data);
+
+/**
+ * 获取句柄。
+ *
+ * 完成队列中有事件时可读，可以加入到EPOLL中等待。
+ *
+ * @return >= 0 成功，-1 失败。
+*/
+int abcdk_uring_fd(abcdk_uring_t *ctx);
+
+/**
+ * 提交队列中的请求数量。
+*/
+unsigned abcdk_uring_pending(abcdk_uring_t *ctx);
+
+/**
+ * 提交队列中的请求。
+ *
+ * @return >= 0 提交的数量，-1 失败。
+*/
+int abcdk_uring_submit(abcdk_uring_t *ctx);
+
+/**
+ * 等待事件。
+ *
+ * 完成队列中有事件时直接返回，不进入内核；否则提交队列中的请求并等待，一次系统调用完成。
+ *
+ * @param events 事件数组，关联数据在data.u64中返回。
+ * @param timeout 超时(毫秒)。>= 0 有事件或时间过期，< 0 直到有事件或出错。
+ *
+ * @return > 0 事件数量，<= 0 超时或出错。
+*/
+int abcdk_uring_wait(abcdk_uring_t *ctx, abcdk_epoll_event *events, int max, time_t timeout);
+
+__END_DECLS
+
+#endif //ABCDKUTIL_URING_H
@@ -9,12 +9,17 @@
 #include <unistd.h>
 #include <string.h>
 #include <sys/sendfile.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
 #include "abcdkutil/general.h"
 #include "abcdkutil/getargs.h"
 #include "abcdkutil/clock.h"
 #include "abcdkutil/thread.h"
 #include "abcdkutil/signal.h"
+#include "abcdkutil/map.h"
+#include "abcdkutil/atomic.h"
 #include "abcdkcomm/mux.h"
+#include "abcdkcomm/comm.h"
 
 void* sigwaitinfo_cb(void* args)
 {
@@ -160,7 +165,10 @@ void test_server(abcdk_tree_t *t)
 {
     abcdk_clock_reset();
 
-    abcdk_mux_t *m = abcdk_mux_alloc();
+    abcdk_mux_param param = {0};
+    param.shards = abcdk_option_get_int(t, "--shards", 0, 1);
+
+    abcdk_mux_t *m = abcdk_mux_alloc2(&param);
 #if 0
 
     printf("attach begin:%lu\n",abcdk_clock_dot(NULL));
@@ -181,8 +189,10 @@ void test_server(abcdk_tree_t *t)
     printf("detach cast:%lu\n",abcdk_clock_step(NULL));
 #else
 
-    #pragma omp parallel for num_threads(3)
-    for (int i = 0; i < 3; i++)
+    int threads = ABCDK_MAX(3, (int)param.shards);
+
+    #pragma omp parallel for num_threads(threads)
+    for (int i = 0; i < threads; i++)
     {
 #if 0
         abcdk_thread_t p;
@@ -224,6 +234,1003 @@ void test_client(abcdk_tree_t *t)
     abcdk_closep(&c);
 }
 
+static void _test_mux_bench_round(abcdk_mux_t *m, int *fds, int conns, int rounds, int batch)
+{
+    abcdk_epoll_event *es = abcdk_heap_alloc(batch * sizeof(abcdk_epoll_event));
+    uint64_t one = 1, val = 0;
+    int events = 0;
+    int chk;
+
+    abcdk_clock_dot(NULL);
+
+    for (int r = 0; r < rounds; r++)
+    {
+        for (int i = 0; i < conns; i++)
+            write(fds[i], &one, sizeof(one));
+
+        for (int i = 0; i < conns;)
+        {
+            int n = abcdk_mux_wait_batch(m, es, batch, 1000);
+            if (n <= 0)
+                break;
+
+            for (int j = 0; j < n; j++)
+            {
+                read(es[j].data.fd, &val, sizeof(val));
+
+                chk = abcdk_mux_mark(m, es[j].data.fd, ABCDK_EPOLL_INPUT, ABCDK_EPOLL_INPUT);
+                assert(chk == 0);
+                chk = abcdk_mux_unref(m, es[j].data.fd, es[j].events);
+                assert(chk == 0);
+            }
+
+            i += n;
+            events += n;
+        }
+    }
+
+    uint64_t cast = abcdk_clock_step(NULL);
+
+    printf("mux: conns=%d batch=%d events=%d cast=%lu(us) rate=%.0f(events/s)\n",
+           conns, batch, events, cast, (double)events * 1000000 / ABCDK_MAX(cast, (uint64_t)1));
+
+    abcdk_heap_free(es);
+}
+
+static void _test_mux_bench_lookup(int *fds, int conns, int rounds)
+{
+    abcdk_map_t map = {0};
+    void **table = NULL;
+    uint64_t sum = 0;
+
+    /*旧的节点表：400个桶的哈希表。*/
+    abcdk_map_init(&map, 400);
+    for (int i = 0; i < conns; i++)
+        abcdk_map_find(&map, &fds[i], sizeof(fds[i]), sizeof(void *));
+
+    abcdk_clock_dot(NULL);
+
+    for (int r = 0; r < rounds; r++)
+    {
+        for (int i = 0; i < conns; i++)
+            sum += (uint64_t)abcdk_map_find(&map, &fds[i], sizeof(fds[i]), 0);
+    }
+
+    uint64_t cast_map = abcdk_clock_step(NULL);
+
+    /*新的节点表：按句柄直接索引。*/
+    table = abcdk_heap_alloc((fds[conns - 1] + 1) * sizeof(void *));
+    for (int i = 0; i < conns; i++)
+        table[fds[i]] = &fds[i];
+
+    abcdk_clock_dot(NULL);
+
+    for (int r = 0; r < rounds; r++)
+    {
+        for (int i = 0; i < conns; i++)
+            sum += (uint64_t)table[fds[i]];
+    }
+
+    uint64_t cast_table = abcdk_clock_step(NULL);
+
+    printf("lookup: conns=%d map=%lu(us) table=%lu(us) (%lu)\n", conns, cast_map, cast_table, sum & 1);
+
+    abcdk_heap_free(table);
+    abcdk_map_destroy(&map);
+}
+
+void test_mux_bench(abcdk_tree_t *t)
+{
+    int rounds = abcdk_option_get_int(t, "--rounds", 0, 10);
+    struct rlimit rl = {0};
+    int chk;
+
+    /*尽可能提升句柄数量限制。*/
+    getrlimit(RLIMIT_NOFILE, &rl);
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+
+    ssize_t count = abcdk_option_count(t, "--conns");
+
+    for (ssize_t n = 0; n < (count > 0 ? count : 3); n++)
+    {
+        int conns = (count > 0 ? abcdk_option_get_int(t, "--conns", n, 1000) : (n == 0 ? 1000 : (n == 1 ? 10000 : 100000)));
+
+        /*保留一些句柄给其它用途。*/
+        if (conns + 64 > rl.rlim_cur)
+        {
+            printf("mux: conns=%d skipped(RLIMIT_NOFILE=%lu)\n", conns, rl.rlim_cur);
+            continue;
+        }
+
+        abcdk_mux_param param = {0};
+        param.shards = abcdk_option_get_int(t, "--shards", 0, 1);
+        param.wait_max = abcdk_option_get_int(t, "--wait-max", 0, 20);
+        param.backend = abcdk_option_get_int(t, "--backend", 0, ABCDK_MUX_BACKEND_EPOLL);
+
+        abcdk_mux_t *m = abcdk_mux_alloc2(&param);
+        int *fds = abcdk_heap_alloc(conns * sizeof(int));
+
+        for (int i = 0; i < conns; i++)
+        {
+            fds[i] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            assert(fds[i] >= 0);
+
+            chk = abcdk_mux_attach2(m, fds[i], 0);
+            assert(chk == 0);
+            chk = abcdk_mux_mark(m, fds[i], ABCDK_EPOLL_INPUT, 0);
+            assert(chk == 0);
+        }
+
+        abcdk_mux_stat stat = {0};
+        abcdk_mux_stat_fetch(m, &stat);
+        printf("mux: backend=%s\n", (stat.backend == ABCDK_MUX_BACKEND_URING ? "io_uring" : "epoll"));
+
+        _test_mux_bench_round(m, fds, conns, rounds, abcdk_option_get_int(t, "--batch", 0, 1));
+        _test_mux_bench_lookup(fds, conns, rounds);
+
+        for (int i = 0; i < conns; i++)
+        {
+            chk = abcdk_mux_detach(m, fds[i]);
+            assert(chk == 0);
+            abcdk_closep(&fds[i]);
+        }
+
+        abcdk_heap_free(fds);
+        abcdk_mux_free(&m);
+    }
+}
+
+typedef struct _test_mux_watchdog_waiter
+{
+    abcdk_mux_t *m;
+    abcdk_epoll_event e;
+    int chk;
+} test_mux_watchdog_waiter;
+
+static void *_test_mux_watchdog_waiter_routine(void *args)
+{
+    test_mux_watchdog_waiter *w = (test_mux_watchdog_waiter *)args;
+
+    /*时间轮为空时没有等待时长的限制。*/
+    w->chk = abcdk_mux_wait(w->m, &w->e, 5000);
+
+    return NULL;
+}
+
+void test_mux_watchdog(abcdk_tree_t *t)
+{
+    int conns = abcdk_option_get_int(t, "--conns", 0, 10);
+    abcdk_mux_param param = {0};
+    param.shards = abcdk_option_get_int(t, "--shards", 0, 1);
+    param.watchdog_tick = abcdk_option_get_int(t, "--tick", 0, 10);
+    param.backend = abcdk_option_get_int(t, "--backend", 0, ABCDK_MUX_BACKEND_EPOLL);
+    int chk;
+
+    abcdk_mux_t *m = abcdk_mux_alloc2(&param);
+    int *fds = abcdk_heap_alloc(conns * sizeof(int));
+
+    uint64_t begin = abcdk_time_clock2kind_with(CLOCK_MONOTONIC, 3);
+
+    for (int i = 0; i < conns; i++)
+    {
+        fds[i] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        assert(fds[i] >= 0);
+
+        /*超时时长依次递增。*/
+        chk = abcdk_mux_attach2(m, fds[i], (i + 1) * 50);
+        assert(chk == 0);
+        chk = abcdk_mux_mark(m, fds[i], ABCDK_EPOLL_INPUT, 0);
+        assert(chk == 0);
+    }
+
+    for (int i = 0; i < conns; i++)
+    {
+        abcdk_epoll_event e;
+        if (abcdk_mux_wait(m, &e, 10000) < 0)
+            break;
+
+        uint64_t span = abcdk_time_clock2kind_with(CLOCK_MONOTONIC, 3) - begin;
+
+        for (int j = 0; j < conns; j++)
+        {
+            if (fds[j] != e.data.fd)
+                continue;
+
+            printf("fd=%d events=%08x timeout=%d(ms) fired=%lu(ms)\n", e.data.fd, e.events, (j + 1) * 50, span);
+        }
+
+        assert(e.events & ABCDK_EPOLL_ERROR);
+        chk = abcdk_mux_unref(m, e.data.fd, e.events);
+        assert(chk == 0);
+        chk = abcdk_mux_detach(m, e.data.fd);
+        assert(chk == 0);
+    }
+
+    for (int i = 0; i < conns; i++)
+        abcdk_closep(&fds[i]);
+
+    /*线程已经阻塞在等待中才添加节点，新节点的超时不能被错过。*/
+    test_mux_watchdog_waiter w = {0};
+    abcdk_thread_t p;
+
+    w.m = m;
+    p.routine = _test_mux_watchdog_waiter_routine;
+    p.opaque = &w;
+    chk = abcdk_thread_create(&p, 1);
+    assert(chk == 0);
+
+    usleep(100 * 1000);
+
+    fds[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    assert(fds[0] >= 0);
+
+    begin = abcdk_time_clock2kind_with(CLOCK_MONOTONIC, 3);
+
+    chk = abcdk_mux_attach2(m, fds[0], 200);
+    assert(chk == 0);
+    chk = abcdk_mux_mark(m, fds[0], ABCDK_EPOLL_INPUT, 0);
+    assert(chk == 0);
+
+    abcdk_thread_join(&p);
+
+    uint64_t span = abcdk_time_clock2kind_with(CLOCK_MONOTONIC, 3) - begin;
+
+    printf("fd=%d events=%08x timeout=200(ms) fired=%lu(ms) (attached while waiting)\n", w.e.data.fd, w.e.events, span);
+
+    assert(w.chk == 0 && w.e.data.fd == fds[0] && (w.e.events & ABCDK_EPOLL_ERROR));
+    assert(span < 200 + 2 * param.watchdog_tick + 100);
+
+    chk = abcdk_mux_unref(m, w.e.data.fd, w.e.events);
+    assert(chk == 0);
+    chk = abcdk_mux_detach(m, w.e.data.fd);
+    assert(chk == 0);
+    abcdk_closep(&fds[0]);
+
+    abcdk_heap_free(fds);
+    abcdk_mux_free(&m);
+}
+
+void test_mux_uring_reuse(abcdk_tree_t *t)
+{
+    abcdk_mux_param param = {0};
+    abcdk_mux_stat stat = {0};
+    abcdk_epoll_event e;
+    uint64_t one = 1;
+    int fd, fd2, fd3, pad = -1, chk;
+
+    /*
+     * 多分片时，检查分片取到完成事件后(不进入内核)，一次提交这期间的注册，
+     * 新注册的完成事件留在完成队列中，直到下一次检查分片。
+    */
+    param.backend = ABCDK_MUX_BACKEND_URING;
+    param.shards = 2;
+
+    abcdk_mux_t *m = abcdk_mux_alloc2(&param);
+    assert(m != NULL);
+
+    abcdk_mux_stat_fetch(m, &stat);
+    if (stat.backend != ABCDK_MUX_BACKEND_URING)
+    {
+        printf("io_uring: not supported, skipped.\n");
+        abcdk_mux_free(&m);
+        return;
+    }
+
+    /*同一个分片中已经提交的注册，完成事件在完成队列中。*/
+    fd3 = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    chk = abcdk_mux_attach2(m, fd3, 0);
+    assert(chk == 0);
+    chk = abcdk_mux_mark(m, fd3, ABCDK_EPOLL_INPUT, 0);
+    assert(chk == 0);
+    chk = abcdk_mux_wait(m, &e, 0);
+    assert(chk < 0);
+    write(fd3, &one, sizeof(one));
+
+    /*注册后句柄就绪，在完成事件被取走之前分离。*/
+    fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd % 2 != fd3 % 2)
+    {
+        pad = fd;
+        fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+    assert(fd % 2 == fd3 % 2);
+    chk = abcdk_mux_attach2(m, fd, 0);
+    assert(chk == 0);
+    chk = abcdk_mux_mark(m, fd, ABCDK_EPOLL_INPUT, 0);
+    assert(chk == 0);
+    write(fd, &one, sizeof(one));
+    chk = abcdk_mux_wait(m, &e, 1000);
+    assert(chk == 0 && e.data.fd == fd3);
+    chk = abcdk_mux_unref(m, fd3, e.events);
+    assert(chk == 0);
+    chk = abcdk_mux_detach(m, fd);
+    assert(chk == 0);
+    close(fd);
+
+    /*复用相同的句柄，旧注册的完成事件不能派发给新的节点。*/
+    fd2 = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    assert(fd2 == fd);
+    chk = abcdk_mux_attach2(m, fd2, 0);
+    assert(chk == 0);
+    chk = abcdk_mux_mark(m, fd2, ABCDK_EPOLL_INPUT, 0);
+    assert(chk == 0);
+
+    chk = abcdk_mux_wait(m, &e, 100);
+    assert(chk < 0);
+
+    /*新的注册正常通知。*/
+    write(fd2, &one, sizeof(one));
+    chk = abcdk_mux_wait(m, &e, 1000);
+    assert(chk == 0 && e.data.fd == fd2 && (e.events & ABCDK_EPOLL_INPUT));
+    chk = abcdk_mux_unref(m, fd2, e.events);
+    assert(chk == 0);
+
+    printf("io_uring: stale completion dropped.\n");
+
+    chk = abcdk_mux_detach(m, fd2);
+    assert(chk == 0);
+    abcdk_closep(&fd2);
+    chk = abcdk_mux_detach(m, fd3);
+    assert(chk == 0);
+    abcdk_closep(&fd3);
+    abcdk_closep(&pad);
+    abcdk_mux_free(&m);
+}
+
+void test_mux_queue(abcdk_tree_t *t)
+{
+    int conns = abcdk_option_get_int(t, "--conns", 0, 1000);
+    abcdk_mux_param param = {0};
+    abcdk_mux_stat stat = {0};
+    int events = 0;
+    int chk;
+
+    param.watchdog_tick = 10;
+    param.queue_size = abcdk_option_get_int(t, "--queue-size", 0, 0);
+    param.backend = abcdk_option_get_int(t, "--backend", 0, ABCDK_MUX_BACKEND_EPOLL);
+
+    abcdk_mux_t *m = abcdk_mux_alloc2(&param);
+    int *fds = abcdk_heap_alloc(conns * sizeof(int));
+
+    /*同时超时，看门狗一次性派发全部的ERROR事件。*/
+    for (int i = 0; i < conns; i++)
+    {
+        fds[i] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        assert(fds[i] >= 0);
+
+        chk = abcdk_mux_attach2(m, fds[i], 20);
+        assert(chk == 0);
+        chk = abcdk_mux_mark(m, fds[i], ABCDK_EPOLL_INPUT, 0);
+        assert(chk == 0);
+    }
+
+    while (events < conns)
+    {
+        abcdk_epoll_event e;
+        if (abcdk_mux_wait(m, &e, 1000) < 0)
+            break;
+
+        assert(e.events & ABCDK_EPOLL_ERROR);
+        chk = abcdk_mux_unref(m, e.data.fd, e.events);
+        assert(chk == 0);
+        chk = abcdk_mux_detach(m, e.data.fd);
+        assert(chk == 0);
+
+        events += 1;
+    }
+
+    abcdk_mux_stat_fetch(m, &stat);
+
+    printf("conns=%d events=%d queue_size=%zu queue_peak=%zu queue_overflow=%lu\n",
+           conns, events, stat.queue_size, stat.queue_peak, stat.queue_overflow);
+
+    assert(events == conns);
+    assert(stat.watchdog_timeouts == conns);
+
+    for (int i = 0; i < conns; i++)
+        abcdk_closep(&fds[i]);
+
+    abcdk_heap_free(fds);
+    abcdk_mux_free(&m);
+}
+
+static void _test_mux_stat_print(abcdk_mux_stat *stat)
+{
+    printf("stat: backend=%s input=%lu inoob=%lu output=%lu error=%lu timeouts=%lu\n",
+           (stat->backend == ABCDK_MUX_BACKEND_URING ? "io_uring" : "epoll"),
+           stat->event_input, stat->event_inoob, stat->event_output, stat->event_error, stat->watchdog_timeouts);
+
+    printf("stat: wait_calls=%lu wait_events=%lu batch=%.2f leader_handoffs=%lu\n",
+           stat->wait_calls, stat->wait_events, (double)stat->wait_events / ABCDK_MAX(stat->wait_calls, (uint64_t)1),
+           stat->leader_handoffs);
+
+    printf("stat: lock_acquires=%lu lock_contended=%lu lock_wait=%lu(us) queue_peak=%zu queue_overflow=%lu\n",
+           stat->lock_acquires, stat->lock_contended, stat->lock_wait_ns / 1000, stat->queue_peak, stat->queue_overflow);
+
+    for (int i = 0; i < ABCDK_MUX_STAT_HIST_BUCKETS; i++)
+    {
+        if (!stat->latency_hist[i])
+            continue;
+
+        if (i == 0)
+            printf("latency: [0,1)(us) %lu\n", stat->latency_hist[i]);
+        else
+            printf("latency: [%lu,%lu)(us) %lu\n", 1UL << (i - 1), 1UL << i, stat->latency_hist[i]);
+    }
+}
+
+typedef struct _test_mux_stat_ctx
+{
+    abcdk_mux_t *mux;
+    volatile int exit_flag;
+    volatile uint64_t snapshots;
+} test_mux_stat_ctx;
+
+static void *_test_mux_stat_worker(void *args)
+{
+    test_mux_stat_ctx *ctx = (test_mux_stat_ctx *)args;
+    abcdk_epoll_event es[8];
+    uint64_t val;
+    int chk;
+
+    while (!ctx->exit_flag)
+    {
+        int n = abcdk_mux_wait_batch(ctx->mux, es, 8, 100);
+        if (n <= 0)
+            continue;
+
+        for (int i = 0; i < n; i++)
+        {
+            read(es[i].data.fd, &val, sizeof(val));
+
+            chk = abcdk_mux_mark(ctx->mux, es[i].data.fd, ABCDK_EPOLL_INPUT, ABCDK_EPOLL_INPUT);
+            assert(chk == 0);
+            chk = abcdk_mux_unref(ctx->mux, es[i].data.fd, es[i].events);
+            assert(chk == 0);
+        }
+    }
+
+    return NULL;
+}
+
+static void *_test_mux_stat_reader(void *args)
+{
+    test_mux_stat_ctx *ctx = (test_mux_stat_ctx *)args;
+    abcdk_mux_stat stat;
+
+    /*与工作线程并发读取，不加锁。*/
+    while (!ctx->exit_flag)
+    {
+        abcdk_mux_stat_fetch(ctx->mux, &stat);
+        abcdk_atomic_fetch_and_add(&ctx->snapshots, 1);
+        usleep(100);
+    }
+
+    return NULL;
+}
+
+void test_mux_stat(abcdk_tree_t *t)
+{
+    int conns = abcdk_option_get_int(t, "--conns", 0, 100);
+    int rounds = abcdk_option_get_int(t, "--rounds", 0, 1000);
+    int threads = abcdk_option_get_int(t, "--threads", 0, 4);
+    abcdk_mux_param param = {0};
+    abcdk_mux_stat stat = {0};
+    test_mux_stat_ctx ctx = {0};
+    uint64_t one = 1, pulled = 0;
+    int chk;
+
+    param.shards = abcdk_option_get_int(t, "--shards", 0, 1);
+    param.backend = abcdk_option_get_int(t, "--backend", 0, ABCDK_MUX_BACKEND_EPOLL);
+
+    ctx.mux = abcdk_mux_alloc2(&param);
+    int *fds = abcdk_heap_alloc(conns * sizeof(int));
+
+    for (int i = 0; i < conns; i++)
+    {
+        fds[i] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        assert(fds[i] >= 0);
+
+        chk = abcdk_mux_attach2(ctx.mux, fds[i], 0);
+        assert(chk == 0);
+        chk = abcdk_mux_mark(ctx.mux, fds[i], ABCDK_EPOLL_INPUT, 0);
+        assert(chk == 0);
+    }
+
+    abcdk_thread_t *ps = abcdk_heap_alloc((threads + 1) * sizeof(abcdk_thread_t));
+    for (int i = 0; i <= threads; i++)
+    {
+        ps[i].routine = (i < threads ? _test_mux_stat_worker : _test_mux_stat_reader);
+        ps[i].opaque = &ctx;
+        chk = abcdk_thread_create(&ps[i], 1);
+        assert(chk == 0);
+    }
+
+    for (int r = 0; r < rounds; r++)
+    {
+        for (int i = 0; i < conns; i++)
+            write(fds[i], &one, sizeof(one));
+    }
+
+    /*等待事件队列排空。*/
+    for (int i = 0; i < 1000; i++)
+    {
+        abcdk_mux_stat_fetch(ctx.mux, &stat);
+        if (stat.queue_count == 0 && i > 10)
+            break;
+
+        usleep(1000);
+    }
+
+    ctx.exit_flag = 1;
+    for (int i = 0; i <= threads; i++)
+        abcdk_thread_join(&ps[i]);
+
+    abcdk_mux_stat_fetch(ctx.mux, &stat);
+    _test_mux_stat_print(&stat);
+
+    for (int i = 0; i < ABCDK_MUX_STAT_HIST_BUCKETS; i++)
+        pulled += stat.latency_hist[i];
+
+    printf("stat: snapshots=%lu pulled=%lu\n", ctx.snapshots, pulled);
+
+    /*分派的事件，或者已经被拉取，或者还在队列中。*/
+    assert(pulled + stat.queue_count == stat.event_input + stat.event_error);
+    assert(stat.event_input > 0 && stat.wait_calls > 0 && stat.lock_acquires > 0);
+
+    for (int i = 0; i < conns; i++)
+    {
+        chk = abcdk_mux_detach(ctx.mux, fds[i]);
+        assert(chk == 0);
+        abcdk_closep(&fds[i]);
+    }
+
+    abcdk_heap_free(ps);
+    abcdk_heap_free(fds);
+    abcdk_mux_free(&ctx.mux);
+}
+
+typedef struct _test_accept_ctx
+{
+    abcdk_mux_t *mux;
+    volatile int exit_flag;
+    volatile uint64_t accepted;
+} test_accept_ctx;
+
+static void *_test_accept_bench_worker(void *args)
+{
+    test_accept_ctx *ctx = (test_accept_ctx *)args;
+    abcdk_epoll_event es[16];
+    int chk;
+
+    while (!ctx->exit_flag)
+    {
+        int n = abcdk_mux_wait_batch(ctx->mux, es, 16, 100);
+        if (n <= 0)
+            continue;
+
+        for (int i = 0; i < n; i++)
+        {
+            if (es[i].events & ABCDK_EPOLL_INPUT)
+            {
+                /*每个监听句柄都是非阻塞的，接收到EAGAIN为止。*/
+                while (1)
+                {
+                    int c = abcdk_accept(es[i].data.fd, NULL);
+                    if (c < 0)
+                        break;
+
+                    abcdk_closep(&c);
+                    abcdk_atomic_fetch_and_add(&ctx->accepted, 1);
+                }
+
+                chk = abcdk_mux_mark(ctx->mux, es[i].data.fd, ABCDK_EPOLL_INPUT, ABCDK_EPOLL_INPUT);
+                assert(chk == 0);
+            }
+
+            chk = abcdk_mux_unref(ctx->mux, es[i].data.fd, es[i].events);
+            assert(chk == 0);
+        }
+    }
+
+    return NULL;
+}
+
+void test_accept_bench(abcdk_tree_t *t)
+{
+    int conns = abcdk_option_get_int(t, "--conns", 0, 10000);
+    int listeners = abcdk_option_get_int(t, "--listeners", 0, 1);
+    int threads = abcdk_option_get_int(t, "--threads", 0, 4);
+    abcdk_mux_param param = {0};
+    abcdk_sockaddr_t a = {0};
+    test_accept_ctx ctx = {0};
+    int fds[256];
+    int chk;
+
+    param.shards = abcdk_option_get_int(t, "--shards", 0, 1);
+    param.backend = abcdk_option_get_int(t, "--backend", 0, ABCDK_MUX_BACKEND_EPOLL);
+    listeners = ABCDK_MIN(ABCDK_MAX(listeners, 1), (int)ABCDK_ARRAY_SIZE(fds));
+    threads = ABCDK_MAX(threads, (int)param.shards);
+
+    abcdk_sockaddr_from_string(&a, abcdk_option_get(t, "--addr", 0, "127.0.0.1:12346"), 0);
+
+    /*每个监听句柄一个分片(句柄连续分配，按句柄取模后落在不同的分片)。*/
+    chk = abcdk_listen_reuseport(fds, listeners, &a, 0);
+    assert(chk == 0);
+
+    ctx.mux = abcdk_mux_alloc2(&param);
+
+    for (int i = 0; i < listeners; i++)
+    {
+        chk = abcdk_mux_attach2(ctx.mux, fds[i], 0);
+        assert(chk == 0);
+        chk = abcdk_mux_mark(ctx.mux, fds[i], ABCDK_EPOLL_INPUT, 0);
+        assert(chk == 0);
+    }
+
+    abcdk_thread_t *ps = abcdk_heap_alloc(threads * sizeof(abcdk_thread_t));
+    for (int i = 0; i < threads; i++)
+    {
+        ps[i].routine = _test_accept_bench_worker;
+        ps[i].opaque = &ctx;
+        chk = abcdk_thread_create(&ps[i], 1);
+        assert(chk == 0);
+    }
+
+    abcdk_clock_dot(NULL);
+
+    for (int i = 0; i < conns; i++)
+    {
+        int c = abcdk_socket(a.family, 0);
+        assert(c >= 0);
+
+        /*SO_LINGER=0，关闭时直接复位，避免客户端的TIME_WAIT耗尽端口。*/
+        struct linger l = {1, 0};
+        setsockopt(c, SOL_SOCKET, SO_LINGER, &l, sizeof(l));
+
+        if (abcdk_connect(c, &a, 10000) != 0)
+        {
+            abcdk_closep(&c);
+            break;
+        }
+
+        abcdk_closep(&c);
+    }
+
+    /*等待服务端接收完毕。*/
+    for (int i = 0; i < 1000 && abcdk_atomic_load(&ctx.accepted) < conns; i++)
+        usleep(1000);
+
+    uint64_t cast = abcdk_clock_step(NULL);
+    uint64_t accepted = abcdk_atomic_load(&ctx.accepted);
+
+    printf("accept: listeners=%d shards=%zu threads=%d conns=%d accepted=%lu cast=%lu(us) rate=%.0f(conns/s)\n",
+           listeners, param.shards, threads, conns, accepted, cast, (double)accepted * 1000000 / ABCDK_MAX(cast, (uint64_t)1));
+
+    ctx.exit_flag = 1;
+    for (int i = 0; i < threads; i++)
+        abcdk_thread_join(&ps[i]);
+
+    for (int i = 0; i < listeners; i++)
+    {
+        chk = abcdk_mux_detach(ctx.mux, fds[i]);
+        assert(chk == 0);
+        abcdk_closep(&fds[i]);
+    }
+
+    abcdk_heap_free(ps);
+    abcdk_mux_free(&ctx.mux);
+}
+
+static void _test_comm_echo_read_cb(abcdk_comm_node_t *node, abcdk_buffer_t *rbuf, void *opaque)
+{
+    /*原样返回。*/
+    if (abcdk_comm_write(node, ABCDK_PTR2VPTR(rbuf->data, rbuf->rsize), rbuf->wsize - rbuf->rsize) > 0)
+        rbuf->rsize = rbuf->wsize;
+}
+
+typedef struct _test_comm_ctx
+{
+    abcdk_comm_t *comm;
+    abcdk_comm_callback conn_cb;
+    volatile int exit_flag;
+    int file_fd;
+    size_t file_size;
+    int pipe_fd;
+} test_comm_ctx;
+
+static void _test_comm_echo_accept_cb(abcdk_comm_node_t *node, int fd, void *opaque)
+{
+    test_comm_ctx *ctx = (test_comm_ctx *)opaque;
+
+    if (!abcdk_comm_attach(ctx->comm, fd, &ctx->conn_cb, ctx, 10 * 1000))
+        abcdk_closep(&fd);
+}
+
+static void *_test_comm_worker(void *args)
+{
+    test_comm_ctx *ctx = (test_comm_ctx *)args;
+
+    while (!ctx->exit_flag)
+        abcdk_comm_dispatch(ctx->comm, 100);
+
+    return NULL;
+}
+
+void test_comm_echo(abcdk_tree_t *t)
+{
+    int conns = abcdk_option_get_int(t, "--conns", 0, 16);
+    size_t bytes = abcdk_option_get_int(t, "--bytes", 0, 1024 * 1024);
+    int threads = abcdk_option_get_int(t, "--threads", 0, 2);
+    abcdk_comm_param param = {0};
+    abcdk_comm_callback lcb = {0};
+    test_comm_ctx ctx = {0};
+    abcdk_sockaddr_t a = {0};
+    int l = -1;
+    int chk;
+
+    param.mux.shards = abcdk_option_get_int(t, "--shards", 0, 1);
+    param.mux.backend = abcdk_option_get_int(t, "--backend", 0, ABCDK_MUX_BACKEND_EPOLL);
+    param.wq_high = abcdk_option_get_int(t, "--wq-high", 0, 64 * 1024);
+
+    ctx.comm = abcdk_comm_alloc(&param);
+
+    ctx.conn_cb.read_cb = _test_comm_echo_read_cb;
+    lcb.accept_cb = _test_comm_echo_accept_cb;
+
+    abcdk_sockaddr_from_string(&a, abcdk_option_get(t, "--addr", 0, "127.0.0.1:12347"), 0);
+    chk = abcdk_listen_reuseport(&l, 1, &a, 0);
+    assert(chk == 0);
+    abcdk_comm_node_t *ln = abcdk_comm_listen(ctx.comm, l, &lcb, &ctx);
+    assert(ln != NULL);
+
+    abcdk_thread_t *ps = abcdk_heap_alloc(threads * sizeof(abcdk_thread_t));
+    for (int i = 0; i < threads; i++)
+    {
+        ps[i].routine = _test_comm_worker;
+        ps[i].opaque = &ctx;
+        chk = abcdk_thread_create(&ps[i], 1);
+        assert(chk == 0);
+    }
+
+    struct pollfd *pfds = abcdk_heap_alloc(conns * sizeof(struct pollfd));
+    size_t *sent = abcdk_heap_alloc(conns * sizeof(size_t));
+    size_t *recvd = abcdk_heap_alloc(conns * sizeof(size_t));
+    char buf[16 * 1024];
+    int done = 0;
+
+    for (int i = 0; i < conns; i++)
+    {
+        pfds[i].fd = abcdk_socket(a.family, 0);
+        chk = abcdk_connect(pfds[i].fd, &a, 10000);
+        assert(chk == 0);
+        abcdk_fflag_add(pfds[i].fd, O_NONBLOCK);
+    }
+
+    abcdk_clock_dot(NULL);
+
+    /*客户端同时发送和接收，数据内容是偏移量的低8位，接收时校验。*/
+    while (done < conns)
+    {
+        for (int i = 0; i < conns; i++)
+            pfds[i].events = (recvd[i] < bytes ? POLLIN : 0) | (sent[i] < bytes ? POLLOUT : 0);
+
+        if (poll(pfds, conns, 10000) <= 0)
+            break;
+
+        for (int i = 0; i < conns; i++)
+        {
+            if ((pfds[i].revents & POLLOUT) && sent[i] < bytes)
+            {
+                size_t n = ABCDK_MIN(bytes - sent[i], sizeof(buf));
+                for (size_t j = 0; j < n; j++)
+                    buf[j] = (char)(sent[i] + j);
+
+                ssize_t w = send(pfds[i].fd, buf, n, MSG_NOSIGNAL);
+                if (w > 0)
+                    sent[i] += w;
+            }
+
+            if ((pfds[i].revents & POLLIN) && recvd[i] < bytes)
+            {
+                ssize_t r = recv(pfds[i].fd, buf, sizeof(buf), 0);
+                for (ssize_t j = 0; j < r; j++)
+                    assert(buf[j] == (char)(recvd[i] + j));
+
+                if (r > 0)
+                    recvd[i] += r;
+                if (recvd[i] >= bytes)
+                    done += 1;
+            }
+        }
+    }
+
+    uint64_t cast = abcdk_clock_step(NULL);
+
+    printf("comm: conns=%d bytes=%zu done=%d cast=%lu(us) rate=%.2f(MB/s)\n",
+           conns, bytes, done, cast, (double)bytes * conns * 2 / ABCDK_MAX(cast, (uint64_t)1));
+
+    assert(done == conns);
+
+    for (int i = 0; i < conns; i++)
+        abcdk_closep(&pfds[i].fd);
+
+    abcdk_comm_close(ln);
+
+    /*等待服务端关闭连接。*/
+    usleep(200 * 1000);
+
+    ctx.exit_flag = 1;
+    for (int i = 0; i < threads; i++)
+        abcdk_thread_join(&ps[i]);
+
+    abcdk_heap_free(pfds);
+    abcdk_heap_free(sent);
+    abcdk_heap_free(recvd);
+    abcdk_heap_free(ps);
+    abcdk_comm_free(&ctx.comm);
+}
+
+static void _test_comm_sendfile_read_cb(abcdk_comm_node_t *node, abcdk_buffer_t *rbuf, void *opaque)
+{
+    test_comm_ctx *ctx = (test_comm_ctx *)opaque;
+    int chk;
+    ssize_t rsize;
+
+    rbuf->rsize = rbuf->wsize;
+
+    /*内存、文件区间(sendfile)、管道(splice)按顺序发送，发送完后关闭。*/
+    rsize = abcdk_comm_write(node, "HEAD", 4);
+    assert(rsize == 4);
+    chk = abcdk_comm_sendfile(node, ctx->file_fd, 1000, ctx->file_size - 1000);
+    assert(chk == 0);
+    chk = abcdk_comm_sendfile(node, ctx->pipe_fd, -1, 0);
+    assert(chk == 0);
+    abcdk_comm_close(node);
+}
+
+static void *_test_comm_sendfile_pipe_writer(void *args)
+{
+    int fd = *(int *)args;
+    char buf[4096];
+    ssize_t rsize;
+
+    for (size_t off = 0; off < 1024 * 1024; off += sizeof(buf))
+    {
+        for (size_t j = 0; j < sizeof(buf); j++)
+            buf[j] = (char)((off + j) * 7);
+
+        /*时常停顿，管道被取空，调度线程不能阻塞在管道上。*/
+        if (off % (64 * 1024) == 0)
+            usleep(1000);
+
+        /*停顿较长的时间，调度线程不能反复处理输出事件(套接字一直可写)。*/
+        if (off == 512 * 1024)
+            usleep(300 * 1000);
+
+        rsize = abcdk_write(fd, buf, sizeof(buf));
+        assert(rsize == sizeof(buf));
+    }
+
+    abcdk_closep(&fd);
+
+    return NULL;
+}
+
+void test_comm_sendfile(abcdk_tree_t *t)
+{
+    abcdk_comm_param param = {0};
+    abcdk_comm_callback lcb = {0};
+    test_comm_ctx ctx = {0};
+    abcdk_sockaddr_t a = {0};
+    abcdk_thread_t p, w;
+    char file[] = "/tmp/abcdk_comm_sendfile_XXXXXX";
+    int pfd[2], l = -1;
+    char buf[4096];
+    int chk;
+    ssize_t rsize;
+
+    ctx.file_size = abcdk_option_get_int(t, "--bytes", 0, 8 * 1024 * 1024);
+    param.mux.backend = abcdk_option_get_int(t, "--backend", 0, ABCDK_MUX_BACKEND_EPOLL);
+
+    /*文件内容是偏移量的低8位。*/
+    ctx.file_fd = mkstemp(file);
+    assert(ctx.file_fd >= 0);
+    unlink(file);
+
+    for (size_t off = 0; off < ctx.file_size; off += sizeof(buf))
+    {
+        for (size_t j = 0; j < sizeof(buf); j++)
+            buf[j] = (char)(off + j);
+
+        rsize = abcdk_write(ctx.file_fd, buf, ABCDK_MIN(sizeof(buf), ctx.file_size - off));
+        assert(rsize > 0);
+    }
+
+    chk = pipe(pfd);
+    assert(chk == 0);
+    ctx.pipe_fd = pfd[0];
+
+    w.routine = _test_comm_sendfile_pipe_writer;
+    w.opaque = &pfd[1];
+    chk = abcdk_thread_create(&w, 1);
+    assert(chk == 0);
+
+    ctx.comm = abcdk_comm_alloc(&param);
+    ctx.conn_cb.read_cb = _test_comm_sendfile_read_cb;
+    lcb.accept_cb = _test_comm_echo_accept_cb;
+
+    abcdk_sockaddr_from_string(&a, abcdk_option_get(t, "--addr", 0, "127.0.0.1:12348"), 0);
+    chk = abcdk_listen_reuseport(&l, 1, &a, 0);
+    assert(chk == 0);
+
+    abcdk_comm_node_t *ln = abcdk_comm_listen(ctx.comm, l, &lcb, &ctx);
+    assert(ln != NULL);
+
+    p.routine = _test_comm_worker;
+    p.opaque = &ctx;
+    chk = abcdk_thread_create(&p, 1);
+    assert(chk == 0);
+
+    int c = abcdk_socket(a.family, 0);
+    chk = abcdk_connect(c, &a, 10000);
+    assert(chk == 0);
+    rsize = send(c, "G", 1, 0);
+    assert(rsize == 1);
+
+    size_t total = 0;
+    size_t expect = 4 + (ctx.file_size - 1000) + 1024 * 1024;
+
+    abcdk_clock_dot(NULL);
+
+    while (1)
+    {
+        ssize_t r = recv(c, buf, sizeof(buf), 0);
+        if (r <= 0)
+            break;
+
+        for (ssize_t j = 0; j < r; j++, total++)
+        {
+            if (total < 4)
+                assert(buf[j] == "HEAD"[total]);
+            else if (total < 4 + ctx.file_size - 1000)
+                assert(buf[j] == (char)(total - 4 + 1000));
+            else
+                assert(buf[j] == (char)((total - 4 - (ctx.file_size - 1000)) * 7));
+        }
+    }
+
+    uint64_t cast = abcdk_clock_step(NULL);
+
+    printf("sendfile: total=%zu expect=%zu cast=%lu(us) rate=%.2f(MB/s)\n",
+           total, expect, cast, (double)total / ABCDK_MAX(cast, (uint64_t)1));
+
+    assert(total == expect);
+
+    /*不支持定位的源句柄被设为非阻塞(共享文件描述)。*/
+    assert(fcntl(ctx.pipe_fd, F_GETFL) & O_NONBLOCK);
+
+    /*源句柄没有数据时等待源句柄可读，输出事件的数量与发送的数据量相关，与停顿的时长无关。*/
+    abcdk_mux_stat stat = {0};
+    abcdk_mux_stat_fetch(abcdk_comm_mux(ctx.comm), &stat);
+    printf("sendfile: event_output=%lu event_input=%lu\n", stat.event_output, stat.event_input);
+    assert(stat.event_output < 10000);
+
+    abcdk_closep(&c);
+    abcdk_comm_close(ln);
+
+    usleep(200 * 1000);
+
+    ctx.exit_flag = 1;
+    abcdk_thread_join(&p);
+    abcdk_thread_join(&w);
+
+    abcdk_closep(&ctx.pipe_fd);
+    abcdk_closep(&ctx.file_fd);
+    abcdk_comm_free(&ctx.comm);
+}
+
 void test_mux(abcdk_tree_t *args)
 {
     if(abcdk_option_exist(args,"--server"))
@@ -249,6 +1256,30 @@ int main(int argc, char **argv)
     if(abcdk_strcmp(func,"test_mux",0)==0)
         test_mux(args);
 
+    if(abcdk_strcmp(func,"test_mux_bench",0)==0)
+        test_mux_bench(args);
+
+    if(abcdk_strcmp(func,"test_mux_watchdog",0)==0)
+        test_mux_watchdog(args);
+
+    if(abcdk_strcmp(func,"test_mux_queue",0)==0)
+        test_mux_queue(args);
+
+    if(abcdk_strcmp(func,"test_mux_uring_reuse",0)==0)
+        test_mux_uring_reuse(args);
+
+    if(abcdk_strcmp(func,"test_mux_stat",0)==0)
+        test_mux_stat(args);
+
+    if(abcdk_strcmp(func,"test_accept_bench",0)==0)
+        test_accept_bench(args);
+
+    if(abcdk_strcmp(func,"test_comm_echo",0)==0)
+        test_comm_echo(args);
+
+    if(abcdk_strcmp(func,"test_comm_sendfile",0)==0)
+        test_comm_sendfile(args);
+
     abcdk_tree_free(&args);
 
     return 0;
@@ -18,6 +18,16 @@
 #include "abcdkutil/clock.h"
 #include "abcdkutil/crc32.h"
 #include "abcdkutil/robots.h"
+#include "abcdkutil/map.h"
+#include "abcdkutil/slab.h"
+#include "abcdkutil/thread.h"
+#include "abcdkutil/pool.h"
+#include "abcdkutil/ring.h"
+#include "abcdkutil/cmap.h"
+#include "abcdkutil/bptree.h"
+#include "abcdkutil/dirent.h"
+#include "abcdkutil/blockio.h"
+#include "abcdkutil/chain.h"
 
 
 void test_log(abcdk_tree_t *args)
@@ -288,6 +298,2796 @@ void test_robots(abcdk_tree_t *args)
     abcdk_robots_parse_file(file,"*");
 }
 
+static size_t _test_rss_bytes()
+{
+    size_t pages = 0, rss = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+
+    if (fp)
+    {
+        fscanf(fp, "%zu %zu", &pages, &rss);
+        fclose(fp);
+    }
+
+    return rss * sysconf(_SC_PAGESIZE);
+}
+
+static void _test_allocator_destroy_cb(abcdk_allocator_t *alloc, void *opaque)
+{
+    *((int *)opaque) += 1;
+}
+
+static void *_test_allocator_slab_worker(void *args)
+{
+    void **ptrs = (void **)args;
+
+    /*申请的内存块交给主线程释放。*/
+    for (int i = 0; i < 10000; i++)
+    {
+        ptrs[i] = abcdk_slab_alloc(1 + (i * 7) % ABCDK_SLAB_SIZE_MAX);
+        assert(ptrs[i] != NULL && ((uint8_t *)ptrs[i])[0] == 0);
+        memset(ptrs[i], 0xA5, 1 + (i * 7) % ABCDK_SLAB_SIZE_MAX);
+    }
+
+    return NULL;
+}
+
+void test_allocator_slab(abcdk_tree_t *args)
+{
+    int count = abcdk_option_get_int(args, "--count", 0, 1000000);
+    int threads = abcdk_option_get_int(args, "--threads", 0, 4);
+    abcdk_slab_stat stat = {0};
+    int destroyed = 0;
+    int chk;
+
+    /*字典：每个元素申请一次(KEY和VALUE在同一块内存中)。*/
+    for (int backend = ABCDK_ALLOCATOR_BACKEND_HEAP; backend <= ABCDK_ALLOCATOR_BACKEND_SLAB; backend++)
+    {
+        abcdk_map_t m = {0};
+        abcdk_slab_stat before = {0}, after = {0};
+
+        abcdk_allocator_backend_set(backend);
+        abcdk_slab_stat_fetch(&before);
+
+        size_t rss = _test_rss_bytes();
+
+        abcdk_clock_dot(NULL);
+
+        abcdk_map_init(&m, count / 4 + 1);
+        for (int i = 0; i < count; i++)
+        {
+            abcdk_allocator_t *v = abcdk_map_find(&m, &i, sizeof(i), sizeof(uint64_t));
+            assert(v != NULL);
+        }
+
+        uint64_t cast_insert = abcdk_clock_step(NULL);
+        size_t rss_used = _test_rss_bytes() - rss;
+
+        abcdk_slab_stat_fetch(&after);
+
+        for (int i = 0; i < count; i += 2)
+            abcdk_map_remove(&m, &i, sizeof(i));
+        abcdk_map_destroy(&m);
+
+        uint64_t cast_free = abcdk_clock_step(NULL);
+
+        printf("%s: count=%d insert=%lu(us) free=%lu(us) rss=%zu(KB)\n",
+               (backend == ABCDK_ALLOCATOR_BACKEND_SLAB ? "slab" : "heap"), count, cast_insert, cast_free, rss_used / 1024);
+
+        if (backend != ABCDK_ALLOCATOR_BACKEND_SLAB)
+            continue;
+
+        printf("slab: alloc_count=%lu heap_count=%lu live=%lu(KB) pages=%lu(KB) heap=%lu(KB) rss_saved=%ld(KB)\n",
+               after.alloc_count - before.alloc_count, after.heap_count - before.heap_count,
+               after.live_bytes / 1024, after.page_bytes / 1024, after.heap_bytes / 1024, after.rss_saved / 1024);
+    }
+
+    abcdk_allocator_backend_set(ABCDK_ALLOCATOR_BACKEND_SLAB);
+
+    /*引用计数和析构函数。*/
+    abcdk_allocator_t *a = abcdk_allocator_alloc2(100);
+    abcdk_allocator_atfree(a, _test_allocator_destroy_cb, &destroyed);
+    assert(abcdk_slab_owned(a));
+
+    abcdk_allocator_t *b = abcdk_allocator_refer(a);
+    abcdk_allocator_unref(&a);
+    assert(destroyed == 0);
+
+    abcdk_allocator_t *c = abcdk_allocator_privatize(&b);
+    assert(c != NULL && b == NULL && destroyed == 0);
+    abcdk_allocator_unref(&c);
+    assert(destroyed == 1);
+
+    /*切换后端后，之前申请的内存块也能正确释放。*/
+    abcdk_tree_t *t1 = abcdk_tree_alloc3(10);
+    abcdk_allocator_backend_set(ABCDK_ALLOCATOR_BACKEND_HEAP);
+    abcdk_tree_t *t2 = abcdk_tree_alloc3(10);
+    assert(abcdk_slab_owned(t1) && !abcdk_slab_owned(t2));
+    abcdk_tree_insert2(t1, t2, 0);
+    abcdk_tree_free(&t1);
+
+    /*跨线程释放。*/
+    abcdk_thread_t *ps = abcdk_heap_alloc(threads * sizeof(abcdk_thread_t));
+    void ***ptrs = abcdk_heap_alloc(threads * sizeof(void **));
+    for (int i = 0; i < threads; i++)
+    {
+        ptrs[i] = abcdk_heap_alloc(10000 * sizeof(void *));
+        ps[i].routine = _test_allocator_slab_worker;
+        ps[i].opaque = ptrs[i];
+        chk = abcdk_thread_create(&ps[i], 1);
+        assert(chk == 0);
+    }
+
+    for (int i = 0; i < threads; i++)
+    {
+        abcdk_thread_join(&ps[i]);
+
+        for (int j = 0; j < 10000; j++)
+            abcdk_slab_free(ptrs[i][j]);
+
+        abcdk_heap_free(ptrs[i]);
+    }
+
+    abcdk_heap_free(ptrs);
+    abcdk_heap_free(ps);
+
+    abcdk_slab_stat_fetch(&stat);
+    assert(stat.alloc_count == stat.free_count);
+
+    abcdk_slab_stat_fetch(&stat);
+    assert(stat.alloc_count == stat.free_count);
+}
+
+void test_allocator_bench(abcdk_tree_t *args)
+{
+    size_t sizes[] = {4096, 65536, 4 * 1024 * 1024, 64 * 1024 * 1024};
+    const char *names[] = {"heap_alloc", "heap_malloc", "alloc", "alloc_uninit", "alloc_hugepage"};
+    int flags[] = {0, 0, 0, ABCDK_ALLOCATOR_UNINIT, ABCDK_ALLOCATOR_HUGEPAGE};
+
+    for (int i = 0; i < ABCDK_ARRAY_SIZE(sizes); i++)
+    {
+        /*每种长度申请并覆盖1G(至少16次)。*/
+        int rounds = ABCDK_MAX((size_t)16, (size_t)1024 * 1024 * 1024 / sizes[i]);
+
+        for (int m = 0; m < ABCDK_ARRAY_SIZE(names); m++)
+        {
+            abcdk_clock_dot(NULL);
+
+            for (int r = 0; r < rounds; r++)
+            {
+                if (m <= 1)
+                {
+                    void *p = (m == 0 ? abcdk_heap_alloc(sizes[i]) : abcdk_heap_malloc(sizes[i]));
+                    assert(p != NULL);
+
+                    /*申请后立即被覆盖。*/
+                    memset(p, r, sizes[i]);
+                    abcdk_heap_free(p);
+                }
+                else
+                {
+                    abcdk_allocator_t *p = abcdk_allocator_alloc3(&sizes[i], 1, 0, flags[m]);
+                    assert(p != NULL);
+
+                    memset(p->pptrs[0], r, sizes[i]);
+                    abcdk_allocator_unref(&p);
+                }
+            }
+
+            uint64_t cast = abcdk_clock_step(NULL);
+
+            printf("size=%zu(KB) %-14s rounds=%d cast=%lu(us) avg=%.2f(us) rate=%.2f(GB/s)\n",
+                   sizes[i] / 1024, names[m], rounds, cast, (double)cast / rounds,
+                   (double)sizes[i] * rounds / 1024 / 1024 / 1024 * 1000000 / ABCDK_MAX(cast, (uint64_t)1));
+        }
+    }
+}
+
+typedef struct _test_ring_ctx
+{
+    /** 无锁池子，NULL(0) 使用加锁的池子。*/
+    abcdk_ring_t *ring;
+
+    abcdk_pool_t pool;
+    abcdk_mutex_t mutex;
+
+    /** 元素大小。*/
+    size_t size;
+
+    /** 每个生产者推送的数量。*/
+    uint64_t per_producer;
+
+    /** 总数量。*/
+    uint64_t total;
+
+    /** 生产者数量和已结束的生产者数量。*/
+    int producers;
+    int producers_done;
+
+    /** 已拉取的数量和数值之和。*/
+    uint64_t pulled;
+    uint64_t pulled_sum;
+
+} test_ring_ctx;
+
+static ssize_t _test_ring_push(test_ring_ctx *ctx, const void *buf)
+{
+    ssize_t chk;
+
+    if (ctx->ring)
+        return abcdk_ring_push(ctx->ring, buf, ctx->size);
+
+    abcdk_mutex_lock(&ctx->mutex, 1);
+    chk = abcdk_pool_push(&ctx->pool, buf, ctx->size);
+    abcdk_mutex_unlock(&ctx->mutex);
+
+    return chk;
+}
+
+static ssize_t _test_ring_pull(test_ring_ctx *ctx, void *buf)
+{
+    ssize_t chk;
+
+    if (ctx->ring)
+        return abcdk_ring_pull(ctx->ring, buf, ctx->size);
+
+    abcdk_mutex_lock(&ctx->mutex, 1);
+    chk = abcdk_pool_pull(&ctx->pool, buf, ctx->size);
+    abcdk_mutex_unlock(&ctx->mutex);
+
+    return chk;
+}
+
+static void *_test_ring_producer(void *opaque)
+{
+    test_ring_ctx *ctx = (test_ring_ctx *)opaque;
+    uint64_t buf[32] = {0};
+
+    for (uint64_t i = 1; i <= ctx->per_producer; i++)
+    {
+        buf[0] = i;
+        while (_test_ring_push(ctx, buf) < 0)
+            sched_yield();
+    }
+
+    __atomic_add_fetch(&ctx->producers_done, 1, __ATOMIC_RELEASE);
+
+    return NULL;
+}
+
+static void *_test_ring_consumer(void *opaque)
+{
+    test_ring_ctx *ctx = (test_ring_ctx *)opaque;
+    uint64_t buf[32] = {0};
+    uint64_t count = 0, sum = 0;
+    int done;
+
+    for (;;)
+    {
+        /*生产者全部结束后，拉取失败表示已经取空。*/
+        done = (__atomic_load_n(&ctx->producers_done, __ATOMIC_ACQUIRE) == ctx->producers);
+
+        if (_test_ring_pull(ctx, buf) < 0)
+        {
+            if (done)
+                break;
+
+            sched_yield();
+            continue;
+        }
+
+        count += 1;
+        sum += buf[0];
+    }
+
+    __atomic_add_fetch(&ctx->pulled_sum, sum, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&ctx->pulled, count, __ATOMIC_RELAXED);
+
+    return NULL;
+}
+
+void test_ring_bench(abcdk_tree_t *args)
+{
+    int count = abcdk_option_get_int(args, "--count", 0, 1000000);
+    int size = abcdk_option_get_int(args, "--size", 0, 64);
+    int number = abcdk_option_get_int(args, "--number", 0, 1024);
+    int max_threads = abcdk_option_get_int(args, "--threads", 0, 32);
+    const char *names[] = {"pool+mutex", "ring_mpmc", "ring_mpsc", "ring_spsc"};
+    int modes[] = {-1, ABCDK_RING_MPMC, ABCDK_RING_MPSC, ABCDK_RING_SPSC};
+    int chk;
+    ssize_t rsize;
+
+    assert(size >= sizeof(uint64_t) && size <= 32 * sizeof(uint64_t));
+
+    for (int threads = 1; threads <= max_threads; threads *= 2)
+    {
+        for (int m = 0; m < ABCDK_ARRAY_SIZE(names); m++)
+        {
+            test_ring_ctx ctx = {0};
+            int producers, consumers;
+
+            if (threads == 1)
+            {
+                /*单线程交替推送和拉取，测量无竞争时的开销。*/
+                producers = consumers = 0;
+            }
+            else if (modes[m] == ABCDK_RING_SPSC)
+            {
+                if (threads != 2)
+                    continue;
+
+                producers = consumers = 1;
+            }
+            else if (modes[m] == ABCDK_RING_MPSC)
+            {
+                producers = threads - 1;
+                consumers = 1;
+            }
+            else
+            {
+                producers = threads / 2;
+                consumers = threads - producers;
+            }
+
+            ctx.size = size;
+            ctx.producers = producers;
+            ctx.per_producer = count / ABCDK_MAX(producers, 1);
+            ctx.total = ctx.per_producer * ABCDK_MAX(producers, 1);
+
+            if (modes[m] < 0)
+            {
+                abcdk_mutex_init2(&ctx.mutex, 0);
+                chk = abcdk_pool_init(&ctx.pool, size, number);
+                assert(chk == 0);
+            }
+            else
+            {
+                ctx.ring = abcdk_ring_alloc(size, number, modes[m]);
+                assert(ctx.ring != NULL);
+            }
+
+            abcdk_thread_t *ps = abcdk_heap_alloc((producers + consumers + 1) * sizeof(abcdk_thread_t));
+
+            abcdk_clock_dot(NULL);
+
+            if (threads == 1)
+            {
+                uint64_t buf[32] = {0};
+
+                for (uint64_t i = 1; i <= ctx.total; i++)
+                {
+                    buf[0] = i;
+                    rsize = _test_ring_push(&ctx, buf);
+                    assert(rsize == size);
+                    rsize = _test_ring_pull(&ctx, buf);
+                    assert(rsize == size);
+                    ctx.pulled += 1;
+                    ctx.pulled_sum += buf[0];
+                }
+            }
+            else
+            {
+                for (int i = 0; i < producers + consumers; i++)
+                {
+                    ps[i].routine = (i < producers ? _test_ring_producer : _test_ring_consumer);
+                    ps[i].opaque = &ctx;
+                    chk = abcdk_thread_create(&ps[i], 1);
+                    assert(chk == 0);
+                }
+
+                for (int i = 0; i < producers + consumers; i++)
+                    abcdk_thread_join(&ps[i]);
+            }
+
+            uint64_t cast = abcdk_clock_step(NULL);
+
+            /*每个生产者推送1~per_producer。*/
+            assert(ctx.pulled == ctx.total);
+            assert(ctx.pulled_sum == ctx.per_producer * (ctx.per_producer + 1) / 2 * ABCDK_MAX(producers, 1));
+
+            if (ctx.ring)
+                assert(abcdk_ring_count(ctx.ring) == 0);
+            else
+                assert(ctx.pool.count == 0);
+
+            printf("threads=%-2d %-10s producers=%-2d consumers=%-2d items=%lu cast=%lu(us) rate=%.2f(M/s)\n",
+                   threads, names[m], producers, consumers, ctx.total, cast,
+                   (double)ctx.total / ABCDK_MAX(cast, (uint64_t)1));
+
+            abcdk_heap_free(ps);
+            abcdk_ring_free(&ctx.ring);
+            abcdk_pool_destroy(&ctx.pool);
+            if (modes[m] < 0)
+                abcdk_mutex_destroy(&ctx.mutex);
+        }
+    }
+}
+
+void test_pool_span(abcdk_tree_t *args)
+{
+    int count = abcdk_option_get_int(args, "--count", 0, 10000000);
+    int number = abcdk_option_get_int(args, "--number", 0, 1024);
+    int batch = abcdk_option_get_int(args, "--batch", 0, 32);
+    size_t sizes[] = {64, 128, 256};
+    abcdk_pool_t pool = {0};
+    uint64_t *p, next_push = 0, next_pull = 0;
+    size_t n;
+    int chk;
+    ssize_t rsize;
+
+    /*绕回表尾时，连续的元素被截断。*/
+    chk = abcdk_pool_init(&pool, sizeof(uint64_t), 8);
+    assert(chk == 0);
+
+    for (int r = 0; r < 100; r++)
+    {
+        n = 5;
+        p = abcdk_pool_reserve(&pool, &n);
+        assert(p != NULL && n >= 1 && n <= 5);
+
+        for (size_t i = 0; i < n; i++)
+            p[i] = next_push++;
+
+        abcdk_pool_commit(&pool, n);
+
+        n = 3;
+        p = abcdk_pool_peek(&pool, &n);
+        assert(p != NULL && n >= 1 && n <= 3);
+
+        for (size_t i = 0; i < n; i++)
+            assert(p[i] == next_pull++);
+
+        abcdk_pool_release(&pool, n);
+
+        /*与复制方式混合使用。*/
+        if (pool.count >= 6)
+        {
+            uint64_t v;
+            rsize = abcdk_pool_pull(&pool, &v, sizeof(v));
+            assert(rsize == sizeof(v) && v == next_pull++);
+        }
+    }
+
+    /*填满后预留失败，扩容后保持顺序。*/
+    while ((p = abcdk_pool_reserve(&pool, NULL)) != NULL)
+    {
+        *p = next_push++;
+        abcdk_pool_commit(&pool, 1);
+    }
+
+    assert(pool.count == 8);
+    chk = abcdk_pool_expand(&pool, 16);
+    assert(chk == 0);
+
+    while ((p = abcdk_pool_peek(&pool, NULL)) != NULL)
+    {
+        assert(*p == next_pull++);
+        abcdk_pool_release(&pool, 1);
+    }
+
+    assert(next_pull == next_push);
+    abcdk_pool_destroy(&pool);
+
+    /*每条记录按字段构造，复制方式需要先在栈上构造，再复制进池子。*/
+    for (int s = 0; s < ABCDK_ARRAY_SIZE(sizes); s++)
+    {
+        size_t words = sizes[s] / sizeof(uint64_t);
+        uint64_t rec[32];
+        uint64_t sum[2] = {0};
+        uint64_t cast[2];
+
+        chk = abcdk_pool_init(&pool, sizes[s], number);
+        assert(chk == 0);
+
+        for (int m = 0; m < 2; m++)
+        {
+            abcdk_clock_dot(NULL);
+
+            for (uint64_t done = 0; done < count;)
+            {
+                /*推送一批，再拉取一批。*/
+                if (m == 0)
+                {
+                    for (int b = 0; b < batch; b++)
+                    {
+                        for (size_t w = 0; w < words; w++)
+                            rec[w] = done + b + w;
+
+                        rsize = abcdk_pool_push(&pool, rec, sizes[s]);
+                        assert(rsize == sizes[s]);
+                    }
+
+                    for (int b = 0; b < batch; b++)
+                    {
+                        rsize = abcdk_pool_pull(&pool, rec, sizes[s]);
+                        assert(rsize == sizes[s]);
+                        sum[m] += rec[words - 1];
+                    }
+                }
+                else
+                {
+                    for (int b = 0; b < batch;)
+                    {
+                        n = batch - b;
+                        p = abcdk_pool_reserve(&pool, &n);
+
+                        for (size_t i = 0; i < n; i++)
+                            for (size_t w = 0; w < words; w++)
+                                p[i * words + w] = done + b + i + w;
+
+                        abcdk_pool_commit(&pool, n);
+                        b += n;
+                    }
+
+                    for (int b = 0; b < batch;)
+                    {
+                        n = batch - b;
+                        p = abcdk_pool_peek(&pool, &n);
+
+                        for (size_t i = 0; i < n; i++)
+                            sum[m] += p[i * words + words - 1];
+
+                        abcdk_pool_release(&pool, n);
+                        b += n;
+                    }
+                }
+
+                done += batch;
+            }
+
+            cast[m] = abcdk_clock_step(NULL);
+        }
+
+        /*两种方式的结果相同。*/
+        assert(sum[0] == sum[1]);
+
+        printf("size=%-3zu copy=%lu(us) span=%lu(us) rate=%.2f/%.2f(M/s)\n", sizes[s], cast[0], cast[1],
+               (double)count / ABCDK_MAX(cast[0], (uint64_t)1), (double)count / ABCDK_MAX(cast[1], (uint64_t)1));
+
+        abcdk_pool_destroy(&pool);
+    }
+}
+
+/*
+ * 链表桶结构的MAP(替换前的实现)，仅用于性能对比。
+*/
+
+static abcdk_tree_t *_test_chain_map_find(abcdk_tree_t *table, const void *key, size_t ksize, size_t vsize)
+{
+    uint64_t bucket = abcdk_hash_bkdr64(key, ksize) % table->alloc->numbers;
+    abcdk_tree_t *it, *node;
+
+    it = (abcdk_tree_t *)table->alloc->pptrs[bucket];
+    if (!it)
+    {
+        it = abcdk_tree_alloc3(sizeof(bucket));
+        assert(it != NULL);
+
+        abcdk_tree_insert2(table, it, 0);
+        table->alloc->pptrs[bucket] = (uint8_t *)it;
+    }
+
+    for (node = abcdk_tree_child(it, 1); node; node = abcdk_tree_sibling(node, 0))
+    {
+        if (node->alloc->sizes[ABCDK_MAP_KEY] == ksize && memcmp(node->alloc->pptrs[ABCDK_MAP_KEY], key, ksize) == 0)
+            return node;
+    }
+
+    if (vsize > 0)
+    {
+        size_t sizes[2] = {ksize, vsize};
+        node = abcdk_tree_alloc2(sizes, 2, 0);
+        assert(node != NULL);
+
+        memcpy(node->alloc->pptrs[ABCDK_MAP_KEY], key, ksize);
+        abcdk_tree_insert2(it, node, 1);
+    }
+
+    return node;
+}
+
+void test_map_bench(abcdk_tree_t *args)
+{
+    int count = abcdk_option_get_int(args, "--count", 0, 1000000);
+    int buckets = abcdk_option_get_int(args, "--buckets", 0, count / 4 + 1);
+    int mode = abcdk_option_get_int(args, "--mode", 0, -1);
+    uint64_t cast[2][4] = {0};
+    size_t rss[2] = {0};
+    uint64_t sum[2] = {0};
+    int chk;
+
+    /*与替换前的实现对比：插入、命中、未命中、删除。对比内存占用时，用--mode分开运行。*/
+    for (int m = 0; m < 2; m++)
+    {
+        if (mode >= 0 && mode != m)
+            continue;
+
+        abcdk_map_t map = {0};
+        abcdk_tree_t *table = NULL;
+        size_t rss_begin = _test_rss_bytes();
+
+        if (m == 0)
+        {
+            table = abcdk_tree_alloc2(NULL, buckets, 0);
+            assert(table != NULL);
+        }
+        else
+        {
+            chk = abcdk_map_init(&map, buckets);
+            assert(chk == 0);
+        }
+
+        abcdk_clock_dot(NULL);
+
+        for (uint64_t i = 0; i < count; i++)
+        {
+            abcdk_allocator_t *v;
+
+            if (m == 0)
+                v = _test_chain_map_find(table, &i, sizeof(i), sizeof(uint64_t))->alloc;
+            else
+                v = abcdk_map_find(&map, &i, sizeof(i), sizeof(uint64_t));
+
+            assert(v != NULL);
+            ABCDK_PTR2OBJ(uint64_t, v->pptrs[ABCDK_MAP_VALUE], 0) = i;
+        }
+
+        cast[m][0] = abcdk_clock_step(NULL);
+        rss[m] = _test_rss_bytes() - rss_begin;
+
+        for (uint64_t i = 0; i < count; i++)
+        {
+            uint64_t k = (i * 0x9E3779B97F4A7C15ULL) % count;
+            abcdk_allocator_t *v;
+
+            if (m == 0)
+                v = _test_chain_map_find(table, &k, sizeof(k), 0)->alloc;
+            else
+                v = abcdk_map_find(&map, &k, sizeof(k), 0);
+
+            sum[m] += ABCDK_PTR2OBJ(uint64_t, v->pptrs[ABCDK_MAP_VALUE], 0);
+        }
+
+        cast[m][1] = abcdk_clock_step(NULL);
+
+        for (uint64_t i = count; i < count * 2ULL; i++)
+        {
+            int miss;
+
+            if (m == 0)
+                miss = (_test_chain_map_find(table, &i, sizeof(i), 0) == NULL);
+            else
+                miss = (abcdk_map_find(&map, &i, sizeof(i), 0) == NULL);
+
+            assert(miss);
+        }
+
+        cast[m][2] = abcdk_clock_step(NULL);
+
+        for (uint64_t i = 0; i < count; i++)
+        {
+            if (m == 0)
+            {
+                abcdk_tree_t *node = _test_chain_map_find(table, &i, sizeof(i), 0);
+                abcdk_tree_unlink(node);
+                abcdk_tree_free(&node);
+            }
+            else
+            {
+                abcdk_map_remove(&map, &i, sizeof(i));
+            }
+        }
+
+        if (m == 0)
+        {
+            abcdk_tree_free(&table);
+        }
+        else
+        {
+            assert(abcdk_map_count(&map) == 0);
+            abcdk_map_destroy(&map);
+        }
+
+        cast[m][3] = abcdk_clock_step(NULL);
+
+        printf("%-5s: count=%d insert=%lu(us) hit=%lu(us) miss=%lu(us) free=%lu(us) rss=%zu(KB)\n",
+               (m == 0 ? "chain" : "flat"), count, cast[m][0], cast[m][1], cast[m][2], cast[m][3], rss[m] / 1024);
+    }
+
+    if (mode < 0)
+        assert(sum[0] == sum[1]);
+}
+
+static int _test_map_flat_dump_cb(abcdk_allocator_t *alloc, void *opaque)
+{
+    uint64_t *sum = (uint64_t *)opaque;
+
+    *sum += ABCDK_PTR2OBJ(uint64_t, alloc->pptrs[ABCDK_MAP_KEY], 0);
+
+    return 1;
+}
+
+void test_map_flat(abcdk_tree_t *args)
+{
+    int count = abcdk_option_get_int(args, "--count", 0, 100000);
+    abcdk_map_t map = {0};
+    uint64_t sum = 0, expect = 0;
+    abcdk_allocator_t *alloc;
+    int chk;
+
+    map.dump_cb = _test_map_flat_dump_cb;
+    map.opaque = &sum;
+
+    /*从最小的表格开始，反复扩容。*/
+    chk = abcdk_map_init(&map, 1);
+    assert(chk == 0);
+
+    for (uint64_t i = 0; i < count; i++)
+    {
+        abcdk_allocator_t *v = abcdk_map_find(&map, &i, sizeof(i), sizeof(uint64_t));
+        assert(v != NULL);
+
+        /*再次查找返回同一个元素。*/
+        alloc = abcdk_map_find(&map, &i, sizeof(i), sizeof(uint64_t));
+        assert(alloc == v);
+    }
+
+    /*元素的地址在扩容后不变，删除一半后剩余的都能找到。*/
+    for (uint64_t i = 0; i < count; i += 2)
+        abcdk_map_remove(&map, &i, sizeof(i));
+
+    assert(abcdk_map_count(&map) == count / 2);
+
+    for (uint64_t i = 0; i < count; i++)
+    {
+        abcdk_allocator_t *v = abcdk_map_find(&map, &i, sizeof(i), 0);
+        assert((i % 2 == 0) == (v == NULL));
+
+        if (v)
+            expect += i;
+    }
+
+    abcdk_map_scan(&map);
+    assert(sum == expect);
+
+    /*删除和插入交替，已删除的槽位被复用或清理。*/
+    for (int r = 0; r < 10; r++)
+    {
+        for (uint64_t i = 0; i < count; i += 2)
+        {
+            alloc = abcdk_map_find(&map, &i, sizeof(i), sizeof(uint64_t));
+            assert(alloc != NULL);
+        }
+
+        for (uint64_t i = 0; i < count; i += 2)
+            abcdk_map_remove(&map, &i, sizeof(i));
+    }
+
+    assert(abcdk_map_count(&map) == count / 2);
+
+    /*变长的KEY。*/
+    for (int i = 0; i < 1000; i++)
+    {
+        char key[32];
+        int len = snprintf(key, sizeof(key), "key-%d", i);
+        alloc = abcdk_map_find(&map, key, len, 1);
+        assert(alloc != NULL);
+    }
+
+    assert(abcdk_map_find(&map, "key-999", 7, 0) != NULL);
+    assert(abcdk_map_find(&map, "key-999", 8, 0) == NULL);
+
+    abcdk_map_destroy(&map);
+}
+
+void test_map_grow(abcdk_tree_t *args)
+{
+    int count = abcdk_option_get_int(args, "--count", 0, 1000000);
+    int lookups = abcdk_option_get_int(args, "--lookups", 0, 1000000);
+    abcdk_map_t map = {0};
+    uint64_t max_insert = 0, max_resize = 0, cast, t;
+    uint64_t checkpoint = 1000;
+    size_t capacity;
+    abcdk_allocator_t *alloc;
+    int chk;
+
+    /*从最小的表格开始插入，记录单次插入的最大延时，每增长10倍测一次查找时间。*/
+    chk = abcdk_map_init(&map, 1);
+    assert(chk == 0);
+
+    for (uint64_t i = 0; i < count; i++)
+    {
+        capacity = abcdk_map_capacity(&map);
+
+        t = abcdk_time_clock2kind_with(CLOCK_MONOTONIC, 9);
+        alloc = abcdk_map_find(&map, &i, sizeof(i), sizeof(uint64_t));
+        assert(alloc != NULL);
+        t = abcdk_time_clock2kind_with(CLOCK_MONOTONIC, 9) - t;
+
+        max_insert = ABCDK_MAX(max_insert, t);
+
+        /*替换表格的那一次插入。*/
+        if (abcdk_map_capacity(&map) != capacity)
+            max_resize = ABCDK_MAX(max_resize, t);
+
+        if (i + 1 != checkpoint && i + 1 != count)
+            continue;
+
+        abcdk_clock_dot(NULL);
+
+        for (uint64_t j = 0; j < lookups; j++)
+        {
+            uint64_t k = (j * 0x9E3779B97F4A7C15ULL) % (i + 1);
+
+            alloc = abcdk_map_find(&map, &k, sizeof(k), 0);
+            assert(alloc != NULL);
+        }
+
+        cast = abcdk_clock_step(NULL);
+
+        printf("count=%-8lu capacity=%-8zu lookup=%.1f(ns) max_insert=%.1f(us) max_resize=%.1f(us)\n", i + 1, abcdk_map_capacity(&map),
+               (double)cast * 1000 / lookups, (double)max_insert / 1000, (double)max_resize / 1000);
+
+        checkpoint *= 10;
+        max_insert = max_resize = 0;
+    }
+
+    /*删除后缩容，剩余的元素都能找到。*/
+    for (uint64_t i = 100; i < count; i++)
+        abcdk_map_remove(&map, &i, sizeof(i));
+
+    printf("count=%-8zu capacity=%-8zu (after remove)\n", abcdk_map_count(&map), abcdk_map_capacity(&map));
+
+    assert(abcdk_map_count(&map) == ABCDK_MIN(count, 100));
+    assert(abcdk_map_capacity(&map) <= 1024);
+
+    for (uint64_t i = 0; i < count; i++)
+        assert((abcdk_map_find(&map, &i, sizeof(i), 0) != NULL) == (i < 100));
+
+    abcdk_map_destroy(&map);
+
+    /*不会缩容到小于初始化时的容量。*/
+    chk = abcdk_map_init(&map, 10000);
+    assert(chk == 0);
+    size_t floor = abcdk_map_capacity(&map);
+
+    for (uint64_t i = 0; i < 100000; i++)
+    {
+        alloc = abcdk_map_find(&map, &i, sizeof(i), 1);
+        assert(alloc != NULL);
+    }
+    for (uint64_t i = 0; i < 100000; i++)
+        abcdk_map_remove(&map, &i, sizeof(i));
+
+    assert(abcdk_map_count(&map) == 0 && abcdk_map_capacity(&map) == floor);
+
+    abcdk_map_destroy(&map);
+}
+
+typedef struct _test_hash_func
+{
+    const char *name;
+    uint64_t (*func)(const void *data, size_t size, uint64_t seed);
+} test_hash_func;
+
+static uint64_t _test_hash_bkdr64(const void *data, size_t size, uint64_t seed)
+{
+    return abcdk_hash_bkdr64(data, size);
+}
+
+static uint64_t _test_hash_wy64(const void *data, size_t size, uint64_t seed)
+{
+    return abcdk_hash_wy64(data, size, seed);
+}
+
+static uint64_t _test_hash_mix64(const void *data, size_t size, uint64_t seed)
+{
+    uint64_t key = 0;
+
+    /*与abcdk_map_hash相同，只用于4字节和8字节的KEY。*/
+    if (size == sizeof(uint64_t))
+        memcpy(&key, data, sizeof(uint64_t));
+    else
+        memcpy(&key, data, sizeof(uint32_t));
+
+    return abcdk_hash_mix64(key, seed);
+}
+
+/*
+ * 按低位或高位分桶，返回卡方值与自由度的比值，均匀分布时接近1。
+*/
+static double _test_hash_chi2(const uint64_t *hashs, size_t count, int bits, int high)
+{
+    size_t buckets = (size_t)1 << bits;
+    uint32_t *counts = abcdk_heap_alloc(buckets * sizeof(uint32_t));
+    double expect = (double)count / buckets, chi2 = 0;
+
+    for (size_t i = 0; i < count; i++)
+        counts[high ? (hashs[i] >> (64 - bits)) : (hashs[i] & (buckets - 1))] += 1;
+
+    for (size_t i = 0; i < buckets; i++)
+        chi2 += (counts[i] - expect) * (counts[i] - expect) / expect;
+
+    abcdk_heap_free(counts);
+
+    return chi2 / (buckets - 1);
+}
+
+void test_hash(abcdk_tree_t *args)
+{
+    int count = abcdk_option_get_int(args, "--count", 0, 1 << 20);
+    int rounds = abcdk_option_get_int(args, "--rounds", 0, 1 << 28);
+    test_hash_func funcs[] = {{"bkdr64", _test_hash_bkdr64}, {"wy64", _test_hash_wy64}, {"mix64", _test_hash_mix64}};
+    size_t sizes[] = {4, 8, 16, 32, 64, 256, 4096};
+    const char *keysets[] = {"seq", "stride4096", "string"};
+    uint64_t seed = abcdk_hash_seed();
+    uint64_t *hashs = abcdk_heap_alloc(count * sizeof(uint64_t));
+    uint8_t *buf = abcdk_heap_alloc(4096);
+    uint64_t sink = 0;
+
+    /*种子不同，HASH值不同；种子相同，HASH值相同。*/
+    assert(seed != 0 && seed == abcdk_hash_seed());
+    assert(abcdk_hash_wy64("abcdk", 5, 1) != abcdk_hash_wy64("abcdk", 5, 2));
+    assert(abcdk_hash_wy64("abcdk", 5, 1) == abcdk_hash_wy64("abcdk", 5, 1));
+    assert(abcdk_hash_mix64(1, 1) != abcdk_hash_mix64(1, 2));
+    assert(abcdk_hash_mix32(1, 1) != abcdk_hash_mix32(2, 1));
+
+    /*所有长度分支，每个字节都影响结果。*/
+    for (size_t len = 1; len <= 200; len++)
+    {
+        memset(buf, 0, len);
+        uint64_t h = abcdk_hash_wy64(buf, len, seed);
+
+        assert(h != abcdk_hash_wy64(buf, len - 1, seed));
+
+        for (size_t i = 0; i < len; i++)
+        {
+            buf[i] = 1;
+            assert(abcdk_hash_wy64(buf, len, seed) != h);
+            buf[i] = 0;
+        }
+    }
+
+    /*速度：每种长度处理相同的总字节数。*/
+    for (int s = 0; s < ABCDK_ARRAY_SIZE(sizes); s++)
+    {
+        int loops = rounds / sizes[s];
+
+        for (size_t i = 0; i < sizes[s]; i++)
+            buf[i] = i * 7;
+
+        for (int f = 0; f < ABCDK_ARRAY_SIZE(funcs); f++)
+        {
+            /*整数混合只用于定长的KEY。*/
+            if (funcs[f].func == _test_hash_mix64 && sizes[s] > sizeof(uint64_t))
+                continue;
+
+            abcdk_clock_dot(NULL);
+
+            for (int i = 0; i < loops; i++)
+            {
+                /*按KEY的宽度写入，避免写入和读取的宽度不同导致存储转发失败。*/
+                if (sizes[s] >= sizeof(uint64_t))
+                    ABCDK_PTR2OBJ(uint64_t, buf, 0) = i;
+                else
+                    ABCDK_PTR2OBJ(uint32_t, buf, 0) = i;
+
+                sink += funcs[f].func(buf, sizes[s], seed);
+            }
+
+            uint64_t cast = abcdk_clock_step(NULL);
+
+            printf("speed: size=%-4zu %-6s %.2f(ns/hash) %.2f(GB/s)\n", sizes[s], funcs[f].name,
+                   (double)cast * 1000 / loops, (double)rounds / 1024 / 1024 / 1024 * 1000000 / ABCDK_MAX(cast, (uint64_t)1));
+        }
+    }
+
+    /*分布：连续整数(句柄)、4K步长的整数(地址)、字符串。分别取低16位和高16位分桶。*/
+    for (int k = 0; k < ABCDK_ARRAY_SIZE(keysets); k++)
+    {
+        for (int f = 0; f < ABCDK_ARRAY_SIZE(funcs); f++)
+        {
+            if (funcs[f].func == _test_hash_mix64 && k == 2)
+                continue;
+
+            for (uint64_t i = 0; i < count; i++)
+            {
+                char str[32];
+
+                if (k == 0)
+                    hashs[i] = funcs[f].func(&i, sizeof(i), seed);
+                else if (k == 1)
+                    hashs[i] = funcs[f].func(&(uint64_t){i * 4096}, sizeof(uint64_t), seed);
+                else
+                    hashs[i] = funcs[f].func(str, snprintf(str, sizeof(str), "key-%lu", i), seed);
+            }
+
+            double low = _test_hash_chi2(hashs, count, 16, 0);
+            double high = _test_hash_chi2(hashs, count, 16, 1);
+
+            printf("distribution: keys=%-10s %-6s chi2/df low=%.3f high=%.3f\n", keysets[k], funcs[f].name, low, high);
+
+            /*新的HASH函数在各种KEY上都接近均匀分布。*/
+            if (funcs[f].func != _test_hash_bkdr64)
+                assert(low < 1.2 && high < 1.2);
+        }
+    }
+
+    /*雪崩：64位KEY翻转任意一个比特，输出的每个比特翻转的概率接近1/2。*/
+    for (int f = 0; f < ABCDK_ARRAY_SIZE(funcs); f++)
+    {
+        double worst = 0;
+
+        for (int bit = 0; bit < 64; bit++)
+        {
+            uint32_t flips[64] = {0};
+            int samples = 10000;
+
+            for (uint64_t i = 0; i < samples; i++)
+            {
+                uint64_t key = abcdk_hash_mix64(i, 0x1234), key2 = key ^ (1ULL << bit);
+                uint64_t diff = funcs[f].func(&key, sizeof(key), seed) ^ funcs[f].func(&key2, sizeof(key2), seed);
+
+                for (int o = 0; o < 64; o++)
+                    flips[o] += (diff >> o) & 1;
+            }
+
+            for (int o = 0; o < 64; o++)
+                worst = ABCDK_MAX(worst, fabs((double)flips[o] / samples - 0.5));
+        }
+
+        printf("avalanche: %-6s worst bias=%.3f\n", funcs[f].name, worst);
+
+        if (funcs[f].func != _test_hash_bkdr64)
+            assert(worst < 0.05);
+    }
+
+    abcdk_heap_free(hashs);
+    abcdk_heap_free(buf);
+
+    /*防止被优化掉。*/
+    fprintf(stderr, "sink=%lu\n", sink);
+}
+
+typedef struct _test_cmap_ctx
+{
+    /** 并发MAP，NULL(0) 使用加锁的MAP。*/
+    abcdk_cmap_t *cmap;
+
+    abcdk_map_t map;
+    abcdk_mutex_t mutex;
+
+    int count;
+    int ops;
+    int write;
+
+    /** 读取时使用abcdk_cmap_visit。*/
+    int visit;
+
+    /** 查找时KEY暂时不存在(删除后还未重新添加)的次数。*/
+    uint64_t misses;
+
+    /** 构造和析构的次数。*/
+    uint64_t constructed;
+    uint64_t destroyed;
+
+} test_cmap_ctx;
+
+static void _test_cmap_construct_cb(abcdk_allocator_t *alloc, void *opaque)
+{
+    test_cmap_ctx *ctx = (test_cmap_ctx *)opaque;
+
+    /*VALUE等于KEY，查找时校验。*/
+    ABCDK_PTR2OBJ(uint64_t, alloc->pptrs[ABCDK_MAP_VALUE], 0) = ABCDK_PTR2OBJ(uint64_t, alloc->pptrs[ABCDK_MAP_KEY], 0);
+
+    __atomic_add_fetch(&ctx->constructed, 1, __ATOMIC_RELAXED);
+}
+
+static void _test_cmap_destructor_cb(abcdk_allocator_t *alloc, void *opaque)
+{
+    test_cmap_ctx *ctx = (test_cmap_ctx *)opaque;
+
+    __atomic_add_fetch(&ctx->destroyed, 1, __ATOMIC_RELAXED);
+}
+
+static int _test_cmap_visit_cb(abcdk_allocator_t *alloc, void *opaque)
+{
+    assert(ABCDK_PTR2OBJ(uint64_t, alloc->pptrs[ABCDK_MAP_VALUE], 0) == *(uint64_t *)opaque);
+
+    return 1;
+}
+
+static void *_test_cmap_worker(void *opaque)
+{
+    test_cmap_ctx *ctx = (test_cmap_ctx *)opaque;
+    uint64_t rand = (uint64_t)pthread_self();
+    uint64_t misses = 0;
+
+    for (int i = 0; i < ctx->ops; i++)
+    {
+        rand = rand * 6364136223846793005ULL + 1442695040888963407ULL;
+
+        uint64_t key = (rand >> 33) % ctx->count;
+        int write = ((rand >> 20) % 100) < ctx->write;
+        abcdk_allocator_t *v;
+
+        if (ctx->cmap)
+        {
+            if (write)
+            {
+                abcdk_cmap_remove(ctx->cmap, &key, sizeof(key));
+                v = abcdk_cmap_find(ctx->cmap, &key, sizeof(key), sizeof(uint64_t));
+                assert(v != NULL);
+                abcdk_allocator_unref(&v);
+            }
+            else if (ctx->visit)
+            {
+                if (abcdk_cmap_visit(ctx->cmap, &key, sizeof(key), _test_cmap_visit_cb, &key) < 0)
+                    misses += 1;
+            }
+            else
+            {
+                v = abcdk_cmap_find(ctx->cmap, &key, sizeof(key), 0);
+                if (v)
+                {
+                    assert(ABCDK_PTR2OBJ(uint64_t, v->pptrs[ABCDK_MAP_VALUE], 0) == key);
+                    abcdk_allocator_unref(&v);
+                }
+                else
+                {
+                    misses += 1;
+                }
+            }
+        }
+        else
+        {
+            abcdk_mutex_lock(&ctx->mutex, 1);
+
+            if (write)
+            {
+                abcdk_map_remove(&ctx->map, &key, sizeof(key));
+                v = abcdk_map_find(&ctx->map, &key, sizeof(key), sizeof(uint64_t));
+                assert(v != NULL);
+            }
+            else
+            {
+                v = abcdk_map_find(&ctx->map, &key, sizeof(key), 0);
+                assert(v != NULL && ABCDK_PTR2OBJ(uint64_t, v->pptrs[ABCDK_MAP_VALUE], 0) == key);
+            }
+
+            abcdk_mutex_unlock(&ctx->mutex);
+        }
+    }
+
+    __atomic_add_fetch(&ctx->misses, misses, __ATOMIC_RELAXED);
+
+    return NULL;
+}
+
+static int _test_cmap_dump_cb(abcdk_allocator_t *alloc, void *opaque)
+{
+    *(uint64_t *)opaque += 1;
+
+    return 1;
+}
+
+void test_cmap_bench(abcdk_tree_t *args)
+{
+    int count = abcdk_option_get_int(args, "--count", 0, 100000);
+    int ops = abcdk_option_get_int(args, "--ops", 0, 200000);
+    int write = abcdk_option_get_int(args, "--write", 0, 1);
+    int max_threads = abcdk_option_get_int(args, "--threads", 0, 64);
+    int chk;
+
+    /*默认1%写入(删除后重新添加)，99%查找。*/
+    for (int threads = 1; threads <= max_threads; threads *= 2)
+    {
+        for (int m = 0; m < 3; m++)
+        {
+            test_cmap_ctx ctx = {0};
+            abcdk_cmap_callback cb = {0};
+            const char *names[] = {"map+mutex", "cmap_find", "cmap_visit"};
+
+            ctx.count = count;
+            ctx.ops = ops;
+            ctx.write = write;
+            ctx.visit = (m == 2);
+
+            if (m == 0)
+            {
+                abcdk_mutex_init2(&ctx.mutex, 0);
+                ctx.map.construct_cb = _test_cmap_construct_cb;
+                ctx.map.destructor_cb = _test_cmap_destructor_cb;
+                ctx.map.opaque = &ctx;
+                chk = abcdk_map_init(&ctx.map, count);
+                assert(chk == 0);
+            }
+            else
+            {
+                cb.construct_cb = _test_cmap_construct_cb;
+                cb.destructor_cb = _test_cmap_destructor_cb;
+                cb.opaque = &ctx;
+                ctx.cmap = abcdk_cmap_alloc(count, &cb);
+                assert(ctx.cmap != NULL);
+            }
+
+            for (uint64_t i = 0; i < count; i++)
+            {
+                abcdk_allocator_t *v;
+
+                if (m == 0)
+                {
+                    v = abcdk_map_find(&ctx.map, &i, sizeof(i), sizeof(uint64_t));
+                    assert(v != NULL);
+                }
+                else
+                {
+                    v = abcdk_cmap_find(ctx.cmap, &i, sizeof(i), sizeof(uint64_t));
+                    assert(v != NULL);
+                    abcdk_allocator_unref(&v);
+                }
+            }
+
+            abcdk_thread_t *ps = abcdk_heap_alloc(threads * sizeof(abcdk_thread_t));
+
+            abcdk_clock_dot(NULL);
+
+            for (int i = 0; i < threads; i++)
+            {
+                ps[i].routine = _test_cmap_worker;
+                ps[i].opaque = &ctx;
+                chk = abcdk_thread_create(&ps[i], 1);
+                assert(chk == 0);
+            }
+
+            for (int i = 0; i < threads; i++)
+                abcdk_thread_join(&ps[i]);
+
+            uint64_t cast = abcdk_clock_step(NULL);
+
+            printf("threads=%-2d %-10s write=%d%% ops=%lu cast=%lu(us) rate=%.2f(M/s) misses=%lu\n",
+                   threads, names[m], write, (uint64_t)threads * ops, cast,
+                   (double)threads * ops / ABCDK_MAX(cast, (uint64_t)1), ctx.misses);
+
+            abcdk_heap_free(ps);
+
+            if (m == 0)
+            {
+                abcdk_map_destroy(&ctx.map);
+                abcdk_mutex_destroy(&ctx.mutex);
+            }
+            else
+            {
+                uint64_t scanned = 0;
+
+                abcdk_cmap_scan(ctx.cmap, _test_cmap_dump_cb, &scanned);
+                assert(scanned == count && abcdk_cmap_count(ctx.cmap) == count);
+
+                abcdk_cmap_free(&ctx.cmap);
+            }
+
+            /*所有元素(包括被删除的)都已析构。*/
+            assert(ctx.constructed == ctx.destroyed);
+        }
+    }
+}
+
+typedef struct _test_bptree_ctx
+{
+    uint64_t constructed;
+    uint64_t destroyed;
+    uint64_t prev;
+    uint64_t sum;
+    uint64_t limit;
+} test_bptree_ctx;
+
+static int _test_bptree_compare_cb(const void *key1, size_t size1, const void *key2, size_t size2, void *opaque)
+{
+    uint64_t a = ABCDK_PTR2OBJ(uint64_t, key1, 0);
+    uint64_t b = ABCDK_PTR2OBJ(uint64_t, key2, 0);
+
+    return (a > b ? 1 : (a < b ? -1 : 0));
+}
+
+static void _test_bptree_construct_cb(abcdk_allocator_t *alloc, void *opaque)
+{
+    test_bptree_ctx *ctx = (test_bptree_ctx *)opaque;
+
+    ABCDK_PTR2OBJ(uint64_t, alloc->pptrs[ABCDK_MAP_VALUE], 0) = ABCDK_PTR2OBJ(uint64_t, alloc->pptrs[ABCDK_MAP_KEY], 0);
+    ctx->constructed += 1;
+}
+
+static void _test_bptree_destructor_cb(abcdk_allocator_t *alloc, void *opaque)
+{
+    test_bptree_ctx *ctx = (test_bptree_ctx *)opaque;
+
+    ctx->destroyed += 1;
+}
+
+static int _test_bptree_dump_cb(abcdk_allocator_t *alloc, void *opaque)
+{
+    test_bptree_ctx *ctx = (test_bptree_ctx *)opaque;
+    uint64_t key = ABCDK_PTR2OBJ(uint64_t, alloc->pptrs[ABCDK_MAP_KEY], 0);
+
+    /*严格升序。*/
+    assert(ctx->sum == 0 || key > ctx->prev);
+    assert(ABCDK_PTR2OBJ(uint64_t, alloc->pptrs[ABCDK_MAP_VALUE], 0) == key);
+
+    ctx->prev = key;
+    ctx->sum += 1;
+
+    return (ctx->sum < ctx->limit ? 1 : -1);
+}
+
+static size_t _test_bptree_scan(abcdk_bptree_t *tree, test_bptree_ctx *ctx, const uint64_t *begin, const uint64_t *end, uint64_t limit)
+{
+    size_t n;
+
+    ctx->prev = ctx->sum = 0;
+    ctx->limit = limit;
+
+    n = abcdk_bptree_scan(tree, begin, sizeof(uint64_t), end, sizeof(uint64_t), _test_bptree_dump_cb, ctx);
+    assert(n == ctx->sum);
+
+    return n;
+}
+
+void test_bptree(abcdk_tree_t *args)
+{
+    int count = abcdk_option_get_int(args, "--count", 0, 1000000);
+    test_bptree_ctx ctx = {0};
+    abcdk_bptree_callback cb = {_test_bptree_compare_cb, _test_bptree_construct_cb, _test_bptree_destructor_cb, &ctx};
+    abcdk_bptree_t *tree;
+    abcdk_allocator_t *alloc, **allocs;
+    abcdk_map_t map = {0};
+    uint64_t *keys, k, k2, cast;
+    size_t n;
+    int chk;
+
+    /*偶数KEY，乱序。*/
+    keys = (uint64_t *)abcdk_heap_alloc(count * sizeof(uint64_t));
+    for (uint64_t i = 0; i < count; i++)
+        keys[i] = i * 2;
+    for (uint64_t i = count - 1; i > 0; i--)
+    {
+        uint64_t j = (i * 0x9E3779B97F4A7C15ULL >> 7) % (i + 1);
+        k = keys[i], keys[i] = keys[j], keys[j] = k;
+    }
+
+    tree = abcdk_bptree_alloc(&cb);
+    assert(tree != NULL);
+
+    abcdk_clock_dot(NULL);
+    for (uint64_t i = 0; i < count; i++)
+    {
+        alloc = abcdk_bptree_find(tree, &keys[i], sizeof(uint64_t), sizeof(uint64_t));
+        assert(alloc != NULL);
+    }
+    cast = abcdk_clock_step(NULL);
+
+    printf("bptree insert count=%d height=%zu cast=%lu(us)\n", count, abcdk_bptree_height(tree), cast);
+
+    assert(abcdk_bptree_count(tree) == count);
+    alloc = abcdk_bptree_find(tree, &keys[0], sizeof(uint64_t), sizeof(uint64_t));
+    assert(alloc != NULL);
+    assert(abcdk_bptree_count(tree) == count && ctx.constructed == count);
+
+    /*按顺序遍历全部，提前终止。*/
+    n = _test_bptree_scan(tree, &ctx, NULL, NULL, UINT64_MAX);
+    assert(n == count);
+    assert(ctx.prev == (uint64_t)(count - 1) * 2);
+    n = _test_bptree_scan(tree, &ctx, NULL, NULL, 10);
+    assert(n == ABCDK_MIN(count, 10));
+
+    /*边界。*/
+    for (uint64_t i = 0; i < 1000 && i < count; i++)
+    {
+        k = keys[i];
+        alloc = abcdk_bptree_lower_bound(tree, &k, sizeof(k));
+        assert(alloc && ABCDK_PTR2OBJ(uint64_t, alloc->pptrs[ABCDK_MAP_KEY], 0) == k);
+
+        k2 = k + 1;
+        alloc = abcdk_bptree_lower_bound(tree, &k2, sizeof(k2));
+        assert((alloc == NULL) == (k == (uint64_t)(count - 1) * 2));
+        assert(!alloc || ABCDK_PTR2OBJ(uint64_t, alloc->pptrs[ABCDK_MAP_KEY], 0) == k + 2);
+
+        alloc = abcdk_bptree_upper_bound(tree, &k, sizeof(k));
+        assert(!alloc || ABCDK_PTR2OBJ(uint64_t, alloc->pptrs[ABCDK_MAP_KEY], 0) == k + 2);
+
+        assert(abcdk_bptree_find(tree, &k2, sizeof(k2), 0) == NULL);
+    }
+
+    /*范围[k, k + 200)有100个元素。*/
+    k = (count > 300 ? count / 3 * 2 : 0);
+    k2 = k + 200;
+    n = _test_bptree_scan(tree, &ctx, &k, &k2, UINT64_MAX);
+    assert(n == ABCDK_MIN(100, count - k / 2));
+
+    /*删除一半(乱序)，剩下的仍然有序并且都能找到。*/
+    abcdk_clock_dot(NULL);
+    for (uint64_t i = 0; i < count / 2; i++)
+    {
+        chk = abcdk_bptree_remove(tree, &keys[i], sizeof(uint64_t));
+        assert(chk == 0);
+    }
+    cast = abcdk_clock_step(NULL);
+
+    printf("bptree remove count=%d height=%zu cast=%lu(us)\n", count / 2, abcdk_bptree_height(tree), cast);
+
+    if (count >= 2)
+    {
+        chk = abcdk_bptree_remove(tree, &keys[0], sizeof(uint64_t));
+        assert(chk == -1);
+    }
+    assert(abcdk_bptree_count(tree) == count - count / 2);
+    assert(ctx.destroyed == count / 2);
+    n = _test_bptree_scan(tree, &ctx, NULL, NULL, UINT64_MAX);
+    assert(n == count - count / 2);
+
+    for (uint64_t i = 0; i < count; i++)
+        assert((abcdk_bptree_find(tree, &keys[i], sizeof(uint64_t), 0) != NULL) == (i >= count / 2));
+
+    /*全部删除，树降到一层。*/
+    for (uint64_t i = count / 2; i < count; i++)
+    {
+        chk = abcdk_bptree_remove(tree, &keys[i], sizeof(uint64_t));
+        assert(chk == 0);
+    }
+
+    assert(abcdk_bptree_count(tree) == 0 && abcdk_bptree_height(tree) == 1);
+    assert(ctx.destroyed == ctx.constructed);
+    n = _test_bptree_scan(tree, &ctx, NULL, NULL, UINT64_MAX);
+    assert(n == 0);
+
+    /*批量加载。*/
+    allocs = (abcdk_allocator_t **)abcdk_heap_alloc(count * sizeof(abcdk_allocator_t *));
+    for (uint64_t i = 0; i < count; i++)
+    {
+        size_t sizes[2] = {sizeof(uint64_t), sizeof(uint64_t)};
+
+        allocs[i] = abcdk_allocator_alloc(sizes, 2, 0);
+        ABCDK_PTR2OBJ(uint64_t, allocs[i]->pptrs[ABCDK_MAP_KEY], 0) = i * 2;
+        ABCDK_PTR2OBJ(uint64_t, allocs[i]->pptrs[ABCDK_MAP_VALUE], 0) = i * 2;
+    }
+
+    /*不是严格升序。*/
+    if (count > 1)
+    {
+        alloc = allocs[0], allocs[0] = allocs[1], allocs[1] = alloc;
+        chk = abcdk_bptree_load(tree, allocs, count);
+        assert(chk == -1);
+        alloc = allocs[0], allocs[0] = allocs[1], allocs[1] = alloc;
+    }
+
+    abcdk_clock_dot(NULL);
+    chk = abcdk_bptree_load(tree, allocs, count);
+    assert(chk == 0);
+    cast = abcdk_clock_step(NULL);
+
+    printf("bptree load   count=%d height=%zu cast=%lu(us)\n", count, abcdk_bptree_height(tree), cast);
+
+    assert(abcdk_bptree_count(tree) == count);
+    chk = abcdk_bptree_load(tree, allocs, count);
+    assert(chk == -1);
+    n = _test_bptree_scan(tree, &ctx, NULL, NULL, UINT64_MAX);
+    assert(n == count);
+
+    /*加载后继续添加(奇数KEY)和删除。*/
+    for (uint64_t i = 0; i < count; i++)
+    {
+        k = keys[i] + 1;
+        alloc = abcdk_bptree_find(tree, &k, sizeof(k), sizeof(uint64_t));
+        assert(alloc != NULL);
+    }
+
+    n = _test_bptree_scan(tree, &ctx, NULL, NULL, UINT64_MAX);
+    assert(n == (size_t)count * 2);
+
+    /*查找和遍历的速度，与HASH表比较。*/
+    chk = abcdk_map_init(&map, count);
+    assert(chk == 0);
+    for (uint64_t i = 0; i < count; i++)
+    {
+        alloc = abcdk_map_find(&map, &keys[i], sizeof(uint64_t), sizeof(uint64_t));
+        assert(alloc != NULL);
+    }
+
+    abcdk_clock_dot(NULL);
+    for (uint64_t i = 0; i < count; i++)
+    {
+        alloc = abcdk_bptree_find(tree, &keys[i], sizeof(uint64_t), 0);
+        assert(alloc != NULL);
+    }
+    cast = abcdk_clock_step(NULL);
+
+    printf("bptree find   count=%d cast=%lu(us)\n", count, cast);
+
+    abcdk_clock_dot(NULL);
+    for (uint64_t i = 0; i < count; i++)
+    {
+        alloc = abcdk_map_find(&map, &keys[i], sizeof(uint64_t), 0);
+        assert(alloc != NULL);
+    }
+    cast = abcdk_clock_step(NULL);
+
+    printf("map    find   count=%d cast=%lu(us)\n", count, cast);
+
+    abcdk_clock_dot(NULL);
+    _test_bptree_scan(tree, &ctx, NULL, NULL, UINT64_MAX);
+    cast = abcdk_clock_step(NULL);
+
+    printf("bptree scan   count=%lu cast=%lu(us)\n", ctx.sum, cast);
+
+    for (uint64_t i = 0; i < count; i++)
+    {
+        chk = abcdk_bptree_remove(tree, allocs[i]->pptrs[ABCDK_MAP_KEY], sizeof(uint64_t));
+        assert(chk == 0);
+    }
+
+    assert(abcdk_bptree_count(tree) == count);
+    n = _test_bptree_scan(tree, &ctx, NULL, NULL, UINT64_MAX);
+    assert(n == count);
+
+    abcdk_bptree_free(&tree);
+    abcdk_map_destroy(&map);
+
+    assert(ctx.destroyed == ctx.constructed + count);
+
+    /*长KEY(不在节点中保存)，默认比较函数按字节排序。*/
+    tree = abcdk_bptree_alloc(NULL);
+    assert(tree != NULL);
+
+    for (uint64_t i = 0; i < count; i++)
+    {
+        char str[64];
+        int len = snprintf(str, sizeof(str), "session-%020lu", keys[i]);
+
+        alloc = abcdk_bptree_find(tree, str, len, 1);
+        assert(alloc != NULL);
+    }
+
+    for (uint64_t i = 0; i < count; i += 2)
+    {
+        char str[64];
+        int len = snprintf(str, sizeof(str), "session-%020lu", keys[i]);
+
+        chk = abcdk_bptree_remove(tree, str, len);
+        assert(chk == 0);
+    }
+
+    for (uint64_t i = 0; i < count; i++)
+    {
+        char str[64];
+        int len = snprintf(str, sizeof(str), "session-%020lu", i * 2 + 1);
+
+        alloc = abcdk_bptree_lower_bound(tree, str, len);
+        assert(!alloc || memcmp(alloc->pptrs[ABCDK_MAP_KEY], str, len) > 0);
+    }
+
+    assert(abcdk_bptree_count(tree) == count / 2);
+    abcdk_bptree_free(&tree);
+
+    abcdk_heap_free(allocs);
+    abcdk_heap_free(keys);
+}
+
+static int _test_tree_arena_dump_cb(size_t depth, abcdk_tree_t *node, void *opaque)
+{
+    *((uint64_t *)opaque) += 1;
+
+    return 1;
+}
+
+static uint64_t _test_tree_arena_count(abcdk_tree_t *root)
+{
+    uint64_t count = 0;
+    abcdk_tree_iterator_t it = {0, _test_tree_arena_dump_cb, &count};
+
+    abcdk_tree_scan(root, &it);
+
+    return count;
+}
+
+void test_tree_arena(abcdk_tree_t *args)
+{
+    int count = abcdk_option_get_int(args, "--count", 0, 1000000);
+    int mode = abcdk_option_get_int(args, "--mode", 0, -1);
+    const char *path = abcdk_option_get(args, "--path", 0, "");
+    const char *names[3] = {"heap", "slab", "arena"};
+    size_t sizes[2] = {0, sizeof(struct stat)};
+    char name[PATH_MAX];
+    abcdk_tree_t *root, *dir, *node;
+    abcdk_arena_stat stat;
+    uint64_t cast_build, cast_scan, cast_free;
+
+    /*
+     * 与目录扫描相同的树：1000个目录，每个目录下count/1000个文件，名字字段刚好容纳完整路径。
+     * 每种模式单独运行(--mode)时，RSS才是准确的。
+    */
+    for (int m = 0; m < 3; m++)
+    {
+        if (mode >= 0 && mode != m)
+            continue;
+
+        abcdk_allocator_backend_set(m == 1 ? ABCDK_ALLOCATOR_BACKEND_SLAB : ABCDK_ALLOCATOR_BACKEND_HEAP);
+
+        size_t rss = _test_rss_bytes();
+
+        abcdk_clock_dot(NULL);
+
+        sizes[0] = 8;
+        root = (m == 2 ? abcdk_tree_arena_alloc(sizes, 2, 0) : abcdk_tree_alloc2(sizes, 2, 0));
+        assert(root != NULL);
+        strcpy((char *)root->alloc->pptrs[ABCDK_DIRENT_NAME], "/data");
+
+        for (int i = 0; i < 1000; i++)
+        {
+            sizes[0] = abcdk_align(snprintf(name, sizeof(name), "/data/dir%04d", i) + 1, 8);
+            dir = abcdk_tree_alloc4(root, sizes, 2, 0);
+            assert(dir != NULL);
+            strcpy((char *)dir->alloc->pptrs[ABCDK_DIRENT_NAME], name);
+            abcdk_tree_insert2(root, dir, 0);
+
+            for (int j = 0; j < count / 1000; j++)
+            {
+                sizes[0] = abcdk_align(snprintf(name, sizeof(name), "/data/dir%04d/file%06d", i, j) + 1, 8);
+                node = abcdk_tree_alloc4(dir, sizes, 2, 0);
+                assert(node != NULL);
+                strcpy((char *)node->alloc->pptrs[ABCDK_DIRENT_NAME], name);
+                abcdk_tree_insert2(dir, node, 0);
+            }
+        }
+
+        cast_build = abcdk_clock_step(NULL);
+        size_t rss_used = _test_rss_bytes() - rss;
+
+        uint64_t nodes = _test_tree_arena_count(root);
+        cast_scan = abcdk_clock_step(NULL);
+
+        assert(nodes == 1 + 1000 + (uint64_t)count / 1000 * 1000);
+
+        if (m == 2)
+        {
+            abcdk_arena_stat_fetch(abcdk_tree_arena(root), &stat);
+            printf("arena: alloc_count=%lu used=%lu(KB) chunks=%lu chunk_bytes=%lu(KB)\n",
+                   stat.alloc_count, stat.used_bytes / 1024, stat.chunk_count, stat.chunk_bytes / 1024);
+        }
+
+        abcdk_clock_dot(NULL);
+        abcdk_tree_free(&root);
+        cast_free = abcdk_clock_step(NULL);
+
+        printf("%-5s nodes=%lu build=%lu(us) scan=%lu(us) free=%lu(us) rss=%zu(KB)\n",
+               names[m], nodes, cast_build, cast_scan, cast_free, rss_used / 1024);
+    }
+
+    abcdk_allocator_backend_set(ABCDK_ALLOCATOR_BACKEND_HEAP);
+
+    /*区域中的子树可以断开和释放，内存在根节点释放时回收。*/
+    sizes[0] = 8;
+    root = abcdk_tree_arena_alloc(sizes, 2, 0);
+    dir = abcdk_tree_alloc4(root, sizes, 2, 0);
+    node = abcdk_tree_alloc4(dir, sizes, 2, 0);
+    assert(root && dir && node && dir->region == root && node->region == root);
+    abcdk_tree_insert2(root, dir, 0);
+    abcdk_tree_insert2(dir, node, 0);
+    abcdk_tree_unlink(dir);
+    abcdk_tree_free(&dir);
+    assert(dir == NULL && _test_tree_arena_count(root) == 1);
+    abcdk_tree_free(&root);
+
+    /*不在区域中时，与abcdk_tree_alloc2相同。*/
+    node = abcdk_tree_alloc4(NULL, sizes, 2, 0);
+    assert(node && node->region == NULL);
+    abcdk_tree_free(&node);
+
+    if (!*path)
+        return;
+
+    /*真实的目录扫描。*/
+    for (int m = 0; m < 3; m += 2)
+    {
+        if (mode >= 0 && mode != m)
+            continue;
+
+        size_t rss = _test_rss_bytes();
+
+        abcdk_clock_dot(NULL);
+
+        sizes[0] = PATH_MAX;
+        root = (m == 2 ? abcdk_tree_arena_alloc(sizes, 2, 0) : abcdk_tree_alloc2(sizes, 2, 0));
+        assert(root != NULL);
+        strcpy((char *)root->alloc->pptrs[ABCDK_DIRENT_NAME], path);
+
+        abcdk_dirscan(root, 100, 0);
+
+        cast_build = abcdk_clock_step(NULL);
+        size_t rss_used = _test_rss_bytes() - rss;
+
+        uint64_t nodes = _test_tree_arena_count(root);
+
+        abcdk_clock_dot(NULL);
+        abcdk_tree_free(&root);
+        cast_free = abcdk_clock_step(NULL);
+
+        printf("dirscan %-5s nodes=%lu scan=%lu(us) free=%lu(us) rss=%zu(KB)\n",
+               names[m], nodes, cast_build, cast_free, rss_used / 1024);
+    }
+}
+
+static abcdk_buffer_t *_test_buffer_ring_alloc(int mode, size_t size)
+{
+    /*0 线性，1 环形，2 环形(镜像映射)。*/
+    if (mode == 0)
+        return abcdk_buffer_alloc2(size);
+
+    return abcdk_buffer_alloc3(size, mode == 2);
+}
+
+void test_buffer_ring(abcdk_tree_t *args)
+{
+    int block = abcdk_option_get_int(args, "--block", 0, 256 * 1024);
+    int chunk = abcdk_option_get_int(args, "--chunk", 0, 4096);
+    int total = abcdk_option_get_int(args, "--total", 0, 64 * 1024 * 1024);
+    int mode = abcdk_option_get_int(args, "--mode", 0, -1);
+    const char *names[3] = {"linear", "ring", "mirror"};
+    char tmpname[] = "/tmp/abcdk-buffer-ring-XXXXXX";
+    uint8_t *src, *dst;
+    abcdk_buffer_t *buf, *buf2;
+    struct iovec vec[2];
+    uint64_t seed = 1;
+    size_t ref_r = 0, ref_w = 0;
+    ssize_t chk;
+    int fds[2];
+    int fd;
+    ssize_t rsize;
+
+    /*
+     * 随机读写，数据按累计的写入长度生成，读出后校验。
+     * 容量不是页的整数倍，镜像映射的容量按页对齐，读写的位置也会跨过末尾。
+    */
+    src = (uint8_t *)abcdk_heap_alloc(8192);
+    dst = (uint8_t *)abcdk_heap_alloc(8192);
+    assert(src && dst);
+
+    for (int m = 1; m < 3; m++)
+    {
+        buf = _test_buffer_ring_alloc(m, 3000);
+        assert(buf && buf->ring && (m == 2 ? buf->size % 4096 == 0 : buf->size == 3000));
+        printf("%s: size=%zu mirror=%d\n", names[m], buf->size, buf->mirror);
+
+        ref_r = ref_w = 0;
+        for (int i = 0; i < 100000; i++)
+        {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            size_t len = (seed >> 33) % 1500 + 1;
+
+            if ((seed >> 20) & 1)
+            {
+                for (size_t j = 0; j < len; j++)
+                    src[j] = (uint8_t)(ref_w + j);
+
+                chk = abcdk_buffer_write(buf, src, len);
+                assert(chk == ABCDK_MIN(len, buf->size - (ref_w - ref_r)));
+                ref_w += chk;
+            }
+            else
+            {
+                chk = abcdk_buffer_read(buf, dst, len);
+                assert(chk == ABCDK_MIN(len, ref_w - ref_r));
+                for (ssize_t j = 0; j < chk; j++)
+                    assert(dst[j] == (uint8_t)(ref_r + j));
+                ref_r += chk;
+            }
+
+            assert(abcdk_buffer_readable(buf) == ref_w - ref_r);
+            assert(abcdk_buffer_writable(buf) == buf->size - (ref_w - ref_r));
+
+            /*镜像映射只有一段。*/
+            chk = abcdk_buffer_rvec(buf, vec);
+            assert(chk <= (buf->mirror ? 1 : 2));
+
+            if (i % 7 == 0)
+                abcdk_buffer_drain(buf);
+        }
+
+        /*跨过末尾的行和格式化写入。*/
+        abcdk_buffer_drain(buf);
+        buf->rsize = buf->wsize = buf->size - 3;
+        rsize = abcdk_buffer_printf(buf, "hello %s\nworld\n", "ring");
+        assert(rsize == 17);
+        rsize = abcdk_buffer_readline(buf, dst, 100);
+        assert(rsize == 11 && strcmp((char *)dst, "hello ring\n") == 0);
+        rsize = abcdk_buffer_readline(buf, dst, 100);
+        assert(rsize == 6 && strcmp((char *)dst, "world\n") == 0);
+        assert(abcdk_buffer_readable(buf) == 0);
+
+        /*跨过末尾的导入和导出。*/
+        buf->rsize = buf->wsize = buf->size - 100;
+        for (int j = 0; j < 1000; j++)
+            src[j] = (uint8_t)(j * 7);
+
+        chk = pipe(fds);
+        assert(chk == 0);
+        rsize = write(fds[1], src, 1000);
+        assert(rsize == 1000);
+        rsize = abcdk_buffer_import_atmost(buf, fds[0], 1000);
+        assert(rsize == 1000);
+        chk = abcdk_buffer_rvec(buf, vec);
+        assert(chk == (buf->mirror ? 1 : 2));
+        rsize = abcdk_buffer_export_atmost(buf, fds[1], 1000);
+        assert(rsize == 1000);
+        rsize = read(fds[0], dst, 1000);
+        assert(rsize == 1000 && memcmp(src, dst, 1000) == 0);
+        abcdk_closep(&fds[0]);
+        abcdk_closep(&fds[1]);
+
+        /*调整容量后，未读数据移到首地址。*/
+        buf->rsize = buf->wsize = buf->size - 10;
+        rsize = abcdk_buffer_write(buf, src, 100);
+        assert(rsize == 100);
+        chk = abcdk_buffer_resize(buf, 5000);
+        assert(chk == 0 && buf->rsize == 0 && buf->wsize == 100);
+        rsize = abcdk_buffer_read(buf, dst, 100);
+        assert(rsize == 100 && memcmp(src, dst, 100) == 0);
+
+        /*引用的内存块，写前复制(不再有镜像映射)。*/
+        buf->rsize = buf->wsize = buf->size - 10;
+        rsize = abcdk_buffer_write(buf, src, 100);
+        assert(rsize == 100);
+        buf2 = abcdk_buffer_copy(buf);
+        assert(buf2 && buf2->ring && buf2->alloc == buf->alloc);
+        rsize = abcdk_buffer_write(buf2, src, 1);
+        assert(rsize == 1 && buf2->alloc != buf->alloc && buf2->mirror == 0);
+        rsize = abcdk_buffer_read(buf2, dst, 101);
+        assert(rsize == 101 && memcmp(src, dst, 100) == 0 && dst[100] == src[0]);
+        abcdk_buffer_free(&buf2);
+
+        buf2 = abcdk_buffer_clone(buf);
+        assert(buf2 && buf2->ring && buf2->mirror == buf->mirror);
+        rsize = abcdk_buffer_read(buf2, dst, 100);
+        assert(rsize == 100 && memcmp(src, dst, 100) == 0);
+        abcdk_buffer_free(&buf2);
+
+        abcdk_buffer_free(&buf);
+    }
+
+    abcdk_heap_free(src);
+    abcdk_heap_free(dst);
+
+    /*
+     * 按块读写文件，每次读写一小段(--chunk)。
+     * 线性缓存每次从缓存读取后都要移动未读数据。
+    */
+    fd = mkstemp(tmpname);
+    assert(fd >= 0);
+    unlink(tmpname);
+
+    src = (uint8_t *)abcdk_heap_alloc(chunk);
+    dst = (uint8_t *)abcdk_heap_alloc(chunk);
+    assert(src && dst);
+
+    for (int m = 0; m < 3; m++)
+    {
+        if (mode >= 0 && mode != m)
+            continue;
+
+        uint32_t sum = 0, sum2 = 0;
+        uint64_t cast_write, cast_read;
+
+        chk = ftruncate(fd, 0);
+        assert(chk == 0);
+        rsize = lseek(fd, 0, SEEK_SET);
+        assert(rsize == 0);
+
+        buf = _test_buffer_ring_alloc(m, block);
+        assert(buf != NULL);
+
+        abcdk_clock_dot(NULL);
+
+        for (int i = 0; i < total / chunk; i++)
+        {
+            memset(src, i, chunk);
+            sum = abcdk_crc32_sum(src, chunk, sum);
+            rsize = abcdk_block_write(fd, src, chunk, buf);
+            assert(rsize == chunk);
+        }
+
+        chk = abcdk_block_write_trailer(fd, 0, buf);
+        assert(chk >= 0);
+
+        cast_write = abcdk_clock_step(NULL);
+
+        abcdk_buffer_free(&buf);
+        buf = _test_buffer_ring_alloc(m, block);
+        assert(buf != NULL);
+
+        rsize = lseek(fd, 0, SEEK_SET);
+        assert(rsize == 0);
+
+        abcdk_clock_dot(NULL);
+
+        for (int i = 0; i < total / chunk; i++)
+        {
+            rsize = abcdk_block_read(fd, dst, chunk, buf);
+            assert(rsize == chunk);
+            sum2 = abcdk_crc32_sum(dst, chunk, sum2);
+        }
+
+        cast_read = abcdk_clock_step(NULL);
+
+        assert(sum == sum2);
+
+        printf("%-6s block=%d chunk=%d total=%d(MB) write=%lu(us) read=%lu(us)\n",
+               names[m], block, chunk, total / 1024 / 1024, cast_write, cast_read);
+
+        abcdk_buffer_free(&buf);
+    }
+
+    abcdk_heap_free(src);
+    abcdk_heap_free(dst);
+    abcdk_closep(&fd);
+}
+
+static void _test_chain_check(abcdk_chain_t *chain, const uint8_t *data, size_t size)
+{
+    struct iovec vec[64];
+    size_t len = 0;
+    int n;
+
+    assert(abcdk_chain_length(chain) == size);
+
+    n = abcdk_chain_iovec(chain, vec, 64);
+    for (int i = 0; i < n; i++)
+    {
+        assert(memcmp(vec[i].iov_base, data + len, vec[i].iov_len) == 0);
+        len += vec[i].iov_len;
+    }
+
+    assert(len == size);
+}
+
+void test_chain(abcdk_tree_t *args)
+{
+    int count = abcdk_option_get_int(args, "--count", 0, 100000);
+    int payload = abcdk_option_get_int(args, "--payload", 0, 4096);
+    char tmpname[] = "/tmp/abcdk-chain-XXXXXX";
+    abcdk_chain_t *chain, *chain2, *chain3;
+    abcdk_allocator_t *alloc;
+    abcdk_buffer_t *buf;
+    uint8_t *src, *dst;
+    uint64_t cast_buffer, cast_chain;
+    int fd;
+    int chk;
+    ssize_t rsize;
+
+    src = (uint8_t *)abcdk_heap_alloc(100000);
+    dst = (uint8_t *)abcdk_heap_alloc(100000);
+    assert(src && dst);
+
+    for (int i = 0; i < 100000; i++)
+        src[i] = (uint8_t)(i * 13 + i / 251);
+
+    /*小段数据写入同一个分段的剩余空间。*/
+    chain = abcdk_chain_alloc();
+    assert(chain != NULL);
+
+    for (int i = 0; i < 1000; i++)
+    {
+        chk = abcdk_chain_append2(chain, src + i * 10, 10);
+        assert(chk == 0);
+    }
+
+    assert(abcdk_chain_count(chain) == 1);
+    _test_chain_check(chain, src, 10000);
+
+    /*共享的内存块是只读的，追加的数据写入新的分段。*/
+    chain2 = abcdk_chain_copy(chain);
+    assert(chain2 != NULL);
+    chk = abcdk_chain_append2(chain, src + 10000, 10);
+    assert(chk == 0 && abcdk_chain_count(chain) == 2);
+    _test_chain_check(chain, src, 10010);
+    _test_chain_check(chain2, src, 10000);
+    abcdk_chain_free(&chain2);
+
+    /*拆分(跨过分段)，拼接还原。*/
+    chain2 = abcdk_chain_split(chain, 5000);
+    assert(chain2 != NULL);
+    _test_chain_check(chain2, src, 5000);
+    _test_chain_check(chain, src + 5000, 5010);
+    abcdk_chain_splice(chain2, chain);
+    assert(abcdk_chain_length(chain) == 0 && abcdk_chain_count(chain) == 0);
+    _test_chain_check(chain2, src, 10010);
+    abcdk_chain_free(&chain);
+    chain = chain2;
+
+    /*前插和读取。*/
+    chk = abcdk_chain_prepend2(chain, "head", 4);
+    assert(chk == 0);
+    rsize = abcdk_chain_read(chain, dst, 4);
+    assert(rsize == 4 && memcmp(dst, "head", 4) == 0);
+    rsize = abcdk_chain_read(chain, dst, 100000);
+    assert(rsize == 10010 && memcmp(dst, src, 10010) == 0);
+    rsize = abcdk_chain_read(chain, dst, 1);
+    assert(rsize == 0);
+
+    /*引用内存块和缓存(包括环形缓存跨过末尾的数据)。*/
+    alloc = abcdk_allocator_alloc2(1000);
+    memcpy(alloc->pptrs[0], src, 1000);
+    chk = abcdk_chain_append(chain, alloc, 500, 500);
+    assert(chk == 0);
+    chk = abcdk_chain_prepend(chain, alloc, 0, 500);
+    assert(chk == 0);
+    abcdk_allocator_unref(&alloc);
+    _test_chain_check(chain, src, 1000);
+
+    for (int m = 0; m < 2; m++)
+    {
+        buf = abcdk_buffer_alloc3(4096, m);
+        buf->rsize = buf->wsize = buf->size - 100;
+        rsize = abcdk_buffer_write(buf, src + 1000, 1000);
+        assert(rsize == 1000);
+        chk = abcdk_chain_append3(chain, buf);
+        assert(chk == 0);
+        abcdk_buffer_free(&buf);
+        _test_chain_check(chain, src, 2000);
+        abcdk_chain_drain(chain, 1000);
+        rsize = abcdk_chain_read(chain, dst, 1000);
+        assert(rsize == 1000 && memcmp(dst, src + 1000, 1000) == 0);
+        alloc = abcdk_allocator_alloc2(1000);
+        memcpy(alloc->pptrs[0], src, 1000);
+        chk = abcdk_chain_append(chain, alloc, 0, 1000);
+        assert(chk == 0);
+        abcdk_allocator_unref(&alloc);
+    }
+
+    abcdk_chain_free(&chain);
+
+    /*导出和导入。*/
+    fd = mkstemp(tmpname);
+    assert(fd >= 0);
+    unlink(tmpname);
+
+    chain = abcdk_chain_alloc();
+    for (int i = 0; i < 100; i++)
+    {
+        alloc = abcdk_allocator_alloc2(1000);
+        memcpy(alloc->pptrs[0], src + i * 1000, 1000);
+        chk = abcdk_chain_append(chain, alloc, 0, 1000);
+        assert(chk == 0);
+        abcdk_allocator_unref(&alloc);
+    }
+
+    rsize = abcdk_chain_export(chain, fd);
+    assert(rsize == 100000 && abcdk_chain_length(chain) == 0);
+    rsize = lseek(fd, 0, SEEK_SET);
+    assert(rsize == 0);
+    chk = abcdk_chain_append2(chain, src, 10);
+    assert(chk == 0);
+    rsize = abcdk_chain_import_atmost(chain, fd, 50000);
+    assert(rsize == 50000);
+    rsize = abcdk_chain_import_atmost(chain, fd, 100000);
+    assert(rsize == 50000);
+    rsize = abcdk_chain_read(chain, dst, 10);
+    assert(rsize == 10 && memcmp(dst, src, 10) == 0);
+    rsize = abcdk_chain_read(chain, dst, 100000);
+    assert(rsize == 100000 && memcmp(dst, src, 100000) == 0);
+    abcdk_chain_free(&chain);
+
+    /*导入到空的链。*/
+    chain = abcdk_chain_alloc();
+    lseek(fd, 0, SEEK_SET);
+    rsize = abcdk_chain_import_atmost(chain, fd, 100);
+    assert(rsize == 100 && abcdk_chain_length(chain) == 100);
+    rsize = abcdk_chain_read(chain, dst, 1000);
+    assert(rsize == 100 && memcmp(dst, src, 100) == 0);
+    abcdk_chain_free(&chain);
+
+    /*
+     * 组装帧(4字节头部+负载)并写入文件。
+     * 1：连续的缓存，容量不足时翻倍并复制。
+     * 2：分段缓存，负载引用同一个内存块，导出时writev。
+    */
+    alloc = abcdk_allocator_alloc2(payload);
+    memcpy(alloc->pptrs[0], src, ABCDK_MIN(payload, 100000));
+
+    chk = ftruncate(fd, 0);
+    assert(chk == 0);
+    rsize = lseek(fd, 0, SEEK_SET);
+    assert(rsize == 0);
+    abcdk_clock_dot(NULL);
+
+    buf = abcdk_buffer_alloc2(4096);
+    for (int i = 0; i < count; i++)
+    {
+        uint32_t hdr = abcdk_endian_h_to_b32(payload);
+
+        while (abcdk_buffer_writable(buf) < sizeof(hdr) + payload)
+        {
+            chk = abcdk_buffer_resize(buf, buf->size * 2);
+            assert(chk == 0);
+        }
+
+        abcdk_buffer_write(buf, &hdr, sizeof(hdr));
+        abcdk_buffer_write(buf, alloc->pptrs[0], payload);
+    }
+
+    while (abcdk_buffer_readable(buf) > 0)
+    {
+        rsize = abcdk_buffer_export_atmost(buf, fd, abcdk_buffer_readable(buf));
+        assert(rsize > 0);
+    }
+
+    abcdk_buffer_free(&buf);
+    cast_buffer = abcdk_clock_step(NULL);
+
+    size_t fsize = lseek(fd, 0, SEEK_CUR);
+    chk = ftruncate(fd, 0);
+    assert(chk == 0);
+    rsize = lseek(fd, 0, SEEK_SET);
+    assert(rsize == 0);
+    abcdk_clock_dot(NULL);
+
+    chain = abcdk_chain_alloc();
+    for (int i = 0; i < count; i++)
+    {
+        uint32_t hdr = abcdk_endian_h_to_b32(payload);
+
+        chain2 = abcdk_chain_alloc();
+        chk = abcdk_chain_append(chain2, alloc, 0, payload);
+        assert(chk == 0);
+        chk = abcdk_chain_prepend2(chain2, &hdr, sizeof(hdr));
+        assert(chk == 0);
+        abcdk_chain_splice(chain, chain2);
+        abcdk_chain_free(&chain2);
+    }
+
+    rsize = abcdk_chain_export(chain, fd);
+    assert(rsize == fsize);
+    abcdk_chain_free(&chain);
+    cast_chain = abcdk_clock_step(NULL);
+
+    rsize = lseek(fd, 0, SEEK_CUR);
+    assert(rsize == fsize);
+
+    printf("frames=%d payload=%d total=%zu(KB) buffer=%lu(us) chain=%lu(us)\n",
+           count, payload, fsize / 1024, cast_buffer, cast_chain);
+
+    abcdk_allocator_unref(&alloc);
+    abcdk_closep(&fd);
+    abcdk_heap_free(src);
+    abcdk_heap_free(dst);
+}
+
+static const void *_test_memdelim_scalar(const void *data, size_t size, uint8_t delim)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        if (ABCDK_PTR2U8(data, i) == delim)
+            return ABCDK_PTR2VPTR(data, i);
+    }
+
+    return NULL;
+}
+
+void test_memdelim(abcdk_tree_t *args)
+{
+    int total = abcdk_option_get_int(args, "--total", 0, 256 * 1024 * 1024);
+    int linelen = abcdk_option_get_int(args, "--linelen", 0, 80);
+    uint8_t *text, *line;
+    abcdk_buffer_t *buf;
+    const void *line_p;
+    uint64_t cast, lines, lines2;
+    abcdk_tree_t *opt;
+    ssize_t chk;
+    FILE *fp;
+    ssize_t rsize;
+
+    /*每个偏移量和长度，每个位置的分隔符，与逐字节比较的结果相同。*/
+    text = (uint8_t *)abcdk_heap_alloc(512);
+    assert(text != NULL);
+
+    for (size_t off = 0; off < 64; off++)
+    {
+        for (size_t len = 0; len < 300; len++)
+        {
+            memset(text, 'a', 512);
+            assert(abcdk_memdelim(text + off, len, '\n') == NULL);
+
+            for (size_t pos = 0; pos < len; pos += 7)
+            {
+                text[off + pos] = '\n';
+                assert(abcdk_memdelim(text + off, len, '\n') == _test_memdelim_scalar(text + off, len, '\n'));
+                assert(abcdk_memdelim(text + off, len, '\n') == text + off + pos);
+                memset(text, 'a', 512);
+            }
+        }
+    }
+
+    abcdk_heap_free(text);
+
+    /*文本：每行"keyN = value..."，长度为linelen。*/
+    text = (uint8_t *)abcdk_heap_malloc(total);
+    assert(text != NULL);
+
+    lines = 0;
+    for (size_t i = 0; i + linelen <= total; i += linelen, lines++)
+    {
+        int n = snprintf((char *)text + i, linelen, "key%lu = ", lines % 16);
+        memset(text + i + n, 'v', linelen - n - 1);
+        text[i + linelen - 1] = '\n';
+    }
+
+    total = lines * linelen;
+
+    /*分隔符查找：逐字节，glibc的memchr，向量化。*/
+    for (int m = 0; m < 3; m++)
+    {
+        const char *names[3] = {"scalar", "memchr", "memdelim"};
+        const uint8_t *p = text, *end = text + total, *eol;
+
+        abcdk_clock_dot(NULL);
+
+        lines2 = 0;
+        while (p < end)
+        {
+            if (m == 0)
+                eol = (const uint8_t *)_test_memdelim_scalar(p, end - p, '\n');
+            else if (m == 1)
+                eol = (const uint8_t *)memchr(p, '\n', end - p);
+            else
+                eol = (const uint8_t *)abcdk_memdelim(p, end - p, '\n');
+
+            p = eol + 1;
+            lines2 += 1;
+        }
+
+        cast = abcdk_clock_step(NULL);
+        assert(lines2 == lines);
+
+        printf("%-8s lines=%lu total=%d(MB) cast=%lu(us) %.2f(GB/s)\n",
+               names[m], lines, total / 1024 / 1024, cast, (double)total / cast / 1000);
+    }
+
+    /*按行读取：复制，不复制。*/
+    buf = abcdk_buffer_alloc(NULL);
+    buf->data = text;
+    buf->size = buf->wsize = total;
+
+    line = (uint8_t *)abcdk_heap_alloc(linelen * 2);
+
+    buf->rsize = 0;
+    abcdk_clock_dot(NULL);
+    for (lines2 = 0; (chk = abcdk_buffer_readline(buf, line, linelen * 2)) > 0; lines2++)
+        assert(chk == linelen);
+    cast = abcdk_clock_step(NULL);
+    assert(lines2 == lines);
+    printf("readline  cast=%lu(us)\n", cast);
+
+    buf->rsize = 0;
+    abcdk_clock_dot(NULL);
+    for (lines2 = 0; (chk = abcdk_buffer_readline2(buf, &line_p)) > 0; lines2++)
+        assert(chk == linelen && ABCDK_PTR2U8(line_p, chk - 1) == '\n');
+    cast = abcdk_clock_step(NULL);
+    assert(lines2 == lines);
+    printf("readline2 cast=%lu(us)\n", cast);
+
+    abcdk_heap_free(line);
+    abcdk_buffer_free(&buf);
+
+    /*环形缓存(非镜像)中跨过末尾的行。*/
+    buf = abcdk_buffer_alloc3(100, 0);
+    buf->rsize = buf->wsize = 95;
+    rsize = abcdk_buffer_write(buf, "hello\nworld", 11);
+    assert(rsize == 11);
+    rsize = abcdk_buffer_readline2(buf, &line_p);
+    assert(rsize == 6 && memcmp(line_p, "hello\n", 6) == 0);
+    rsize = abcdk_buffer_readline2(buf, &line_p);
+    assert(rsize == 5 && memcmp(line_p, "world", 5) == 0);
+    rsize = abcdk_buffer_readline2(buf, &line_p);
+    assert(rsize == 0);
+    abcdk_buffer_free(&buf);
+
+    /*参数导入：文件流(fmemopen+getdelim)，文本。*/
+    total = ABCDK_MIN(total, 64 * 1024 * 1024);
+    total -= total % linelen;
+
+    for (int m = 0; m < 2; m++)
+    {
+        opt = abcdk_tree_alloc3(1);
+
+        abcdk_clock_dot(NULL);
+
+        if (m == 0)
+        {
+            fp = fmemopen(text, total, "r");
+            abcdk_getargs_fp(opt, fp, '\n', '#', NULL, NULL);
+            fclose(fp);
+        }
+        else
+        {
+            abcdk_getargs_text(opt, (char *)text, total, '\n', '#', NULL, NULL);
+        }
+
+        cast = abcdk_clock_step(NULL);
+
+        assert(abcdk_option_count(opt, "key15") == total / linelen / 16);
+        printf("getargs %-4s total=%d(MB) cast=%lu(us)\n", (m == 0 ? "fp" : "text"), total / 1024 / 1024, cast);
+
+        abcdk_tree_free(&opt);
+    }
+
+    abcdk_heap_free(text);
+
+    /*文件流和文本的解析结果相同(注释、空行、没有结尾的分割字符)。*/
+    const char *conf[2] = {"# note\n\na = 1\n b : '2' \n\tc\nd=\"4\"", "--x\n 1\n#--y\n--z\n2\n3"};
+    char out[2][256];
+
+    for (int i = 0; i < 2; i++)
+    {
+        for (int m = 0; m < 2; m++)
+        {
+            opt = abcdk_tree_alloc3(1);
+
+            if (m == 0)
+            {
+                fp = fmemopen((char *)conf[i], strlen(conf[i]), "r");
+                abcdk_getargs_fp(opt, fp, '\n', '#', "argv0", (i ? "--" : NULL));
+                fclose(fp);
+            }
+            else
+            {
+                abcdk_getargs_text(opt, conf[i], strlen(conf[i]), '\n', '#', "argv0", (i ? "--" : NULL));
+            }
+
+            fp = fmemopen(out[m], sizeof(out[m]), "w");
+            abcdk_option_fprintf(fp, opt, NULL);
+            fclose(fp);
+
+            abcdk_tree_free(&opt);
+        }
+
+        assert(strcmp(out[0], out[1]) == 0);
+    }
+
+    /*从普通文件和管道导入，结果和文本相同。*/
+    char fifo[] = "/tmp/abcdk-getargs-XXXXXX";
+    char file[] = "/tmp/abcdk-getargs-XXXXXX";
+    int fd;
+    pid_t pid;
+
+    fd = mkstemp(file);
+    assert(fd >= 0);
+    chk = abcdk_write(fd, conf[1], strlen(conf[1]));
+    assert(chk == strlen(conf[1]));
+    abcdk_closep(&fd);
+
+    fd = mkstemp(fifo);
+    assert(fd >= 0);
+    abcdk_closep(&fd);
+    unlink(fifo);
+    chk = mkfifo(fifo, 0600);
+    assert(chk == 0);
+
+    for (int m = 0; m < 2; m++)
+    {
+        pid = -1;
+        if (m == 1)
+        {
+            pid = fork();
+            assert(pid >= 0);
+            if (pid == 0)
+            {
+                fd = open(fifo, O_WRONLY);
+                abcdk_write(fd, conf[1], strlen(conf[1]));
+                _exit(0);
+            }
+        }
+
+        opt = abcdk_tree_alloc3(1);
+        abcdk_getargs_file(opt, (m ? fifo : file), '\n', '#', "argv0", "--");
+
+        fp = fmemopen(out[0], sizeof(out[0]), "w");
+        abcdk_option_fprintf(fp, opt, NULL);
+        fclose(fp);
+
+        abcdk_tree_free(&opt);
+
+        if (pid > 0)
+            waitpid(pid, NULL, 0);
+
+        assert(strcmp(out[0], out[1]) == 0);
+    }
+
+    unlink(file);
+    unlink(fifo);
+}
+
+typedef struct _test_block_device
+{
+    int fd;
+    size_t block;
+    int delay;
+    uint64_t bytes;
+    uint64_t sum;
+} test_block_device;
+
+static uint64_t _test_block_sum(const uint8_t *data, size_t size, uint64_t sum)
+{
+    for (size_t i = 0; i < size; i++)
+        sum += data[i];
+
+    return sum;
+}
+
+static void *_test_block_device_routine(void *opaque)
+{
+    test_block_device *dev = (test_block_device *)opaque;
+    uint8_t *buf = abcdk_heap_alloc(dev->block);
+    ssize_t rsize, rsize2;
+
+    /*
+     * 模拟磁带：按固定的速度"写入"一个块后，写入的调用才返回。
+     * 管道的容量是一页，块的最后两页在"写入"后才读取。
+    */
+    while ((rsize = abcdk_read(dev->fd, buf, dev->block - 8192)) > 0)
+    {
+        usleep(dev->delay);
+
+        rsize2 = (rsize == dev->block - 8192 ? abcdk_read(dev->fd, buf + rsize, 8192) : 0);
+        if (rsize2 > 0)
+            rsize += rsize2;
+
+        dev->sum = _test_block_sum(buf, rsize, dev->sum);
+        dev->bytes += rsize;
+    }
+
+    abcdk_heap_free(buf);
+
+    return NULL;
+}
+
+void test_block_writer(abcdk_tree_t *args)
+{
+    int block = abcdk_option_get_int(args, "--block", 0, 256 * 1024);
+    int blocks = abcdk_option_get_int(args, "--blocks", 0, 4);
+    int count = abcdk_option_get_int(args, "--count", 0, 64);
+    int delay = abcdk_option_get_int(args, "--delay", 0, 2000);
+    int work = abcdk_option_get_int(args, "--work", 0, 2000);
+    size_t chunk = 10000;
+    abcdk_block_writer_t *writer;
+    abcdk_block_writer_stat stat;
+    test_block_device dev;
+    abcdk_thread_t thread;
+    abcdk_buffer_t *buf;
+    uint8_t *data;
+    uint64_t sum;
+    int fds[2];
+    int chk;
+    ssize_t rsize;
+
+    data = abcdk_heap_alloc(chunk);
+    assert(data != NULL);
+
+    /*
+     * 0：同步(abcdk_block_write)，1：异步(abcdk_block_writer_t)。
+     * 每次写入的长度不是块大小的整数倍，最后一块需要补齐。
+    */
+    for (int m = 0; m < 2; m++)
+    {
+        chk = pipe(fds);
+        assert(chk == 0);
+        chk = fcntl(fds[1], F_SETPIPE_SZ, 4096);
+        assert(chk == 4096);
+
+        memset(&dev, 0, sizeof(dev));
+        dev.fd = fds[0];
+        dev.block = block;
+        dev.delay = delay;
+
+        thread.routine = _test_block_device_routine;
+        thread.opaque = &dev;
+        chk = abcdk_thread_create(&thread, 1);
+        assert(chk == 0);
+
+        buf = (m == 0 ? abcdk_buffer_alloc3(block, 0) : NULL);
+        writer = (m == 1 ? abcdk_block_writer_alloc(fds[1], block, blocks) : NULL);
+
+        sum = 0;
+        size_t total = (size_t)block * count - chunk / 2;
+
+        abcdk_clock_dot(NULL);
+
+        for (size_t i = 0, seq = 0; i < total; i += chunk, seq++)
+        {
+            size_t len = ABCDK_MIN(chunk, total - i);
+
+            /*模拟打包：每个块的数据需要读取源文件(等待磁盘)。*/
+            if (i / block != (i + len) / block)
+                usleep(work);
+
+            memset(data, seq, len);
+            sum = _test_block_sum(data, len, sum);
+
+            if (m == 0)
+                rsize = abcdk_block_write(fds[1], data, len, buf);
+            else
+                rsize = abcdk_block_writer_write(writer, data, len);
+
+            assert(rsize == len);
+        }
+
+        if (m == 0)
+            chk = abcdk_block_write_trailer(fds[1], 0, buf);
+        else
+            chk = abcdk_block_writer_trailer(writer, 0);
+
+        assert(chk == 0);
+
+        uint64_t cast = abcdk_clock_step(NULL);
+
+        if (m == 1)
+            abcdk_block_writer_stat_fetch(writer, &stat);
+
+        abcdk_buffer_free(&buf);
+        abcdk_block_writer_free(&writer);
+        abcdk_closep(&fds[1]);
+        abcdk_thread_join(&thread);
+        abcdk_closep(&fds[0]);
+
+        /*补齐的部分是0。*/
+        assert(dev.bytes == (uint64_t)block * count && dev.sum == sum);
+
+        printf("%-5s block=%d count=%d work=%d(us) delay=%d(us) cast=%lu(us)", (m == 0 ? "sync" : "async"),
+               block, count, work, delay, cast);
+        if (m == 1)
+            printf(" blocks=%lu stalls=%lu idles=%lu", stat.blocks, stat.stalls, stat.idles);
+        printf("\n");
+    }
+
+    /*写入失败在后续的调用中返回。*/
+    chk = pipe(fds);
+    assert(chk == 0);
+    abcdk_closep(&fds[0]);
+    signal(SIGPIPE, SIG_IGN);
+
+    writer = abcdk_block_writer_alloc(fds[1], 4096, 2);
+    assert(writer != NULL);
+    abcdk_block_writer_write(writer, data, 4096);
+    chk = abcdk_block_writer_trailer(writer, 0);
+    assert(chk == -1 && errno == EPIPE);
+    rsize = abcdk_block_writer_write(writer, data, 1);
+    assert(rsize == -1);
+    abcdk_block_writer_free(&writer);
+    abcdk_closep(&fds[1]);
+
+    /*
+     * 小块、少量的块、很短的写入，调用者和写线程频繁地交替等待。
+     * 加锁或等待有问题时，统计的长度不对或补齐等不到返回。
+    */
+    fds[1] = abcdk_open("/dev/null", 1, 0, 0);
+    assert(fds[1] >= 0);
+
+    for (int r = 0; r < 10; r++)
+    {
+        writer = abcdk_block_writer_alloc(fds[1], 512, 2);
+        assert(writer != NULL);
+
+        for (int i = 0; i < 200000; i++)
+        {
+            rsize = abcdk_block_writer_write(writer, data, 100);
+            assert(rsize == 100);
+        }
+
+        chk = abcdk_block_writer_trailer(writer, 0);
+        assert(chk == 0);
+
+        abcdk_block_writer_stat_fetch(writer, &stat);
+        assert(stat.bytes == (200000 * 100 + 511) / 512 * 512);
+        assert(stat.blocks == stat.bytes / 512);
+
+        abcdk_block_writer_free(&writer);
+    }
+
+    abcdk_closep(&fds[1]);
+
+    abcdk_heap_free(data);
+}
+
+static void *_test_block_source_routine(void *opaque)
+{
+    test_block_device *dev = (test_block_device *)opaque;
+    uint8_t *buf = abcdk_heap_alloc(dev->block);
+    size_t total = dev->bytes;
+    ssize_t rsize;
+
+    /*
+     * 模拟磁带：收到读取的调用后，按固定的速度"读取"一个块。
+     * 管道的容量是一页，写入第二页时等待调用者开始读取，然后才开始"读取"。
+    */
+    for (size_t i = 0, seq = 0; i < total; i += dev->block, seq++)
+    {
+        size_t len = ABCDK_MIN(dev->block, total - i);
+
+        memset(buf, seq, len);
+        dev->sum = _test_block_sum(buf, len, dev->sum);
+
+        if (len > 8192)
+        {
+            rsize = abcdk_write(dev->fd, buf, 8192);
+            assert(rsize == 8192);
+            usleep(dev->delay);
+        }
+
+        rsize = abcdk_write(dev->fd, buf + (len > 8192 ? 8192 : 0), len - (len > 8192 ? 8192 : 0));
+        assert(rsize > 0);
+    }
+
+    abcdk_heap_free(buf);
+    abcdk_closep(&dev->fd);
+
+    return NULL;
+}
+
+void test_block_reader(abcdk_tree_t *args)
+{
+    int block = abcdk_option_get_int(args, "--block", 0, 256 * 1024);
+    int blocks = abcdk_option_get_int(args, "--blocks", 0, 4);
+    int count = abcdk_option_get_int(args, "--count", 0, 64);
+    int delay = abcdk_option_get_int(args, "--delay", 0, 2000);
+    int work = abcdk_option_get_int(args, "--work", 0, 2000);
+    size_t chunk = 10000;
+    abcdk_block_reader_t *reader;
+    abcdk_block_reader_stat stat;
+    char tmpname[] = "/tmp/abcdk-block-reader-XXXXXX";
+    test_block_device dev;
+    abcdk_thread_t thread;
+    abcdk_buffer_t *buf;
+    const void *block_p;
+    uint8_t *data;
+    uint64_t sum;
+    ssize_t rsize;
+    int fds[2];
+    int chk;
+
+    data = abcdk_heap_alloc(chunk);
+    assert(data != NULL);
+
+    /*
+     * 0：同步(abcdk_block_read)，1：预读(abcdk_block_reader_read)，2：预读(不复制)。
+     * 最后一块不是完整的块。
+    */
+    for (int m = 0; m < 3; m++)
+    {
+        chk = pipe(fds);
+        assert(chk == 0);
+        chk = fcntl(fds[1], F_SETPIPE_SZ, 4096);
+        assert(chk == 4096);
+
+        memset(&dev, 0, sizeof(dev));
+        dev.fd = fds[1];
+        dev.block = block;
+        dev.delay = delay;
+        dev.bytes = (uint64_t)block * count - chunk / 2;
+
+        thread.routine = _test_block_source_routine;
+        thread.opaque = &dev;
+        chk = abcdk_thread_create(&thread, 1);
+        assert(chk == 0);
+
+        buf = (m == 0 ? abcdk_buffer_alloc3(block, 0) : NULL);
+        reader = (m != 0 ? abcdk_block_reader_alloc(fds[0], block, blocks) : NULL);
+
+        sum = 0;
+        size_t total = 0;
+
+        abcdk_clock_dot(NULL);
+
+        for (;;)
+        {
+            if (m == 0)
+                rsize = abcdk_block_read(fds[0], data, chunk, buf);
+            else if (m == 1)
+                rsize = abcdk_block_reader_read(reader, data, chunk);
+            else
+                rsize = abcdk_block_reader_fetch(reader, &block_p);
+
+            if (rsize <= 0)
+                break;
+
+            /*模拟解包：每个块的数据需要写入目标文件(等待磁盘)。*/
+            if (total / block != (total + rsize) / block)
+                usleep(work);
+
+            sum = _test_block_sum((m == 2 ? block_p : data), rsize, sum);
+            total += rsize;
+
+            if (m == 2)
+                abcdk_block_reader_drain(reader, rsize);
+        }
+
+        uint64_t cast = abcdk_clock_step(NULL);
+
+        assert(rsize == 0);
+
+        if (m != 0)
+            abcdk_block_reader_stat_fetch(reader, &stat);
+
+        abcdk_buffer_free(&buf);
+        abcdk_block_reader_free(&reader);
+        abcdk_thread_join(&thread);
+        abcdk_closep(&fds[0]);
+
+        assert(total == dev.bytes && sum == dev.sum);
+
+        printf("%-5s block=%d count=%d work=%d(us) delay=%d(us) cast=%lu(us)", (m == 0 ? "sync" : (m == 1 ? "async" : "fetch")),
+               block, count, work, delay, cast);
+        if (m != 0)
+            printf(" blocks=%lu stalls=%lu idles=%lu", stat.blocks, stat.stalls, stat.idles);
+        printf("\n");
+    }
+
+    /*读取失败在取完已读入的块后返回。*/
+    fds[0] = abcdk_open("/", 0, 0, 0);
+    assert(fds[0] >= 0);
+
+    reader = abcdk_block_reader_alloc(fds[0], 4096, 2);
+    assert(reader != NULL);
+    rsize = abcdk_block_reader_read(reader, data, 1);
+    assert(rsize == -1 && errno == EISDIR);
+    rsize = abcdk_block_reader_fetch(reader, &block_p);
+    assert(rsize == -1);
+    abcdk_block_reader_free(&reader);
+    abcdk_closep(&fds[0]);
+
+    /*
+     * 小块、少量的块、很短的读取，调用者和读线程频繁地交替等待。
+     * 加锁或等待有问题时，块在取完之前被读线程覆盖，内容或长度不对。
+    */
+    fds[0] = mkstemp(tmpname);
+    assert(fds[0] >= 0);
+    unlink(tmpname);
+
+    for (size_t i = 0; i < chunk; i++)
+        data[i] = (uint8_t)(i * 7);
+
+    for (int i = 0; i < 100; i++)
+    {
+        rsize = abcdk_write(fds[0], data, chunk);
+        assert(rsize == chunk);
+    }
+
+    for (int r = 0; r < 10; r++)
+    {
+        lseek(fds[0], 0, SEEK_SET);
+
+        reader = abcdk_block_reader_alloc(fds[0], 512, 2);
+        assert(reader != NULL);
+
+        size_t total = 0;
+
+        while ((rsize = abcdk_block_reader_fetch(reader, &block_p)) > 0)
+        {
+            rsize = ABCDK_MIN(rsize, 100);
+            for (ssize_t i = 0; i < rsize; i++)
+                assert(((uint8_t *)block_p)[i] == data[(total + i) % chunk]);
+
+            abcdk_block_reader_drain(reader, rsize);
+            total += rsize;
+        }
+
+        assert(rsize == 0 && total == chunk * 100);
+
+        abcdk_block_reader_stat_fetch(reader, &stat);
+        assert(stat.bytes == total);
+
+        abcdk_block_reader_free(&reader);
+    }
+
+    abcdk_closep(&fds[0]);
+
+    abcdk_heap_free(data);
+}
 
 int main(int argc, char **argv)
 {
@@ -330,6 +3130,54 @@ int main(int argc, char **argv)
     if (abcdk_strcmp(func, "test_robots", 0) == 0)
         test_robots(args);
 
+    if (abcdk_strcmp(func, "test_allocator_slab", 0) == 0)
+        test_allocator_slab(args);
+
+    if (abcdk_strcmp(func, "test_allocator_bench", 0) == 0)
+        test_allocator_bench(args);
+
+    if (abcdk_strcmp(func, "test_ring_bench", 0) == 0)
+        test_ring_bench(args);
+
+    if (abcdk_strcmp(func, "test_pool_span", 0) == 0)
+        test_pool_span(args);
+
+    if (abcdk_strcmp(func, "test_map_flat", 0) == 0)
+        test_map_flat(args);
+
+    if (abcdk_strcmp(func, "test_map_bench", 0) == 0)
+        test_map_bench(args);
+
+    if (abcdk_strcmp(func, "test_map_grow", 0) == 0)
+        test_map_grow(args);
+
+    if (abcdk_strcmp(func, "test_hash", 0) == 0)
+        test_hash(args);
+
+    if (abcdk_strcmp(func, "test_cmap_bench", 0) == 0)
+        test_cmap_bench(args);
+
+    if (abcdk_strcmp(func, "test_bptree", 0) == 0)
+        test_bptree(args);
+
+    if (abcdk_strcmp(func, "test_tree_arena", 0) == 0)
+        test_tree_arena(args);
+
+    if (abcdk_strcmp(func, "test_buffer_ring", 0) == 0)
+        test_buffer_ring(args);
+
+    if (abcdk_strcmp(func, "test_chain", 0) == 0)
+        test_chain(args);
+
+    if (abcdk_strcmp(func, "test_memdelim", 0) == 0)
+        test_memdelim(args);
+
+    if (abcdk_strcmp(func, "test_block_writer", 0) == 0)
+        test_block_writer(args);
+
+    if (abcdk_strcmp(func, "test_block_reader", 0) == 0)
+        test_block_reader(args);
+
     abcdk_tree_free(&args);
     
     return 0;
@@ -12,6 +12,7 @@
 #include "abcdkutil/getargs.h"
 #include "abcdkutil/scsi.h"
 #include "abcdkutil/mt.h"
+#include "abcdkutil/tar.h"
 
 /**/
 enum _abcdkmt_cmd
@@ -53,10 +54,21 @@ enum _abcdkmt_cmd
 #define ABCDKMT_SEEK_POS ABCDKMT_SEEK_POS
 
     /** 写FILEMARK。*/
-    ABCDKMT_WRITE_FILEMARK = 10
+    ABCDKMT_WRITE_FILEMARK = 10,
 #define ABCDKMT_WRITE_FILEMARK ABCDKMT_WRITE_FILEMARK
+
+    /** 写入文件(TAR)。*/
+    ABCDKMT_TAR_CREATE = 11,
+#define ABCDKMT_TAR_CREATE ABCDKMT_TAR_CREATE
+
+    /** 读出文件(TAR)。*/
+    ABCDKMT_TAR_EXTRACT = 12
+#define ABCDKMT_TAR_EXTRACT ABCDKMT_TAR_EXTRACT
 };
 
+/** TAR的默认块大小(20个记录)。*/
+#define ABCDKMT_TAR_BLOCKSIZE (20 * ABCDK_TAR_BLOCK_SIZE)
+
 void _abcdkmt_print_usage(abcdk_tree_t *args, int only_version)
 {
     char name[NAME_MAX] = {0};
@@ -84,7 +96,7 @@ void _abcdkmt_print_usage(abcdk_tree_t *args, int only_version)
     fprintf(stderr, "\t\tOutput version information and exit.\n");
 
     fprintf(stderr, "\n\t--dev < FILE >\n");
-    fprintf(stderr, "\t\tBlock SCSI device.\n");
+    fprintf(stderr, "\t\tBlock SCSI device. Tape device(st) or archive file for TAR commands.\n");
 
     fprintf(stderr, "\n\t--pos-block < NUMBER >\n");
     fprintf(stderr, "\t\tLogical object identifier.\n");
@@ -95,6 +107,21 @@ void _abcdkmt_print_usage(abcdk_tree_t *args, int only_version)
     fprintf(stderr, "\n\t--filemarks < NUMBER >\n");
     fprintf(stderr, "\t\tLogical object numbers. default: 1\n");
 
+    fprintf(stderr, "\n\t--src < PATH [PATH ...] >\n");
+    fprintf(stderr, "\t\tFiles, directories or links to write(not recursive).\n");
+
+    fprintf(stderr, "\n\t--dst < PATH >\n");
+    fprintf(stderr, "\t\tDirectory to extract into. default: ./\n");
+
+    fprintf(stderr, "\n\t--blocksize < NUMBER >\n");
+    fprintf(stderr, "\t\tBlock size(Bytes), multiple of %d. default: %d\n", ABCDK_TAR_BLOCK_SIZE, ABCDKMT_TAR_BLOCKSIZE);
+
+    fprintf(stderr, "\n\t--async-blocks < NUMBER >\n");
+    fprintf(stderr, "\t\tBlocks queued to a writer thread when writing(TAR), at least 2. default: 0(synchronous)\n");
+
+    fprintf(stderr, "\n\t--read-ahead < NUMBER >\n");
+    fprintf(stderr, "\t\tBlocks read ahead by a reader thread when reading(TAR), at least 2. default: 0(synchronous)\n");
+
     fprintf(stderr, "\n\t--cmd < NUMBER >\n");
     fprintf(stderr, "\t\tCommand. default: %d\n", ABCDKMT_STATUS);
 
@@ -108,6 +135,8 @@ void _abcdkmt_print_usage(abcdk_tree_t *args, int only_version)
     fprintf(stderr, "\t\t%d: Read position.\n", ABCDKMT_READ_POS);
     fprintf(stderr, "\t\t%d: Seek position.\n", ABCDKMT_SEEK_POS);
     fprintf(stderr, "\t\t%d: Write filemark.\n", ABCDKMT_WRITE_FILEMARK);
+    fprintf(stderr, "\t\t%d: Write files(TAR).\n", ABCDKMT_TAR_CREATE);
+    fprintf(stderr, "\t\t%d: Read files(TAR).\n", ABCDKMT_TAR_EXTRACT);
 }
 
 static struct _abcdkmt_sense_dict
@@ -291,6 +320,346 @@ final:
     return;
 }
 
+int _abcdkmt_tar_create(abcdk_tree_t *args, abcdk_tar_t *tar, void *buf, size_t size)
+{
+    const char *src_p = NULL;
+    char linkname[PATH_MAX] = {0};
+    char zero[2 * ABCDK_TAR_BLOCK_SIZE] = {0};
+    struct stat attr = {0};
+    int fd = -1;
+    ssize_t rsize;
+    int chk;
+
+    for (int i = 0;; i++)
+    {
+        src_p = abcdk_option_get(args, "--src", i, NULL);
+        if (!src_p)
+            break;
+
+        if (lstat(src_p, &attr) != 0)
+        {
+            syslog(LOG_WARNING, "'%s' %s.", src_p, strerror(errno));
+            goto final_error;
+        }
+
+        memset(linkname, 0, PATH_MAX);
+
+        if (S_ISLNK(attr.st_mode))
+        {
+            if (readlink(src_p, linkname, PATH_MAX - 1) < 0)
+            {
+                syslog(LOG_WARNING, "'%s' %s.", src_p, strerror(errno));
+                goto final_error;
+            }
+        }
+        else if (!S_ISREG(attr.st_mode) && !S_ISDIR(attr.st_mode))
+        {
+            syslog(LOG_WARNING, "'%s' Not supported, skip.", src_p);
+            continue;
+        }
+
+        chk = abcdk_tar_write_hdr(tar, src_p, &attr, (S_ISLNK(attr.st_mode) ? linkname : NULL));
+        if (chk != 0)
+            goto print_error;
+
+        if (!S_ISREG(attr.st_mode) || attr.st_size <= 0)
+            continue;
+
+        fd = abcdk_open(src_p, 0, 0, 0);
+        if (fd < 0)
+        {
+            syslog(LOG_WARNING, "'%s' %s.", src_p, strerror(errno));
+            goto final_error;
+        }
+
+        /*按头部中记录的长度写入，文件在此期间变化时，后面的条目不会错位。*/
+        for (off_t off = 0; off < attr.st_size; off += rsize)
+        {
+            rsize = abcdk_read(fd, buf, ABCDK_MIN((off_t)size, attr.st_size - off));
+            if (rsize <= 0)
+            {
+                syslog(LOG_WARNING, "'%s' Truncated.", src_p);
+                goto final_error;
+            }
+
+            if (abcdk_tar_write(tar, buf, rsize) != rsize)
+                goto print_error;
+        }
+
+        abcdk_closep(&fd);
+
+        chk = abcdk_tar_write_align(tar, attr.st_size);
+        if (chk != 0)
+            goto print_error;
+    }
+
+    /*两个空的头部表示结束，最后一块的剩余部分也用0填充。*/
+    if (abcdk_tar_write(tar, zero, sizeof(zero)) != sizeof(zero))
+        goto print_error;
+
+    chk = abcdk_tar_write_trailer(tar, 0);
+    if (chk < 0)
+        goto print_error;
+
+    return 0;
+
+print_error:
+
+    syslog(LOG_WARNING, "%s.", strerror(errno ? errno : EIO));
+
+final_error:
+
+    abcdk_closep(&fd);
+
+    return -1;
+}
+
+/*
+ * 检查目标目录下已存在的上级路径中是否有符号链接。
+ *
+ * 解压时不跟随符号链接，否则前面的条目(x -> /etc)加上后面的条目(x/passwd)，就能写到目标目录以外。
+*/
+int _abcdkmt_tar_parent_safe(const char *dst, const char *name)
+{
+    char tmp[PATH_MAX] = {0};
+    char path[PATH_MAX * 2] = {0};
+    char *saveptr = NULL;
+    char *it = NULL;
+    char *next = NULL;
+    struct stat attr = {0};
+
+    strncpy(tmp, name, PATH_MAX - 1);
+    abcdk_dirdir(path, dst);
+
+    it = strtok_r(tmp, "/", &saveptr);
+    while (it)
+    {
+        /*最后一级由调用者处理。*/
+        next = strtok_r(NULL, "/", &saveptr);
+        if (!next)
+            break;
+
+        abcdk_dirdir(path, "/");
+        abcdk_dirdir(path, it);
+
+        if (lstat(path, &attr) != 0)
+            return (errno == ENOENT ? 0 : -1);
+
+        if (S_ISLNK(attr.st_mode))
+            return -1;
+
+        it = next;
+    }
+
+    return 0;
+}
+
+int _abcdkmt_tar_extract(abcdk_tree_t *args, abcdk_tar_t *tar, void *buf, size_t size)
+{
+    const char *dst_p = NULL;
+    char name[PATH_MAX] = {0};
+    char linkname[PATH_MAX] = {0};
+    char path[PATH_MAX * 2] = {0};
+    struct stat attr = {0};
+    struct stat attr2 = {0};
+    int fd = -1;
+    ssize_t rsize;
+    int chk;
+
+    dst_p = abcdk_option_get(args, "--dst", 0, "./");
+
+    for (;;)
+    {
+        memset(name, 0, PATH_MAX);
+        memset(linkname, 0, PATH_MAX);
+        memset(&attr, 0, sizeof(attr));
+
+        /*结束标志(空的头部)或不是TAR头部时停止。*/
+        chk = abcdk_tar_read_hdr(tar, name, &attr, linkname);
+        if (chk != 0)
+            break;
+
+        /*名字中的"../"不能超出目标目录，符号链接由下面的检查处理。*/
+        memset(path, 0, sizeof(path));
+        abcdk_dirdir(path, "/");
+        abcdk_dirdir(path, name);
+        memset(name, 0, PATH_MAX);
+        abcdk_dirnice(name, path);
+
+        memset(path, 0, sizeof(path));
+        abcdk_dirdir(path, dst_p);
+        abcdk_dirdir(path, name);
+
+        /*上级路径中有符号链接的条目不解压，数据照常读出。*/
+        if (_abcdkmt_tar_parent_safe(dst_p, name) != 0)
+        {
+            syslog(LOG_WARNING, "'%s' Through a symbolic link, skip.", path);
+        }
+        else if (S_ISDIR(attr.st_mode))
+        {
+            abcdk_dirdir(path, "/");
+            abcdk_mkdir(path, attr.st_mode & 0777);
+        }
+        else if (S_ISLNK(attr.st_mode))
+        {
+            abcdk_mkdir(path, 0755);
+            unlink(path);
+            if (symlink(linkname, path) != 0)
+                syslog(LOG_WARNING, "'%s' %s.", path, strerror(errno));
+        }
+        else if (S_ISREG(attr.st_mode))
+        {
+            abcdk_mkdir(path, 0755);
+
+            /*已存在的符号链接不跟随，先删除再创建。*/
+            if (lstat(path, &attr2) == 0 && S_ISLNK(attr2.st_mode))
+                unlink(path);
+
+            fd = open(path, O_WRONLY | O_CREAT | O_NOFOLLOW | __O_LARGEFILE | __O_CLOEXEC, S_IRUSR | S_IWUSR);
+            if (fd < 0)
+            {
+                syslog(LOG_WARNING, "'%s' %s.", path, strerror(errno));
+                goto final_error;
+            }
+
+            fchmod(fd, attr.st_mode & 07777);
+            ftruncate(fd, 0);
+        }
+
+        if (attr.st_size <= 0)
+        {
+            abcdk_closep(&fd);
+            continue;
+        }
+
+        /*其它类型的数据也要读出来，后面的头部才不会错位。*/
+        for (off_t off = 0; off < attr.st_size; off += rsize)
+        {
+            rsize = abcdk_tar_read(tar, buf, ABCDK_MIN((off_t)size, attr.st_size - off));
+            if (rsize <= 0)
+                goto print_error;
+
+            if (fd >= 0 && abcdk_write(fd, buf, rsize) != rsize)
+            {
+                syslog(LOG_WARNING, "'%s' %s.", path, strerror(errno));
+                goto final_error;
+            }
+        }
+
+        abcdk_closep(&fd);
+
+        chk = abcdk_tar_read_align(tar, attr.st_size);
+        if (chk != 0)
+            goto print_error;
+    }
+
+    return 0;
+
+print_error:
+
+    syslog(LOG_WARNING, "%s.", strerror(errno ? errno : EIO));
+
+final_error:
+
+    abcdk_closep(&fd);
+
+    return -1;
+}
+
+void _abcdkmt_tar(abcdk_tree_t *args, const char *dev_p, int cmd)
+{
+    abcdk_tar_t tar = {-1, NULL};
+    abcdk_block_writer_stat wstat = {0};
+    abcdk_block_reader_stat rstat = {0};
+    size_t blocksize = 0;
+    int async_blocks = 0;
+    int read_ahead = 0;
+    void *buf = NULL;
+    int chk;
+
+    blocksize = abcdk_option_get_long(args, "--blocksize", 0, ABCDKMT_TAR_BLOCKSIZE);
+    if (blocksize < ABCDK_TAR_BLOCK_SIZE || blocksize % ABCDK_TAR_BLOCK_SIZE != 0)
+    {
+        syslog(LOG_WARNING, "Block size must be a multiple of %d.", ABCDK_TAR_BLOCK_SIZE);
+        ABCDK_ERRNO_AND_GOTO1(EINVAL, final);
+    }
+
+    async_blocks = abcdk_option_get_int(args, "--async-blocks", 0, 0);
+    if (async_blocks == 1 || async_blocks < 0)
+    {
+        syslog(LOG_WARNING, "Async blocks must be 0 or at least 2.");
+        ABCDK_ERRNO_AND_GOTO1(EINVAL, final);
+    }
+
+    read_ahead = abcdk_option_get_int(args, "--read-ahead", 0, 0);
+    if (read_ahead == 1 || read_ahead < 0)
+    {
+        syslog(LOG_WARNING, "Read ahead must be 0 or at least 2.");
+        ABCDK_ERRNO_AND_GOTO1(EINVAL, final);
+    }
+
+    tar.fd = abcdk_open(dev_p, (cmd == ABCDKMT_TAR_CREATE), 0, 0);
+    if (tar.fd < 0)
+    {
+        syslog(LOG_WARNING, "'%s' %s.", dev_p, strerror(errno));
+        goto final;
+    }
+
+    /*环形缓存，每次取走数据后不需要移动未读数据，设备仍然按整块读写。*/
+    tar.buf = abcdk_buffer_alloc3(blocksize, 0);
+    buf = abcdk_heap_alloc(blocksize);
+    if (!tar.buf || !buf)
+        ABCDK_ERRNO_AND_GOTO1(ENOMEM, final);
+
+    /*写线程按整块写入设备，调用者同时准备后面的块，磁带可以保持连续走带。*/
+    if (cmd == ABCDKMT_TAR_CREATE && async_blocks >= 2)
+    {
+        tar.writer = abcdk_block_writer_alloc(tar.fd, blocksize, async_blocks);
+        if (!tar.writer)
+            ABCDK_ERRNO_AND_GOTO1(ENOMEM, final);
+    }
+
+    /*读线程按整块预读，调用者同时写出前面的文件。*/
+    if (cmd == ABCDKMT_TAR_EXTRACT && read_ahead >= 2)
+    {
+        tar.reader = abcdk_block_reader_alloc(tar.fd, blocksize, read_ahead);
+        if (!tar.reader)
+            ABCDK_ERRNO_AND_GOTO1(ENOMEM, final);
+    }
+
+    if (cmd == ABCDKMT_TAR_CREATE)
+        chk = _abcdkmt_tar_create(args, &tar, buf, blocksize);
+    else
+        chk = _abcdkmt_tar_extract(args, &tar, buf, blocksize);
+
+    if (chk != 0 && errno == 0)
+        errno = EIO;
+
+    if (tar.writer)
+    {
+        abcdk_block_writer_stat_fetch(tar.writer, &wstat);
+        syslog(LOG_INFO, "Blocks: %lu, Stalls: %lu, Idles: %lu.", wstat.blocks, wstat.stalls, wstat.idles);
+    }
+
+    if (tar.reader)
+    {
+        abcdk_block_reader_stat_fetch(tar.reader, &rstat);
+        syslog(LOG_INFO, "Blocks: %lu, Stalls: %lu, Idles: %lu.", rstat.blocks, rstat.stalls, rstat.idles);
+    }
+
+    /*No error.*/
+    if (chk == 0)
+        errno = 0;
+
+final:
+
+    abcdk_block_writer_free(&tar.writer);
+    abcdk_block_reader_free(&tar.reader);
+    abcdk_heap_free(buf);
+    abcdk_buffer_free(&tar.buf);
+    abcdk_closep(&tar.fd);
+}
+
 void _abcdkmt_work(abcdk_tree_t *args)
 {
     abcdk_scsi_io_stat stat = {0};
@@ -316,6 +685,13 @@ void _abcdkmt_work(abcdk_tree_t *args)
         goto final;
     }
 
+    /*TAR命令直接读写设备(或文件)，不需要SCSI命令。*/
+    if (cmd == ABCDKMT_TAR_CREATE || cmd == ABCDKMT_TAR_EXTRACT)
+    {
+        _abcdkmt_tar(args, dev_p, cmd);
+        return;
+    }
+
     fd = abcdk_open(dev_p, 1, 1, 0);
     if (fd < 0)
     {